@@ -10,6 +10,7 @@
 
 #include "imodule.h"
 #include <cstddef>
+#include <cstdint>
 
 #include "itextstream.h"
 
@@ -33,6 +34,10 @@ public:
 
     // Returns the absolute file system path to the archive the given file is located in
     virtual std::string getArchivePath(const std::string& relativePath) = 0;
+
+    // Returns an opaque stamp changing whenever the given file is modified on disk.
+    // Files in PAK archives share the stamp of the PAK file itself.
+    virtual std::int64_t getLastModified(const std::string& relativePath) = 0;
 };
 
 /**
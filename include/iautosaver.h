@@ -28,7 +28,11 @@ public:
     // Perform an automatic save, unconditionally. This will run the save algorithms
     // for the currently loaded map, regardless whether it is due for a save or not.
     // Call the "runAutosaveCheck" method to see if an autosave is overdue.
+    // The map is written in the background, the scene can be changed right after this call.
     virtual void performAutosave() = 0;
+
+    // Blocks until the save started by the last performAutosave() call is done.
+    virtual void waitForPendingSave() = 0;
 };
 
 constexpr const char* const RKEY_AUTOSAVE_SNAPSHOTS_ENABLED = "user/ui/map/autoSaveSnapshots";
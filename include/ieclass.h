@@ -42,6 +42,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 class Shader;
 typedef std::shared_ptr<Shader> ShaderPtr;
+class RenderSystem;
+typedef std::shared_ptr<RenderSystem> RenderSystemPtr;
 class AABB;
 
 /**
@@ -184,6 +186,15 @@ public:
     /// Get the shader used for rendering this entity class in filled mode.
     virtual const std::string& getFillShader() const = 0;
 
+    /**
+     * Return the shaders named by getWireShader() and getFillShader(), as
+     * captured from the given render system. The entity class keeps them
+     * until its colour changes, subsequent calls don't need to look up
+     * the shader names in the render system.
+     */
+    virtual const ShaderPtr& captureWireShader(const RenderSystemPtr& renderSystem) const = 0;
+    virtual const ShaderPtr& captureFillShader(const RenderSystemPtr& renderSystem) const = 0;
+
 
     /* ENTITY CLASS ATTRIBUTES */
 
@@ -368,8 +379,9 @@ public:
     virtual void unrealise() = 0;
 
     /**
-     * greebo: This reloads the entityDefs and modelDefs from all files. Does not
-     * change the scenegraph, only the contents of the EClass objects are
+     * greebo: This reloads the entityDefs and modelDefs from the files that have
+     * been changed or added since they were last parsed. Does not change the
+     * scenegraph, only the contents of the affected EClass objects are
      * re-parsed. All IEntityClassPtrs remain valid, no entityDefs are removed.
      *
      * Note: This is NOT the same as unrealise + realise
@@ -235,6 +235,21 @@ public:
 	 */
 	virtual bool isOfType(const std::string& className) = 0;
 
+    /**
+     * \brief
+     * Start a batch of spawnarg changes on this entity.
+     *
+     * Until the matching endKeyValueChanges() call, key observers and
+     * Entity::Observer::onKeyChange are not invoked for changed values.
+     * Each changed key is reported once with its final value when the batch
+     * ends. Key insertions and removals are still reported immediately.
+     * Calls can be nested, use the KeyValueChangeScope class for exception safety.
+     */
+    virtual void beginKeyValueChanges() = 0;
+
+    /// End the batch of spawnarg changes started by beginKeyValueChanges()
+    virtual void endKeyValueChanges() = 0;
+
     /* ENTITY ATTACHMENTS */
 
     /// Details of an attached entity
@@ -462,6 +477,17 @@ public:
      * @throws: cmd::ExecutionFailure if anything goes wrong or the selection is not suitable.
      */
     virtual IEntityNodePtr createEntityFromSelection(const std::string& name, const Vector3& origin) = 0;
+
+    /**
+     * Start a batch of spawnarg changes spanning all entities, like
+     * Entity::beginKeyValueChanges() does for a single one. Meant for bulk
+     * operations touching many entities, the deferred notifications are
+     * delivered when the outermost batch ends.
+     */
+    virtual void beginKeyValueChanges() = 0;
+
+    /// End the batch of spawnarg changes started by beginKeyValueChanges()
+    virtual void endKeyValueChanges() = 0;
 };
 
 inline IEntityModule& GlobalEntityModule()
@@ -469,3 +495,42 @@ inline IEntityModule& GlobalEntityModule()
     static module::InstanceReference<IEntityModule> _reference(MODULE_ENTITY);
     return _reference;
 }
+
+/**
+ * Scoped object collecting the spawnarg changes of a single entity, or of
+ * all entities if constructed without argument. Observers are notified
+ * once per changed key when the object goes out of scope.
+ */
+class KeyValueChangeScope
+{
+private:
+    Entity* _entity;
+
+public:
+    KeyValueChangeScope() :
+        _entity(nullptr)
+    {
+        GlobalEntityModule().beginKeyValueChanges();
+    }
+
+    KeyValueChangeScope(Entity& entity) :
+        _entity(&entity)
+    {
+        _entity->beginKeyValueChanges();
+    }
+
+    KeyValueChangeScope(const KeyValueChangeScope& other) = delete;
+    KeyValueChangeScope& operator=(const KeyValueChangeScope& other) = delete;
+
+    ~KeyValueChangeScope()
+    {
+        if (_entity != nullptr)
+        {
+            _entity->endKeyValueChanges();
+        }
+        else
+        {
+            GlobalEntityModule().endKeyValueChanges();
+        }
+    }
+};
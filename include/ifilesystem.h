@@ -7,6 +7,7 @@
  */
 
 #include <cstddef>
+#include <cstdint>
 #include <string>
 #include <list>
 #include <set>
@@ -125,6 +126,12 @@ public:
         return _infoProvider ? _infoProvider->getArchivePath(fullPath()) : "";
     }
 
+    // See IArchiveFileInfoProvider::getLastModified
+    std::int64_t getLastModified() const
+    {
+        return _infoProvider ? _infoProvider->getLastModified(fullPath()) : 0;
+    }
+
     /// Equality comparison with another FileInfo
     bool operator== (const FileInfo& rhs) const
     {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "inode.h"
+#include "math/Vector3.h"
 
 namespace scene
 {
@@ -22,6 +23,13 @@ public:
 	 */
 	virtual void addOriginToChildren() = 0;
 	virtual void removeOriginFromChildren() = 0;
+
+	/**
+	 * Returns the origin the child primitives are positioned relative to
+	 * in the map file, this is what removeOriginFromChildren() would
+	 * subtract from them. Map writers apply this offset on the fly.
+	 */
+	virtual Vector3 getChildPrimitiveOrigin() const = 0;
 };
 typedef std::shared_ptr<GroupNode> GroupNodePtr;
 
@@ -111,6 +111,22 @@ public:
      */
     virtual ImagePtr imageFromVFS(const std::string& vfsPath) const = 0;
 
+    /**
+     * \brief
+     * Check whether an image with the given VFS path exists, using the same
+     * extension and prefix lookup order as imageFromVFS(). The image
+     * itself is not loaded.
+     */
+    virtual bool imageExistsInVFS(const std::string& vfsPath) const = 0;
+
+    /**
+     * \brief
+     * Returns the VFS path of the image file imageFromVFS() would load for
+     * the given name (including prefix and extension), or an empty string
+     * if no matching file exists.
+     */
+    virtual std::string findImageFileInVFS(const std::string& vfsPath) const = 0;
+
     /**
      * \brief
      * Load an image from a filesystem path.
@@ -2,7 +2,12 @@
 
 #include <set>
 #include <string>
+#include <vector>
+#include <cstdint>
+#include <cassert>
+#include <iterator>
 #include <functional>
+#include <initializer_list>
 #include "imodule.h"
 #include <sigc++/signal.h>
 
@@ -12,8 +17,263 @@ namespace scene
 class INode;
 typedef std::shared_ptr<INode> INodePtr;
 
-// A list of named layers
-typedef std::set<int> LayerList;
+/**
+ * The set of layer IDs an object is a member of, stored as a bit mask.
+ *
+ * The IDs 0..63 are held in place, higher IDs (which are rare) spill into
+ * additional mask words on the heap. Iteration yields the IDs in ascending
+ * order, the interface follows the one of std::set<int>.
+ */
+class LayerList
+{
+private:
+	static constexpr int BITS_PER_WORD = 64;
+
+	// Bits for the layer IDs 0..63
+	std::uint64_t _bits;
+
+	// Bits for the layer IDs 64 and above, trailing zero words are removed
+	std::vector<std::uint64_t> _moreBits;
+
+public:
+	typedef int value_type;
+
+	class const_iterator
+	{
+	private:
+		const LayerList* _list;
+		int _layerId; // -1 == end
+
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef int value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const int* pointer;
+		typedef const int& reference;
+
+		const_iterator(const LayerList* list, int layerId) :
+			_list(list),
+			_layerId(layerId)
+		{}
+
+		const int& operator*() const
+		{
+			return _layerId;
+		}
+
+		const_iterator& operator++()
+		{
+			_layerId = _list->findNextLayer(_layerId + 1);
+			return *this;
+		}
+
+		const_iterator operator++(int)
+		{
+			auto previous = *this;
+			++(*this);
+			return previous;
+		}
+
+		bool operator==(const const_iterator& other) const
+		{
+			return _layerId == other._layerId;
+		}
+
+		bool operator!=(const const_iterator& other) const
+		{
+			return _layerId != other._layerId;
+		}
+	};
+
+	typedef const_iterator iterator;
+
+	LayerList() :
+		_bits(0)
+	{}
+
+	LayerList(std::initializer_list<int> layerIds) :
+		_bits(0)
+	{
+		insert(layerIds.begin(), layerIds.end());
+	}
+
+	void insert(int layerId)
+	{
+		assert(layerId >= 0);
+
+		if (layerId < BITS_PER_WORD)
+		{
+			_bits |= bit(layerId);
+			return;
+		}
+
+		std::size_t word = layerId / BITS_PER_WORD - 1;
+
+		if (word >= _moreBits.size())
+		{
+			_moreBits.resize(word + 1, 0);
+		}
+
+		_moreBits[word] |= bit(layerId % BITS_PER_WORD);
+	}
+
+	template<typename InputIterator>
+	void insert(InputIterator first, InputIterator last)
+	{
+		for (; first != last; ++first)
+		{
+			insert(*first);
+		}
+	}
+
+	// Removes the given layer ID, returns the number of removed elements (0 or 1)
+	std::size_t erase(int layerId)
+	{
+		if (count(layerId) == 0)
+		{
+			return 0;
+		}
+
+		if (layerId < BITS_PER_WORD)
+		{
+			_bits &= ~bit(layerId);
+			return 1;
+		}
+
+		_moreBits[layerId / BITS_PER_WORD - 1] &= ~bit(layerId % BITS_PER_WORD);
+
+		while (!_moreBits.empty() && _moreBits.back() == 0)
+		{
+			_moreBits.pop_back();
+		}
+
+		return 1;
+	}
+
+	std::size_t count(int layerId) const
+	{
+		if (layerId < 0)
+		{
+			return 0;
+		}
+
+		if (layerId < BITS_PER_WORD)
+		{
+			return (_bits & bit(layerId)) != 0 ? 1 : 0;
+		}
+
+		std::size_t word = layerId / BITS_PER_WORD - 1;
+
+		return word < _moreBits.size() && (_moreBits[word] & bit(layerId % BITS_PER_WORD)) != 0 ? 1 : 0;
+	}
+
+	bool empty() const
+	{
+		return _bits == 0 && _moreBits.empty();
+	}
+
+	std::size_t size() const
+	{
+		std::size_t result = countBits(_bits);
+
+		for (auto word : _moreBits)
+		{
+			result += countBits(word);
+		}
+
+		return result;
+	}
+
+	void clear()
+	{
+		_bits = 0;
+		_moreBits.clear();
+	}
+
+	// Returns true if at least one layer ID is contained in both lists
+	bool intersects(const LayerList& other) const
+	{
+		if ((_bits & other._bits) != 0)
+		{
+			return true;
+		}
+
+		for (std::size_t i = 0; i < _moreBits.size() && i < other._moreBits.size(); ++i)
+		{
+			if ((_moreBits[i] & other._moreBits[i]) != 0)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	const_iterator begin() const
+	{
+		return const_iterator(this, findNextLayer(0));
+	}
+
+	const_iterator end() const
+	{
+		return const_iterator(this, -1);
+	}
+
+	bool operator==(const LayerList& other) const
+	{
+		return _bits == other._bits && _moreBits == other._moreBits;
+	}
+
+	bool operator!=(const LayerList& other) const
+	{
+		return !operator==(other);
+	}
+
+private:
+	static std::uint64_t bit(int index)
+	{
+		return static_cast<std::uint64_t>(1) << index;
+	}
+
+	static std::size_t countBits(std::uint64_t word)
+	{
+		std::size_t count = 0;
+
+		for (; word != 0; word &= word - 1)
+		{
+			++count;
+		}
+
+		return count;
+	}
+
+	// Returns the lowest layer ID >= the given one, or -1 if there is none
+	int findNextLayer(int layerId) const
+	{
+		std::size_t numWords = _moreBits.size() + 1;
+
+		for (std::size_t word = layerId / BITS_PER_WORD; word < numWords; ++word)
+		{
+			std::uint64_t bits = word == 0 ? _bits : _moreBits[word - 1];
+
+			// Mask out the IDs below the requested one
+			if (word == static_cast<std::size_t>(layerId / BITS_PER_WORD))
+			{
+				bits &= ~static_cast<std::uint64_t>(0) << (layerId % BITS_PER_WORD);
+			}
+
+			for (int index = 0; bits != 0; ++index, bits >>= 1)
+			{
+				if (bits & 1)
+				{
+					return static_cast<int>(word) * BITS_PER_WORD + index;
+				}
+			}
+		}
+
+		return -1;
+	}
+};
 
 /**
  * greebo: Interface of a Layered object.
@@ -174,6 +434,20 @@ public:
 	 */
 	virtual bool updateNodeVisibility(const scene::INodePtr& node) = 0;
 
+	/**
+	 * Keeps the per-layer member index up to date. This is called by the nodes
+	 * themselves when they are inserted into or removed from the scene (with
+	 * an empty new or old list, respectively), and whenever their layer
+	 * memberships change while they are part of the scene.
+	 */
+	virtual void onNodeLayersChanged(INode& node, const LayerList& oldLayers, const LayerList& newLayers) = 0;
+
+	/**
+	 * Invokes the given functor for each node in the scene which is a member
+	 * of the given layer, in no particular order.
+	 */
+	virtual void foreachLayerMember(int layerID, const std::function<void(const INodePtr&)>& functor) = 0;
+
 	/**
 	 * greebo: Sets the selection status of the entire layer.
 	 *
@@ -121,6 +121,22 @@ public:
 	// Patch export methods
 	virtual void beginWritePatch(const IPatchNodePtr& patch, std::ostream& stream) = 0;
 	virtual void endWritePatch(const IPatchNodePtr& patch, std::ostream& stream) = 0;
+
+	/**
+	 * Writers which are able to write each entity (including its primitives)
+	 * independently from the others can return a new writer instance here,
+	 * which will be used to write the entity with the given (zero-based) number
+	 * to a separate buffer, possibly on a worker thread. The returned writer
+	 * must not rely on any state besides the entity number and must not
+	 * access any non-threadsafe modules while writing.
+	 *
+	 * The default implementation returns an empty pointer, in which case all
+	 * nodes are written sequentially through this writer instance.
+	 */
+	virtual std::shared_ptr<IMapWriter> createEntityWriter(std::size_t entityNumber)
+	{
+		return std::shared_ptr<IMapWriter>();
+	}
 };
 typedef std::shared_ptr<IMapWriter> IMapWriterPtr;
 
@@ -219,6 +235,16 @@ public:
 	 */
 	virtual bool allowInfoFileCreation() const = 0;
 
+	/**
+	 * Returns true if a binary cache of the map can be saved along the
+	 * .map file, which is then used to speed up loading the unchanged map.
+	 * This is an optional feature, it is disabled by default.
+	 */
+	virtual bool allowBinaryCacheCreation() const
+	{
+		return false;
+	}
+
 	/**
 	 * greebo: Returns true if this map format is able to load
 	 * the contents of this file. Usually this includes a version
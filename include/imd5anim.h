@@ -57,6 +57,10 @@ public:
 	// Each frame has a series of float values, applied to one or more animated components (x, y, z, yaw, pitch, roll)
 	typedef std::vector<float> FrameKeys;
 
+	// The model-space origin and orientation of every joint at a certain time
+	typedef std::vector<Key> Pose;
+	typedef std::shared_ptr<const Pose> PosePtr;
+
 	/**
 	 * Get the number of joints in this animation.
 	 */
@@ -86,6 +90,13 @@ public:
 	 * Returns the float values of the given frame index.
 	 */
 	virtual const FrameKeys& getFrameKeys(std::size_t index) const = 0;
+
+	/**
+	 * Returns the model-space pose of all joints at the given time (in msec),
+	 * interpolated between the two nearest frames. Recently requested poses
+	 * are cached, all callers asking for the same time receive the same object.
+	 */
+	virtual PosePtr getPose(std::size_t time) const = 0;
 };
 typedef std::shared_ptr<IMD5Anim> IMD5AnimPtr;
 
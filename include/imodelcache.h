@@ -8,6 +8,27 @@
 namespace model 
 {
 
+/**
+ * A node standing in for a model which is still being loaded in the background,
+ * as returned by IModelCache::getModelNodeAsync(). It renders the bounds of the
+ * default null model.
+ *
+ * Once the model is available, the model cache emits signal_modelLoaded() with
+ * the actual model node (or a NullModel if the model failed to load), the owner
+ * of the placeholder is supposed to replace the placeholder with it.
+ */
+class IModelPlaceholder
+{
+public:
+	virtual ~IModelPlaceholder() {}
+
+	// The model path this placeholder has been requested for
+	virtual const std::string& getRequestedModelPath() const = 0;
+
+	// Emitted (on the main thread) when the model node is ready to be swapped in
+	virtual sigc::signal<void, const scene::INodePtr&> signal_modelLoaded() = 0;
+};
+
 /** Modelcache interface.
  */
 class IModelCache :
@@ -24,6 +45,26 @@ public:
 	 */
 	virtual scene::INodePtr getModelNode(const std::string& modelPath) = 0;
 
+	/**
+	 * Like getModelNode(), but doesn't block on models which are not in the cache yet:
+	 * these are parsed on a worker thread, the returned node is an IModelPlaceholder
+	 * then. Requests for the same model are loaded only once.
+	 *
+	 * Cache hits, model defs and particles are returned synchronously, as they
+	 * would be by getModelNode().
+	 *
+	 * The placeholders are notified by waitForPendingModels(). A synchronous
+	 * getModelNode() call for a model in flight will wait for that load to finish.
+	 */
+	virtual scene::INodePtr getModelNodeAsync(const std::string& modelPath) = 0;
+
+	/**
+	 * Blocks until all models requested through getModelNodeAsync() are loaded,
+	 * then emits the modelLoaded signal of each placeholder still alive.
+	 * Must be called from the main thread.
+	 */
+	virtual void waitForPendingModels() = 0;
+
 	/**
 	 * greebo: Get the IModel object for the given VFS path. The request is cached,
 	 * so calling this with the same path twice will return the same
@@ -42,6 +83,23 @@ public:
 	// This reloads all selected models in the map
 	virtual void refreshSelectedModels(bool blockScreenUpdates = true) = 0;
 
+	// Memory usage and efficiency figures of the model cache
+	struct Statistics
+	{
+		// Number of models held in the cache
+		std::size_t numModels = 0;
+
+		// Bytes occupied by the vertex and index data of the cached models
+		std::size_t vertexDataSize = 0;
+		std::size_t indexDataSize = 0;
+
+		// Model requests served from the cache and requests which had to load a model file
+		std::size_t numHits = 0;
+		std::size_t numMisses = 0;
+	};
+
+	virtual Statistics getStatistics() const = 0;
+
 	// Clears a specific model from the cache
 	virtual void removeModel(const std::string& modelPath) = 0;
 
@@ -46,6 +46,15 @@ public:
 	 * respecting the applied skin.
 	 */
 	virtual const std::string& getActiveMaterial() const = 0;
+
+	/**
+	 * Surfaces storing their vertices in a more compact format build the
+	 * vertices returned by getVertex() on first access. This frees them again,
+	 * call it once done reading the vertices. Any references obtained before
+	 * are invalidated, the next access will build the vertices again.
+	 */
+	virtual void releaseVertexArray() const
+	{}
 };
 
 /**
@@ -218,8 +218,8 @@ public:
 
 	/**
      * \brief
-     * Force the particles manager to reload all particle definitions from the
-     * .prt files.
+     * Force the particles manager to reload the particle definitions from the
+     * .prt files that have been changed, added or removed since the last load.
      *
      * Any existing references to IParticleDefs will remain valid, but their
      * contents might change.  Anything sensitive to these changes (like the
@@ -532,6 +532,12 @@ public:
 	 */
 	virtual void setTime(std::size_t milliSeconds) = 0;
 
+	/**
+	 * Returns the number of GL state changes (program, texture, render flag
+	 * and transform changes) performed during the last call to render().
+	 */
+	virtual std::size_t getStateChangeCount() const = 0;
+
     /* SHADER PROGRAMS */
 
     /// Available GL programs used for backend rendering.
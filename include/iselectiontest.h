@@ -3,6 +3,7 @@
 #include <cstddef>
 
 #include "math/FloatTools.h"
+#include "math/Vector3.h"
 #include "inode.h"
 #include "iselection.h"
 #include <memory>
@@ -150,6 +151,34 @@ private:
 	std::size_t m_stride;
 };
 
+/**
+ * Random access to a sequence of single-precision float[3] positions with
+ * a certain stride, like the ones of a packed vertex array. The positions
+ * are converted to Vector3 when they are accessed.
+ */
+class FloatVertexPointer
+{
+	typedef const unsigned char* byte_pointer;
+public:
+	FloatVertexPointer(const float* vertices, std::size_t stride) :
+		_vertices(reinterpret_cast<byte_pointer>(vertices)),
+		_stride(stride)
+	{}
+
+	Vector3 operator[](std::size_t i) const
+	{
+		auto components = reinterpret_cast<const float*>(_vertices + _stride * i);
+		return Vector3(components[0], components[1], components[2]);
+	}
+
+private:
+	// The address of the first position
+	byte_pointer _vertices;
+
+	// The distance (in bytes) to the next position in memory
+	std::size_t _stride;
+};
+
 class IndexPointer
 {
 public:
@@ -233,6 +262,7 @@ public:
   virtual void TestLineStrip(const VertexPointer& vertices, std::size_t count, SelectionIntersection& best) = 0;
   virtual void TestLines(const VertexPointer& vertices, std::size_t count, SelectionIntersection& best) = 0;
   virtual void TestTriangles(const VertexPointer& vertices, const IndexPointer& indices, SelectionIntersection& best) = 0;
+  virtual void TestTriangles(const FloatVertexPointer& vertices, const IndexPointer& indices, SelectionIntersection& best) = 0;
   virtual void TestQuads(const VertexPointer& vertices, const IndexPointer& indices, SelectionIntersection& best) = 0;
   virtual void TestQuadStrip(const VertexPointer& vertices, const IndexPointer& indices, SelectionIntersection& best) = 0;
 };
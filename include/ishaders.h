@@ -489,6 +489,11 @@ public:
   virtual void unrealise() = 0;
   virtual void refresh() = 0;
 
+  // Re-parses the material files which have been changed, added or removed
+  // since they were loaded. Existing materials are updated in place and emit
+  // their changed signal, textures are not reloaded.
+  virtual void reloadChangedMaterials() = 0;
+
 	/** Determine whether the shader system is realised. This may be used
 	 * by components which need to ensure the shaders are realised before
 	 * they start trying to display them.
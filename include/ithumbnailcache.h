@@ -0,0 +1,72 @@
+#pragma once
+
+#include "imodule.h"
+#include "iimage.h"
+
+namespace image
+{
+
+/**
+ * A downscaled preview image of a material's editor image, as generated
+ * by the thumbnail cache.
+ */
+struct Thumbnail
+{
+    using Ptr = std::shared_ptr<Thumbnail>;
+
+    // The downscaled RGBA image
+    ImagePtr image;
+
+    // Dimensions of the full-size source image
+    std::size_t sourceWidth = 0;
+    std::size_t sourceHeight = 0;
+};
+
+/**
+ * Module generating and caching thumbnails of material editor images,
+ * used by the texture and media browsers to display previews without
+ * having to load and upload the full-size images.
+ *
+ * Thumbnails are generated on worker threads and stored in an on-disk cache
+ * located in the user's cache data path, which is used on subsequent requests.
+ */
+class IThumbnailCache :
+    public RegisterableModule
+{
+public:
+    virtual ~IThumbnailCache() {}
+
+    /**
+     * Returns the thumbnail of the named material's editor image if it is
+     * available. If it is not, its generation is queued and an empty pointer
+     * is returned, client code is supposed to ask again later.
+     * Must be called from the main thread.
+     */
+    virtual Thumbnail::Ptr getThumbnail(const std::string& materialName) = 0;
+
+    /**
+     * A counter which is incremented each time a queued thumbnail has been
+     * completed. Client code can compare it against a previous value
+     * to check whether it is time to request the pending thumbnails again.
+     */
+    virtual std::size_t getGeneration() const = 0;
+
+    // Returns true if there are thumbnails queued for generation
+    virtual bool hasPendingThumbnails() const = 0;
+
+    // Blocks until all queued thumbnails have been processed
+    virtual void waitForPendingThumbnails() = 0;
+
+    // Discards all thumbnails held in memory, the on-disk cache is not affected
+    virtual void clear() = 0;
+};
+
+}
+
+const char* const MODULE_THUMBNAILCACHE("ThumbnailCache");
+
+inline image::IThumbnailCache& GlobalThumbnailCache()
+{
+    static module::InstanceReference<image::IThumbnailCache> _reference(MODULE_THUMBNAILCACHE);
+    return _reference;
+}
@@ -81,14 +81,15 @@ public:
 	virtual const StringList& getAllSkins() = 0;
 
     // Adds a runtime-generated skin to the collection, it will be resolvable by capture(). 
-    // Note that this skin is not going to survive a refresh() call 
+    // The skin is kept until it is removed again using removeSkin().
     virtual void addNamedSkin(const ModelSkinPtr& modelSkin) = 0;
 
     // Removes a named skin from the cache
     virtual void removeSkin(const std::string& name) = 0;
 
 	/**
-	 * greebo: Reloads all skins from the definition files.
+	 * greebo: Reloads the skins from the definition files that have been
+	 * changed, added or removed since they were last loaded.
 	 */
 	virtual void refresh() = 0;
 
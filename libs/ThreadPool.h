@@ -0,0 +1,187 @@
+#pragma once
+
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <functional>
+#include <future>
+#include <algorithm>
+
+namespace util
+{
+
+/**
+ * Fixed-size pool of worker threads processing queued tasks in FIFO order.
+ * Tasks are executed concurrently, there is no ordering guarantee between
+ * tasks running on different workers.
+ *
+ * Destroying the pool will discard all unstarted tasks, but will block
+ * until the currently running tasks are done.
+ */
+class ThreadPool
+{
+private:
+    std::mutex _lock;
+    std::condition_variable _tasksAvailable;
+    std::condition_variable _tasksDone;
+
+    std::deque<std::function<void()>> _queue;
+    std::vector<std::thread> _workers;
+
+    std::size_t _numActiveTasks;
+    bool _shutdown;
+
+public:
+    // Construct a pool with the given number of workers.
+    // Passing 0 will create a pool using the number of hardware threads.
+    explicit ThreadPool(std::size_t numWorkers = 0) :
+        _numActiveTasks(0),
+        _shutdown(false)
+    {
+        if (numWorkers == 0)
+        {
+            numWorkers = GetDefaultNumWorkers();
+        }
+
+        _workers.reserve(numWorkers);
+
+        for (std::size_t i = 0; i < numWorkers; ++i)
+        {
+            _workers.emplace_back([this]() { processQueue(); });
+        }
+    }
+
+    ThreadPool(const ThreadPool& other) = delete;
+    ThreadPool& operator=(const ThreadPool& other) = delete;
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+            _queue.clear();
+            _shutdown = true;
+        }
+
+        _tasksAvailable.notify_all();
+
+        for (auto& worker : _workers)
+        {
+            worker.join();
+        }
+    }
+
+    std::size_t getNumWorkers() const
+    {
+        return _workers.size();
+    }
+
+    // Adds the given task to the queue, it will be picked up by the next idle worker.
+    // The task must not throw, use submit() to propagate exceptions to the caller.
+    void enqueue(const std::function<void()>& task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+            _queue.push_back(task);
+        }
+
+        _tasksAvailable.notify_one();
+    }
+
+    // Adds the given function to the queue, the returned future
+    // can be used to retrieve its result (or the exception it threw).
+    template<typename Func>
+    auto submit(Func&& func) -> std::future<decltype(func())>
+    {
+        using ReturnType = decltype(func());
+
+        auto task = std::make_shared<std::packaged_task<ReturnType()>>(std::forward<Func>(func));
+        auto future = task->get_future();
+
+        enqueue([task]() { (*task)(); });
+
+        return future;
+    }
+
+    // Removes all tasks that have not been started yet
+    void clearPendingTasks()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+            _queue.clear();
+        }
+
+        _tasksDone.notify_all();
+    }
+
+    // Returns true if there are neither queued nor running tasks
+    bool isIdle()
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        return _queue.empty() && _numActiveTasks == 0;
+    }
+
+    // Blocks until all queued and running tasks have been processed
+    void waitForIdle()
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        _tasksDone.wait(lock, [this]() { return _queue.empty() && _numActiveTasks == 0; });
+    }
+
+    // Number of workers used when not specified explicitly, always at least 1
+    static std::size_t GetDefaultNumWorkers()
+    {
+        return std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    // Returns true if the calling thread is a worker of any ThreadPool (within this module).
+    // Tasks can use this to avoid spawning further threads of their own,
+    // the pool is supposed to keep the hardware threads busy already.
+    static bool IsWorkerThread()
+    {
+        return WorkerThreadFlag();
+    }
+
+private:
+    static bool& WorkerThreadFlag()
+    {
+        thread_local bool isWorkerThread = false;
+        return isWorkerThread;
+    }
+
+    void processQueue()
+    {
+        WorkerThreadFlag() = true;
+
+        while (true)
+        {
+            std::function<void()> task;
+
+            {
+                std::unique_lock<std::mutex> lock(_lock);
+                _tasksAvailable.wait(lock, [this]() { return _shutdown || !_queue.empty(); });
+
+                if (_shutdown)
+                {
+                    return;
+                }
+
+                task = std::move(_queue.front());
+                _queue.pop_front();
+                ++_numActiveTasks;
+            }
+
+            task();
+
+            {
+                std::lock_guard<std::mutex> lock(_lock);
+                --_numActiveTasks;
+            }
+
+            _tasksDone.notify_all();
+        }
+    }
+};
+
+}
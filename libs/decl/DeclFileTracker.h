@@ -0,0 +1,273 @@
+#pragma once
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "ifilesystem.h"
+
+namespace decl
+{
+
+/**
+ * Keeps track of the decl files found in a given VFS folder, to let the
+ * decl managers re-parse only the files that changed since the last scan.
+ *
+ * Each scan records the containing archive, size and modification stamp
+ * of every file. A subsequent scanForChanges() compares the current state
+ * of the VFS against that snapshot and reports the added, modified and
+ * removed files. Files in directory archives are read from disk on demand,
+ * so edits to loose files show up without re-initialising the VFS.
+ *
+ * The managers can record the names of the declarations found in each file.
+ * A name declared by more than one file is resolved by the file order, so
+ * when reloading a changed file the managers need to parse the unchanged
+ * files declaring the same names again, see getFilesDeclaring().
+ */
+class DeclFileTracker
+{
+public:
+    struct Changes
+    {
+        // Added or modified files, in VFS traversal order
+        std::vector<vfs::FileInfo> changedFiles;
+
+        // Files that have been present during the last scan but are gone now
+        std::vector<vfs::FileInfo> removedFiles;
+
+        bool empty() const
+        {
+            return changedFiles.empty() && removedFiles.empty();
+        }
+
+        // The mod-relative paths of all changed and removed files
+        std::set<std::string> getAffectedPaths() const
+        {
+            std::set<std::string> paths;
+
+            for (const auto& fileInfo : changedFiles)
+            {
+                paths.insert(fileInfo.fullPath());
+            }
+
+            for (const auto& fileInfo : removedFiles)
+            {
+                paths.insert(fileInfo.fullPath());
+            }
+
+            return paths;
+        }
+    };
+
+private:
+    struct FileStamp
+    {
+        std::string topDir;
+        std::string name;
+        std::string archivePath;
+        std::size_t size;
+        std::int64_t lastModified;
+
+        bool operator==(const FileStamp& other) const
+        {
+            return size == other.size && lastModified == other.lastModified &&
+                archivePath == other.archivePath;
+        }
+    };
+
+    std::string _baseDir;
+    std::string _extension;
+    std::size_t _depth;
+
+    // Stamps of the last scan, keyed by the mod-relative path
+    std::map<std::string, FileStamp> _stamps;
+    bool _hasSnapshot;
+
+    // The files of the last scan in VFS order
+    std::vector<vfs::FileInfo> _files;
+
+    // The declaration names recorded for each file (mod-relative path)
+    std::map<std::string, std::set<std::string>> _declaredNames;
+
+public:
+    DeclFileTracker(const std::string& baseDir, const std::string& extension, std::size_t depth = 1) :
+        _baseDir(baseDir),
+        _extension(extension),
+        _depth(depth),
+        _hasSnapshot(false)
+    {}
+
+    // True if scan() has been called since construction or the last clear()
+    bool hasSnapshot() const
+    {
+        return _hasSnapshot;
+    }
+
+    // Forget about the recorded file state, the next scan will list all files
+    void clear()
+    {
+        _stamps.clear();
+        _files.clear();
+        _declaredNames.clear();
+        _hasSnapshot = false;
+    }
+
+    // Lists all matching files in VFS order and records their current state
+    std::vector<vfs::FileInfo> scan()
+    {
+        _files.clear();
+        _stamps.clear();
+
+        GlobalFileSystem().forEachFile(_baseDir, _extension, [&](const vfs::FileInfo& fileInfo)
+        {
+            _files.push_back(fileInfo);
+            _stamps.emplace(fileInfo.fullPath(), getStamp(fileInfo));
+        }, _depth);
+
+        _hasSnapshot = true;
+
+        return _files;
+    }
+
+    // Compares the current state of the VFS against the last scan, and records
+    // the new state. Without a previous scan, all files are reported as changed.
+    Changes scanForChanges()
+    {
+        Changes changes;
+        std::map<std::string, FileStamp> previousStamps;
+        previousStamps.swap(_stamps);
+
+        changes.changedFiles = scan();
+
+        // Drop all files which are still in the same state as before
+        auto unchanged = [&](const vfs::FileInfo& fileInfo)
+        {
+            auto previous = previousStamps.find(fileInfo.fullPath());
+
+            if (previous == previousStamps.end())
+            {
+                return false; // added
+            }
+
+            bool isUnchanged = previous->second == _stamps.at(previous->first);
+            previousStamps.erase(previous);
+
+            return isUnchanged;
+        };
+
+        changes.changedFiles.erase(
+            std::remove_if(changes.changedFiles.begin(), changes.changedFiles.end(), unchanged),
+            changes.changedFiles.end());
+
+        // What's left over in the previous map has been removed from the VFS
+        for (const auto& pair : previousStamps)
+        {
+            changes.removedFiles.emplace_back(pair.second.topDir, pair.second.name, vfs::Visibility::NORMAL);
+        }
+
+        return changes;
+    }
+
+    // Records the names of the declarations parsed from the given file,
+    // replacing the previous record. An empty set removes the record.
+    void setDeclaredNames(const std::string& path, std::set<std::string> names)
+    {
+        if (names.empty())
+        {
+            _declaredNames.erase(path);
+        }
+        else
+        {
+            _declaredNames[path] = std::move(names);
+        }
+    }
+
+    // Returns the names recorded for the given files
+    std::set<std::string> getDeclaredNames(const std::set<std::string>& paths) const
+    {
+        std::set<std::string> names;
+
+        for (const auto& path : paths)
+        {
+            auto found = _declaredNames.find(path);
+
+            if (found != _declaredNames.end())
+            {
+                names.insert(found->second.begin(), found->second.end());
+            }
+        }
+
+        return names;
+    }
+
+    // Returns the files of the last scan declaring at least one of the given names,
+    // in VFS order. The files in excludedPaths are left out.
+    std::vector<vfs::FileInfo> getFilesDeclaring(const std::set<std::string>& names,
+        const std::set<std::string>& excludedPaths) const
+    {
+        std::vector<vfs::FileInfo> files;
+
+        if (names.empty()) return files;
+
+        for (const auto& fileInfo : _files)
+        {
+            auto path = fileInfo.fullPath();
+            auto found = _declaredNames.find(path);
+
+            if (found == _declaredNames.end() || excludedPaths.count(path) > 0)
+            {
+                continue;
+            }
+
+            for (const auto& name : found->second)
+            {
+                if (names.count(name) > 0)
+                {
+                    files.push_back(fileInfo);
+                    break;
+                }
+            }
+        }
+
+        return files;
+    }
+
+    // Brings the given files into the order of the last scan,
+    // files not found by the last scan are moved to the end
+    void sortInScanOrder(std::vector<vfs::FileInfo>& files) const
+    {
+        std::map<std::string, std::size_t> positions;
+
+        for (std::size_t i = 0; i < _files.size(); ++i)
+        {
+            positions.emplace(_files[i].fullPath(), i);
+        }
+
+        auto getPosition = [&](const vfs::FileInfo& fileInfo)
+        {
+            auto found = positions.find(fileInfo.fullPath());
+            return found != positions.end() ? found->second : _files.size();
+        };
+
+        std::stable_sort(files.begin(), files.end(), [&](const vfs::FileInfo& a, const vfs::FileInfo& b)
+        {
+            return getPosition(a) < getPosition(b);
+        });
+    }
+
+private:
+    static FileStamp getStamp(const vfs::FileInfo& fileInfo)
+    {
+        return FileStamp
+        {
+            fileInfo.topDir,
+            fileInfo.name,
+            fileInfo.getArchivePath(),
+            fileInfo.getSize(),
+            fileInfo.getLastModified()
+        };
+    }
+};
+
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include "RGBAImage.h"
+
+namespace image
+{
+
+/**
+ * Returns the dimensions of a thumbnail of the given source size, such that
+ * the longer side is at most maxSize pixels. The aspect ratio is preserved,
+ * images smaller than maxSize are not enlarged.
+ */
+inline std::pair<std::size_t, std::size_t> getThumbnailSize(std::size_t width, std::size_t height, std::size_t maxSize)
+{
+    auto longerSide = std::max(width, height);
+
+    if (longerSide <= maxSize)
+    {
+        return { width, height };
+    }
+
+    return {
+        std::max<std::size_t>(width * maxSize / longerSide, 1),
+        std::max<std::size_t>(height * maxSize / longerSide, 1)
+    };
+}
+
+/**
+ * Create a downscaled RGBA copy of the given image, fitting into a square of
+ * maxSize pixels. Each thumbnail pixel is the average of the source pixels
+ * it covers (box filter). Only uncompressed RGBA images are supported,
+ * an empty pointer is returned for any other image.
+ */
+inline RGBAImagePtr createThumbnail(const Image& source, std::size_t maxSize)
+{
+    if (source.isPrecompressed() || source.getGLFormat() != GL_RGBA || source.getPixels() == nullptr)
+    {
+        return RGBAImagePtr();
+    }
+
+    auto sourceWidth = source.getWidth();
+    auto sourceHeight = source.getHeight();
+
+    if (sourceWidth == 0 || sourceHeight == 0)
+    {
+        return RGBAImagePtr();
+    }
+
+    auto size = getThumbnailSize(sourceWidth, sourceHeight, maxSize);
+    auto thumbnail = std::make_shared<RGBAImage>(size.first, size.second);
+
+    auto sourcePixels = reinterpret_cast<const RGBAPixel*>(source.getPixels());
+
+    for (std::size_t y = 0; y < size.second; ++y)
+    {
+        // Source rows covered by this thumbnail row, at least one
+        auto y0 = y * sourceHeight / size.second;
+        auto y1 = std::max((y + 1) * sourceHeight / size.second, y0 + 1);
+
+        for (std::size_t x = 0; x < size.first; ++x)
+        {
+            auto x0 = x * sourceWidth / size.first;
+            auto x1 = std::max((x + 1) * sourceWidth / size.first, x0 + 1);
+
+            std::size_t red = 0, green = 0, blue = 0, alpha = 0;
+
+            for (auto sy = y0; sy < y1; ++sy)
+            {
+                const auto* row = sourcePixels + sy * sourceWidth;
+
+                for (auto sx = x0; sx < x1; ++sx)
+                {
+                    red += row[sx].red;
+                    green += row[sx].green;
+                    blue += row[sx].blue;
+                    alpha += row[sx].alpha;
+                }
+            }
+
+            auto numPixels = (y1 - y0) * (x1 - x0);
+            auto& target = thumbnail->pixels[y * size.first + x];
+
+            target.red = static_cast<uint8_t>(red / numPixels);
+            target.green = static_cast<uint8_t>(green / numPixels);
+            target.blue = static_cast<uint8_t>(blue / numPixels);
+            target.alpha = static_cast<uint8_t>(alpha / numPixels);
+        }
+    }
+
+    return thumbnail;
+}
+
+}
@@ -3,6 +3,7 @@
 #include "itextstream.h"
 #include "fs.h"
 #include "debugging/debugging.h"
+#include <cstdint>
 
 /// \file
 /// \brief OS file-system querying and manipulation.
@@ -113,4 +114,14 @@ inline std::size_t getFileSize(const std::string& path)
 	}
 }
 
+// Returns an opaque modification stamp of the given file, which changes
+// whenever the file is written to. Returns 0 if the file cannot be queried.
+inline std::int64_t getLastModifiedStamp(const std::string& path)
+{
+	std::error_code ec;
+	auto lastWriteTime = fs::last_write_time(path, ec);
+
+	return ec ? 0 : static_cast<std::int64_t>(lastWriteTime.time_since_epoch().count());
+}
+
 } // namespace
@@ -0,0 +1,260 @@
+#pragma once
+
+#include <cmath>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include "math/Vector3.h"
+#include "math/Quaternion.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define DR_SKINNING_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace render
+{
+
+/**
+ * Vertex as produced by the skinning kernel, this is uploaded as it is
+ * to the vertex buffer of animated meshes.
+ */
+struct SkinnedVertex
+{
+    float vertex[3];
+    float normal[3];
+    float texcoord[2];
+    float tangent[3];
+    float bitangent[3];
+};
+
+/**
+ * Transformation of a joint, stored as four matrix columns: the three
+ * rotation columns (w = 0) and the joint origin (w = 1).
+ */
+struct alignas(16) SkinningJoint
+{
+    float columns[4][4];
+};
+
+/**
+ * A weight of a skinned vertex. The position relative to the joint is
+ * pre-multiplied with the weight, the weight itself is stored in w.
+ */
+struct alignas(16) SkinningWeight
+{
+    float position[4];
+    std::uint32_t joint;
+};
+
+/// The weights influencing a single vertex
+struct SkinningInfluence
+{
+    std::uint32_t firstWeight;
+    std::uint32_t numWeights;
+};
+
+/// Creates the joint transformation for the given orientation and origin
+inline SkinningJoint createSkinningJoint(const Quaternion& orientation, const Vector3& origin)
+{
+    // Same terms as Quaternion::transformPoint
+    double xx = orientation.x() * orientation.x();
+    double yy = orientation.y() * orientation.y();
+    double zz = orientation.z() * orientation.z();
+    double ww = orientation.w() * orientation.w();
+
+    double xy2 = orientation.x() * orientation.y() * 2;
+    double xz2 = orientation.x() * orientation.z() * 2;
+    double xw2 = orientation.x() * orientation.w() * 2;
+    double yz2 = orientation.y() * orientation.z() * 2;
+    double yw2 = orientation.y() * orientation.w() * 2;
+    double zw2 = orientation.z() * orientation.w() * 2;
+
+    const double columns[4][4] =
+    {
+        { ww + xx - yy - zz, xy2 + zw2, xz2 - yw2, 0 },
+        { xy2 - zw2, ww - xx + yy - zz, yz2 + xw2, 0 },
+        { yw2 + xz2, yz2 - xw2, ww - xx - yy + zz, 0 },
+        { origin.x(), origin.y(), origin.z(), 1 },
+    };
+
+    SkinningJoint joint;
+
+    for (std::size_t c = 0; c < 4; ++c)
+    {
+        for (std::size_t r = 0; r < 4; ++r)
+        {
+            joint.columns[c][r] = static_cast<float>(columns[c][r]);
+        }
+    }
+
+    return joint;
+}
+
+/// Creates a vertex weight of the given position (relative to the joint) and strength
+inline SkinningWeight createSkinningWeight(const Vector3& position, float weight, std::size_t joint)
+{
+    return SkinningWeight
+    {
+        {
+            static_cast<float>(position.x() * weight),
+            static_cast<float>(position.y() * weight),
+            static_cast<float>(position.z() * weight),
+            weight
+        },
+        static_cast<std::uint32_t>(joint)
+    };
+}
+
+namespace detail
+{
+
+inline void normaliseVector(float* v)
+{
+    float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+
+    // Zero vectors are left untouched
+    if (length > 0)
+    {
+        v[0] /= length;
+        v[1] /= length;
+        v[2] /= length;
+    }
+}
+
+// Calculates the tangent (s) and bitangent (t) of the given triangle, see ArbitraryMeshTriangle_calcTangents
+inline void calculateTangents(const SkinnedVertex& a, const SkinnedVertex& b, const SkinnedVertex& c, float* s, float* t)
+{
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        // Cross product of (b-a) and (c-a) in (position[i], u, v) space
+        float ab[3] = { b.vertex[i] - a.vertex[i], b.texcoord[0] - a.texcoord[0], b.texcoord[1] - a.texcoord[1] };
+        float ac[3] = { c.vertex[i] - a.vertex[i], c.texcoord[0] - a.texcoord[0], c.texcoord[1] - a.texcoord[1] };
+
+        float crossX = ab[1] * ac[2] - ab[2] * ac[1];
+        float crossY = ab[2] * ac[0] - ab[0] * ac[2];
+        float crossZ = ab[0] * ac[1] - ab[1] * ac[0];
+
+        if (std::fabs(crossX) > 0.000001f)
+        {
+            s[i] = -crossY / crossX;
+            t[i] = -crossZ / crossX;
+        }
+        else
+        {
+            s[i] = t[i] = 0;
+        }
+    }
+}
+
+}
+
+/**
+ * Deforms the given vertices to the pose defined by the joints, then
+ * recalculates their normals and tangent vectors from the triangles
+ * defined by the index array. The texcoords of the target vertices are
+ * expected to be set already, they are needed for the tangents.
+ *
+ * Each vertex position is the sum of its weight positions transformed
+ * by the respective joint, which is done using SSE where available.
+ */
+template<typename Index_T>
+void skinMesh(const std::vector<SkinningJoint>& joints, const std::vector<SkinningWeight>& weights,
+              const std::vector<SkinningInfluence>& influences, const std::vector<Index_T>& indices,
+              std::vector<SkinnedVertex>& vertices)
+{
+    assert(vertices.size() == influences.size());
+
+    for (std::size_t v = 0; v < influences.size(); ++v)
+    {
+        const auto& influence = influences[v];
+        auto& target = vertices[v];
+
+#ifdef DR_SKINNING_SSE
+        __m128 skinned = _mm_setzero_ps();
+
+        for (auto w = influence.firstWeight; w < influence.firstWeight + influence.numWeights; ++w)
+        {
+            const auto& weight = weights[w];
+            assert(weight.joint < joints.size());
+            const auto& joint = joints[weight.joint];
+
+            __m128 position = _mm_load_ps(weight.position);
+
+            skinned = _mm_add_ps(skinned, _mm_mul_ps(_mm_load_ps(joint.columns[0]), _mm_shuffle_ps(position, position, _MM_SHUFFLE(0, 0, 0, 0))));
+            skinned = _mm_add_ps(skinned, _mm_mul_ps(_mm_load_ps(joint.columns[1]), _mm_shuffle_ps(position, position, _MM_SHUFFLE(1, 1, 1, 1))));
+            skinned = _mm_add_ps(skinned, _mm_mul_ps(_mm_load_ps(joint.columns[2]), _mm_shuffle_ps(position, position, _MM_SHUFFLE(2, 2, 2, 2))));
+            skinned = _mm_add_ps(skinned, _mm_mul_ps(_mm_load_ps(joint.columns[3]), _mm_shuffle_ps(position, position, _MM_SHUFFLE(3, 3, 3, 3))));
+        }
+
+        alignas(16) float result[4];
+        _mm_store_ps(result, skinned);
+#else
+        float result[4] = { 0, 0, 0, 0 };
+
+        for (auto w = influence.firstWeight; w < influence.firstWeight + influence.numWeights; ++w)
+        {
+            const auto& weight = weights[w];
+            assert(weight.joint < joints.size());
+            const auto& joint = joints[weight.joint];
+
+            for (std::size_t c = 0; c < 4; ++c)
+            {
+                for (std::size_t r = 0; r < 3; ++r)
+                {
+                    result[r] += joint.columns[c][r] * weight.position[c];
+                }
+            }
+        }
+#endif
+
+        target.vertex[0] = result[0];
+        target.vertex[1] = result[1];
+        target.vertex[2] = result[2];
+
+        for (std::size_t i = 0; i < 3; ++i)
+        {
+            target.normal[i] = target.tangent[i] = target.bitangent[i] = 0;
+        }
+    }
+
+    // Accumulate the area-weighted face normals and the tangent vectors of each triangle
+    for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        auto& a = vertices[indices[i]];
+        auto& b = vertices[indices[i + 1]];
+        auto& c = vertices[indices[i + 2]];
+
+        float ca[3] = { c.vertex[0] - a.vertex[0], c.vertex[1] - a.vertex[1], c.vertex[2] - a.vertex[2] };
+        float ba[3] = { b.vertex[0] - a.vertex[0], b.vertex[1] - a.vertex[1], b.vertex[2] - a.vertex[2] };
+
+        float normal[3] =
+        {
+            ca[1] * ba[2] - ca[2] * ba[1],
+            ca[2] * ba[0] - ca[0] * ba[2],
+            ca[0] * ba[1] - ca[1] * ba[0]
+        };
+
+        float s[3], t[3];
+        detail::calculateTangents(a, b, c, s, t);
+
+        for (auto* vertex : { &a, &b, &c })
+        {
+            for (std::size_t j = 0; j < 3; ++j)
+            {
+                vertex->normal[j] += normal[j];
+                vertex->tangent[j] += s[j];
+                vertex->bitangent[j] += t[j];
+            }
+        }
+    }
+
+    for (auto& vertex : vertices)
+    {
+        detail::normaliseVector(vertex.normal);
+        detail::normaliseVector(vertex.tangent);
+        detail::normaliseVector(vertex.bitangent);
+    }
+}
+
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include "ArbitraryMeshVertex.h"
+
+namespace render
+{
+
+/**
+ * Compact storage format of a mesh vertex, as it is uploaded to the vertex
+ * buffers of static models (44 bytes, compared to the 136 bytes of an
+ * ArbitraryMeshVertex).
+ *
+ * Position and texcoords are single-precision floats, the unit-length
+ * normal and tangent vectors are stored as signed normalised shorts,
+ * the colour as unsigned normalised bytes (RGBA, alpha is always 255).
+ *
+ * Use packMeshVertex and unpackMeshVertex to convert between the two formats.
+ */
+struct PackedMeshVertex
+{
+    float vertex[3];
+    float texcoord[2];
+    std::int16_t normal[3];
+    std::int16_t tangent[3];
+    std::int16_t bitangent[3];
+    std::int16_t padding;
+    std::uint8_t colour[4];
+
+    Vector3 getVertex() const
+    {
+        return Vector3(vertex[0], vertex[1], vertex[2]);
+    }
+};
+
+static_assert(sizeof(PackedMeshVertex) == 44, "PackedMeshVertex is expected to be tightly packed");
+
+namespace detail
+{
+
+// Maps [-1..1] to [-32767..32767], as OpenGL expects it for normalised shorts
+inline std::int16_t packSnorm16(double value)
+{
+    return static_cast<std::int16_t>(std::lround(std::clamp(value, -1.0, 1.0) * 32767.0));
+}
+
+inline double unpackSnorm16(std::int16_t value)
+{
+    return std::max(value / 32767.0, -1.0);
+}
+
+inline std::uint8_t packUnorm8(double value)
+{
+    return static_cast<std::uint8_t>(std::lround(std::clamp(value, 0.0, 1.0) * 255.0));
+}
+
+inline double unpackUnorm8(std::uint8_t value)
+{
+    return value / 255.0;
+}
+
+inline void packVector(const Vector3& source, std::int16_t* target)
+{
+    target[0] = packSnorm16(source.x());
+    target[1] = packSnorm16(source.y());
+    target[2] = packSnorm16(source.z());
+}
+
+inline Vector3 unpackVector(const std::int16_t* source)
+{
+    return Vector3(unpackSnorm16(source[0]), unpackSnorm16(source[1]), unpackSnorm16(source[2]));
+}
+
+}
+
+/// Converts the given vertex to the compact format, normal and tangent vectors are expected to be normalised
+inline PackedMeshVertex packMeshVertex(const ArbitraryMeshVertex& source)
+{
+    PackedMeshVertex packed;
+
+    packed.vertex[0] = static_cast<float>(source.vertex.x());
+    packed.vertex[1] = static_cast<float>(source.vertex.y());
+    packed.vertex[2] = static_cast<float>(source.vertex.z());
+
+    packed.texcoord[0] = static_cast<float>(source.texcoord.x());
+    packed.texcoord[1] = static_cast<float>(source.texcoord.y());
+
+    detail::packVector(source.normal, packed.normal);
+    detail::packVector(source.tangent, packed.tangent);
+    detail::packVector(source.bitangent, packed.bitangent);
+    packed.padding = 0;
+
+    packed.colour[0] = detail::packUnorm8(source.colour.x());
+    packed.colour[1] = detail::packUnorm8(source.colour.y());
+    packed.colour[2] = detail::packUnorm8(source.colour.z());
+    packed.colour[3] = 255;
+
+    return packed;
+}
+
+/// Converts the compact vertex back to the double-precision format
+inline ArbitraryMeshVertex unpackMeshVertex(const PackedMeshVertex& packed)
+{
+    ArbitraryMeshVertex vertex(
+        packed.getVertex(),
+        detail::unpackVector(packed.normal),
+        TexCoord2f(packed.texcoord[0], packed.texcoord[1]),
+        Vector3(detail::unpackUnorm8(packed.colour[0]), detail::unpackUnorm8(packed.colour[1]),
+            detail::unpackUnorm8(packed.colour[2]))
+    );
+
+    vertex.tangent = detail::unpackVector(packed.tangent);
+    vertex.bitangent = detail::unpackVector(packed.bitangent);
+
+    return vertex;
+}
+
+}
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include "irender.h"
+#include "iglrender.h"
+
+namespace render
+{
+
+/**
+ * Sorts the given entries by their 64 bit key member (LSD radix sort, one byte
+ * per pass). The sort is stable: entries sharing the same key keep their relative
+ * order. Bytes that are the same in all keys are skipped, such that keys only
+ * using their lower bits are sorted in one or two passes.
+ *
+ * The buffer vector is used as temporary storage, it can be kept by the
+ * caller to avoid re-allocating it on every call.
+ */
+template<typename Entry>
+void radixSortByKey(std::vector<Entry>& entries, std::vector<Entry>& buffer)
+{
+    if (entries.size() < 2)
+    {
+        return;
+    }
+
+    // Find the bits that differ between at least two keys
+    auto firstKey = entries.front().key;
+    std::uint64_t differingBits = 0;
+
+    for (const auto& entry : entries)
+    {
+        differingBits |= entry.key ^ firstKey;
+    }
+
+    buffer.resize(entries.size());
+
+    for (unsigned int shift = 0; shift < 64; shift += 8)
+    {
+        if (((differingBits >> shift) & 0xff) == 0)
+        {
+            continue;
+        }
+
+        std::size_t offsets[256] = { 0 };
+
+        for (const auto& entry : entries)
+        {
+            ++offsets[(entry.key >> shift) & 0xff];
+        }
+
+        std::size_t total = 0;
+
+        for (auto& offset : offsets)
+        {
+            auto count = offset;
+            offset = total;
+            total += count;
+        }
+
+        for (const auto& entry : entries)
+        {
+            buffer[offsets[(entry.key >> shift) & 0xff]++] = entry;
+        }
+
+        entries.swap(buffer);
+    }
+}
+
+/**
+ * Sort key of a renderable within a single shader pass. Renderables are grouped
+ * by the render entity they belong to (the pass state needs to be re-applied
+ * for every entity), the entity index is the order the entities have been
+ * submitted in, index 0 is reserved for renderables without entity.
+ * Within an entity's group, renderables with an identity transform are put
+ * first, unless the draw order must be preserved (e.g. for blended passes).
+ */
+inline std::uint64_t getRenderableSortKey(std::size_t entityIndex, bool hasIdentityTransform, bool preserveOrder)
+{
+    return (static_cast<std::uint64_t>(entityIndex) << 1) | (preserveOrder || hasIdentityTransform ? 0 : 1);
+}
+
+/**
+ * Determines the order the shader passes are rendered in. Every frame, each
+ * non-empty pass is added to the queue, which assigns a 64 bit sort key,
+ * composed of the state which is expensive to change (most significant first):
+ *
+ * 51..63  sort position, this defines the layering and is always respected
+ * 46..50  GL program
+ * 42..45  depth test, depth write, blend and fill flags
+ * 26..41  texture0
+ * 13..25  texture1
+ *  0..12  texture2
+ *
+ * The passes are then radix-sorted by this key, such that passes sharing the
+ * same program, depth/blend state and textures are rendered in succession.
+ * Passes with equal keys keep the order they have been added in.
+ */
+template<typename Pass>
+class RenderQueue
+{
+public:
+    struct Entry
+    {
+        std::uint64_t key;
+        Pass* pass;
+    };
+
+private:
+    std::vector<Entry> _entries;
+    std::vector<Entry> _sortBuffer;
+
+    // Programs in the order they have first been encountered, the index is used in the key
+    std::vector<const GLProgram*> _programs;
+
+public:
+    // Adds the given pass with the given state, filtered by the global render flags mask
+    void add(const OpenGLState& state, unsigned int globalFlagsMask, Pass* pass)
+    {
+        _entries.push_back(Entry{ getSortKey(state, globalFlagsMask), pass });
+    }
+
+    void sort()
+    {
+        radixSortByKey(_entries, _sortBuffer);
+    }
+
+    // Removes all passes, the program indices are kept
+    void clear()
+    {
+        _entries.clear();
+    }
+
+    bool empty() const
+    {
+        return _entries.empty();
+    }
+
+    std::size_t size() const
+    {
+        return _entries.size();
+    }
+
+    typename std::vector<Entry>::const_iterator begin() const
+    {
+        return _entries.begin();
+    }
+
+    typename std::vector<Entry>::const_iterator end() const
+    {
+        return _entries.end();
+    }
+
+    std::uint64_t getSortKey(const OpenGLState& state, unsigned int globalFlagsMask)
+    {
+        constexpr unsigned int KeyedFlags[] = { RENDER_DEPTHTEST, RENDER_DEPTHWRITE, RENDER_BLEND, RENDER_FILL };
+
+        auto sortPosition = static_cast<std::uint64_t>(state.getSortPosition() - OpenGLState::SORT_FIRST);
+
+        std::uint64_t flags = 0;
+        auto requiredFlags = state.getRenderFlags() & globalFlagsMask;
+
+        for (auto flag : KeyedFlags)
+        {
+            flags = (flags << 1) | ((requiredFlags & flag) != 0 ? 1 : 0);
+        }
+
+        auto program = (requiredFlags & RENDER_PROGRAM) != 0 ? getProgramIndex(state.glProgram) : 0;
+
+        return (sortPosition & 0x1fff) << 51 |
+            (static_cast<std::uint64_t>(program) & 0x1f) << 46 |
+            flags << 42 |
+            (static_cast<std::uint64_t>(state.texture0) & 0xffff) << 26 |
+            (static_cast<std::uint64_t>(state.texture1) & 0x1fff) << 13 |
+            (static_cast<std::uint64_t>(state.texture2) & 0x1fff);
+    }
+
+private:
+    // Returns a small number identifying the given program, 0 is used for no program
+    std::size_t getProgramIndex(const GLProgram* program)
+    {
+        if (program == nullptr)
+        {
+            return 0;
+        }
+
+        auto existing = std::find(_programs.begin(), _programs.end(), program);
+
+        if (existing != _programs.end())
+        {
+            return existing - _programs.begin() + 1;
+        }
+
+        _programs.push_back(program);
+        return _programs.size();
+    }
+};
+
+}
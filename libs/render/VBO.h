@@ -27,9 +27,12 @@ namespace detail
  *
  * \param data
  * Array of data to copy into the VBO.
+ *
+ * \param usage
+ * Usage hint for the data store, GL_DYNAMIC_DRAW for data which is replaced often.
  */
 template<typename Array_T>
-GLuint makeVBOFromArray(GLenum target, const Array_T& data)
+GLuint makeVBOFromArray(GLenum target, const Array_T& data, GLenum usage = GL_STATIC_DRAW)
 {
     // Create and bind
     GLuint vboID = 0;
@@ -37,7 +40,7 @@ GLuint makeVBOFromArray(GLenum target, const Array_T& data)
     glBindBuffer(target, vboID);
 
     // Copy data
-    glBufferData(target, detail::byteSize(data), &data.front(), GL_STATIC_DRAW);
+    glBufferData(target, detail::byteSize(data), &data.front(), usage);
 
     // Return the VBO identifier
     return vboID;
@@ -65,6 +65,24 @@ public:
 	}
 };
 
+Vector3 getChildPrimitiveOrigin(const scene::INodePtr& entityNode)
+{
+	Entity* entity = Node_getEntity(entityNode);
+
+	// Same checks as in OriginRemover
+	if (entity != nullptr && !entity->isWorldspawn())
+	{
+		scene::GroupNodePtr groupNode = Node_getGroupNode(entityNode);
+
+		if (groupNode)
+		{
+			return groupNode->getChildPrimitiveOrigin();
+		}
+	}
+
+	return Vector3(0, 0, 0);
+}
+
 void addOriginToChildPrimitives(const scene::INodePtr& root)
 {
 	// Disable texture lock during this process
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include "math/Vector3.h"
 
 // Forward Decl.
 namespace scene { class INode; typedef std::shared_ptr<INode> INodePtr; }
@@ -19,4 +20,12 @@ void addOriginToChildPrimitives(const scene::INodePtr& root);
  */
 void removeOriginFromChildPrimitives(const scene::INodePtr& root);
 
+/**
+ * Returns the origin the child primitives of the given entity node are
+ * positioned relative to when writing them to a map file. This is the
+ * offset removeOriginFromChildPrimitives() would subtract from them,
+ * a zero vector for worldspawn and non-group entities.
+ */
+Vector3 getChildPrimitiveOrigin(const scene::INodePtr& entityNode);
+
 } // namespace
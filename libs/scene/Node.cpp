@@ -2,6 +2,8 @@
 
 #include "itransformnode.h"
 #include "iscenegraph.h"
+#include "imap.h"
+#include "ilayer.h"
 #include "debugging/debugging.h"
 #include "InstanceWalkers.h"
 #include "AABBAccumulateWalker.h"
@@ -39,6 +41,8 @@ Node::Node(const Node& other) :
 	_boundsMutex(false),
 	_childBoundsChanged(true),
 	_childBoundsMutex(false),
+	_transformChanged(true),
+	_transformMutex(false),
 	_local2world(other._local2world),
 	_instantiated(false),
 	_forceVisible(false),
@@ -108,27 +112,35 @@ bool Node::excluded() const
 
 void Node::addToLayer(int layerId)
 {
+	auto oldLayers = _layers;
 	_layers.insert(layerId);
+
+	onLayersChanged(oldLayers);
 }
 
 void Node::moveToLayer(int layerId)
 {
+	auto oldLayers = _layers;
 	_layers.clear();
 	_layers.insert(layerId);
+
+	onLayersChanged(oldLayers);
 }
 
 void Node::removeFromLayer(int layerId)
 {
 	// Look up the layer ID and remove it from the list
-	LayerList::iterator found = _layers.find(layerId);
-
-	if (found != _layers.end()) {
-		_layers.erase(found);
+	if (_layers.count(layerId) > 0)
+	{
+		auto oldLayers = _layers;
+		_layers.erase(layerId);
 
 		// greebo: Make sure that every node is at least member of layer 0
 		if (_layers.empty()) {
 			_layers.insert(0);
 		}
+
+		onLayersChanged(oldLayers);
 	}
 }
 
@@ -141,10 +153,29 @@ void Node::assignToLayers(const LayerList& newLayers)
 {
 	if (!newLayers.empty())
     {
+		auto oldLayers = _layers;
         _layers = newLayers;
+
+		onLayersChanged(oldLayers);
     }
 }
 
+void Node::onLayersChanged(const LayerList& oldLayers)
+{
+	// The layer manager of the scene keeps track of the layer members
+	if (!_instantiated || oldLayers == _layers || getNodeType() == INode::Type::MapRoot)
+	{
+		return;
+	}
+
+	auto root = getRootNode();
+
+	if (root)
+	{
+		root->getLayerManager().onNodeLayersChanged(*this, oldLayers, _layers);
+	}
+}
+
 void Node::addChildNode(const INodePtr& node)
 {
 	// Add the node to the TraversableNodeSet, this triggers an
@@ -276,10 +307,20 @@ void Node::onChildRemoved(const INodePtr& child)
 void Node::onInsertIntoScene(IMapRootNode& root)
 {
 	_instantiated = true;
+
+	if (getNodeType() != INode::Type::MapRoot)
+	{
+		root.getLayerManager().onNodeLayersChanged(*this, LayerList(), _layers);
+	}
 }
 
 void Node::onRemoveFromScene(IMapRootNode& root)
 {
+	if (getNodeType() != INode::Type::MapRoot)
+	{
+		root.getLayerManager().onNodeLayersChanged(*this, _layers, LayerList());
+	}
+
 	_instantiated = false;
 }
 
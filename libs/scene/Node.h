@@ -214,6 +214,9 @@ private:
 	void evaluateBounds() const;
 	void evaluateChildBounds() const;
 	void evaluateTransform() const;
+
+	// Notifies the layer manager of the scene about changed layer memberships
+	void onLayersChanged(const LayerList& oldLayers);
 };
 
 typedef std::shared_ptr<Node> NodePtr;
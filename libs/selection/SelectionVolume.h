@@ -104,14 +104,12 @@ public:
 
     void TestTriangles(const VertexPointer& vertices, const IndexPointer& indices, SelectionIntersection& best) override
     {
-        Vector4 clipped[9];
-        for (IndexPointer::iterator i(indices.begin()); i != indices.end(); i += 3)
-        {
-            BestPoint(clipTriangle(_local2view, vertices[*i],
-                                   vertices[*(i + 1)], vertices[*(i + 2)],
-                                   clipped),
-                      clipped, best, _cull);
-        }
+        testTriangles(vertices, indices, best);
+    }
+
+    void TestTriangles(const FloatVertexPointer& vertices, const IndexPointer& indices, SelectionIntersection& best) override
+    {
+        testTriangles(vertices, indices, best);
     }
 
     void TestQuads(const VertexPointer& vertices, const IndexPointer& indices, SelectionIntersection& best) override
@@ -145,6 +143,20 @@ public:
                       clipped, best, _cull);
         }
     }
+
+private:
+    template<typename VertexPointerType>
+    void testTriangles(const VertexPointerType& vertices, const IndexPointer& indices, SelectionIntersection& best)
+    {
+        Vector4 clipped[9];
+        for (IndexPointer::iterator i(indices.begin()); i != indices.end(); i += 3)
+        {
+            BestPoint(clipTriangle(_local2view, vertices[*i],
+                                   vertices[*(i + 1)], vertices[*(i + 2)],
+                                   clipped),
+                      clipped, best, _cull);
+        }
+    }
 };
 
 // --------------------------------------------------------------------------------
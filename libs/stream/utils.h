@@ -72,4 +72,28 @@ inline InputStream::byte_type readByte(InputStream& stream)
 	return value;
 }
 
+/**
+ * Reads up to length bytes from the given stream into the buffer, unlike
+ * InputStream::read() this keeps reading until the requested amount has been
+ * retrieved or the stream is exhausted. Returns the number of bytes read.
+ */
+inline std::size_t readBlock(InputStream& stream, InputStream::byte_type* buffer, std::size_t length)
+{
+	std::size_t totalBytesRead = 0;
+
+	while (totalBytesRead < length)
+	{
+		auto bytesRead = stream.read(buffer + totalBytesRead, length - totalBytesRead);
+
+		if (bytesRead == 0)
+		{
+			break;
+		}
+
+		totalBytesRead += bytesRead;
+	}
+
+	return totalBytesRead;
+}
+
 }
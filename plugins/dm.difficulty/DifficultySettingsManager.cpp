@@ -219,6 +219,9 @@ void DifficultySettingsManager::saveSettings()
         entities.push_back(&entNode->getEntity());
     }
 
+    // Collect the spawnarg changes, observers are notified once per key at the end
+    KeyValueChangeScope changeScope;
+
     // Clear all difficulty-spawnargs from existing entities
     for (DifficultyEntityFinder::EntityList::const_iterator i = entities.begin();
          i != entities.end(); i++)
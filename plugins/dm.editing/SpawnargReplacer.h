@@ -61,6 +61,9 @@ public:
 
 	void processEntities()
 	{
+		// Defer the key observers until all values have been replaced
+		KeyValueChangeScope changeScope;
+
 		for (EntityKeyMap::const_iterator e = _entityMap.begin();
 			 e != _entityMap.end(); ++e)
 		{
@@ -164,7 +164,7 @@ void ModelInterface::registerInterface(py::module& scope, py::dict& globals)
 	surface.def(py::init<const model::IModelSurface&>());
 	surface.def("getNumVertices", &ScriptModelSurface::getNumVertices);
 	surface.def("getNumTriangles", &ScriptModelSurface::getNumTriangles);
-	surface.def("getVertex", &ScriptModelSurface::getVertex, py::return_value_policy::reference);
+	surface.def("getVertex", &ScriptModelSurface::getVertex, py::return_value_policy::copy);
 	surface.def("getPolygon", &ScriptModelSurface::getPolygon);
 	surface.def("getDefaultMaterial", &ScriptModelSurface::getDefaultMaterial);
 	surface.def("getActiveMaterial", &ScriptModelSurface::getActiveMaterial);
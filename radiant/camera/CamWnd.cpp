@@ -806,6 +806,8 @@ void CamWnd::Cam_Draw()
         );
         GlobalRenderSystem().render(allowedRenderFlags, _camera->getModelView(),
                                     _camera->getProjection(), _view.getViewer());
+
+        _renderStats.setStateChangeCount(GlobalRenderSystem().getStateChangeCount());
     }
 
     // greebo: Draw the clipper's points (skipping the depth-test)
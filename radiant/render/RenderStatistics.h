@@ -19,6 +19,9 @@ class RenderStatistics
     int _visibleLights = 0;
     int _totalLights = 0;
 
+    // GL state changes performed by the render back-end
+    std::size_t _stateChanges = 0;
+
 public:
 
     /// Return the constructed string for display
@@ -30,6 +33,7 @@ public:
 
         return "lights: " + std::to_string(_visibleLights)
              + " / " + std::to_string(_totalLights)
+             + " | state changes: " + std::to_string(_stateChanges)
              + " | f/e: " + std::to_string(_feTime) + " ms"
              + " | b/e: " + std::to_string(beTime) + " ms"
              + " | tot: " + std::to_string(totTime) + " ms"
@@ -49,10 +53,17 @@ public:
         _totalLights += total;
     }
 
+    /// Set the number of GL state changes of the back-end render pass
+    void setStateChangeCount(std::size_t count)
+    {
+        _stateChanges = count;
+    }
+
     /// Reset statistics at the beginning of a frame render
     void resetStats()
     {
         _visibleLights = _totalLights = 0;
+        _stateChanges = 0;
 
         _feTime = 0;
         _timer.Start();
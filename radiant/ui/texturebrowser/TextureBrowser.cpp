@@ -63,6 +63,9 @@ public:
     Vector2i position;
     MaterialPtr material;
 
+    // The thumbnail of this material, empty if it's still being generated
+    image::Thumbnail::Ptr thumbnail;
+
     TextureTile(TextureBrowser& owner) :
         _owner(owner)
     {}
@@ -72,6 +75,13 @@ public:
         return _owner.materialIsVisible(material);
     }
 
+    // True if this tile is overlapping the visible part of the viewport
+    bool isInViewport()
+    {
+        return (position.y() - size.y() - FONT_HEIGHT() < _owner.getOriginY()) &&
+            (position.y() > _owner.getOriginY() - _owner.getViewportHeight());
+    }
+
     void render(bool drawName)
     {
         if (!isVisible())
@@ -79,15 +89,19 @@ public:
             return;
         }
 
-        TexturePtr texture = material->getEditorImage();
-        if (!texture) return;
-
         // Is this texture visible?
-        if ((position.y() - size.y() - FONT_HEIGHT() < _owner.getOriginY()) &&
-            (position.y() > _owner.getOriginY() - _owner.getViewportHeight()))
+        if (isInViewport())
         {
             drawBorder();
-            drawTextureQuad(texture->getGLTexNum());
+
+            // Tiles waiting for their thumbnail are drawn without the quad
+            auto texture = _owner.getTileTexture(*this);
+
+            if (texture)
+            {
+                drawTextureQuad(texture->getGLTexNum());
+            }
+
             if (drawName)
                 drawTextureName();
         }
@@ -233,7 +247,10 @@ TextureBrowser::TextureBrowser(wxWindow* parent) :
     _showOtherMaterials(registry::getValue<bool>(RKEY_TEXTURES_SHOW_OTHER_MATERIALS)),
     _uniformTextureSize(registry::getValue<int>(RKEY_TEXTURE_UNIFORM_SIZE)),
     _maxNameLength(registry::getValue<int>(RKEY_TEXTURE_MAX_NAME_LENGTH)),
-    _updateNeeded(true)
+    _updateNeeded(true),
+    _thumbnailTexturesNeedPurge(false),
+    _thumbnailGeneration(0),
+    _thumbnailsPending(false)
 {
     observeKey(RKEY_TEXTURES_HIDE_UNUSED);
     observeKey(RKEY_TEXTURES_SHOW_OTHER_MATERIALS);
@@ -461,14 +478,14 @@ void TextureBrowser::onFavouritesChanged()
 }
 
 // Return the display width of a texture in the texture browser
-int TextureBrowser::getTextureWidth(const Texture& tex) const
+int TextureBrowser::getTextureWidth(std::size_t width, std::size_t height) const
 {
     if (!_useUniformScale)
     {
         // Don't use uniform scale
-        return static_cast<int>(tex.getWidth() * (static_cast<float>(_textureScale) / 100));
+        return static_cast<int>(width * (static_cast<float>(_textureScale) / 100));
     }
-    else if (tex.getWidth() >= tex.getHeight())
+    else if (width >= height)
     {
         // Texture is square, or wider than it is tall
         return _uniformTextureSize;
@@ -477,19 +494,19 @@ int TextureBrowser::getTextureWidth(const Texture& tex) const
     {
         // Otherwise, preserve the texture's aspect ratio
         return static_cast<int>(_uniformTextureSize *
-            (static_cast<float>(tex.getWidth()) / tex.getHeight())
+            (static_cast<float>(width) / height)
         );
     }
 }
 
-int TextureBrowser::getTextureHeight(const Texture& tex) const
+int TextureBrowser::getTextureHeight(std::size_t width, std::size_t height) const
 {
     if (!_useUniformScale)
     {
         // Don't use uniform scale
-        return static_cast<int>(tex.getHeight() * (static_cast<float>(_textureScale) / 100));
+        return static_cast<int>(height * (static_cast<float>(_textureScale) / 100));
     }
-    else if (tex.getHeight() >= tex.getWidth())
+    else if (height >= width)
     {
         // Texture is square, or taller than it is wide
         return _uniformTextureSize;
@@ -499,7 +516,7 @@ int TextureBrowser::getTextureHeight(const Texture& tex) const
         // Otherwise, preserve the texture's aspect ratio
         return static_cast<int>(
             _uniformTextureSize
-            * (static_cast<float>(tex.getHeight()) / tex.getWidth())
+            * (static_cast<float>(height) / width)
         );
     }
 }
@@ -536,10 +553,10 @@ public:
 };
 
 TextureBrowser::Vector2i TextureBrowser::getPositionForTexture(
-    CurrentPosition& currentPos, const Texture& tex) const
+    CurrentPosition& currentPos, std::size_t width, std::size_t height) const
 {
-    int nWidth = getTextureWidth(tex);
-    int nHeight = getTextureHeight(tex);
+    int nWidth = getTextureWidth(width, height);
+    int nHeight = getTextureHeight(width, height);
 
     // Wrap to the next row if there is not enough horizontal space for this
     // texture
@@ -674,9 +691,8 @@ void TextureBrowser::performUpdate()
 
     // Update all renderable items
     _tiles.clear();
+    _thumbnailTexturesNeedPurge = true;
 
-    CurrentPosition layout;
-    _entireSpaceHeight = 0;
     // Update the favourites
     _favourites = GlobalFavouritesManager().getFavourites(decl::Type::Material);
 
@@ -687,27 +703,128 @@ void TextureBrowser::performUpdate()
             return;
         }
 
-        // Create a new tile for this material
+        // Create a new tile for this material, the thumbnail
+        // is requested once the tile is scrolled into view
         _tiles.push_back(TextureTile(*this));
-        TextureTile& tile = _tiles.back();
+        _tiles.back().material = mat;
+    });
 
-        tile.material = mat;
+    layoutTiles();
+}
 
-        Texture& texture = *tile.material->getEditorImage();
+void TextureBrowser::layoutTiles()
+{
+    CurrentPosition layout;
+    _entireSpaceHeight = 0;
 
-        tile.position = getPositionForTexture(layout, texture);
-        tile.size.x() = getTextureWidth(texture);
-        tile.size.y() = getTextureHeight(texture);
+    for (auto& tile : _tiles)
+    {
+        // The layout is based on the size of the full image, which is known
+        // from the thumbnail without having to load the editor image.
+        // Tiles without thumbnail are using the placeholder size.
+        std::size_t width = _uniformTextureSize;
+        std::size_t height = _uniformTextureSize;
+
+        if (tile.thumbnail && tile.thumbnail->image)
+        {
+            width = tile.thumbnail->sourceWidth;
+            height = tile.thumbnail->sourceHeight;
+        }
+        else if (tile.thumbnail)
+        {
+            // No thumbnail support for this material, fall back to the editor image
+            Texture& texture = *tile.material->getEditorImage();
+            width = texture.getWidth();
+            height = texture.getHeight();
+        }
+
+        tile.position = getPositionForTexture(layout, width, height);
+        tile.size.x() = getTextureWidth(width, height);
+        tile.size.y() = getTextureHeight(width, height);
 
         _entireSpaceHeight = std::max(
             _entireSpaceHeight,
             abs(tile.position.y()) + FONT_HEIGHT() + tile.size.y() + TILE_BORDER
         );
-    });
+    }
 
     updateScroll();
 }
 
+bool TextureBrowser::requestVisibleThumbnails()
+{
+    auto& thumbnailCache = GlobalThumbnailCache();
+    _thumbnailGeneration = thumbnailCache.getGeneration();
+    _thumbnailsPending = false;
+
+    bool layoutChanged = false;
+
+    for (auto& tile : _tiles)
+    {
+        if (tile.thumbnail || !tile.isVisible() || !tile.isInViewport())
+        {
+            continue;
+        }
+
+        tile.thumbnail = thumbnailCache.getThumbnail(tile.material->getName());
+
+        if (!tile.thumbnail)
+        {
+            _thumbnailsPending = true;
+            continue;
+        }
+
+        // The tile has been laid out with the placeholder size
+        layoutChanged = true;
+    }
+
+    return layoutChanged;
+}
+
+TexturePtr TextureBrowser::getTileTexture(const TextureTile& tile)
+{
+    if (!tile.thumbnail)
+    {
+        return TexturePtr();
+    }
+
+    if (!tile.thumbnail->image)
+    {
+        return tile.material->getEditorImage();
+    }
+
+    auto& texture = _thumbnailTextures[tile.material->getName()];
+
+    if (!texture)
+    {
+        texture = tile.thumbnail->image->bindTexture(tile.material->getName(), BindableTexture::Role::COLOUR);
+    }
+
+    return texture;
+}
+
+void TextureBrowser::purgeThumbnailTextures()
+{
+    std::set<std::string> usedNames;
+
+    for (const auto& tile : _tiles)
+    {
+        usedNames.insert(tile.material->getName());
+    }
+
+    for (auto i = _thumbnailTextures.begin(); i != _thumbnailTextures.end();)
+    {
+        if (usedNames.count(i->first) == 0)
+        {
+            _thumbnailTextures.erase(i++);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
 void TextureBrowser::onActiveShadersChanged()
 {
     queueUpdate();
@@ -805,6 +922,20 @@ void TextureBrowser::draw()
 
 	debug::assertNoGlErrors();
 
+    // Thumbnail textures of tiles that are gone are released with the context current
+    if (_thumbnailTexturesNeedPurge)
+    {
+        _thumbnailTexturesNeedPurge = false;
+        purgeThumbnailTextures();
+    }
+
+    // Request the thumbnails of the tiles in view, the tiles
+    // arriving with a different size are moving the ones after them
+    if (requestVisibleThumbnails())
+    {
+        layoutTiles();
+    }
+
     glEnable (GL_TEXTURE_2D);
 	glPolygonMode (GL_FRONT_AND_BACK, GL_FILL);
 
@@ -1001,6 +1132,13 @@ void TextureBrowser::onGLMouseButtonRelease(wxMouseEvent& ev)
 
 void TextureBrowser::onIdle(wxIdleEvent& ev)
 {
+    // Redraw once new thumbnails have arrived, the visible tiles will pick them up
+    if (_thumbnailsPending && _thumbnailGeneration != GlobalThumbnailCache().getGeneration())
+    {
+        _thumbnailsPending = false;
+        queueDraw();
+    }
+
     if (_updateNeeded)
     {
         performUpdate();
@@ -3,6 +3,7 @@
 #include <sigc++/connection.h>
 #include "iregistry.h"
 #include "icommandsystem.h"
+#include "ithumbnailcache.h"
 #include "wxutil/FreezePointer.h"
 
 #include "texturelib.h"
@@ -10,6 +11,7 @@
 #include "registry/CachedKey.h"
 
 #include "TextureBrowserManager.h"
+#include <map>
 #include <wx/panel.h>
 
 namespace wxutil
@@ -131,6 +133,18 @@ class TextureBrowser :
     // renderable items will be updated next round
     bool _updateNeeded;
 
+    // Uploaded thumbnail textures of the visible tiles, by material name
+    std::map<std::string, TexturePtr> _thumbnailTextures;
+
+    // Set when the tiles changed, unused thumbnail textures are released on next draw
+    bool _thumbnailTexturesNeedPurge;
+
+    // The thumbnail cache generation the visible tiles have been requested with
+    std::size_t _thumbnailGeneration;
+
+    // True if at least one tile is still waiting for its thumbnail
+    bool _thumbnailsPending;
+
 public:
     // Constructor
     TextureBrowser(wxWindow* parent);
@@ -162,18 +176,32 @@ private:
     // Actually updates the renderable items (usually done before rendering)
     void performUpdate();
 
+    // Calculates the tile positions and the scrollable height
+    void layoutTiles();
+
+    // Requests the thumbnails of the tiles in the viewport which don't have one yet.
+    // Returns true if a thumbnail arrived, which requires the tiles to be laid out again.
+    bool requestVisibleThumbnails();
+
     // This gets called by the ShaderSystem
     void onActiveShadersChanged();
 
-    // Return the display width/height of a texture in the texture browser
-    int getTextureWidth(const Texture& tex) const;
-    int getTextureHeight(const Texture& tex) const;
+    // Return the display width/height of a texture of the given size in the texture browser
+    int getTextureWidth(std::size_t width, std::size_t height) const;
+    int getTextureHeight(std::size_t width, std::size_t height) const;
 
-    // Get a new position for the given texture, and advance the CurrentPosition
+    // Get a new position for a texture of the given size, and advance the CurrentPosition
     // state object.
     class CurrentPosition;
     Vector2i getPositionForTexture(CurrentPosition& layout,
-                                   const Texture& texture) const;
+                                   std::size_t width, std::size_t height) const;
+
+    // Returns the GL texture to render the given tile with, uploading the thumbnail
+    // if necessary. Returns an empty pointer if the thumbnail is not available yet.
+    TexturePtr getTileTexture(const TextureTile& tile);
+
+    // Releases the thumbnail textures which are not used by any tile
+    void purgeThumbnailTextures();
 
     bool checkSeekInMediaBrowser(); // sensitivity check
     void onSeekInMediaBrowser();
@@ -110,6 +110,7 @@ Face::Face(Brush& owner, const Face& other) :
     m_plane(other.m_plane),
     _shader(other._shader.getMaterialName(), _owner.getBrushNode().getRenderSystem()),
     _texdef(other.getProjection()),
+    m_winding(other.m_winding),
     _undoStateSaver(nullptr),
     _faceIsVisible(other._faceIsVisible)
 {
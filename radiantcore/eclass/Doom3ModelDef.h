@@ -13,6 +13,11 @@ class Doom3ModelDef :
 private:
 	std::size_t _parseStamp;
 
+	// The mesh, skin and anims as declared, before inheriting from the parent
+	std::string _declaredMesh;
+	std::string _declaredSkin;
+	Anims _declaredAnims;
+
 public:
     using Ptr = std::shared_ptr<Doom3ModelDef>;
 
@@ -47,6 +52,35 @@ public:
 		anims.clear();
 		modName = "base";
         defFilename.clear();
+
+		_declaredMesh.clear();
+		_declaredSkin.clear();
+		_declaredAnims.clear();
+	}
+
+	// Drops everything inherited from the parent, restoring the declared
+	// mesh, skin and anims before resolving the inheritance again
+	void resetInheritance()
+	{
+		resolved = false;
+		mesh = _declaredMesh;
+		skin = _declaredSkin;
+		anims = _declaredAnims;
+	}
+
+	// Replaces the contents of this def with the ones of the given freshly
+	// parsed def, keeping this object and its name
+	void takeContentsFrom(const Doom3ModelDef& parsed)
+	{
+		parent = parsed.parent;
+		modName = parsed.modName;
+		defFilename = parsed.defFilename;
+
+		_declaredMesh = parsed._declaredMesh;
+		_declaredSkin = parsed._declaredSkin;
+		_declaredAnims = parsed._declaredAnims;
+
+		resetInheritance();
 	}
 
 	// Reads the data from the given tokens into the member variables
@@ -100,6 +134,10 @@ public:
 	            state = NONE;
 	        }
 	    }
+
+		_declaredMesh = mesh;
+		_declaredSkin = skin;
+		_declaredAnims = anims;
 	}
 };
 
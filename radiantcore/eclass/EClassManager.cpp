@@ -14,6 +14,7 @@
 #include "Doom3ModelDef.h"
 
 #include "string/case_conv.h"
+#include "ThreadPool.h"
 #include <functional>
 
 #include "debugging/ScopedDebugTimer.h"
@@ -21,12 +22,53 @@
 
 namespace eclass {
 
+namespace
+{
+    // The names recorded in the file tracker, entityDefs and models share the DEF files
+    inline std::string getEntityDefDeclName(const std::string& name)
+    {
+        return "entityDef " + name;
+    }
+
+    inline std::string getModelDeclName(const std::string& name)
+    {
+        return "model " + name;
+    }
+}
+
+struct EClassManager::ParsedDefFile
+{
+    std::string modName;
+
+    // The declarations in the order they appear in the file
+    std::vector<EntityClass::Ptr> entityClasses;
+    std::vector<Doom3ModelDef::Ptr> models;
+
+    std::set<std::string> getDeclNames() const
+    {
+        std::set<std::string> names;
+
+        for (const auto& eclass : entityClasses)
+        {
+            names.insert(getEntityDefDeclName(eclass->getName()));
+        }
+
+        for (const auto& model : models)
+        {
+            names.insert(getModelDeclName(model->name));
+        }
+
+        return names;
+    }
+};
+
 // Constructor
 EClassManager::EClassManager() :
     _realised(false),
     _defLoader(std::bind(&EClassManager::loadDefAndResolveInheritance, this),
                std::bind(&EClassManager::onDefLoadingCompleted, this)),
-	_curParseStamp(0)
+	_curParseStamp(0),
+    _defFiles("def/", "def")
 {}
 
 sigc::signal<void> EClassManager::defsLoadingSignal() const
@@ -132,24 +174,117 @@ void EClassManager::resolveModelInheritance(const std::string& name, const Doom3
 	}
 }
 
-void EClassManager::parseDefFiles()
+void EClassManager::parseDefFiles(const std::vector<vfs::FileInfo>& files)
 {
-	rMessage() << "searching vfs directory 'def' for *.def\n";
-
 	// Increase the parse stamp for this run
 	_curParseStamp++;
 
 	{
 		ScopedDebugTimer timer("EntityDefs parsed: ");
-        GlobalFileSystem().forEachFile(
-            "def/", "def",
-            [&](const vfs::FileInfo& fileInfo) { parseFile(fileInfo); }
-        );
+
+        util::ThreadPool workers;
+        std::vector<std::future<ParsedDefFile>> parsedFiles;
+
+        for (const auto& fileInfo : files)
+        {
+            parsedFiles.emplace_back(workers.submit([fileInfo]() { return parseDefFile(fileInfo); }));
+        }
+
+        // The contents of the existing classes will be replaced,
+        // drop all references to the attributes of their parents
+        for (const auto& pair : _entityClasses)
+        {
+            pair.second->resetInheritance();
+        }
+
+        // Merge the results in the order the VFS has been listing the files,
+        // such that the outcome is the same as parsing them one after the other
+        for (std::size_t i = 0; i < parsedFiles.size(); ++i)
+        {
+            auto result = parsedFiles[i].get();
+
+            _defFiles.setDeclaredNames(files[i].fullPath(), result.getDeclNames());
+            mergeDefFile(result);
+        }
 	}
 }
 
+std::map<std::string, EClassManager::ParsedDefFile> EClassManager::parseDefFilesInParallel(
+    const std::vector<vfs::FileInfo>& files)
+{
+    util::ThreadPool workers;
+    std::vector<std::future<ParsedDefFile>> parsedFiles;
+
+    for (const auto& fileInfo : files)
+    {
+        parsedFiles.emplace_back(workers.submit([fileInfo]() { return parseDefFile(fileInfo); }));
+    }
+
+    std::map<std::string, ParsedDefFile> result;
+
+    for (std::size_t i = 0; i < parsedFiles.size(); ++i)
+    {
+        result.emplace(files[i].fullPath(), parsedFiles[i].get());
+    }
+
+    return result;
+}
+
+void EClassManager::parseChangedDefFiles(const decl::DeclFileTracker::Changes& changes)
+{
+    _curParseStamp++;
+
+    auto affectedPaths = changes.getAffectedPaths();
+
+    // The declarations of the changed and removed files, before and after the change
+    auto affectedNames = _defFiles.getDeclaredNames(affectedPaths);
+    auto parsedFiles = parseDefFilesInParallel(changes.changedFiles);
+
+    for (const auto& fileInfo : changes.removedFiles)
+    {
+        _defFiles.setDeclaredNames(fileInfo.fullPath(), {});
+    }
+
+    for (const auto& pair : parsedFiles)
+    {
+        auto names = pair.second.getDeclNames();
+        affectedNames.insert(names.begin(), names.end());
+
+        _defFiles.setDeclaredNames(pair.first, std::move(names));
+    }
+
+    // The unchanged files declaring any of these names compete for them, the
+    // file listed last by the VFS wins. These need to be parsed again too.
+    auto files = _defFiles.getFilesDeclaring(affectedNames, affectedPaths);
+    auto otherParsedFiles = parseDefFilesInParallel(files);
+
+    parsedFiles.insert(std::make_move_iterator(otherParsedFiles.begin()),
+        std::make_move_iterator(otherParsedFiles.end()));
+
+    files.insert(files.end(), changes.changedFiles.begin(), changes.changedFiles.end());
+    _defFiles.sortInScanOrder(files);
+
+    for (const auto& pair : _entityClasses)
+    {
+        pair.second->resetInheritance();
+    }
+
+    // Merge the affected declarations in VFS order, like a full load would do
+    for (const auto& fileInfo : files)
+    {
+        mergeDefFile(parsedFiles.at(fileInfo.fullPath()), &affectedNames);
+    }
+}
+
 void EClassManager::resolveInheritance()
 {
+    // Start over with the declared contents of every modelDef, an unchanged
+    // model might inherit from one that changed since the last run
+    for (const auto& pair : _models)
+    {
+        pair.second->resetInheritance();
+    }
+
 	// Resolve inheritance on the model classes
     for (Models::value_type& pair : _models)
     {
@@ -157,14 +292,73 @@ void EClassManager::resolveInheritance()
     }
 
     // Resolve inheritance for the entities. At this stage the classes
-    // will have the name of their parent, but not an actual pointer to
-    // it
-    for (EntityClasses::value_type& pair : _entityClasses)
-	{
-		// Tell the class to resolve its own inheritance using the given
-		// map as a source for parent lookup
-        pair.second->resolveInheritance(_entityClasses);
+    // will have the name of their parent, but not an actual pointer to it.
+    // Sort the classes such that every parent is resolved before its children,
+    // the children will then be able to take over the parent's attribute list.
+    std::map<EntityClass*, std::vector<EntityClass*>> children;
+    // The classes to resolve, together with their parent
+    std::vector<std::pair<EntityClass*, EntityClass*>> resolveQueue;
+
+    for (const auto& pair : _entityClasses)
+    {
+        pair.second->resetInheritance();
+
+        const auto& parentName = pair.second->getParentName();
+
+        if (parentName.empty() || parentName == pair.first)
+        {
+            resolveQueue.emplace_back(pair.second.get(), nullptr);
+            continue;
+        }
+
+        auto parent = _entityClasses.find(parentName);
+
+        if (parent == _entityClasses.end())
+        {
+            rWarning() << "[eclassmgr] Entity class "
+                << pair.first << " specifies unknown parent class "
+                << parentName << std::endl;
+
+            resolveQueue.emplace_back(pair.second.get(), nullptr);
+            continue;
+        }
+
+        children[parent->second.get()].push_back(pair.second.get());
+    }
+
+    // Breadth-first walk, starting at the classes without a parent
+    for (std::size_t i = 0; i < resolveQueue.size(); ++i)
+    {
+        auto* eclass = resolveQueue[i].first;
+        eclass->resolveInheritance(resolveQueue[i].second);
+
+        auto found = children.find(eclass);
+
+        if (found == children.end()) continue;
+
+        for (auto* child : found->second)
+        {
+            resolveQueue.emplace_back(child, eclass);
+        }
+    }
+
+    // Classes still unresolved are part of an inheritance loop (or derived from one)
+    if (resolveQueue.size() < _entityClasses.size())
+    {
+        for (const auto& pair : _entityClasses)
+        {
+            if (!pair.second->isInheritanceResolved())
+            {
+                rWarning() << "[eclassmgr] Entity class " << pair.first
+                    << " has circular inheritance" << std::endl;
+
+                pair.second->resolveInheritance(nullptr);
+            }
+        }
+    }
 
+    for (const auto& pair : _entityClasses)
+	{
         // If the entity has a model path ("model" key), lookup the actual
         // model and apply its mesh and skin to this entity.
         if (!pair.second->getModelPath().empty())
@@ -180,6 +374,22 @@ void EClassManager::resolveInheritance()
     }
 }
 
+bool EClassManager::isModelDefParsedInCurrentRun(const std::string& name) const
+{
+    std::set<std::string> visited; // guard against inheritance loops
+
+    for (auto i = _models.find(name); i != _models.end() && visited.insert(i->first).second;
+         i = _models.find(i->second->parent))
+    {
+        if (i->second->getParseStamp() == _curParseStamp)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 void EClassManager::ensureDefsLoaded()
 {
     _defLoader.ensureFinished();
@@ -195,7 +405,9 @@ void EClassManager::loadDefAndResolveInheritance()
         eclass.second->blockChangedSignal(true);
     }
 
-    parseDefFiles();
+    rMessage() << "searching vfs directory 'def' for *.def\n";
+
+    parseDefFiles(_defFiles.scan());
     resolveInheritance();
     applyColours();
 
@@ -254,6 +466,7 @@ void EClassManager::unrealise()
 	{
         // This waits for any threaded work to finish
         _defLoader.reset();
+        _defFiles.clear();
        	_realised = false;
     }
 }
@@ -286,17 +499,70 @@ void EClassManager::forEachModelDef(const std::function<void(const IModelDefPtr&
 
 void EClassManager::reloadDefs()
 {
-	// greebo: Leave all current entityclasses as they are, just invoke the
-	// FileLoader again. It will parse the files again, and look up
-	// the eclass names in the existing map. If found, the eclass
-	// will be asked to clear itself and re-parse from the tokens.
+    ensureDefsLoaded();
+
+	// greebo: Leave all current entityclasses as they are, just parse the
+	// files that have been changed or added since the last scan, plus the
+	// ones competing with them for the same names. The eclass
+	// names are looked up in the existing map. If found, the eclass
+	// will be asked to take over the newly parsed contents.
 	// This is to assure that any IEntityClassPtrs remain intact during
 	// the process, only the class contents change.
-	parseDefFiles();
+    auto changes = _defFiles.scanForChanges();
+
+    if (changes.empty())
+    {
+        rMessage() << "[eclassmgr] No changed DEF files found" << std::endl;
+        return;
+    }
+
+    rMessage() << "[eclassmgr] Reloading " << changes.changedFiles.size() << " changed DEF files, " <<
+        changes.removedFiles.size() << " files have been removed" << std::endl;
 
-	// Resolve the eclass inheritance again
+    // Hold back the changed signals until the inheritance has been resolved,
+    // the observers need to see the inherited attributes. Remember the parents,
+    // to notify the classes which lost theirs or got a different one.
+    std::map<EntityClass*, const IEntityClass*> previousParents;
+
+    for (const auto& pair : _entityClasses)
+    {
+        pair.second->blockChangedSignal(true);
+        previousParents.emplace(pair.second.get(), pair.second->getParent());
+    }
+
+	parseChangedDefFiles(changes);
+
+	// Resolve the eclass inheritance again, the changed classes might be parents of unchanged ones
 	resolveInheritance();
 
+    // Notify the observers of all classes which have been parsed in this run,
+    // or which inherit from one of those
+    for (const auto& pair : _entityClasses)
+    {
+        auto& eclass = *pair.second;
+        eclass.blockChangedSignal(false);
+
+        auto previousParent = previousParents.find(&eclass);
+        bool changed = previousParent == previousParents.end() ||
+            previousParent->second != eclass.getParent();
+
+        for (const IEntityClass* cur = &eclass; cur && !changed; cur = cur->getParent())
+        {
+            changed = static_cast<const EntityClass*>(cur)->getParseStamp() == _curParseStamp;
+        }
+
+        // The modelDef named by the class (or one of its ancestors) might have changed too
+        if (!changed)
+        {
+            changed = isModelDefParsedInCurrentRun(eclass.getModelDefName());
+        }
+
+        if (changed)
+        {
+            eclass.emitChangedSignal();
+        }
+    }
+
     _defsReloadedSignal.emit();
 }
 
@@ -402,110 +668,118 @@ void EClassManager::onFileSystemShutdown()
 	unrealise();
 }
 
-// Parse the provided stream containing the contents of a single .def file.
-// Extract all entitydefs and create objects accordingly.
-void EClassManager::parse(TextInputStream& inStr, const vfs::FileInfo& fileInfo, const std::string& modDir)
+EClassManager::ParsedDefFile EClassManager::parseDefFile(const vfs::FileInfo& fileInfo)
 {
-	// Construct a tokeniser for the stream
-	std::istream is(&inStr);
-    parser::BasicDefTokeniser<std::istream> tokeniser(is);
+    ParsedDefFile result;
 
-    while (tokeniser.hasMoreTokens())
-	{
-        std::string blockType = tokeniser.nextToken();
-        string::to_lower(blockType);
+	auto file = GlobalFileSystem().openTextFile(fileInfo.fullPath());
 
-        if (blockType == "entitydef")
-		{
-			// Get the (lowercase) entity name
-			const std::string sName =
-    			string::to_lower_copy(tokeniser.nextToken());
+	if (!file) return result;
 
-			// Ensure that an Entity class with this name already exists
-			// When reloading entityDef declarations, most names will already be registered
-			auto i = _entityClasses.find(sName);
+    result.modName = file->getModName();
 
-			if (i == _entityClasses.end())
-			{
-				// Not existing yet, allocate a new class
-				auto result = _entityClasses.emplace(sName, std::make_shared<EntityClass>(sName, fileInfo));
+	try
+    {
+        std::istream is(&file->getInputStream());
+        parser::BasicDefTokeniser<std::istream> tokeniser(is);
 
-				i = result.first;
-			}
-			else
-			{
-				// EntityDef already exists, compare the parse stamp
-				if (i->second->getParseStamp() == _curParseStamp)
-				{
-					rWarning() << "[eclassmgr]: EntityDef "
-						<< sName << " redefined" << std::endl;
-				}
-			}
+        while (tokeniser.hasMoreTokens())
+        {
+            std::string blockType = tokeniser.nextToken();
+            string::to_lower(blockType);
 
-			// At this point, i is pointing to a valid entityclass
-			i->second->setParseStamp(_curParseStamp);
+            if (blockType == "entitydef")
+            {
+                // Get the (lowercase) entity name
+                auto eclass = std::make_shared<EntityClass>(
+                    string::to_lower_copy(tokeniser.nextToken()), fileInfo);
 
-        	// Parse the contents of the eclass (excluding name)
-			i->second->parseFromTokens(tokeniser);
+                result.entityClasses.push_back(eclass);
 
-			// Set the mod directory
-        	i->second->setModName(modDir);
-        }
-        else if (blockType == "model")
-		{
-			// Read the name
-			std::string modelDefName = tokeniser.nextToken();
+                // Parse the contents of the eclass (excluding name)
+                eclass->parseFromTokens(tokeniser);
+            }
+            else if (blockType == "model")
+            {
+                auto model = std::make_shared<Doom3ModelDef>(tokeniser.nextToken());
 
-			// Ensure that an Entity class with this name already exists
-			// When reloading entityDef declarations, most names will already be registered
-			auto foundModel = _models.find(modelDefName);
+                result.models.push_back(model);
 
-			if (foundModel == _models.end())
-			{
-				// Does not exist yet, allocate a new one
+                model->parseFromTokens(tokeniser);
+                model->defFilename = fileInfo.fullPath();
+            }
+        }
+	}
+    catch (parser::ParseException& e)
+    {
+		rError() << "[eclassmgr] failed to parse " << fileInfo.fullPath()
+				 << " (" << e.what() << ")" << std::endl;
+	}
 
-				// Allocate an empty ModelDef
-        		auto model = std::make_shared<Doom3ModelDef>(modelDefName);
+    return result;
+}
 
-                foundModel = _models.emplace(modelDefName, model).first;
-			}
-			else
-			{
-				// Model already exists, compare the parse stamp
-				if (foundModel->second->getParseStamp() == _curParseStamp)
-				{
-					rWarning() << "[eclassmgr]: Model "
-						<< modelDefName << " redefined" << std::endl;
-				}
-			}
+void EClassManager::mergeDefFile(ParsedDefFile& parsedFile, const std::set<std::string>* declNames)
+{
+    for (const auto& eclass : parsedFile.entityClasses)
+    {
+        if (declNames && declNames->count(getEntityDefDeclName(eclass->getName())) == 0)
+        {
+            continue;
+        }
 
-			// Model structure is allocated and in the map,
-            // invoke the parser routine
-            foundModel->second->setParseStamp(_curParseStamp);
+        // When reloading entityDef declarations, most names will already be registered
+        auto i = _entityClasses.find(eclass->getName());
 
-            foundModel->second->parseFromTokens(tokeniser);
-            foundModel->second->setModName(modDir);
-            foundModel->second->defFilename = fileInfo.fullPath();
+        if (i == _entityClasses.end())
+        {
+            i = _entityClasses.emplace(eclass->getName(), eclass).first;
         }
-    }
-}
+        else
+        {
+            // EntityDef already exists, compare the parse stamp
+            if (i->second->getParseStamp() == _curParseStamp)
+            {
+                rWarning() << "[eclassmgr]: EntityDef "
+                    << eclass->getName() << " redefined" << std::endl;
+            }
 
-void EClassManager::parseFile(const vfs::FileInfo& fileInfo)
-{
-	auto file = GlobalFileSystem().openTextFile(fileInfo.fullPath());
+            // Keep the existing object, references to it must remain valid
+            i->second->takeContentsFrom(*eclass);
+        }
 
-	if (!file) return;
+        i->second->setParseStamp(_curParseStamp);
+        i->second->setModName(parsedFile.modName);
+    }
 
-	try
-    {
-		// Parse entity defs from the file
-		parse(file->getInputStream(), fileInfo, file->getModName());
-	}
-    catch (parser::ParseException& e)
+    for (const auto& model : parsedFile.models)
     {
-		rError() << "[eclassmgr] failed to parse " << fileInfo.fullPath()
-				 << " (" << e.what() << ")" << std::endl;
-	}
+        if (declNames && declNames->count(getModelDeclName(model->name)) == 0)
+        {
+            continue;
+        }
+
+        auto foundModel = _models.find(model->name);
+
+        if (foundModel == _models.end())
+        {
+            foundModel = _models.emplace(model->name, model).first;
+        }
+        else
+        {
+            // Model already exists, compare the parse stamp
+            if (foundModel->second->getParseStamp() == _curParseStamp)
+            {
+                rWarning() << "[eclassmgr]: Model "
+                    << model->name << " redefined" << std::endl;
+            }
+
+            foundModel->second->takeContentsFrom(*model);
+        }
+
+        foundModel->second->setParseStamp(_curParseStamp);
+        foundModel->second->setModName(parsedFile.modName);
+    }
 }
 
 void EClassManager::onDefLoadingCompleted()
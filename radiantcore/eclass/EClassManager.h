@@ -6,6 +6,7 @@
 #include "ifilesystem.h"
 #include "itextstream.h"
 #include "ThreadedDefLoader.h"
+#include "decl/DeclFileTracker.h"
 
 #include "EntityClass.h"
 #include "Doom3ModelDef.h"
@@ -49,6 +50,9 @@ class EClassManager :
 	// definitions have been parsed
 	std::size_t _curParseStamp;
 
+    // The DEF files found during the last scan, to reload the changed ones only
+    decl::DeclFileTracker _defFiles;
+
     sigc::signal<void> _defsLoadingSignal;
     sigc::signal<void> _defsLoadedSignal;
     sigc::signal<void> _defsReloadedSignal;
@@ -89,8 +93,18 @@ public:
     void shutdownModule() override;
 
 private:
-	// Method loading the DEF files
-    void parseFile(const vfs::FileInfo& fileInfo);
+    // The entityDefs and models declared in a single DEF file
+    struct ParsedDefFile;
+
+    // Parses the given DEF file into new objects, called by the worker threads
+    static ParsedDefFile parseDefFile(const vfs::FileInfo& fileInfo);
+
+    // Parses the given files in parallel, the results are mapped by the file path
+    static std::map<std::string, ParsedDefFile> parseDefFilesInParallel(const std::vector<vfs::FileInfo>& files);
+
+    // Adds the parsed declarations to the maps, replacing the contents of existing ones.
+    // If declNames is given, only the declarations of these names are merged.
+    void mergeDefFile(ParsedDefFile& parsedFile, const std::set<std::string>* declNames = nullptr);
 
     // Since loading is happening in a worker thread, we need to ensure
     // that it's done loading before accessing any defs or models.
@@ -110,13 +124,17 @@ private:
 	EntityClass::Ptr insertUnique(const EntityClass::Ptr& eclass);
     EntityClass::Ptr findInternal(const std::string& name);
 
-	// Parses the given inputstream for DEFs.
-	void parse(TextInputStream& inStr, const vfs::FileInfo& fileInfo, const std::string& modDir);
-
 	// Recursively resolves the inheritance of the model defs
 	void resolveModelInheritance(const std::string& name, const Doom3ModelDef::Ptr& model);
 
-	void parseDefFiles();
+    // True if the named modelDef or one of its ancestors has been parsed in the current run
+    bool isModelDefParsedInCurrentRun(const std::string& name) const;
+
+	void parseDefFiles(const std::vector<vfs::FileInfo>& files);
+
+    // Re-parses the changed files and the unchanged ones declaring the same
+    // names, then merges the affected declarations in VFS order
+    void parseChangedDefFiles(const decl::DeclFileTracker::Changes& changes);
 	void resolveInheritance();
 
 	void reloadDefsCmd(const cmd::ArgumentList& args);
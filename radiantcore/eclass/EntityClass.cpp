@@ -2,11 +2,14 @@
 
 #include "itextstream.h"
 #include "ieclasscolours.h"
+#include "irender.h"
 #include "os/path.h"
 #include "string/convert.h"
 
 #include "string/predicate.h"
 #include <fmt/format.h>
+#include <algorithm>
+#include <utility>
 #include <functional>
 
 namespace eclass
@@ -26,6 +29,7 @@ EntityClass::EntityClass(const std::string& name, const vfs::FileInfo& fileInfo,
   _isLight(false),
   _colour(-1, -1, -1),
   _colourTransparent(false),
+  _colourGeneration(0),
   _fixedSize(fixedSize),
   _model(""),
   _skin(""),
@@ -101,14 +105,35 @@ void EntityClass::setColour(const Vector3& colour)
         _colour = DefaultEntityColour;
     }
 
+    // Re-applying the same colour (as the colour manager and the parent
+    // class signals tend to do) doesn't need to bother the entities
+    if (updateColourShaders())
+    {
+        emitChangedSignal();
+    }
+}
+
+bool EntityClass::updateColourShaders()
+{
     // Define fill and wire versions of the entity colour
-    _fillShader = _colourTransparent ?
+    auto fillShader = _colourTransparent ?
         fmt::format("[{0:f} {1:f} {2:f}]", _colour[0], _colour[1], _colour[2]) :
         fmt::format("({0:f} {1:f} {2:f})", _colour[0], _colour[1], _colour[2]);
 
-    _wireShader = fmt::format("<{0:f} {1:f} {2:f}>", _colour[0], _colour[1], _colour[2]);
+    auto wireShader = fmt::format("<{0:f} {1:f} {2:f}>", _colour[0], _colour[1], _colour[2]);
 
-    emitChangedSignal();
+    if (fillShader == _fillShader && wireShader == _wireShader)
+    {
+        return false;
+    }
+
+    _fillShader = std::move(fillShader);
+    _wireShader = std::move(wireShader);
+
+    // Invalidates the captured shaders
+    ++_colourGeneration;
+
+    return true;
 }
 
 void EntityClass::resetColour()
@@ -148,6 +173,44 @@ const std::string& EntityClass::getFillShader() const
     return !_fillShader.empty() ? _fillShader : DefaultFillShader;
 }
 
+const ShaderPtr& EntityClass::captureWireShader(const RenderSystemPtr& renderSystem) const
+{
+    return getCapturedShaders(renderSystem).wireShader;
+}
+
+const ShaderPtr& EntityClass::captureFillShader(const RenderSystemPtr& renderSystem) const
+{
+    return getCapturedShaders(renderSystem).fillShader;
+}
+
+const EntityClass::CapturedShaders& EntityClass::getCapturedShaders(const RenderSystemPtr& renderSystem) const
+{
+    // Forget about the render systems that are gone
+    _capturedShaders.erase(std::remove_if(_capturedShaders.begin(), _capturedShaders.end(),
+        [](const CapturedShaders& captured) { return captured.renderSystem.expired(); }),
+        _capturedShaders.end());
+
+    // There's usually just the main render system and maybe a preview
+    auto captured = std::find_if(_capturedShaders.begin(), _capturedShaders.end(),
+        [&](const CapturedShaders& captured) { return captured.renderSystem.lock() == renderSystem; });
+
+    if (captured == _capturedShaders.end())
+    {
+        _capturedShaders.push_back(CapturedShaders{ renderSystem, 0, ShaderPtr(), ShaderPtr() });
+        captured = _capturedShaders.end() - 1;
+    }
+    else if (captured->colourGeneration == _colourGeneration && captured->wireShader)
+    {
+        return *captured;
+    }
+
+    captured->colourGeneration = _colourGeneration;
+    captured->wireShader = renderSystem->capture(getWireShader());
+    captured->fillShader = renderSystem->capture(getFillShader());
+
+    return *captured;
+}
+
 /* ATTRIBUTES */
 
 /**
@@ -231,45 +294,84 @@ void EntityClass::forEachAttribute(AttributeVisitor visitor,
     }
 }
 
+const std::string& EntityClass::getParentName() const
+{
+    return getAttribute("inherit", false).getValue();
+}
+
+std::string EntityClass::getModelDefName() const
+{
+    return os::standardPath(getAttribute("model").getValue());
+}
+
+void EntityClass::resetInheritance()
+{
+    _parentChangedConnection.disconnect();
+    _parent = nullptr;
+
+    _allAttributes.clear();
+    _inheritanceResolved = false;
+}
+
 // Resolve inheritance for this class
-void EntityClass::resolveInheritance(EntityClasses& classmap)
+void EntityClass::resolveInheritance(EntityClass* parent)
 {
-    // If we have already resolved inheritance, do nothing
-    if (_inheritanceResolved)
-        return;
+    _parent = parent;
 
-    // Lookup the parent name and return if it is not set. Also return if the
-    // parent name is the same as our own classname, to avoid infinite
-    // recursion.
-    std::string parName = getAttribute("inherit").getValue();
-    if (parName.empty() || parName == _name)
-        return;
+    // Merge our own attributes into the (sorted) attribute list of the parent,
+    // replacing the inherited attributes of the same name
+    _allAttributes.clear();
+    _allAttributes.reserve(_attributes.size() + (_parent ? _parent->_allAttributes.size() : 0));
+
+    string::ILess less;
+    auto own = _attributes.begin();
 
-    // Find the parent entity class
-    EntityClasses::iterator pIter = classmap.find(parName);
-    if (pIter != classmap.end())
+    if (_parent)
     {
-        // Recursively resolve inheritance of parent
-        pIter->second->resolveInheritance(classmap);
+        for (const auto* inherited : _parent->_allAttributes)
+        {
+            while (own != _attributes.end() && less(own->first, inherited->getName()))
+            {
+                _allAttributes.push_back(&(own++)->second);
+            }
 
-        // Set our parent pointer
-        _parent = pIter->second.get();
+            // Skip the inherited attribute if we have one with that name
+            if (own == _attributes.end() || less(inherited->getName(), own->first))
+            {
+                _allAttributes.push_back(inherited);
+            }
+        }
     }
-    else
+
+    for (; own != _attributes.end(); ++own)
     {
-        rWarning() << "[eclassmgr] Entity class "
-                              << _name << " specifies unknown parent class "
-                              << parName << std::endl;
+        _allAttributes.push_back(&own->second);
     }
 
     // Set the resolved flag
     _inheritanceResolved = true;
 
-    if (!getAttribute("model").getValue().empty())
+    // Derive the model from the (probably inherited) "model" key on every run,
+    // the EClassManager replaces it with the mesh of the modelDef it names
+    auto modelDefName = getModelDefName();
+
+    if (!modelDefName.empty())
     {
-        // We have a model path (probably an inherited one)
-        setModelPath(getAttribute("model").getValue());
+        setModelPath(modelDefName);
     }
+    else
+    {
+        _model.clear();
+    }
+
+    _skin.clear();
+
+    // Return if the parent name is not set or the same as our own classname,
+    // these classes keep the properties they have been parsed with
+    const auto& parentName = getParentName();
+
+    if (parentName.empty() || parentName == _name)
+        return;
 
     if (getAttribute("editor_light").getValue() == "1" || getAttribute("spawnclass").getValue() == "idLight")
     {
@@ -287,12 +389,39 @@ void EntityClass::resolveInheritance(EntityClasses& classmap)
     resetColour();
     if (_parent)
     {
-        _parent->changedSignal().connect(
+        _parentChangedConnection = _parent->changedSignal().connect(
             sigc::mem_fun(this, &EntityClass::resetColour)
         );
     }
 }
 
+void EntityClass::takeContentsFrom(EntityClass& parsed)
+{
+    _isLight = parsed._isLight;
+    _colour = parsed._colour;
+    _colourTransparent = parsed._colourTransparent;
+
+    if (_fillShader != parsed._fillShader || _wireShader != parsed._wireShader)
+    {
+        _fillShader = parsed._fillShader;
+        _wireShader = parsed._wireShader;
+        ++_colourGeneration;
+    }
+
+    _fixedSize = parsed._fixedSize;
+    _attributes = std::move(parsed._attributes);
+    _model = parsed._model;
+    _skin = parsed._skin;
+    _modName = parsed._modName;
+
+    // The inherited attributes are gathered again when resolving inheritance
+    _allAttributes.clear();
+    _inheritanceResolved = false;
+
+    // Notify the observers
+    emitChangedSignal();
+}
+
 bool EntityClass::isOfType(const std::string& className)
 {
 	for (const IEntityClass* currentClass = this;
@@ -327,6 +456,19 @@ const EntityClassAttribute&
 EntityClass::getAttribute(const std::string& name,
                                bool includeInherited) const
 {
+    // Resolved classes know all their inherited attributes
+    if (includeInherited && _inheritanceResolved)
+    {
+        auto found = std::lower_bound(_allAttributes.begin(), _allAttributes.end(), name,
+            [](const EntityClassAttribute* attribute, const std::string& name)
+            {
+                return string::icmp(attribute->getName().c_str(), name.c_str()) < 0;
+            });
+
+        return found != _allAttributes.end() && string::icmp((*found)->getName().c_str(), name.c_str()) == 0 ?
+            **found : _emptyAttribute;
+    }
+
     // First look up the attribute on this class; if found, we can simply return it
     auto f = _attributes.find(name);
     if (f != _attributes.end())
@@ -353,6 +495,7 @@ void EntityClass::clear()
     _fixedSize = false;
 
     _attributes.clear();
+    _allAttributes.clear();
     _model.clear();
     _skin.clear();
     _inheritanceResolved = false;
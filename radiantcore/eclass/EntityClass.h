@@ -13,6 +13,7 @@
 #include <vector>
 #include <map>
 #include <memory>
+#include <sigc++/connection.h>
 
 /* FORWARD DECLS */
 
@@ -58,6 +59,20 @@ private:
     std::string _fillShader;
     std::string _wireShader;
 
+    // Incremented whenever the shader names above change
+    std::size_t _colourGeneration;
+
+    // The shaders captured from a render system, valid as long as their
+    // generation matches the one of the colour
+    struct CapturedShaders
+    {
+        std::weak_ptr<RenderSystem> renderSystem;
+        std::size_t colourGeneration;
+        ShaderPtr wireShader;
+        ShaderPtr fillShader;
+    };
+    mutable std::vector<CapturedShaders> _capturedShaders;
+
     // Does this entity have a fixed size?
     bool _fixedSize;
 
@@ -66,13 +81,20 @@ private:
     typedef std::map<std::string, EntityClassAttribute, string::ILess> EntityAttributeMap;
     EntityAttributeMap _attributes;
 
+    // All attributes of this class and its ancestors, sorted by name ignoring
+    // case, the most derived one wins. Built when resolving inheritance, such
+    // that getAttribute() doesn't need to walk up the parent chain.
+    std::vector<const EntityClassAttribute*> _allAttributes;
+
+    // Connection to the parent's changed signal, the colour is inherited
+    sigc::connection _parentChangedConnection;
+
     // The model and skin for this entity class (if it has one)
     std::string _model;
     std::string _skin;
 
-    // Flag to indicate inheritance resolved. An EntityClass resolves its
-    // inheritance by copying all values from the parent onto the child,
-    // after recursively instructing the parent to resolve its own inheritance.
+    // Flag to indicate inheritance resolved, _allAttributes is valid then.
+    // The parents are always resolved before their children.
     bool _inheritanceResolved;
 
     // Name of the mod owning this class
@@ -94,6 +116,12 @@ private:
     void parseEditorSpawnarg(const std::string& key, const std::string& value);
     void setIsLight(bool val);
 
+    // Sets the shader names for the current colour, returns true if they changed
+    bool updateColourShaders();
+
+    // Returns the shaders captured from the given render system, capturing them if necessary
+    const CapturedShaders& getCapturedShaders(const RenderSystemPtr& renderSystem) const;
+
     // Visit attributes recursively, parent first then child
     using InternalAttrVisitor = std::function<void(const EntityClassAttribute&)>;
     void forEachAttributeInternal(InternalAttrVisitor visitor,
@@ -149,6 +177,8 @@ private:
     void resetColour();
     const std::string& getWireShader() const override;
     const std::string& getFillShader() const override;
+    const ShaderPtr& captureWireShader(const RenderSystemPtr& renderSystem) const override;
+    const ShaderPtr& captureFillShader(const RenderSystemPtr& renderSystem) const override;
     EntityClassAttribute& getAttribute(const std::string&,
                                        bool includeInherited = true) override;
     const EntityClassAttribute&
@@ -172,15 +202,34 @@ private:
     /// Set the skin.
     void setSkin(const std::string& skin) { _skin = skin; }
 
+    /// The name of the parent class, as declared by the "inherit" key of this class
+    const std::string& getParentName() const;
+
+    /// The value of the (possibly inherited) "model" key, which is either a model
+    /// path or the name of a modelDef. Unlike getModelPath() this is never
+    /// replaced by the mesh of the modelDef.
+    std::string getModelDefName() const;
+
+    /// Forget the parent and the inherited attributes, before resolving them again
+    void resetInheritance();
+
     /**
      * Resolve inheritance for this class.
      *
-     * @param classmap
-     * A reference to the global map of entity classes, which should be searched
-     * for the parent entity.
+     * @param parent
+     * The parent class as named by getParentName(), or nullptr if there is
+     * none or it can't be found. The parent must have been resolved already.
      */
-    typedef std::map<std::string, EntityClass::Ptr> EntityClasses;
-    void resolveInheritance(EntityClasses& classmap);
+    void resolveInheritance(EntityClass* parent);
+
+    bool isInheritanceResolved() const
+    {
+        return _inheritanceResolved;
+    }
+
+    /// Replace the contents of this class with the ones of the given freshly
+    /// parsed class, keeping this object (and all references to it) intact
+    void takeContentsFrom(EntityClass& parsed);
 
     /**
      * Return the mod name.
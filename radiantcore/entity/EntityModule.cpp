@@ -13,6 +13,7 @@
 #include "string/replace.h"
 
 #include "SpawnArgs.h"
+#include "KeyValueChangeBatch.h"
 
 #include "light/LightNode.h"
 #include "doom3group/Doom3GroupNode.h"
@@ -260,6 +261,16 @@ ITargetManagerPtr Doom3EntityModule::createTargetManager()
     return std::make_shared<TargetManager>();
 }
 
+void Doom3EntityModule::beginKeyValueChanges()
+{
+	KeyValueChangeBatch::Begin();
+}
+
+void Doom3EntityModule::endKeyValueChanges()
+{
+	KeyValueChangeBatch::End();
+}
+
 IEntitySettings& Doom3EntityModule::getSettings()
 {
 	return *EntitySettings::InstancePtr();
@@ -24,6 +24,9 @@ public:
 	 */
 	IEntityNodePtr createEntityFromSelection(const std::string& name, const Vector3& origin) override;
 
+	void beginKeyValueChanges() override;
+	void endKeyValueChanges() override;
+
 	// RegisterableModule implementation
 	virtual const std::string& getName() const override;
 	virtual const StringSet& getDependencies() const override;
@@ -61,11 +61,11 @@ void EntityNode::construct()
 
 	TargetableNode::construct();
 
-	addKeyObserver("name", _nameKey);
+	addKeyObserver(atom::Name(), _nameKey);
 	addKeyObserver("_color", _colourKey);
 
 	_modelKeyObserver.setCallback(std::bind(&EntityNode::_modelKeyChanged, this, std::placeholders::_1));
-	addKeyObserver("model", _modelKeyObserver);
+	addKeyObserver(atom::Model(), _modelKeyObserver);
 
 	// Connect the skin keyvalue change handler directly to the model node manager
 	_skinKeyObserver.setCallback(std::bind(&ModelKey::skinChanged, &_modelKey, std::placeholders::_1));
@@ -109,10 +109,10 @@ void EntityNode::destruct()
 	removeKeyObserver("skin", _skinKeyObserver);
 
 	_modelKey.setActive(false); // disable callbacks during destruction
-	removeKeyObserver("model", _modelKeyObserver);
+	removeKeyObserver(atom::Model(), _modelKeyObserver);
 
 	removeKeyObserver("_color", _colourKey);
-	removeKeyObserver("name", _nameKey);
+	removeKeyObserver(atom::Name(), _nameKey);
 
 	_eclassChangedConn.disconnect();
 
@@ -184,6 +184,16 @@ void EntityNode::removeKeyObserver(const std::string& key, KeyObserver& observer
 	_keyObservers.erase(key, observer);
 }
 
+void EntityNode::addKeyObserver(const KeyAtom& key, KeyObserver& observer)
+{
+	_keyObservers.insert(key, observer);
+}
+
+void EntityNode::removeKeyObserver(const KeyAtom& key, KeyObserver& observer)
+{
+	_keyObservers.erase(key, observer);
+}
+
 Entity& EntityNode::getEntity()
 {
 	return _spawnArgs;
@@ -295,6 +305,9 @@ void EntityNode::onInsertIntoScene(scene::IMapRootNode& root)
 {
     GlobalCounters().getCounter(counterEntities).increment();
 
+	// Don't take model placeholders into the scene, this is before the undo system is connected
+	_modelKey.ensureModelLoaded();
+
 	_spawnArgs.connectUndoSystem(root.getUndoChangeTracker());
 	_modelKey.connectUndoSystem(root.getUndoChangeTracker());
 
@@ -385,8 +398,11 @@ void EntityNode::acquireShaders(const RenderSystemPtr& renderSystem)
 {
     if (renderSystem)
     {
-        _fillShader = renderSystem->capture(_spawnArgs.getEntityClass()->getFillShader());
-        _wireShader = renderSystem->capture(_spawnArgs.getEntityClass()->getWireShader());
+        // The entity class keeps the captured shaders, all entities of
+        // that class share them without looking them up by name
+        const auto& eclass = _spawnArgs.getEntityClass();
+        _fillShader = eclass->captureFillShader(renderSystem);
+        _wireShader = eclass->captureWireShader(renderSystem);
     }
     else
     {
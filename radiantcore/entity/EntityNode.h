@@ -153,6 +153,10 @@ public:
 	void addKeyObserver(const std::string& key, KeyObserver& observer);
 	void removeKeyObserver(const std::string& key, KeyObserver& observer);
 
+	// Overloads taking an interned key, used for the keys every entity observes
+	void addKeyObserver(const KeyAtom& key, KeyObserver& observer);
+	void removeKeyObserver(const KeyAtom& key, KeyObserver& observer);
+
 	ModelKey& getModelKey(); // needed by the Doom3Group class, could be a fixme
     const ModelKey& getModelKey() const;
 
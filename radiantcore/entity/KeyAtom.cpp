@@ -0,0 +1,167 @@
+#include "KeyAtom.h"
+
+#include <cctype>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include "string/case_conv.h"
+
+namespace entity
+{
+
+namespace
+{
+
+inline char foldCase(char c)
+{
+	return static_cast<char>(::tolower(static_cast<unsigned char>(c)));
+}
+
+// Hashes a key ignoring its case, without creating a folded copy (FNV-1a)
+struct FoldedHash
+{
+	std::size_t operator()(std::string_view key) const
+	{
+		std::size_t hash = 14695981039346656037ull;
+
+		for (auto c : key)
+		{
+			hash ^= static_cast<unsigned char>(foldCase(c));
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+};
+
+struct FoldedEqual
+{
+	bool operator()(std::string_view a, std::string_view b) const
+	{
+		if (a.size() != b.size()) return false;
+
+		for (std::size_t i = 0; i < a.size(); ++i)
+		{
+			if (foldCase(a[i]) != foldCase(b[i])) return false;
+		}
+
+		return true;
+	}
+};
+
+// The table of all interned keys. Entities can be created by worker threads,
+// access is guarded.
+class KeyAtomTable
+{
+private:
+	std::shared_mutex _lock;
+
+	// Deque to keep the interned names at a fixed address, atoms point to them
+	std::deque<std::string> _names;
+
+	// The views refer to the strings in _names. Lookups pass a view of the
+	// incoming key, which is compared to the folded names ignoring case.
+	std::unordered_map<std::string_view, const std::string*, FoldedHash, FoldedEqual> _atoms;
+
+public:
+	static KeyAtomTable& Instance()
+	{
+		static KeyAtomTable _table;
+		return _table;
+	}
+
+	const std::string* find(const std::string& key)
+	{
+		std::shared_lock<std::shared_mutex> lock(_lock);
+
+		auto found = _atoms.find(key);
+		return found != _atoms.end() ? found->second : nullptr;
+	}
+
+	const std::string* intern(const std::string& key)
+	{
+		std::unique_lock<std::shared_mutex> lock(_lock);
+
+		auto found = _atoms.find(key);
+
+		if (found != _atoms.end())
+		{
+			return found->second;
+		}
+
+		const auto& name = _names.emplace_back(string::to_lower_copy(key));
+		_atoms.emplace(name, &name);
+
+		return &name;
+	}
+};
+
+}
+
+KeyAtom KeyAtom::Intern(const std::string& key)
+{
+	auto& table = KeyAtomTable::Instance();
+
+	// Most keys are already known, try the shared lock first
+	auto name = table.find(key);
+
+	return KeyAtom(name != nullptr ? name : table.intern(key));
+}
+
+KeyAtom KeyAtom::Find(const std::string& key)
+{
+	return KeyAtom(KeyAtomTable::Instance().find(key));
+}
+
+const std::string& KeyAtom::getName() const
+{
+	static const std::string _emptyName;
+
+	// The interned names never change, no need to consult the table
+	return _name != nullptr ? *_name : _emptyName;
+}
+
+namespace atom
+{
+
+const KeyAtom& Name()
+{
+	static const auto _atom = KeyAtom::Intern("name");
+	return _atom;
+}
+
+const KeyAtom& Classname()
+{
+	static const auto _atom = KeyAtom::Intern("classname");
+	return _atom;
+}
+
+const KeyAtom& Model()
+{
+	static const auto _atom = KeyAtom::Intern("model");
+	return _atom;
+}
+
+const KeyAtom& Origin()
+{
+	static const auto _atom = KeyAtom::Intern("origin");
+	return _atom;
+}
+
+const KeyAtom& Angle()
+{
+	static const auto _atom = KeyAtom::Intern("angle");
+	return _atom;
+}
+
+const KeyAtom& Rotation()
+{
+	static const auto _atom = KeyAtom::Intern("rotation");
+	return _atom;
+}
+
+}
+
+} // namespace entity
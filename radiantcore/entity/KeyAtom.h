@@ -0,0 +1,100 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+namespace entity
+{
+
+/**
+ * An interned spawnarg key. Keys are case-folded when they are interned,
+ * two atoms compare equal if their keys are equal ignoring case, which
+ * is the comparison entities use for their spawnargs.
+ *
+ * Comparing and hashing atoms is a pointer operation, the key string
+ * only needs to be looked up once when the atom is created. Looking up
+ * a key doesn't allocate, the table hashes the key case-insensitively.
+ */
+class KeyAtom
+{
+private:
+	// The interned, case-folded key, owned by the atom table
+	const std::string* _name;
+
+	explicit KeyAtom(const std::string* name) :
+		_name(name)
+	{}
+
+public:
+	// Constructs an invalid atom, not matching any key
+	KeyAtom() :
+		_name(nullptr)
+	{}
+
+	// Returns the atom for the given key, interning the key if necessary
+	static KeyAtom Intern(const std::string& key);
+
+	// Returns the atom for the given key, or an invalid atom if the key
+	// has never been interned (then no entity can have this key either)
+	static KeyAtom Find(const std::string& key);
+
+	bool isValid() const
+	{
+		return _name != nullptr;
+	}
+
+	// The case-folded key (an empty string for invalid atoms)
+	const std::string& getName() const;
+
+	bool operator==(const KeyAtom& other) const
+	{
+		return _name == other._name;
+	}
+
+	bool operator!=(const KeyAtom& other) const
+	{
+		return _name != other._name;
+	}
+
+	bool operator<(const KeyAtom& other) const
+	{
+		return std::less<const std::string*>()(_name, other._name);
+	}
+
+	std::size_t getHash() const
+	{
+		return std::hash<const std::string*>()(_name);
+	}
+};
+
+/**
+ * The atoms of the keys the entity code observes or queries itself,
+ * interned on first use. Using these saves the table lookup.
+ */
+namespace atom
+{
+
+const KeyAtom& Name();
+const KeyAtom& Classname();
+const KeyAtom& Model();
+const KeyAtom& Origin();
+const KeyAtom& Angle();
+const KeyAtom& Rotation();
+
+}
+
+} // namespace entity
+
+namespace std
+{
+
+template<>
+struct hash<entity::KeyAtom>
+{
+	std::size_t operator()(const entity::KeyAtom& atom) const
+	{
+		return atom.getHash();
+	}
+};
+
+}
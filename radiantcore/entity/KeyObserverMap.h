@@ -23,10 +23,13 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #define INCLUDED_KEYOBSERVERS_H
 
 #include "ientity.h"
-#include <map>
+#include <unordered_map>
+#include <vector>
 #include <string>
+#include <algorithm>
 
 #include "SpawnArgs.h"
+#include "KeyAtom.h"
 
 namespace entity
 {
@@ -35,8 +38,9 @@ class KeyObserverMap :
 	public Entity::Observer,
     public sigc::trackable
 {
-	// A map using case-insensitive comparison
-	typedef std::multimap<std::string, KeyObserver*, string::ILess> KeyObservers;
+	// The observers of each key, the atoms take care of the case-insensitive comparison
+	typedef std::vector<KeyObserver*> KeyObserverList;
+	typedef std::unordered_map<KeyAtom, KeyObserverList> KeyObservers;
 	KeyObservers _keyObservers;
 
 	// The observed entity
@@ -61,10 +65,15 @@ public:
 	 */
 	void insert(const std::string& key, KeyObserver& observer)
 	{
-		_keyObservers.insert(KeyObservers::value_type(key, &observer));
+		insert(KeyAtom::Intern(key), observer);
+	}
+
+	void insert(const KeyAtom& atom, KeyObserver& observer)
+	{
+		_keyObservers[atom].push_back(&observer);
 
 		// Check if the entity already has such a (non-inherited) spawnarg
-		EntityKeyValuePtr keyValue = _entity.getEntityKeyValue(key);
+		EntityKeyValuePtr keyValue = _entity.getEntityKeyValue(atom);
 
 		if (keyValue != NULL)
 		{
@@ -73,63 +82,86 @@ public:
 		}
 
 		// Call the observer right now with the current keyvalue as argument
-		observer.onKeyValueChanged(_entity.getKeyValue(key));
+		observer.onKeyValueChanged(_entity.getKeyValue(atom));
 	}
 
 	void erase(const std::string& key, KeyObserver& observer)
 	{
-		for (KeyObservers::iterator i = _keyObservers.find(key);
-			 i != _keyObservers.upper_bound(key) && i != _keyObservers.end();
-			 /* in-loop increment */)
+		erase(KeyAtom::Find(key), observer);
+	}
+
+	void erase(const KeyAtom& atom, KeyObserver& observer)
+	{
+		auto found = _keyObservers.find(atom);
+
+		if (found == _keyObservers.end())
 		{
-			if (i->second == &observer)
-			{
-				EntityKeyValuePtr keyValue = _entity.getEntityKeyValue(key);
+			return;
+		}
 
-				if (keyValue != NULL)
+		auto& observers = found->second;
+		auto newEnd = std::remove(observers.begin(), observers.end(), &observer);
+
+		if (newEnd != observers.end())
+		{
+			EntityKeyValuePtr keyValue = _entity.getEntityKeyValue(found->first);
+
+			if (keyValue != NULL)
+			{
+				// Detach the observer from the actual keyvalue, once per registration
+				for (auto i = newEnd; i != observers.end(); ++i)
 				{
-					// Detach the observer from the actual keyvalue
 					keyValue->detach(observer);
 				}
-
-				_keyObservers.erase(i++);
-			}
-			else
-			{
-				++i;
 			}
+
+			observers.erase(newEnd, observers.end());
+		}
+
+		if (observers.empty())
+		{
+			_keyObservers.erase(found);
 		}
 	}
 
 	void refreshObservers()
 	{
-		for (KeyObservers::const_iterator i = _keyObservers.begin();
-			i != _keyObservers.end(); ++i)
+		for (const auto& pair : _keyObservers)
 		{
-			// Call the observer once again with the entity value
-			i->second->onKeyValueChanged(_entity.getKeyValue(i->first));
+			// Look up the value once for all observers of this key
+			auto value = _entity.getKeyValue(pair.first);
+
+			for (auto* observer : pair.second)
+			{
+				// Call the observer once again with the entity value
+				observer->onKeyValueChanged(value);
+			}
 		}
 	}
 
 	// Entity::Observer implementation, gets called on key insert
 	void onKeyInsert(const std::string& key, EntityKeyValue& value)
 	{
-		for (KeyObservers::const_iterator i = _keyObservers.find(key);
-			 i != _keyObservers.upper_bound(key) && i != _keyObservers.end();
-			 ++i)
+		auto found = _keyObservers.find(KeyAtom::Find(key));
+
+		if (found == _keyObservers.end()) return;
+
+		for (auto* observer : found->second)
 		{
-			value.attach(*i->second);
+			value.attach(*observer);
 		}
 	}
 
 	// Entity::Observer implementation, gets called on Key erase
 	void onKeyErase(const std::string& key, EntityKeyValue& value)
 	{
-		for (KeyObservers::const_iterator i = _keyObservers.find(key);
-			 i != _keyObservers.upper_bound(key) && i != _keyObservers.end();
-			 ++i)
+		auto found = _keyObservers.find(KeyAtom::Find(key));
+
+		if (found == _keyObservers.end()) return;
+
+		for (auto* observer : found->second)
 		{
-			value.detach(*i->second);
+			value.detach(*observer);
 		}
 	}
 };
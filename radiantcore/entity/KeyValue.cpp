@@ -9,13 +9,17 @@ namespace entity
 KeyValue::KeyValue(const std::string& value, const std::string& empty) :
 	_value(value),
 	_emptyValue(empty),
-	_undo(_value, std::bind(&KeyValue::importState, this, std::placeholders::_1), "KeyValue")
+	_undo(_value, std::bind(&KeyValue::importState, this, std::placeholders::_1), "KeyValue"),
+	_notificationsDeferred(false),
+	_notificationPending(false)
 {
 	notify();
 }
 
 KeyValue::~KeyValue() {
 	assert(_observers.empty());
+
+	KeyValueChangeBatch::Dequeue(*this);
 }
 
 void KeyValue::connectUndoSystem(IMapFileChangeTracker& changeTracker)
@@ -61,6 +65,23 @@ void KeyValue::assign(const std::string& other) {
 
 void KeyValue::notify()
 {
+	if (_notificationsDeferred || KeyValueChangeBatch::IsActive())
+	{
+		// Remember the change, the observers will see the value
+		// it has when the batch of changes is done
+		if (!_notificationPending)
+		{
+			_notificationPending = true;
+
+			if (KeyValueChangeBatch::IsActive())
+			{
+				KeyValueChangeBatch::Enqueue(*this);
+			}
+		}
+
+		return;
+	}
+
 	// Store the name locally, to avoid string-copy operations in the loop below
 	const std::string& value = get();
 
@@ -70,6 +91,27 @@ void KeyValue::notify()
 	}
 }
 
+void KeyValue::setNotificationsDeferred(bool deferred)
+{
+	_notificationsDeferred = deferred;
+
+	if (!deferred)
+	{
+		sendDeferredNotifications();
+	}
+}
+
+void KeyValue::sendDeferredNotifications()
+{
+	if (!_notificationPending) return;
+
+	_notificationPending = false;
+
+	// This might defer the notification again, if the entity
+	// is still collecting changes after the global batch ended
+	notify();
+}
+
 void KeyValue::importState(const std::string& string) 
 {
 	// Add ourselves to the Undo event observers, to get notified after all this has been finished
@@ -2,6 +2,7 @@
 
 #include "ientity.h"
 #include "ObservedUndoable.h"
+#include "KeyValueChangeBatch.h"
 #include "string/string.h"
 #include <vector>
 #include <sigc++/connection.h>
@@ -14,8 +15,11 @@ namespace entity
 ///
 /// - Notifies observers when value changes - value changes to "" on destruction.
 /// - Provides undo support through the global undo system.
+/// - Holds back notifications while its entity or the global KeyValueChangeBatch
+///   is collecting changes, the observers receive the final value only.
 class KeyValue :
 	public EntityKeyValue,
+	public DeferredNotification,
 	public sigc::trackable
 {
 private:
@@ -28,6 +32,12 @@ private:
 	sigc::connection _undoHandler;
 	sigc::connection _redoHandler;
 
+	// Set by the owning entity while it's collecting changes
+	bool _notificationsDeferred;
+
+	// True if the observers haven't been notified about the current value yet
+	bool _notificationPending;
+
 public:
 	KeyValue(const std::string& value, const std::string& empty);
 
@@ -46,6 +56,13 @@ public:
 
 	void notify();
 
+	// Enables or disables the deferred notification mode, disabling
+	// it sends the pending notification if the value has been changed.
+	void setNotificationsDeferred(bool deferred);
+
+	// DeferredNotification implementation
+	void sendDeferredNotifications() override;
+
 	void importState(const std::string& string);
 
 	// NameObserver implementation
@@ -0,0 +1,81 @@
+#include "KeyValueChangeBatch.h"
+
+#include <vector>
+#include <algorithm>
+
+namespace entity
+{
+
+namespace
+{
+	std::size_t _batchDepth = 0;
+
+	// The objects queued during the active batch
+	std::vector<DeferredNotification*> _queue;
+
+	// The objects currently being notified, any of them might be
+	// destroyed as a result of a notification sent before them.
+	// Observers starting a batch of their own add a nested list.
+	std::vector<std::vector<DeferredNotification*>*> _flushing;
+
+	void removeFrom(std::vector<DeferredNotification*>& list, DeferredNotification* notification)
+	{
+		// Null the entries instead of erasing them, the flush loop is index-based
+		std::replace(list.begin(), list.end(), notification, static_cast<DeferredNotification*>(nullptr));
+	}
+}
+
+void KeyValueChangeBatch::Begin()
+{
+	++_batchDepth;
+}
+
+void KeyValueChangeBatch::End()
+{
+	if (_batchDepth == 0 || --_batchDepth > 0)
+	{
+		return;
+	}
+
+	// Observers reacting to the notifications will change other keys,
+	// these changes are delivered immediately now that the batch is over.
+	std::vector<DeferredNotification*> queue;
+	queue.swap(_queue);
+
+	_flushing.push_back(&queue);
+
+	for (std::size_t i = 0; i < queue.size(); ++i)
+	{
+		if (queue[i] != nullptr)
+		{
+			queue[i]->sendDeferredNotifications();
+		}
+	}
+
+	_flushing.pop_back();
+}
+
+bool KeyValueChangeBatch::IsActive()
+{
+	return _batchDepth > 0;
+}
+
+void KeyValueChangeBatch::Enqueue(DeferredNotification& notification)
+{
+	_queue.push_back(&notification);
+}
+
+void KeyValueChangeBatch::Dequeue(DeferredNotification& notification)
+{
+	if (!_queue.empty())
+	{
+		removeFrom(_queue, &notification);
+	}
+
+	for (auto* list : _flushing)
+	{
+		removeFrom(*list, &notification);
+	}
+}
+
+}
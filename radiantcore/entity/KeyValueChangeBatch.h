@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+
+namespace entity
+{
+
+/**
+ * An object holding back change notifications while a batch of spawnarg
+ * edits is in progress.
+ */
+class DeferredNotification
+{
+public:
+	virtual ~DeferredNotification() {}
+
+	// Delivers the notifications that have been held back
+	virtual void sendDeferredNotifications() = 0;
+};
+
+/**
+ * The global batch of spawnarg changes, spanning all entities.
+ *
+ * While a batch is active, KeyValues and SpawnArgs don't notify their
+ * observers on every change. They queue themselves here instead and
+ * deliver a single notification with the final value once the outermost
+ * batch has ended. Batches can be nested, they are not thread-safe.
+ */
+class KeyValueChangeBatch
+{
+public:
+	static void Begin();
+	static void End();
+
+	static bool IsActive();
+
+	// Queues the given object for notification at the end of the batch.
+	// Objects can be queued more than once, it's up to them to avoid
+	// sending the same notification twice.
+	static void Enqueue(DeferredNotification& notification);
+
+	// Removes all occurrences of the given object from the queue,
+	// to be called by objects that are destroyed.
+	static void Dequeue(DeferredNotification& notification);
+};
+
+}
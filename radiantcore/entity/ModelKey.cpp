@@ -1,6 +1,8 @@
 #include "ModelKey.h"
 
 #include <functional>
+#include <sigc++/functors/mem_fun.h>
+#include <sigc++/bind.h>
 #include "imodelcache.h"
 #include "ifiletypes.h"
 #include "scene/Node.h"
@@ -70,10 +72,25 @@ void ModelKey::attachModelNode()
 		return;
 	}
 
-	// We have a non-empty model key, send the request to
-	// the model cache to acquire a new child node
-	_model.node = GlobalModelCache().getModelNode(_model.path);
+	// We have a non-empty model key, send the request to the model cache to acquire
+	// a new child node. Entities outside the scene can live with a placeholder for a while.
+	_model.node = _parentNode.inScene() ?
+		GlobalModelCache().getModelNode(_model.path) :
+		GlobalModelCache().getModelNodeAsync(_model.path);
 
+	auto placeholder = std::dynamic_pointer_cast<model::IModelPlaceholder>(_model.node);
+
+	if (placeholder)
+	{
+		placeholder->signal_modelLoaded().connect(
+			sigc::bind(sigc::mem_fun(*this, &ModelKey::onModelLoaded), _model.node.get()));
+	}
+
+	insertModelNode();
+}
+
+void ModelKey::insertModelNode()
+{
 	// The model loader should not return NULL, but a sanity check is always ok
 	if (_model.node)
 	{
@@ -101,7 +118,11 @@ void ModelKey::attachModelNodeKeepinSkin()
         // Check if we have a skinnable model and remember the skin
 	    SkinnedModelPtr skinned = std::dynamic_pointer_cast<SkinnedModel>(_model.node);
 
-	    std::string skin = skinned ? skinned->getSkin() : "";
+        // Placeholders don't know about skins, use the one we received last
+	    std::string skin = skinned ? skinned->getSkin() :
+            std::dynamic_pointer_cast<model::IModelPlaceholder>(_model.node) ? _skin : "";
+
+        _skin = skin;
 	
 	    attachModelNode();
 	
@@ -120,8 +141,42 @@ void ModelKey::attachModelNodeKeepinSkin()
     }
 }
 
+void ModelKey::ensureModelLoaded()
+{
+	if (!std::dynamic_pointer_cast<model::IModelPlaceholder>(_model.node))
+	{
+		return;
+	}
+
+	// This will wait for the pending load
+	onModelLoaded(GlobalModelCache().getModelNode(_model.path), _model.node.get());
+}
+
+void ModelKey::onModelLoaded(const scene::INodePtr& modelNode, const scene::INode* placeholder)
+{
+	if (_model.node.get() != placeholder)
+	{
+		return; // the model has been changed in the meantime
+	}
+
+	_parentNode.removeChildNode(_model.node);
+
+	_model.node = modelNode;
+
+	insertModelNode();
+
+	SkinnedModelPtr skinned = std::dynamic_pointer_cast<SkinnedModel>(_model.node);
+
+	if (skinned && !_skin.empty())
+	{
+		skinned->skinChanged(_skin);
+	}
+}
+
 void ModelKey::skinChanged(const std::string& value)
 {
+	_skin = value;
+
 	// Check if we have a skinnable model
 	SkinnedModelPtr skinned = std::dynamic_pointer_cast<SkinnedModel>(_model.node);
 
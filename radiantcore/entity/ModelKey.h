@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <sigc++/trackable.h>
 #include "inode.h"
 #include "mapfile.h"
 #include "ObservedUndoable.h"
@@ -9,8 +10,13 @@
  * greebo: A ModelKey object watches the "model" spawnarg of
  * an entity. As soon as the keyvalue changes, the according
  * modelnode is loaded and inserted into the entity's Traversable.
+ *
+ * As long as the entity is not part of the scene (e.g. during map loading)
+ * models missing in the cache are loaded in the background, a placeholder node
+ * is inserted meanwhile which is swapped as soon as the model has arrived.
  */
-class ModelKey
+class ModelKey :
+	public sigc::trackable
 {
 private:
 	// The parent node, where the model node can be added to (as child)
@@ -24,6 +30,9 @@ private:
 
 	ModelNodeAndPath _model;
 
+	// The last value passed to skinChanged(), to be applied when a placeholder is replaced
+	std::string _skin;
+
 	// To deactivate model handling during node destruction
 	bool _active;
 
@@ -48,6 +57,10 @@ public:
 	// Returns the reference to the "singleton" model node
 	const scene::INodePtr& getNode() const;
 
+	// Replaces a placeholder node with the actual model, blocking until it is loaded.
+	// To be called before the parent entity is inserted into the scene.
+	void ensureModelLoaded();
+
 	void connectUndoSystem(IMapFileChangeTracker& changeTracker);
 	void disconnectUndoSystem(IMapFileChangeTracker& changeTracker);
 
@@ -58,5 +71,11 @@ private:
     // Attaches a model node, making sure that the skin setting is kept
     void attachModelNodeKeepinSkin();
 
+	// Adds the model node as child to the parent node, inheriting its layers and visibility
+	void insertModelNode();
+
+	// Callback of a placeholder's modelLoaded signal
+	void onModelLoaded(const scene::INodePtr& modelNode, const scene::INode* placeholder);
+
 	void importState(const ModelNodeAndPath& data);
 };
@@ -2,18 +2,25 @@
 
 #include "ieclass.h"
 #include "debugging/debugging.h"
-#include "string/predicate.h"
+#include <algorithm>
 #include <functional>
 
 namespace entity
 {
 
+namespace
+{
+	// Entities with at least this many spawnargs maintain a key index
+	constexpr std::size_t KEY_INDEX_THRESHOLD = 16;
+}
+
 SpawnArgs::SpawnArgs(const IEntityClassPtr& eclass) :
 	_eclass(eclass),
 	_undo(_keyValues, std::bind(&SpawnArgs::importState, this, std::placeholders::_1), "EntityKeyValues"),
 	_instanced(false),
 	_observerMutex(false),
 	_isContainer(!eclass->isFixedSize()),
+	_changeDepth(0),
 	_attachments(eclass->getName())
 {
     // Parse attachment keys
@@ -27,6 +34,7 @@ SpawnArgs::SpawnArgs(const SpawnArgs& other) :
 	_instanced(false),
 	_observerMutex(false),
 	_isContainer(other._isContainer),
+	_changeDepth(0),
 	_attachments(other._attachments)
 {
     // Copy keyvalue strings, not actual KeyValue pointers
@@ -36,6 +44,11 @@ SpawnArgs::SpawnArgs(const SpawnArgs& other) :
     }
 }
 
+SpawnArgs::~SpawnArgs()
+{
+	KeyValueChangeBatch::Dequeue(*this);
+}
+
 void SpawnArgs::parseAttachments()
 {
     // Parse the keys
@@ -51,9 +64,9 @@ void SpawnArgs::parseAttachments()
 
 bool SpawnArgs::isModel() const
 {
-	std::string name = getKeyValue("name");
-	std::string model = getKeyValue("model");
-	std::string classname = getKeyValue("classname");
+	std::string name = getKeyValue(atom::Name());
+	std::string model = getKeyValue(atom::Model());
+	std::string classname = getKeyValue(atom::Classname());
 
 	return (classname == "func_static" && !name.empty() && name != model);
 }
@@ -188,10 +201,73 @@ void SpawnArgs::setKeyValue(const std::string& key, const std::string& value)
 	}
 }
 
+void SpawnArgs::beginKeyValueChanges()
+{
+	if (_changeDepth++ > 0) return;
+
+	for (const auto& pair : _keyValues)
+	{
+		pair.second->setNotificationsDeferred(true);
+	}
+}
+
+void SpawnArgs::endKeyValueChanges()
+{
+	ASSERT_MESSAGE(_changeDepth > 0, "endKeyValueChanges() without beginKeyValueChanges()");
+
+	if (_changeDepth == 0 || --_changeDepth > 0) return;
+
+	// Copy the list, the key observers might insert or remove spawnargs
+	auto keyValues = _keyValues;
+
+	for (const auto& pair : keyValues)
+	{
+		pair.second->setNotificationsDeferred(false);
+	}
+
+	if (KeyValueChangeBatch::IsActive())
+	{
+		// The global batch takes over the key change notifications
+		if (!_pendingKeyChanges.empty())
+		{
+			KeyValueChangeBatch::Enqueue(*this);
+		}
+	}
+	else
+	{
+		sendDeferredNotifications();
+	}
+}
+
+void SpawnArgs::sendDeferredNotifications()
+{
+	// Still collecting changes, endKeyValueChanges() will send them
+	if (_changeDepth > 0) return;
+
+	std::vector<KeyAtom> pendingKeys;
+	pendingKeys.swap(_pendingKeyChanges);
+
+	for (const auto& atom : pendingKeys)
+	{
+		auto i = find(atom);
+
+		// Keys removed in the meantime have been reported through onKeyErase
+		if (i != _keyValues.end())
+		{
+			notifyChange(i->first, i->second->get());
+		}
+	}
+}
+
+bool SpawnArgs::notificationsDeferred() const
+{
+	return _changeDepth > 0 || KeyValueChangeBatch::IsActive();
+}
+
 std::string SpawnArgs::getKeyValue(const std::string& key) const
 {
 	// Lookup the key in the map
-	KeyValues::const_iterator i = find(key);
+	KeyValues::const_iterator i = find(KeyAtom::Find(key));
 
 	// If key is found, return it, otherwise lookup the default value on
 	// the entity class
@@ -205,10 +281,23 @@ std::string SpawnArgs::getKeyValue(const std::string& key) const
 	}
 }
 
+std::string SpawnArgs::getKeyValue(const KeyAtom& key) const
+{
+	KeyValues::const_iterator i = find(key);
+
+	if (i != _keyValues.end())
+	{
+		return i->second->get();
+	}
+
+	// Invalid atoms have an empty name, which is not an attribute either
+	return _eclass->getAttribute(key.getName()).getValue();
+}
+
 bool SpawnArgs::isInherited(const std::string& key) const
 {
 	// Check if we have the key in the local keyvalue map
-	bool definedLocally = (find(key) != _keyValues.end());
+	bool definedLocally = (find(KeyAtom::Find(key)) != _keyValues.end());
 
 	// The value is inherited, if it doesn't exist locally and the inherited one is not empty
 	return (!definedLocally && !_eclass->getAttribute(key).getValue().empty());
@@ -220,6 +309,11 @@ void SpawnArgs::forEachAttachment(AttachmentFunc func) const
 }
 
 EntityKeyValuePtr SpawnArgs::getEntityKeyValue(const std::string& key)
+{
+	return getEntityKeyValue(KeyAtom::Find(key));
+}
+
+EntityKeyValuePtr SpawnArgs::getEntityKeyValue(const KeyAtom& key)
 {
 	KeyValues::const_iterator found = find(key);
 
@@ -228,7 +322,7 @@ EntityKeyValuePtr SpawnArgs::getEntityKeyValue(const std::string& key)
 
 bool SpawnArgs::isWorldspawn() const
 {
-	return getKeyValue("classname") == "worldspawn";
+	return getKeyValue(atom::Classname()) == "worldspawn";
 }
 
 bool SpawnArgs::isContainer() const
@@ -283,6 +377,11 @@ void SpawnArgs::notifyErase(const std::string& key, KeyValue& value)
 }
 
 void SpawnArgs::insert(const std::string& key, const KeyValuePtr& keyValue)
+{
+	insert(KeyAtom::Intern(key), key, keyValue);
+}
+
+void SpawnArgs::insert(const KeyAtom& atom, const std::string& key, const KeyValuePtr& keyValue)
 {
 	// Insert the new key at the end of the list
 	KeyValues::iterator i = _keyValues.insert(
@@ -290,6 +389,22 @@ void SpawnArgs::insert(const std::string& key, const KeyValuePtr& keyValue)
 		KeyValuePair(key, keyValue)
 	);
 
+	_keyAtoms.push_back(atom);
+
+	if (_changeDepth > 0)
+	{
+		keyValue->setNotificationsDeferred(true);
+	}
+
+	if (!_keyIndex.empty())
+	{
+		_keyIndex.emplace(atom, _keyAtoms.size() - 1);
+	}
+	else if (_keyAtoms.size() >= KEY_INDEX_THRESHOLD)
+	{
+		rebuildKeyIndex();
+	}
+
 	// Dereference the iterator to get a KeyValue& reference and notify the observers
 	notifyInsert(key, *i->second);
 
@@ -301,17 +416,35 @@ void SpawnArgs::insert(const std::string& key, const KeyValuePtr& keyValue)
 
 void SpawnArgs::insert(const std::string& key, const std::string& value)
 {
+	auto atom = KeyAtom::Intern(key);
+
 	// Try to lookup the key in the map
-	KeyValues::iterator i = find(key);
+	KeyValues::iterator i = find(atom);
 
 	if (i != _keyValues.end())
     {
 		// Key has been found
 		i->second->assign(value);
 
-        // Notify observers of key change, using the found key as argument
-		// as the case of the incoming "key" might be different
-        notifyChange(i->first, value);
+		if (notificationsDeferred())
+		{
+			// Report the change once, when the batch is done
+			if (std::find(_pendingKeyChanges.begin(), _pendingKeyChanges.end(), atom) == _pendingKeyChanges.end())
+			{
+				if (_pendingKeyChanges.empty() && KeyValueChangeBatch::IsActive())
+				{
+					KeyValueChangeBatch::Enqueue(*this);
+				}
+
+				_pendingKeyChanges.push_back(atom);
+			}
+		}
+		else
+		{
+			// Notify observers of key change, using the found key as argument
+			// as the case of the incoming "key" might be different
+			notifyChange(i->first, value);
+		}
 	}
 	else
 	{
@@ -319,10 +452,7 @@ void SpawnArgs::insert(const std::string& key, const std::string& value)
 		_undo.save();
 
 		// Allocate a new KeyValue object and insert it into the map
-		insert(
-			key,
-			KeyValuePtr(new KeyValue(value, _eclass->getAttribute(key).getValue()))
-		);
+		insert(atom, key, std::make_shared<KeyValue>(value, _eclass->getAttribute(key).getValue()));
 	}
 }
 
@@ -337,9 +467,19 @@ void SpawnArgs::erase(const KeyValues::iterator& i)
 	std::string key(i->first);
 	KeyValuePtr value(i->second);
 
+	// Deliver any pending value change before the observers are detached
+	value->setNotificationsDeferred(false);
+
 	// Actually delete the object from the list
+	_keyAtoms.erase(_keyAtoms.begin() + (i - _keyValues.begin()));
 	_keyValues.erase(i);
 
+	if (!_keyIndex.empty())
+	{
+		// The positions of the subsequent keys have changed
+		rebuildKeyIndex();
+	}
+
 	// Notify about the deletion
 	notifyErase(key, *value);
 
@@ -350,7 +490,7 @@ void SpawnArgs::erase(const KeyValues::iterator& i)
 void SpawnArgs::erase(const std::string& key)
 {
 	// Try to lookup the key
-	KeyValues::iterator i = find(key);
+	KeyValues::iterator i = find(KeyAtom::Find(key));
 
 	if (i != _keyValues.end())
 	{
@@ -359,36 +499,46 @@ void SpawnArgs::erase(const std::string& key)
 	}
 }
 
-SpawnArgs::KeyValues::const_iterator SpawnArgs::find(const std::string& key) const
+SpawnArgs::KeyValues::const_iterator SpawnArgs::find(const KeyAtom& key) const
+{
+	return _keyValues.begin() + findIndex(key);
+}
+
+SpawnArgs::KeyValues::iterator SpawnArgs::find(const KeyAtom& key)
+{
+	return _keyValues.begin() + findIndex(key);
+}
+
+std::size_t SpawnArgs::findIndex(const KeyAtom& key) const
 {
-	for (KeyValues::const_iterator i = _keyValues.begin();
-		 i != _keyValues.end();
-		 ++i)
+	// Keys that have never been interned can't be present
+	if (!key.isValid())
 	{
-		if (string::iequals(i->first, key))
-		{
-			return i;
-		}
+		return _keyAtoms.size();
+	}
+
+	if (!_keyIndex.empty())
+	{
+		auto found = _keyIndex.find(key);
+		return found != _keyIndex.end() ? found->second : _keyAtoms.size();
 	}
 
-	// Not found
-	return _keyValues.end();
+	return std::find(_keyAtoms.begin(), _keyAtoms.end(), key) - _keyAtoms.begin();
 }
 
-SpawnArgs::KeyValues::iterator SpawnArgs::find(const std::string& key)
+void SpawnArgs::rebuildKeyIndex()
 {
-	for (KeyValues::iterator i = _keyValues.begin();
-		 i != _keyValues.end();
-		 ++i)
+	_keyIndex.clear();
+
+	if (_keyAtoms.size() < KEY_INDEX_THRESHOLD)
 	{
-		if (string::iequals(i->first, key))
-		{
-			return i;
-		}
+		return;
 	}
 
-	// Not found
-	return _keyValues.end();
+	for (std::size_t i = 0; i < _keyAtoms.size(); ++i)
+	{
+		_keyIndex.emplace(_keyAtoms[i], i);
+	}
 }
 
 } // namespace entity
@@ -3,7 +3,9 @@
 #include "AttachmentData.h"
 
 #include <vector>
+#include <unordered_map>
 #include "KeyValue.h"
+#include "KeyAtom.h"
 #include <memory>
 
 namespace entity {
@@ -16,9 +18,12 @@ namespace entity {
  * The actual rendering and entity behaviour is handled by the EntityNode.
  *
  * It's possible to attach observers to this entity to get notified upon
- * key/value changes.
+ * key/value changes. Changes made during a batch (see beginKeyValueChanges)
+ * are reported once per key when the batch ends.
  */
-class SpawnArgs: public Entity
+class SpawnArgs:
+	public Entity,
+	public DeferredNotification
 {
 	IEntityClassPtr _eclass;
 
@@ -31,6 +36,13 @@ class SpawnArgs: public Entity
 	typedef std::vector<KeyValuePair> KeyValues;
 	KeyValues _keyValues;
 
+	// The interned keys of the pairs in _keyValues, in the same order
+	std::vector<KeyAtom> _keyAtoms;
+
+	// Maps the keys to their position in _keyValues. Only entities with
+	// many spawnargs get an index, the others are searched linearly.
+	std::unordered_map<KeyAtom, std::size_t> _keyIndex;
+
 	typedef std::set<Observer*> Observers;
 	Observers _observers;
 
@@ -41,6 +53,12 @@ class SpawnArgs: public Entity
 
 	bool _isContainer;
 
+	// Nesting level of the beginKeyValueChanges() calls
+	std::size_t _changeDepth;
+
+	// The keys whose onKeyChange notification has been held back
+	std::vector<KeyAtom> _pendingKeyChanges;
+
     // Store attachment information
     AttachmentData _attachments;
 
@@ -51,6 +69,8 @@ public:
 	// Copy constructor
 	SpawnArgs(const SpawnArgs& other);
 
+	~SpawnArgs();
+
 	void importState(const KeyValues& keyValues);
 
     /* Entity implementation */
@@ -66,6 +86,8 @@ public:
 	std::string getKeyValue(const std::string& key) const override;
 	bool isInherited(const std::string& key) const override;
     void forEachAttachment(AttachmentFunc func) const override;
+	void beginKeyValueChanges() override;
+	void endKeyValueChanges() override;
 
 	bool isWorldspawn() const override;
 	bool isContainer() const override;
@@ -78,9 +100,17 @@ public:
 	// Only returns non-NULL for non-inherited keyvalues.
 	EntityKeyValuePtr getEntityKeyValue(const std::string& key);
 
+	// Overloads taking an interned key, saving the lookup of the key string
+	std::string getKeyValue(const KeyAtom& key) const;
+	EntityKeyValuePtr getEntityKeyValue(const KeyAtom& key);
+
 	bool isOfType(const std::string& className) override;
 
+	// DeferredNotification implementation
+	void sendDeferredNotifications() override;
+
 private:
+	bool notificationsDeferred() const;
 
     // Parse attachment information from def_attach and related keys (which are
     // most likely on the entity class, not the entity itself)
@@ -92,13 +122,20 @@ private:
 	void notifyErase(const std::string& key, KeyValue& value);
 
 	void insert(const std::string& key, const KeyValuePtr& keyValue);
+	void insert(const KeyAtom& atom, const std::string& key, const KeyValuePtr& keyValue);
 	void insert(const std::string& key, const std::string& value);
 
 	void erase(const KeyValues::iterator& i);
 	void erase(const std::string& key);
 
-	KeyValues::iterator find(const std::string& key);
-	KeyValues::const_iterator find(const std::string& key) const;
+	KeyValues::iterator find(const KeyAtom& key);
+	KeyValues::const_iterator find(const KeyAtom& key) const;
+
+	// Returns the position of the key in _keyValues, or the size of _keyValues if not found
+	std::size_t findIndex(const KeyAtom& key) const;
+
+	// Creates or clears the key index, depending on the number of spawnargs
+	void rebuildKeyIndex();
 };
 
 } // namespace entity
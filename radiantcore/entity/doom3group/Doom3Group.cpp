@@ -63,6 +63,10 @@ Vector3& Doom3Group::getOrigin() {
 	return m_origin;
 }
 
+const Vector3& Doom3Group::getOrigin() const {
+	return m_origin;
+}
+
 const Vector3& Doom3Group::getUntransformedOrigin() const
 {
     return m_originKey.get();
@@ -275,10 +279,10 @@ void Doom3Group::construct()
 
 	m_rotation.setIdentity();
 
-	_owner.addKeyObserver("origin", m_originKey);
-	_owner.addKeyObserver("angle", _angleObserver);
-	_owner.addKeyObserver("rotation", _rotationObserver);
-	_owner.addKeyObserver("name", _nameObserver);
+	_owner.addKeyObserver(atom::Origin(), m_originKey);
+	_owner.addKeyObserver(atom::Angle(), _angleObserver);
+	_owner.addKeyObserver(atom::Rotation(), _rotationObserver);
+	_owner.addKeyObserver(atom::Name(), _nameObserver);
 	_owner.addKeyObserver(curve_Nurbs, m_curveNURBS);
 	_owner.addKeyObserver(curve_CatmullRomSpline, m_curveCatmullRom);
 
@@ -289,10 +293,10 @@ void Doom3Group::destroy()
 {
 	modelChanged("");
 
-	_owner.removeKeyObserver("origin", m_originKey);
-	_owner.removeKeyObserver("angle", _angleObserver);
-	_owner.removeKeyObserver("rotation", _rotationObserver);
-	_owner.removeKeyObserver("name", _nameObserver);
+	_owner.removeKeyObserver(atom::Origin(), m_originKey);
+	_owner.removeKeyObserver(atom::Angle(), _angleObserver);
+	_owner.removeKeyObserver(atom::Rotation(), _rotationObserver);
+	_owner.removeKeyObserver(atom::Name(), _nameObserver);
 	_owner.removeKeyObserver(curve_Nurbs, m_curveNURBS);
 	_owner.removeKeyObserver(curve_CatmullRomSpline, m_curveCatmullRom);
 }
@@ -93,6 +93,7 @@ public:
 	 */
 	void addOriginToChildren() override;
 	void removeOriginFromChildren() override;
+	Vector3 getChildPrimitiveOrigin() const override;
 
 	// Renderable implementation
 	void renderSolid(RenderableCollector& collector, const VolumeTest& volume) const override;
@@ -29,9 +29,9 @@ EclassModelNode::EclassModelNode(const EclassModelNode& other) :
 
 EclassModelNode::~EclassModelNode()
 {
-    removeKeyObserver("origin", _originKey);
-    removeKeyObserver("rotation", _rotationObserver);
-    removeKeyObserver("angle", _angleObserver);
+    removeKeyObserver(atom::Origin(), _originKey);
+    removeKeyObserver(atom::Rotation(), _rotationObserver);
+    removeKeyObserver(atom::Angle(), _angleObserver);
 }
 
 EclassModelNodePtr EclassModelNode::Create(const IEntityClassPtr& eclass)
@@ -51,9 +51,9 @@ void EclassModelNode::construct()
 
     _rotation.setIdentity();
 
-    addKeyObserver("angle", _angleObserver);
-	addKeyObserver("rotation", _rotationObserver);
-    addKeyObserver("origin", _originKey);
+    addKeyObserver(atom::Angle(), _angleObserver);
+	addKeyObserver(atom::Rotation(), _rotationObserver);
+    addKeyObserver(atom::Origin(), _originKey);
 }
 
 // Snappable implementation
@@ -40,16 +40,16 @@ GenericEntityNode::~GenericEntityNode()
 	if (!_allow3Drotations)
 	{
 		// Ordinary rotation (2D around z axis), use angle key observer
-		removeKeyObserver("angle", _angleObserver);
+		removeKeyObserver(atom::Angle(), _angleObserver);
 	}
 	else
 	{
 		// Full 3D rotations allowed, observe both keys using the rotation key observer
-		removeKeyObserver("angle", _angleObserver);
-		removeKeyObserver("rotation", _rotationObserver);
+		removeKeyObserver(atom::Angle(), _angleObserver);
+		removeKeyObserver(atom::Rotation(), _rotationObserver);
 	}
 
-	removeKeyObserver("origin", m_originKey);
+	removeKeyObserver(atom::Origin(), m_originKey);
 }
 
 GenericEntityNodePtr GenericEntityNode::Create(const IEntityClassPtr& eclass)
@@ -74,7 +74,7 @@ void GenericEntityNode::construct()
 		_angleObserver.setCallback(std::bind(&AngleKey::angleChanged, &m_angleKey, std::placeholders::_1));
 
 		// Ordinary rotation (2D around z axis), use angle key observer
-		addKeyObserver("angle", _angleObserver);
+		addKeyObserver(atom::Angle(), _angleObserver);
 	}
 	else
 	{
@@ -82,11 +82,11 @@ void GenericEntityNode::construct()
 		_rotationObserver.setCallback(std::bind(&RotationKey::rotationChanged, &m_rotationKey, std::placeholders::_1));
 
 		// Full 3D rotations allowed, observe both keys using the rotation key observer
-		addKeyObserver("angle", _angleObserver);
-		addKeyObserver("rotation", _rotationObserver);
+		addKeyObserver(atom::Angle(), _angleObserver);
+		addKeyObserver(atom::Rotation(), _rotationObserver);
 	}
 
-	addKeyObserver("origin", m_originKey);
+	addKeyObserver(atom::Origin(), m_originKey);
 }
 
 void GenericEntityNode::snapto(float snap)
@@ -107,10 +107,10 @@ void Light::construct()
     // which might set them to true again.
     m_useLightTarget = m_useLightUp = m_useLightRight = m_useLightStart = m_useLightEnd = false;
 
-    _owner.addKeyObserver("origin", m_originKey);
+    _owner.addKeyObserver(atom::Origin(), m_originKey);
 
-    _owner.addKeyObserver("angle", _angleObserver);
-    _owner.addKeyObserver("rotation", _rotationObserver);
+    _owner.addKeyObserver(atom::Angle(), _angleObserver);
+    _owner.addKeyObserver(atom::Rotation(), _rotationObserver);
     _owner.addKeyObserver("light_radius", _lightRadiusObserver);
     _owner.addKeyObserver("light_center", _lightCenterObserver);
     _owner.addKeyObserver("light_rotation", _lightRotationObserver);
@@ -134,10 +134,10 @@ void Light::construct()
 
 void Light::destroy()
 {
-    _owner.removeKeyObserver("origin", m_originKey);
+    _owner.removeKeyObserver(atom::Origin(), m_originKey);
 
-    _owner.removeKeyObserver("angle", _angleObserver);
-    _owner.removeKeyObserver("rotation", _rotationObserver);
+    _owner.removeKeyObserver(atom::Angle(), _angleObserver);
+    _owner.removeKeyObserver(atom::Rotation(), _rotationObserver);
 
     _owner.removeKeyObserver("light_radius", _lightRadiusObserver);
     _owner.removeKeyObserver("light_center", _lightCenterObserver);
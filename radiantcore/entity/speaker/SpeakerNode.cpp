@@ -62,7 +62,7 @@ void SpeakerNode::construct()
 	m_aabb_local = _spawnArgs.getEntityClass()->getBounds();
 	m_aabb_border = m_aabb_local;
 
-	addKeyObserver("origin", m_originKey);
+	addKeyObserver(atom::Origin(), m_originKey);
 	addKeyObserver(KEY_S_SHADER, _shaderObserver);
 	addKeyObserver(KEY_S_MINDISTANCE, _radiusMinObserver);
 	addKeyObserver(KEY_S_MAXDISTANCE, _radiusMaxObserver);
@@ -70,7 +70,7 @@ void SpeakerNode::construct()
 
 SpeakerNode::~SpeakerNode()
 {
-	removeKeyObserver("origin", m_originKey);
+	removeKeyObserver(atom::Origin(), m_originKey);
 	removeKeyObserver(KEY_S_SHADER, _shaderObserver);
 	removeKeyObserver(KEY_S_MINDISTANCE, _radiusMinObserver);
 	removeKeyObserver(KEY_S_MAXDISTANCE, _radiusMaxObserver);
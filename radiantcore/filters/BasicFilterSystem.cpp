@@ -1,6 +1,7 @@
 #include "BasicFilterSystem.h"
 
 #include <functional>
+#include <algorithm>
 
 #include "iradiant.h"
 #include "itextstream.h"
@@ -8,6 +9,8 @@
 #include "iregistry.h"
 #include "igame.h"
 #include "ishaders.h"
+#include "ieclass.h"
+#include "ientity.h"
 
 #include "module/StaticModule.h"
 #include "InstanceUpdateWalker.h"
@@ -28,6 +31,11 @@ namespace
 
 	// Registry key for persistent filter setting
 	const std::string RKEY_USER_ACTIVE_FILTERS = RKEY_USER_FILTER_BASE + "//activeFilter";
+
+	bool hasRulesOfType(const FilterRules& rules, FilterRule::Type type)
+	{
+		return std::any_of(rules.begin(), rules.end(), [&](const FilterRule& rule) { return rule.type == type; });
+	}
 }
 
 void BasicFilterSystem::setAllFilterStates(bool state)
@@ -393,8 +401,8 @@ void BasicFilterSystem::setFilterState(const std::string& filter, bool state)
 	// loaded from the filters themselves
 	_visibilityCache.clear();
 
-	// Update the scenegraph instances
-	update();
+	// Update the scenegraph instances affected by this filter
+	updateAffectedBy(_availableFilters.find(filter)->second->getRuleSet());
 
 	_filterConfigChangedSignal.emit();
 
@@ -454,7 +462,8 @@ bool BasicFilterSystem::removeFilter(const std::string& filter)
 		_activeFilters.erase(found);
 	}
 
-	// Now remove the object from the available filters too
+	// Now remove the object from the available filters too, keeping its rules for the update
+	auto removedRules = f->second->getRuleSet();
 	_availableFilters.erase(f);
 
 	_filterCollectionChangedSignal.emit();
@@ -466,7 +475,7 @@ bool BasicFilterSystem::removeFilter(const std::string& filter)
 
 		_filterConfigChangedSignal.emit();
 
-		update();
+		updateAffectedBy(removedRules);
 	}
 
 	return true;
@@ -540,9 +549,10 @@ bool BasicFilterSystem::isVisible(const FilterRule::Type type, const std::string
 {
 	// Check if this item is in the visibility cache, returning
 	// its cached value if found
-	auto cacheIter = _visibilityCache.find(name);
-	
-	if (cacheIter != _visibilityCache.end())
+	auto& cache = _visibilityCache[type];
+	auto cacheIter = cache.find(name);
+
+	if (cacheIter != cache.end())
 	{
 		return cacheIter->second;
 	}
@@ -564,13 +574,19 @@ bool BasicFilterSystem::isVisible(const FilterRule::Type type, const std::string
 	}
 
 	// Cache the result and return to caller
-	_visibilityCache.emplace(name, visFlag);
+	cache.emplace(name, visFlag);
 
 	return visFlag;
 }
 
 bool BasicFilterSystem::isEntityVisible(const FilterRule::Type type, const Entity& entity)
 {
+	// Entity class rules only depend on the class name, these can use the cache
+	if (type == FilterRule::TYPE_ENTITYCLASS && entity.getEntityClass())
+	{
+		return isVisible(type, entity.getEntityClass()->getName());
+	}
+
 	// Otherwise, walk the list of active filters to find a value for
 	// this item.
 	bool visFlag = true; // default if no filters modify it
@@ -603,6 +619,10 @@ bool BasicFilterSystem::setFilterRules(const std::string& filter, const FilterRu
 
 	if (f != _availableFilters.end() && !f->second->isReadOnly())
 	{
+		// The nodes affected by either the old or the new rules need an update
+		auto affectedRules = f->second->getRuleSet();
+		affectedRules.insert(affectedRules.end(), ruleSet.begin(), ruleSet.end());
+
 		// Apply the ruleset
 		f->second->setRules(ruleSet);
 
@@ -611,7 +631,10 @@ bool BasicFilterSystem::setFilterRules(const std::string& filter, const FilterRu
 
 		_filterConfigChangedSignal.emit();
 
-		update();
+		if (getFilterState(filter))
+		{
+			updateAffectedBy(affectedRules);
+		}
 
 		return true;
 	}
@@ -627,6 +650,28 @@ void BasicFilterSystem::updateSubgraph(const scene::INodePtr& root)
 	root->traverse(walker);
 }
 
+void BasicFilterSystem::updateAffectedBy(const FilterRules& rules)
+{
+	bool textureRules = hasRulesOfType(rules, FilterRule::TYPE_TEXTURE);
+	bool objectRules = hasRulesOfType(rules, FilterRule::TYPE_OBJECT);
+	bool entityRules = hasRulesOfType(rules, FilterRule::TYPE_ENTITYCLASS) ||
+		hasRulesOfType(rules, FilterRule::TYPE_ENTITYKEYVALUE);
+
+	// Brushes and patches judge their visibility on basis of their materials
+	if (textureRules)
+	{
+		updateShaders();
+	}
+
+	if (!GlobalSceneGraph().root() || !(textureRules || objectRules || entityRules))
+	{
+		return;
+	}
+
+	InstanceUpdateWalker walker(*this, entityRules, textureRules || objectRules);
+	GlobalSceneGraph().root()->traverse(walker);
+}
+
 // Update scenegraph instances with filtered status
 void BasicFilterSystem::updateScene() 
 {
@@ -5,6 +5,7 @@
 #include "icommandsystem.h"
 
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <string>
 #include <iostream>
@@ -29,10 +30,11 @@ private:
 	// Second table containing just the active filters
 	FilterTable _activeFilters;
 
-	// Cache of visibility flags for item names, to avoid having to
-	// traverse the active filter list for each lookup
-	typedef std::map<std::string, bool> StringFlagCache;
-	StringFlagCache _visibilityCache;
+	// Cache of visibility flags for item names (per rule type), to avoid having
+	// to traverse the active filter list for each lookup. Valid for the current
+	// set of active filters and their rules, it's cleared when any of them changes.
+	typedef std::unordered_map<std::string, bool> StringFlagCache;
+	std::map<FilterRule::Type, StringFlagCache> _visibilityCache;
 
     sigc::signal<void> _filterConfigChangedSignal;
     sigc::signal<void> _filterCollectionChangedSignal;
@@ -48,6 +50,10 @@ private:
 
 	void updateShaders();
 
+	// Updates the materials and scene nodes affected by the given rules,
+	// to be called after a filter has been (de-)activated or its rules changed
+	void updateAffectedBy(const FilterRules& rules);
+
 	void addFiltersFromXML(const xml::NodeList& nodes, bool readOnly);
 
 	XmlFilterEventAdapter::Ptr ensureEventAdapter(XMLFilter& filter);
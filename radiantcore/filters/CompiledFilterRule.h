@@ -0,0 +1,102 @@
+#pragma once
+
+#include <regex>
+#include <string>
+#include "ifilter.h"
+#include "itextstream.h"
+
+namespace filters
+{
+
+/**
+ * A FilterRule with its match expression prepared for repeated queries.
+ *
+ * The expression is compiled to a std::regex once. Expressions without any
+ * regex metacharacters are compared as plain strings instead, expressions
+ * consisting of a literal followed by ".*" as string prefix.
+ */
+class CompiledFilterRule
+{
+public:
+	FilterRule::Type type;
+
+	// The entity key, only applies for type "entitykeyvalue"
+	std::string entityKey;
+
+	// true for action="show", false for action="hide"
+	bool show;
+
+private:
+	enum class MatchType
+	{
+		Literal,
+		Prefix,
+		Regex,
+		Invalid,	// can't be compiled, never matches
+	};
+
+	MatchType _matchType;
+
+	// The string to compare against for the literal and prefix types
+	std::string _literal;
+
+	std::regex _regex;
+
+public:
+	CompiledFilterRule(const FilterRule& rule) :
+		type(rule.type),
+		entityKey(rule.entityKey),
+		show(rule.show),
+		_matchType(MatchType::Regex)
+	{
+		const std::string& match = rule.match;
+
+		if (isLiteral(match))
+		{
+			_matchType = MatchType::Literal;
+			_literal = match;
+		}
+		else if (match.size() >= 2 && match.compare(match.size() - 2, 2, ".*") == 0 &&
+			isLiteral(match.substr(0, match.size() - 2)))
+		{
+			_matchType = MatchType::Prefix;
+			_literal = match.substr(0, match.size() - 2);
+		}
+		else
+		{
+			try
+			{
+				_regex = std::regex(match);
+			}
+			catch (const std::regex_error& ex)
+			{
+				rWarning() << "Invalid filter rule expression " << match << ": " << ex.what() << std::endl;
+				_matchType = MatchType::Invalid;
+			}
+		}
+	}
+
+	// Returns true if the whole given string is matched by the rule expression
+	bool matches(const std::string& value) const
+	{
+		switch (_matchType)
+		{
+		case MatchType::Literal:
+			return value == _literal;
+		case MatchType::Prefix:
+			return value.compare(0, _literal.size(), _literal) == 0;
+		case MatchType::Regex:
+			return std::regex_match(value, _regex);
+		default:
+			return false;
+		}
+	}
+
+private:
+	static bool isLiteral(const std::string& expression)
+	{
+		return expression.find_first_of("\\^$.|?*+()[]{}") == std::string::npos;
+	}
+};
+
+}
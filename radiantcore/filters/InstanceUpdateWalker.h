@@ -43,6 +43,12 @@ public:
 /**
  * Scenegraph walker to update filtered status of nodes based on the
  * currently active set of filters.
+ *
+ * In incremental mode, only the nodes affected by a changed filter are
+ * evaluated: entities keep their current status unless entity rules changed,
+ * and the children of unchanged entities are only visited if the brush or
+ * patch rules changed. Entities becoming visible get their whole subgraph
+ * evaluated.
  */
 class InstanceUpdateWalker :
 	public scene::NodeVisitor
@@ -59,13 +65,30 @@ private:
 	bool _patchesAreVisible;
 	bool _brushesAreVisible;
 
+	bool _incremental;
+
+	// Which nodes are affected by the changed rules (incremental mode only)
+	bool _updateEntities;
+	bool _updatePrimitives;
+
 public:
+	// Evaluates every node
 	InstanceUpdateWalker(IFilterSystem& filterSystem) :
+		InstanceUpdateWalker(filterSystem, true, true)
+	{
+		_incremental = false;
+	}
+
+	// Evaluates entities if updateEntities is true, brushes and patches if updatePrimitives is true
+	InstanceUpdateWalker(IFilterSystem& filterSystem, bool updateEntities, bool updatePrimitives) :
 		_filterSystem(filterSystem),
 		_hideWalker(true),
 		_showWalker(false),
 		_patchesAreVisible(_filterSystem.isVisible(FilterRule::TYPE_OBJECT, "patch")),
-		_brushesAreVisible(_filterSystem.isVisible(FilterRule::TYPE_OBJECT, "brush"))
+		_brushesAreVisible(_filterSystem.isVisible(FilterRule::TYPE_OBJECT, "brush")),
+		_incremental(true),
+		_updateEntities(updateEntities),
+		_updatePrimitives(updatePrimitives)
 	{}
 
 	bool pre(const scene::INodePtr& node) override
@@ -73,12 +96,20 @@ public:
 		// Check entity eclass and spawnargs
 		if (Node_isEntity(node))
 		{
-			bool isVisible = evaluateEntity(node);
+			bool wasVisible = !node->isFiltered();
+			bool isVisible = _updateEntities ? evaluateEntity(node) : wasVisible;
 
-			setSubgraphFilterStatus(node, isVisible);
+			if (!_incremental || isVisible != wasVisible)
+			{
+				setSubgraphFilterStatus(node, isVisible);
+
+				// If the entity is hidden, don't traverse its child nodes
+				return isVisible;
+			}
 
-			// If the entity is hidden, don't traverse its child nodes
-			return isVisible;
+			// The status of this entity didn't change, the children only
+			// need to be checked if their own rules changed
+			return isVisible && _updatePrimitives;
 		}
 
 		// greebo: Check visibility of Patches
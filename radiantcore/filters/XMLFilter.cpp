@@ -3,7 +3,6 @@
 #include "ientity.h"
 #include "ieclass.h"
 #include "ifilter.h"
-#include <regex>
 #include <algorithm>
 
 namespace filters
@@ -25,24 +24,19 @@ bool XMLFilter::isVisible(const FilterRule::Type type, const std::string& name)
 
 	bool visible = true; // default if unmodified by rules
 
-	for (FilterRules::const_iterator ruleIter = _rules.begin();
-		 ruleIter != _rules.end();
-		 ++ruleIter)
+	for (const auto& rule : _compiledRules)
 	{
 		// Check the item type.
-		if (ruleIter->type != type)
+		if (rule.type != type)
 		{
 			continue;
 		}
 
-		// If we have a rule for this item, use a regex to match the query name
-		// against the "match" parameter
-		std::regex ex(ruleIter->match);
-
-		if (std::regex_match(name, ex))
+		// If we have a rule for this item, match the query name against the "match" parameter
+		if (rule.matches(name))
 		{
 			// Overwrite the visible flag with the value from the rule.
-			visible = ruleIter->show;
+			visible = rule.show;
 		}
 	}
 
@@ -55,32 +49,26 @@ bool XMLFilter::isEntityVisible(const FilterRule::Type type, const Entity& entit
 	bool visible = true; // default if unmodified by rules
 
 	IEntityClassConstPtr eclass = entity.getEntityClass();
-	
-	for (FilterRules::const_iterator ruleIter = _rules.begin();
-		 ruleIter != _rules.end();
-		 ++ruleIter)
+
+	for (const auto& rule : _compiledRules)
 	{
-		if (ruleIter->type != type)
+		if (rule.type != type)
 		{
 			continue;
 		}
 
 		if (type == FilterRule::TYPE_ENTITYCLASS)
 		{
-			std::regex ex(ruleIter->match);
-
-			if (std::regex_match(eclass->getName(), ex))
+			if (rule.matches(eclass->getName()))
 			{
-				visible = ruleIter->show;
+				visible = rule.show;
 			}
 		}
 		else if (type == FilterRule::TYPE_ENTITYKEYVALUE)
 		{
-			std::regex ex(ruleIter->match);
-
-			if (std::regex_match(entity.getKeyValue(ruleIter->entityKey), ex))
+			if (rule.matches(entity.getKeyValue(rule.entityKey)))
 			{
-				visible = ruleIter->show;
+				visible = rule.show;
 			}
 		}
 	}
@@ -116,8 +104,17 @@ const FilterRules& XMLFilter::getRuleSet() const
 
 void XMLFilter::setRules(const FilterRules& rules) {
 	_rules = rules;
+
+	_compiledRules.clear();
+	_compiledRules.reserve(_rules.size());
+
+	for (const auto& rule : _rules)
+	{
+		_compiledRules.emplace_back(rule);
+	}
 }
 
+
 void XMLFilter::updateEventName() {
 	// Construct the eventname out of the filtername (strip the spaces and add "Filter" prefix)
 	_eventName = _name;
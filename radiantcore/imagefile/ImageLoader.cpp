@@ -53,8 +53,7 @@ ImageLoader::ImageLoader()
     addLoaderToMap(std::make_shared<DDSLoader>());
 }
 
-// Load image from VFS
-ImagePtr ImageLoader::imageFromVFS(const std::string& rawName) const
+std::string ImageLoader::findImageFile(const std::string& rawName, ImageTypeLoader::Ptr& loader) const
 {
     // Replace backslashes with forward slashes and strip of
     // the file extension of the provided token, and store
@@ -73,26 +72,50 @@ ImagePtr ImageLoader::imageFromVFS(const std::string& rawName) const
             continue;
         }
 
-        ImageTypeLoader& ldr = *loaderIter->second;
-
 		// Construct the full name of the image to load, including the
 		// prefix (e.g. "dds/") and the file extension.
-		std::string fullName = ldr.getPrefix() + name + "." + extension;
+		std::string fullName = loaderIter->second->getPrefix() + name + "." + extension;
 
-		// Try to open the file (will fail if the extension does not fit)
-		auto file = GlobalFileSystem().openFile(fullName);
-
-		// Has the file been loaded?
-		if (file)
+		// Check the VFS for this file (will fail if the extension does not fit)
+		if (GlobalFileSystem().getFileCount(fullName) > 0)
         {
-			// Try to invoke the imageloader with a reference to the
-			// ArchiveFile
-			return ldr.load(*file);
+            loader = loaderIter->second;
+			return fullName;
 		}
 	}
 
     // File not found
-	return ImagePtr();
+	return std::string();
+}
+
+// Load image from VFS
+ImagePtr ImageLoader::imageFromVFS(const std::string& rawName) const
+{
+    ImageTypeLoader::Ptr loader;
+    auto fullName = findImageFile(rawName, loader);
+
+    if (fullName.empty())
+    {
+        return ImagePtr();
+    }
+
+    // Try to open the file
+    auto file = GlobalFileSystem().openFile(fullName);
+
+    // Try to invoke the imageloader with a reference to the ArchiveFile
+    return file ? loader->load(*file) : ImagePtr();
+}
+
+bool ImageLoader::imageExistsInVFS(const std::string& rawName) const
+{
+    ImageTypeLoader::Ptr loader;
+    return !findImageFile(rawName, loader).empty();
+}
+
+std::string ImageLoader::findImageFileInVFS(const std::string& rawName) const
+{
+    ImageTypeLoader::Ptr loader;
+    return findImageFile(rawName, loader);
 }
 
 ImagePtr ImageLoader::imageFromFile(const std::string& filename) const
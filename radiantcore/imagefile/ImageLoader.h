@@ -23,6 +23,10 @@ private:
 private:
     void addLoaderToMap(const ImageTypeLoader::Ptr& loader);
 
+    // Returns the full VFS path and loader of the first matching image file
+    // for the given name, or an empty string if no file exists
+    std::string findImageFile(const std::string& rawName, ImageTypeLoader::Ptr& loader) const;
+
 public:
 
     // Construct and initialise loaders
@@ -30,6 +34,8 @@ public:
 
     // ImageLoader implementation
     ImagePtr imageFromVFS(const std::string& vfsPath) const override;
+    bool imageExistsInVFS(const std::string& vfsPath) const override;
+    std::string findImageFileInVFS(const std::string& vfsPath) const override;
 	ImagePtr imageFromFile(const std::string& filename) const override;
 
     // RegisterableModule implementation
@@ -10,18 +10,17 @@
 
 #include "ifilesystem.h"
 
-#include "stream/ScopedArchiveBuffer.h"
+#include "stream/utils.h"
 #include "RGBAImage.h"
 
 typedef unsigned char byte;
 
-/* Expanded data source object for stdio input */
+/* Expanded data source object for archive file input */
 
 typedef struct {
     struct jpeg_source_mgr pub;	/* public fields */
 
-    int src_size;
-    JOCTET* src_buffer;
+    InputStream* stream;    /* source stream */
 
     JOCTET* buffer;		/* start of buffer */
     boolean start_of_file;	/* have we gotten any data yet? */
@@ -29,7 +28,7 @@ typedef struct {
 
 typedef my_source_mgr* my_src_ptr;
 
-#define INPUT_BUF_SIZE  4096	/* choose an efficiently fread'able size */
+#define INPUT_BUF_SIZE  65536	/* choose an efficiently readable size */
 
 
 /*
@@ -52,49 +51,19 @@ static void my_init_source(j_decompress_ptr cinfo)
 /*
  * Fill the input buffer --- called whenever buffer is emptied.
  *
- * In typical applications, this should read fresh data into the buffer
- * (ignoring the current state of next_input_byte & bytes_in_buffer),
- * reset the pointer & count to the start of the buffer, and return TRUE
- * indicating that the buffer has been reloaded.  It is not necessary to
- * fill the buffer entirely, only to obtain at least one more byte.
+ * The data is read from the archive file's input stream in blocks of
+ * INPUT_BUF_SIZE bytes, without having to load the whole file into memory.
  *
  * There is no such thing as an EOF return.  If the end of the file has been
- * reached, the routine has a choice of ERREXIT() or inserting fake data into
- * the buffer.  In most cases, generating a warning message and inserting a
- * fake EOI marker is the best course of action --- this will allow the
- * decompressor to output however much of the image is there.  However,
- * the resulting error message is misleading if the real problem is an empty
- * input file, so we handle that case specially.
- *
- * In applications that need to be able to suspend compression due to input
- * not being available yet, a FALSE return indicates that no more data can be
- * obtained right now, but more may be forthcoming later.  In this situation,
- * the decompressor will return to its caller (with an indication of the
- * number of scanlines it has read, if any).  The application should resume
- * decompression after it has loaded more data into the input buffer.  Note
- * that there are substantial restrictions on the use of suspension --- see
- * the documentation.
- *
- * When suspending, the decompressor will back up to a convenient restart point
- * (typically the start of the current MCU). next_input_byte & bytes_in_buffer
- * indicate where the restart point will be if the current call returns FALSE.
- * Data beyond this point must be rescanned after resumption, so move it to
- * the front of the buffer rather than discarding it.
+ * reached, we generate a warning message and insert a fake EOI marker, which
+ * will allow the decompressor to output however much of the image is there.
+ * An empty input file is treated as fatal error.
  */
 
 static boolean my_fill_input_buffer(j_decompress_ptr cinfo)
 {
     my_src_ptr src = (my_src_ptr)cinfo->src;
-    size_t nbytes;
-
-    if (src->src_size > INPUT_BUF_SIZE)
-        nbytes = INPUT_BUF_SIZE;
-    else
-        nbytes = src->src_size;
-
-    memcpy(src->buffer, src->src_buffer, nbytes);
-    src->src_buffer += nbytes;
-    src->src_size -= static_cast<int>(nbytes);
+    size_t nbytes = stream::readBlock(*src->stream, src->buffer, INPUT_BUF_SIZE);
 
     if (nbytes <= 0) {
         if (src->start_of_file)	/* Treat empty input file as fatal error */
@@ -130,9 +99,8 @@ static void my_skip_input_data(j_decompress_ptr cinfo, long num_bytes)
 {
     my_src_ptr src = (my_src_ptr)cinfo->src;
 
-    /* Just a dumb implementation for now.  Could use fseek() except
-     * it doesn't work on pipes.  Not clear that being smart is worth
-     * any trouble anyway --- large skips are infrequent.
+    /* Just a dumb implementation for now.  The archive streams are not
+     * seekable in general, and large skips are infrequent anyway.
      */
     if (num_bytes > 0) {
         while (num_bytes > (long)src->pub.bytes_in_buffer) {
@@ -173,29 +141,22 @@ static void my_term_source(j_decompress_ptr cinfo)
 
 
 /*
- * Prepare for input from a stdio stream.
- * The caller must have already opened the stream, and is responsible
- * for closing it after finishing decompression.
+ * Prepare for input from an archive file stream.
+ * The caller is responsible for keeping the stream alive
+ * until decompression is finished.
  */
 
-static void jpeg_buffer_src(j_decompress_ptr cinfo, void* buffer, int bufsize)
+static void jpeg_stream_src(j_decompress_ptr cinfo, InputStream& stream)
 {
     my_src_ptr src;
 
-    /* The source object and input buffer are made permanent so that a series
-     * of JPEG images can be read from the same file by calling jpeg_stdio_src
-     * only before the first one.  (If we discarded the buffer at the end of
-     * one image, we'd likely lose the start of the next one.)
-     * This makes it unsafe to use this manager and a different source
-     * manager serially with the same JPEG object.  Caveat programmer.
-     */
     if (cinfo->src == NULL) {	/* first time for this JPEG object? */
         cinfo->src = (struct jpeg_source_mgr*)
             (*cinfo->mem->alloc_small) ((j_common_ptr)cinfo, JPOOL_PERMANENT,
                 sizeof(my_source_mgr));
         src = (my_src_ptr)cinfo->src;
         src->buffer = (JOCTET*)
-            (*cinfo->mem->alloc_small) ((j_common_ptr)cinfo, JPOOL_PERMANENT,
+            (*cinfo->mem->alloc_large) ((j_common_ptr)cinfo, JPOOL_PERMANENT,
                 INPUT_BUF_SIZE * sizeof(JOCTET));
     }
 
@@ -205,27 +166,25 @@ static void jpeg_buffer_src(j_decompress_ptr cinfo, void* buffer, int bufsize)
     src->pub.skip_input_data = my_skip_input_data;
     src->pub.resync_to_restart = jpeg_resync_to_restart; /* use default method */
     src->pub.term_source = my_term_source;
-    src->src_buffer = (JOCTET*)buffer;
-    src->src_size = bufsize;
+    src->stream = &stream;
     src->pub.bytes_in_buffer = 0; /* forces fill_input_buffer on first read */
     src->pub.next_input_byte = NULL; /* until buffer loaded */
 }
 
 // =============================================================================
 
-static char errormsg[JMSG_LENGTH_MAX];
-
 typedef struct my_jpeg_error_mgr
 {
     struct jpeg_error_mgr pub;  // "public" fields
     jmp_buf setjmp_buffer;      // for return to caller
+    char errormsg[JMSG_LENGTH_MAX]; // per decoder, images might be loaded by multiple threads
 } bt_jpeg_error_mgr;
 
 static void my_jpeg_error_exit(j_common_ptr cinfo)
 {
     my_jpeg_error_mgr* myerr = (bt_jpeg_error_mgr*)cinfo->err;
 
-    (*cinfo->err->format_message) (cinfo, errormsg);
+    (*cinfo->err->format_message) (cinfo, myerr->errormsg);
 
     longjmp(myerr->setjmp_buffer, 1);
 }
@@ -316,7 +275,7 @@ static void j_putGrayScanlineToRGB(unsigned char* jpegline, int widthPix, unsign
     }
 }
 
-static RGBAImagePtr LoadJPGBuff_(const void* src_buffer, int src_size)
+static RGBAImagePtr LoadJPGFromStream(InputStream& stream)
 {
     struct jpeg_decompress_struct cinfo;
     struct my_jpeg_error_mgr jerr;
@@ -326,20 +285,48 @@ static RGBAImagePtr LoadJPGBuff_(const void* src_buffer, int src_size)
 
     if (setjmp(jerr.setjmp_buffer)) //< TODO: use c++ exceptions instead of setjmp/longjmp to handle errors
     {
-        rError() << "WARNING: JPEG library error: " << errormsg << "\n";
+        rError() << "WARNING: JPEG library error: " << jerr.errormsg << "\n";
         jpeg_destroy_decompress(&cinfo);
         return RGBAImagePtr();
     }
 
     jpeg_create_decompress(&cinfo);
-    jpeg_buffer_src(&cinfo, const_cast<void*>(src_buffer), src_size);
+    jpeg_stream_src(&cinfo, stream);
     jpeg_read_header(&cinfo, TRUE);
-    jpeg_start_decompress(&cinfo);
 
-    int row_stride = cinfo.output_width * cinfo.output_components;
+#ifdef JCS_EXTENSIONS
+    // libjpeg-turbo is able to convert to RGBA on its own, let it decode straight into the image
+    bool decodeToRGBA = cinfo.jpeg_color_space == JCS_YCbCr || cinfo.jpeg_color_space == JCS_RGB ||
+        cinfo.jpeg_color_space == JCS_GRAYSCALE;
+
+    if (decodeToRGBA)
+    {
+        cinfo.out_color_space = JCS_EXT_RGBA;
+    }
+#else
+    bool decodeToRGBA = false;
+#endif
+
+    jpeg_start_decompress(&cinfo);
 
     RGBAImagePtr image(new RGBAImage(cinfo.output_width, cinfo.output_height));
 
+    if (decodeToRGBA)
+    {
+        while (cinfo.output_scanline < cinfo.output_height)
+        {
+            JSAMPROW row = image->getPixels() + cinfo.output_scanline * cinfo.output_width * sizeof(RGBAPixel);
+            jpeg_read_scanlines(&cinfo, &row, 1);
+        }
+
+        jpeg_finish_decompress(&cinfo);
+        jpeg_destroy_decompress(&cinfo);
+
+        return image;
+    }
+
+    int row_stride = cinfo.output_width * cinfo.output_components;
+
     JSAMPARRAY buffer = (*cinfo.mem->alloc_sarray) ((j_common_ptr)&cinfo, JPOOL_IMAGE, row_stride, 1);
 
     while (cinfo.output_scanline < cinfo.output_height)
@@ -365,8 +352,7 @@ namespace image
 
 ImagePtr JPEGLoader::load(ArchiveFile& file) const
 {
-    archive::ScopedArchiveBuffer buffer(file);
-    return LoadJPGBuff_(buffer.buffer, static_cast<int>(buffer.length));
+    return LoadJPGFromStream(file.getInputStream());
 }
 
 ImageTypeLoader::Extensions JPEGLoader::getExtensions() const
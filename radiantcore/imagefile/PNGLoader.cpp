@@ -1,9 +1,9 @@
 #include "PNGLoader.h"
 
 #include <png.h>
-#include <cstring>
+#include "iarchive.h"
 #include "RGBAImage.h"
-#include "stream/ScopedArchiveBuffer.h"
+#include "stream/utils.h"
 
 typedef unsigned char byte;
 
@@ -24,19 +24,19 @@ void user_error_fn(png_structp png_ptr, png_const_charp error_msg)
 	longjmp(png_jmpbuf(png_ptr), 1);
 }
 
-void user_read_data(png_structp png_ptr, png_bytep data, png_uint_32 length)
+// Reads the data straight from the archive file's input stream
+void user_read_data(png_structp png_ptr, png_bytep data, png_size_t length)
 {
-	png_bytep* p_p_fbuffer = (png_bytep*)png_get_io_ptr(png_ptr);
-	std::memcpy(data, *p_p_fbuffer, length);
-	*p_p_fbuffer += length;
+	auto* stream = static_cast<InputStream*>(png_get_io_ptr(png_ptr));
+
+	if (stream::readBlock(*stream, data, length) != length)
+	{
+		png_error(png_ptr, "unexpected end of file");
+	}
 }
 
-RGBAImagePtr LoadPNGBuff(unsigned char* fbuffer)
+RGBAImagePtr LoadPNGFromStream(InputStream& stream)
 {
-	png_bytep p_fbuffer;
-
-	p_fbuffer = fbuffer;
-
 	// the reading glue
 	// http://www.libpng.org/pub/png/libpng-manual.html
 
@@ -69,7 +69,7 @@ RGBAImagePtr LoadPNGBuff(unsigned char* fbuffer)
 	}
 
 	// configure the read function
-	png_set_read_fn(png_ptr, (png_voidp)&p_fbuffer, (png_rw_ptr)&user_read_data);
+	png_set_read_fn(png_ptr, &stream, user_read_data);
 
 	if (setjmp(png_jmpbuf(png_ptr)))
 	{
@@ -164,16 +164,14 @@ RGBAImagePtr LoadPNGBuff(unsigned char* fbuffer)
 	png_read_end(png_ptr, info_ptr);
 
 	/* free up the memory structure */
-	png_destroy_read_struct(&png_ptr, &info_ptr, png_infopp_NULL);
+	png_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
 
 	return image;
 }
 
 ImagePtr PNGLoader::load(ArchiveFile& file) const
 {
-    archive::ScopedArchiveBuffer buffer(file);
-
-    return LoadPNGBuff(buffer.buffer);
+    return LoadPNGFromStream(file.getInputStream());
 }
 
 ImageTypeLoader::Extensions PNGLoader::getExtensions() const
@@ -21,408 +21,437 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "TGALoader.h"
 
-#include "ifilesystem.h"
+#include <vector>
+#include <future>
+#include <thread>
+
+#include "itextstream.h"
 #include "iarchive.h"
 #include "idatastream.h"
 
-typedef unsigned char byte;
-
-#include <stdlib.h>
-
-#include "stream/ScopedArchiveBuffer.h"
-#include "stream/PointerInputStream.h"
 #include "RGBAImage.h"
+#include "ThreadPool.h"
 #include "stream/utils.h"
 
 namespace image
 {
 
-// represents x,y origin of tga image being decoded
-class Flip00 {}; // no flip
-class Flip01 {}; // vertical flip only
-class Flip10 {}; // horizontal flip only
-class Flip11 {}; // both
+namespace
+{
 
-template<typename PixelDecoder>
-void image_decode(stream::PointerInputStream& istream, PixelDecoder& decode, RGBAImage& image, const Flip00&)
+struct TargaHeader
 {
-  RGBAPixel* end = image.pixels + (image.getHeight() * image.getWidth());
-  for(RGBAPixel* row = end; row != image.pixels; row -= image.getWidth())
-  {
-    for(RGBAPixel* pixel = row - image.getWidth(); pixel != row; ++pixel)
-    {
-      decode(istream, *pixel);
-    }
-  }
+    unsigned char id_length, colormap_type, image_type;
+    unsigned short colormap_index, colormap_length;
+    unsigned char colormap_size;
+    unsigned short x_origin, y_origin, width, height;
+    unsigned char pixel_size, attributes;
+};
+
+// Size of the header preceding the (optional) image ID and the pixel data
+constexpr std::size_t TGA_HEADER_SIZE = 18;
+
+constexpr unsigned int TGA_FLIP_HORIZONTAL = 0x10;
+constexpr unsigned int TGA_FLIP_VERTICAL = 0x20;
+
+// RLE images with at least this many pixels are decoded by multiple threads
+constexpr std::size_t PARALLEL_DECODE_MIN_PIXELS = 512 * 512;
+
+// The minimum number of rows handled by a single decoding thread
+constexpr std::size_t PARALLEL_DECODE_MIN_ROWS = 64;
+
+inline uint16_t getLittleEndianUint16(const uint8_t* bytes)
+{
+    return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
 }
 
-template<typename PixelDecoder>
-void image_decode(stream::PointerInputStream& istream, PixelDecoder& decode, RGBAImage& image, const Flip01&)
+// Reads the header and skips the image ID, returns false if the stream is too short
+bool readHeader(TargaHeader& header, InputStream& stream)
 {
-  RGBAPixel* end = image.pixels + (image.getHeight() * image.getWidth());
-  for(RGBAPixel* row = image.pixels; row != end; row += image.getWidth())
-  {
-    for(RGBAPixel* pixel = row; pixel != row + image.getWidth(); ++pixel)
+    uint8_t bytes[TGA_HEADER_SIZE];
+
+    if (stream::readBlock(stream, bytes, TGA_HEADER_SIZE) != TGA_HEADER_SIZE)
     {
-      decode(istream, *pixel);
+        return false;
     }
-  }
+
+    header.id_length = bytes[0];
+    header.colormap_type = bytes[1];
+    header.image_type = bytes[2];
+    header.colormap_index = getLittleEndianUint16(bytes + 3);
+    header.colormap_length = getLittleEndianUint16(bytes + 5);
+    header.colormap_size = bytes[7];
+    header.x_origin = getLittleEndianUint16(bytes + 8);
+    header.y_origin = getLittleEndianUint16(bytes + 10);
+    header.width = getLittleEndianUint16(bytes + 12);
+    header.height = getLittleEndianUint16(bytes + 14);
+    header.pixel_size = bytes[16];
+    header.attributes = bytes[17];
+
+    // Skip the TARGA image comment
+    uint8_t imageId[255];
+    return stream::readBlock(stream, imageId, header.id_length) == header.id_length;
 }
 
-template<typename PixelDecoder>
-void image_decode(stream::PointerInputStream& istream, PixelDecoder& decode, RGBAImage& image, const Flip10&)
+// Maps the rows and columns of the pixel data (in file order)
+// to the image memory, depending on the image origin
+class PixelMapper
 {
-  RGBAPixel* end = image.pixels + (image.getHeight() * image.getWidth());
-  for(RGBAPixel* row = end; row != image.pixels; row -= image.getWidth())
-  {
-    for(RGBAPixel* pixel = row; pixel != row - image.getWidth();)
+private:
+    RGBAImage& _image;
+    bool _topToBottom;
+    bool _rightToLeft;
+
+public:
+    PixelMapper(RGBAImage& image, unsigned char attributes) :
+        _image(image),
+        _topToBottom((attributes & TGA_FLIP_VERTICAL) != 0),
+        _rightToLeft((attributes & TGA_FLIP_HORIZONTAL) != 0)
+    {}
+
+    // Returns the image pixel the given row of the file data starts at
+    RGBAPixel* getRowStart(std::size_t fileRow) const
     {
-      decode(istream, *--pixel);
+        auto width = _image.getWidth();
+        auto row = _topToBottom ? fileRow : _image.getHeight() - 1 - fileRow;
+        auto rowStart = _image.pixels + row * width;
+
+        return _rightToLeft ? rowStart + width - 1 : rowStart;
     }
-  }
-}
 
-template<typename PixelDecoder>
-void image_decode(stream::PointerInputStream& istream, PixelDecoder& decode, RGBAImage& image, const Flip11&)
-{
-  RGBAPixel* end = image.pixels + (image.getHeight() * image.getWidth());
-  for(RGBAPixel* row = image.pixels; row != end; row += image.getWidth())
-  {
-    for(RGBAPixel* pixel = row + image.getWidth(); pixel != row;)
+    // The offset from one image pixel to the next one in file order
+    std::ptrdiff_t getPixelStep() const
     {
-      decode(istream, *--pixel);
+        return _rightToLeft ? -1 : 1;
     }
-  }
-}
+};
+
+template<std::size_t BytesPerPixel>
+inline void decodePixel(const uint8_t* source, RGBAPixel& pixel);
 
-inline void istream_read_gray(stream::PointerInputStream& istream, RGBAPixel& pixel)
+template<>
+inline void decodePixel<1>(const uint8_t* source, RGBAPixel& pixel)
 {
-  istream.read(&pixel.blue, 1);
-  pixel.red = pixel.green = pixel.blue;
-  pixel.alpha = 0xff;
+    pixel.red = pixel.green = pixel.blue = source[0];
+    pixel.alpha = 0xff;
 }
 
-inline void istream_read_rgb(stream::PointerInputStream& istream, RGBAPixel& pixel)
+template<>
+inline void decodePixel<3>(const uint8_t* source, RGBAPixel& pixel)
 {
-  istream.read(&pixel.blue, 1);
-  istream.read(&pixel.green, 1);
-  istream.read(&pixel.red, 1);
-  pixel.alpha = 0xff;
+    pixel.blue = source[0];
+    pixel.green = source[1];
+    pixel.red = source[2];
+    pixel.alpha = 0xff;
 }
 
-inline void istream_read_rgba(stream::PointerInputStream& istream, RGBAPixel& pixel)
+template<>
+inline void decodePixel<4>(const uint8_t* source, RGBAPixel& pixel)
 {
-  istream.read(&pixel.blue, 1);
-  istream.read(&pixel.green, 1);
-  istream.read(&pixel.red, 1);
-  istream.read(&pixel.alpha, 1);
+    pixel.blue = source[0];
+    pixel.green = source[1];
+    pixel.red = source[2];
+    pixel.alpha = source[3];
 }
 
-class TargaDecodeGrayPixel
+// Decodes uncompressed pixel data, row by row, straight from the stream.
+// Returns false if the stream ended prematurely, the missing pixels are black.
+template<std::size_t BytesPerPixel>
+bool decodeUncompressed(InputStream& stream, RGBAImage& image, const PixelMapper& mapper)
 {
-public:
-  void operator()(stream::PointerInputStream& istream, RGBAPixel& pixel)
-  {
-    istream_read_gray(istream, pixel);
-  }
-};
+    auto width = image.getWidth();
+    auto step = mapper.getPixelStep();
+    bool complete = true;
 
-template<typename Flip>
-void targa_decode_grayscale(stream::PointerInputStream& istream, RGBAImage& image, const Flip& flip)
-{
-  TargaDecodeGrayPixel decode;
-  image_decode(istream, decode, image, flip);
-}
+    std::vector<uint8_t> rowData(width * BytesPerPixel);
 
-class TargaDecodeRGBPixel
-{
-public:
-  void operator()(stream::PointerInputStream& istream, RGBAPixel& pixel)
-  {
-    istream_read_rgb(istream, pixel);
-  }
-};
+    for (std::size_t row = 0; row < image.getHeight(); ++row)
+    {
+        auto bytesRead = stream::readBlock(stream, rowData.data(), rowData.size());
 
-template<typename Flip>
-void targa_decode_rgb(stream::PointerInputStream& istream, RGBAImage& image, const Flip& flip)
-{
-  TargaDecodeRGBPixel decode;
-  image_decode(istream, decode, image, flip);
+        if (bytesRead < rowData.size())
+        {
+            std::fill(rowData.begin() + bytesRead, rowData.end(), 0);
+            complete = false;
+        }
+
+        auto pixel = mapper.getRowStart(row);
+        const auto* source = rowData.data();
+
+        for (std::size_t x = 0; x < width; ++x, pixel += step, source += BytesPerPixel)
+        {
+            decodePixel<BytesPerPixel>(source, *pixel);
+        }
+    }
+
+    return complete;
 }
 
-class TargaDecodeRGBAPixel
+// A position in the RLE packet sequence
+struct RLEPosition
 {
-public:
-  void operator()(stream::PointerInputStream& istream, RGBAPixel& pixel)
-  {
-    istream_read_rgba(istream, pixel);
-  }
+    // The header byte of the packet
+    const uint8_t* packet;
+
+    // The number of pixels of this packet which belong to the preceding rows
+    std::size_t pixelsToSkip;
 };
 
-template<typename Flip>
-void targa_decode_rgba(stream::PointerInputStream& istream, RGBAImage& image, const Flip& flip)
+// Decodes the given range of rows, starting at the given packet.
+// RLE packets are allowed to span multiple rows. Returns false if the data
+// ended prematurely, the missing pixels are black in that case.
+template<std::size_t BytesPerPixel>
+bool decodeRLERows(const uint8_t* end, RLEPosition start, std::size_t firstRow,
+                   std::size_t numRows, RGBAImage& image, const PixelMapper& mapper)
 {
-  TargaDecodeRGBAPixel decode;
-  image_decode(istream, decode, image, flip);
-}
+    auto width = image.getWidth();
+    auto step = mapper.getPixelStep();
 
-typedef byte TargaPacket;
-typedef byte TargaPacketSize;
+    const auto* pos = start.packet;
+    auto pixelsToSkip = start.pixelsToSkip;
+    std::size_t remaining = 0;
+    bool isRunLength = false;
+    bool complete = true;
+    RGBAPixel runPixel;
 
-inline void targa_packet_read_istream(TargaPacket& packet, stream::PointerInputStream& istream)
-{
-  istream.read(&packet, 1);
+    for (auto row = firstRow; row < firstRow + numRows; ++row)
+    {
+        auto pixel = mapper.getRowStart(row);
+
+        for (std::size_t x = 0; x < width; ++x, pixel += step)
+        {
+            if (remaining == 0)
+            {
+                std::size_t available = pos < end ? end - pos - 1 : 0;
+
+                if (pos < end)
+                {
+                    remaining = 1 + (*pos & 0x7f);
+                    isRunLength = (*pos & 0x80) != 0;
+                    ++pos;
+                }
+
+                if (pos >= end || available < (isRunLength ? 1 : remaining) * BytesPerPixel)
+                {
+                    // Out of data, fill the rest of the rows with black
+                    runPixel = RGBAPixel{ 0, 0, 0, 0xff };
+                    isRunLength = true;
+                    remaining = width * numRows;
+                    complete = false;
+                }
+                else if (isRunLength)
+                {
+                    decodePixel<BytesPerPixel>(pos, runPixel);
+                    pos += BytesPerPixel;
+                }
+
+                if (pixelsToSkip > 0)
+                {
+                    if (!isRunLength)
+                    {
+                        pos += pixelsToSkip * BytesPerPixel;
+                    }
+
+                    remaining -= pixelsToSkip;
+                    pixelsToSkip = 0;
+                }
+            }
+
+            if (isRunLength)
+            {
+                *pixel = runPixel;
+            }
+            else
+            {
+                decodePixel<BytesPerPixel>(pos, *pixel);
+                pos += BytesPerPixel;
+            }
+
+            --remaining;
+        }
+    }
+
+    return complete;
 }
 
-inline bool targa_packet_is_rle(const TargaPacket& packet)
+// Walks the RLE packet headers (without decoding any pixels) to find the
+// packets containing the first pixel of each chunk. Returns false
+// if the data ended before all positions could be located.
+template<std::size_t BytesPerPixel>
+bool findRLEChunkPositions(const uint8_t* begin, const uint8_t* end, std::size_t pixelsPerChunk,
+                           std::size_t numChunks, std::vector<RLEPosition>& positions)
 {
-  return (packet & 0x80) != 0;
+    positions.push_back(RLEPosition{ begin, 0 });
+
+    const auto* pos = begin;
+    std::size_t pixel = 0;
+    std::size_t nextChunkStart = pixelsPerChunk;
+
+    while (positions.size() < numChunks)
+    {
+        if (pos >= end)
+        {
+            return false;
+        }
+
+        std::size_t packetPixels = 1 + (*pos & 0x7f);
+        std::size_t packetSize = 1 + ((*pos & 0x80) != 0 ? 1 : packetPixels) * BytesPerPixel;
+
+        while (positions.size() < numChunks && nextChunkStart < pixel + packetPixels)
+        {
+            positions.push_back(RLEPosition{ pos, nextChunkStart - pixel });
+            nextChunkStart += pixelsPerChunk;
+        }
+
+        if (static_cast<std::size_t>(end - pos) < packetSize)
+        {
+            return false;
+        }
+
+        pos += packetSize;
+        pixel += packetPixels;
+    }
+
+    return true;
 }
 
-inline TargaPacketSize targa_packet_size(const TargaPacket& packet)
+// Decodes the RLE pixel data. The compressed data is read into memory
+// in one go, large images are then split into chunks of rows which are
+// decoded in parallel. Images loaded by a thread pool worker (thumbnails,
+// models) are decoded serially, the pool is already keeping all cores busy.
+template<std::size_t BytesPerPixel>
+bool decodeRLE(InputStream& stream, std::size_t dataSize, RGBAImage& image, const PixelMapper& mapper)
 {
-  return 1 + (packet & 0x7f);
-}
+    std::vector<uint8_t> data(dataSize);
+    data.resize(stream::readBlock(stream, data.data(), data.size()));
 
+    const auto* begin = data.data();
+    const auto* end = begin + data.size();
 
-class TargaDecodeRGBPixelRLE
-{
-  TargaPacketSize m_packetSize;
-  RGBAPixel m_pixel;
-  TargaPacket m_packet;
-public:
-  TargaDecodeRGBPixelRLE() : m_packetSize(0)
-  {
-  }
-  void operator()(stream::PointerInputStream& istream, RGBAPixel& pixel)
-  {
-    if(m_packetSize == 0)
-    {
-      targa_packet_read_istream(m_packet, istream);
-      m_packetSize = targa_packet_size(m_packet);
+    auto width = image.getWidth();
+    auto height = image.getHeight();
 
-      if(targa_packet_is_rle(m_packet))
-      {
-        istream_read_rgb(istream, m_pixel);
-      }
-    }
+    std::size_t numChunks = 1;
 
-    if(targa_packet_is_rle(m_packet))
+    if (width * height >= PARALLEL_DECODE_MIN_PIXELS && !util::ThreadPool::IsWorkerThread())
     {
-      pixel = m_pixel;
+        numChunks = std::min<std::size_t>(std::thread::hardware_concurrency(), height / PARALLEL_DECODE_MIN_ROWS);
     }
-    else
+
+    std::vector<RLEPosition> positions;
+    auto rowsPerChunk = numChunks > 1 ? (height + numChunks - 1) / numChunks : height;
+
+    if (numChunks <= 1 ||
+        !findRLEChunkPositions<BytesPerPixel>(begin, end, rowsPerChunk * width, numChunks, positions))
     {
-      istream_read_rgb(istream, pixel);
+        return decodeRLERows<BytesPerPixel>(end, RLEPosition{ begin, 0 }, 0, height, image, mapper);
     }
 
-    --m_packetSize;
-  }
-};
-
-template<typename Flip>
-void targa_decode_rle_rgb(stream::PointerInputStream& istream, RGBAImage& image, const Flip& flip)
-{
-	TargaDecodeRGBPixelRLE decode;
-  image_decode(istream, decode, image, flip);
-}
+    std::vector<std::future<bool>> tasks;
 
-class TargaDecodeRGBAPixelRLE
-{
-  TargaPacketSize m_packetSize;
-  RGBAPixel m_pixel;
-  TargaPacket m_packet;
-public:
-  TargaDecodeRGBAPixelRLE() : m_packetSize(0)
-  {
-  }
-  void operator()(stream::PointerInputStream& istream, RGBAPixel& pixel)
-  {
-    if(m_packetSize == 0)
+    for (std::size_t chunk = 1; chunk < positions.size(); ++chunk)
     {
-      targa_packet_read_istream(m_packet, istream);
-      m_packetSize = targa_packet_size(m_packet);
+        auto firstRow = chunk * rowsPerChunk;
+        auto numRows = std::min(rowsPerChunk, height - firstRow);
 
-      if(targa_packet_is_rle(m_packet))
-      {
-        istream_read_rgba(istream, m_pixel);
-      }
+        tasks.emplace_back(std::async(std::launch::async, [&, chunk, firstRow, numRows]()
+        {
+            return decodeRLERows<BytesPerPixel>(end, positions[chunk], firstRow, numRows, image, mapper);
+        }));
     }
 
-    if(targa_packet_is_rle(m_packet))
-    {
-      pixel = m_pixel;
-    }
-    else
+    // The first chunk is handled by this thread
+    auto complete = decodeRLERows<BytesPerPixel>(end, positions[0], 0, rowsPerChunk, image, mapper);
+
+    for (auto& task : tasks)
     {
-      istream_read_rgba(istream, pixel);
+        complete = task.get() && complete;
     }
 
-    --m_packetSize;
-  }
-};
+    return complete;
+}
 
-template<typename Flip>
-void targa_decode_rle_rgba(stream::PointerInputStream& istream, RGBAImage& image, const Flip& flip)
-{
-	TargaDecodeRGBAPixelRLE decode;
-  image_decode(istream, decode, image, flip);
 }
 
-struct TargaHeader
+ImagePtr TGALoader::load(ArchiveFile& file) const
 {
-  unsigned char id_length, colormap_type, image_type;
-  unsigned short colormap_index, colormap_length;
-  unsigned char colormap_size;
-  unsigned short x_origin, y_origin, width, height;
-  unsigned char pixel_size, attributes;
-};
+    auto& stream = file.getInputStream();
 
-inline void targa_header_read_istream(TargaHeader& targa_header, stream::PointerInputStream& istream)
-{
-	static_assert(sizeof(unsigned short) == sizeof(uint16_t), "TGA Loader Code relies on unsigned short being 16 bits wide!");
-
-	targa_header.id_length = stream::readByte(istream);
-	targa_header.colormap_type = stream::readByte(istream);
-	targa_header.image_type = stream::readByte(istream);
-
-	targa_header.colormap_index = stream::readLittleEndian<uint16_t>(istream);
-	targa_header.colormap_length = stream::readLittleEndian<uint16_t>(istream);
-	targa_header.colormap_size = stream::readByte(istream);
-	targa_header.x_origin = stream::readLittleEndian<uint16_t>(istream);
-	targa_header.y_origin = stream::readLittleEndian<uint16_t>(istream);
-	targa_header.width = stream::readLittleEndian<uint16_t>(istream);
-	targa_header.height = stream::readLittleEndian<uint16_t>(istream);
-	targa_header.pixel_size = stream::readByte(istream);
-	targa_header.attributes = stream::readByte(istream);
-
-  if (targa_header.id_length != 0)
-    istream.seek(targa_header.id_length);	// skip TARGA image comment
-}
+    TargaHeader header;
 
-template<typename Type>
-class ScopeDelete
-{
-  Type* m_value;
-  ScopeDelete(const ScopeDelete&);
-  ScopeDelete& operator=(const ScopeDelete&);
-public:
-  ScopeDelete(Type* value) : m_value(value)
-  {
-  }
-  ~ScopeDelete()
-  {
-    delete m_value;
-  }
-  Type* get_pointer() const
-  {
-    return m_value;
-  }
-};
+    if (!readHeader(header, stream))
+    {
+        rError() << "LoadTGA: " << file.getName() << " is too small to be a TGA image" << std::endl;
+        return ImagePtr();
+    }
 
-template<typename Flip>
-RGBAImagePtr Targa_decodeImageData(const TargaHeader& targa_header, stream::PointerInputStream& istream, const Flip& flip)
-{
-  RGBAImagePtr image (new RGBAImage(targa_header.width, targa_header.height));
+    if (header.image_type != 2 && header.image_type != 10 && header.image_type != 3)
+    {
+        rError() << "LoadTGA: TGA type " << static_cast<int>(header.image_type) << " not supported" << std::endl;
+        rError() << "LoadTGA: Only type 2 (RGB), 3 (gray), and 10 (RGB) TGA images supported" << std::endl;
+        return ImagePtr();
+    }
 
-  if (targa_header.image_type == 2 || targa_header.image_type == 3)
-  {
-    switch (targa_header.pixel_size)
+    if (header.colormap_type != 0)
     {
-    case 8:
-      targa_decode_grayscale(istream, *image, flip);
-      break;
-    case 24:
-      targa_decode_rgb(istream, *image, flip);
-      break;
-    case 32:
-      targa_decode_rgba(istream, *image, flip);
-      break;
-    default:
-      rError() << "LoadTGA: illegal pixel_size '" << targa_header.pixel_size << "'\n";
-      return RGBAImagePtr();
+        rError() << "LoadTGA: colormaps not supported" << std::endl;
+        return ImagePtr();
     }
-  }
-  else if (targa_header.image_type == 10)
-  {
-    switch (targa_header.pixel_size)
+
+    if ((header.pixel_size != 32 && header.pixel_size != 24) && header.image_type != 3)
     {
-    case 24:
-      targa_decode_rle_rgb(istream, *image, flip);
-      break;
-    case 32:
-      targa_decode_rle_rgba(istream, *image, flip);
-      break;
-    default:
-      rError() << "LoadTGA: illegal pixel_size '" << targa_header.pixel_size << "'\n";
-      return RGBAImagePtr();
+        rError() << "LoadTGA: Only 32 or 24 bit images supported" << std::endl;
+        return ImagePtr();
     }
-  }
 
-  return image;
-}
+    RGBAImagePtr image(new RGBAImage(header.width, header.height));
+    PixelMapper mapper(*image, header.attributes);
 
-const unsigned int TGA_FLIP_HORIZONTAL = 0x10;
-const unsigned int TGA_FLIP_VERTICAL = 0x20;
+    auto headerSize = TGA_HEADER_SIZE + header.id_length;
+    auto dataSize = file.size() > headerSize ? file.size() - headerSize : 0;
 
-RGBAImagePtr LoadTGABuff(const byte* buffer)
-{
-	stream::PointerInputStream istream(buffer);
-  TargaHeader targa_header;
-
-  targa_header_read_istream(targa_header, istream);
-
-  if (targa_header.image_type != 2 && targa_header.image_type != 10 && targa_header.image_type != 3)
-  {
-    rError() << "LoadTGA: TGA type " << targa_header.image_type << " not supported\n";
-    rError() << "LoadTGA: Only type 2 (RGB), 3 (gray), and 10 (RGB) TGA images supported\n";
-    return RGBAImagePtr();
-  }
-
-  if (targa_header.colormap_type != 0)
-  {
-    rError() << "LoadTGA: colormaps not supported\n";
-    return RGBAImagePtr();
-  }
-
-  if ((targa_header.pixel_size != 32 && targa_header.pixel_size != 24)
-      && targa_header.image_type != 3)
-  {
-    rError() << "LoadTGA: Only 32 or 24 bit images supported\n";
-    return RGBAImagePtr();
-  }
-
-  if ((targa_header.attributes & (TGA_FLIP_HORIZONTAL|TGA_FLIP_VERTICAL)) == 0)
-  {
-    return Targa_decodeImageData(targa_header, istream, Flip00());
-  }
-
-  if((targa_header.attributes & TGA_FLIP_HORIZONTAL) == 0 &&
-	 (targa_header.attributes & TGA_FLIP_VERTICAL) != 0)
-  {
-    return Targa_decodeImageData(targa_header, istream, Flip01());
-  }
-
-  if ((targa_header.attributes & TGA_FLIP_HORIZONTAL) != 0 &&
-	  (targa_header.attributes & TGA_FLIP_VERTICAL) == 0)
-  {
-    return Targa_decodeImageData(targa_header, istream, Flip10());
-  }
-
-  if ((targa_header.attributes & TGA_FLIP_HORIZONTAL) != 0 &&
-	  (targa_header.attributes & TGA_FLIP_VERTICAL) != 0)
-  {
-    return Targa_decodeImageData(targa_header, istream, Flip11());
-  }
-
-  // unreachable
-  return RGBAImagePtr();
-}
+    bool complete = true;
 
-ImagePtr TGALoader::load(ArchiveFile& file) const
-{
-    archive::ScopedArchiveBuffer buffer(file);
-    return LoadTGABuff(buffer.buffer);
+    if (header.image_type == 2 || header.image_type == 3)
+    {
+        switch (header.pixel_size)
+        {
+        case 8:
+            complete = decodeUncompressed<1>(stream, *image, mapper);
+            break;
+        case 24:
+            complete = decodeUncompressed<3>(stream, *image, mapper);
+            break;
+        case 32:
+            complete = decodeUncompressed<4>(stream, *image, mapper);
+            break;
+        default:
+            rError() << "LoadTGA: illegal pixel_size '" << static_cast<int>(header.pixel_size) << "'" << std::endl;
+            return ImagePtr();
+        }
+    }
+    else
+    {
+        switch (header.pixel_size)
+        {
+        case 24:
+            complete = decodeRLE<3>(stream, dataSize, *image, mapper);
+            break;
+        case 32:
+            complete = decodeRLE<4>(stream, dataSize, *image, mapper);
+            break;
+        default:
+            rError() << "LoadTGA: illegal pixel_size '" << static_cast<int>(header.pixel_size) << "'" << std::endl;
+            return ImagePtr();
+        }
+    }
+
+    if (!complete)
+    {
+        rWarning() << "LoadTGA: unexpected end of pixel data in " << file.getName() << std::endl;
+    }
+
+    return image;
 }
 
 ImageTypeLoader::Extensions TGALoader::getExtensions() const
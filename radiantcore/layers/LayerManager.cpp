@@ -6,15 +6,17 @@
 #include "icommandsystem.h"
 #include "scene/Node.h"
 #include "scenelib.h"
+#include "entitylib.h"
 #include "module/StaticModule.h"
 
 #include "AddToLayerWalker.h"
 #include "MoveToLayerWalker.h"
 #include "RemoveFromLayerWalker.h"
-#include "SetLayerSelectedWalker.h"
 #include "LayerInfoFileModule.h"
 
 #include <functional>
+#include <algorithm>
+#include <unordered_map>
 #include <climits>
 
 namespace scene
@@ -59,7 +61,7 @@ int LayerManager::createLayer(const std::string& name, int layerID)
 	_layerVisibility.resize(highestID+1);
 
 	// Set the newly created layer to "visible"
-	_layerVisibility[result.first->first] = true;
+	setLayerVisibilityFlag(result.first->first, true);
 
 	// Layers have changed
 	onLayersChanged();
@@ -99,14 +101,16 @@ void LayerManager::deleteLayer(const std::string& name)
 	}
 
 	// Remove all nodes from this layer first, but don't de-select them yet
-	RemoveFromLayerWalker walker(layerID);
-	GlobalSceneGraph().root()->traverse(walker);
+	for (const auto& member : getLayerMembers(layerID))
+	{
+		member->removeFromLayer(layerID);
+	}
 
 	// Remove the layer
 	_layers.erase(layerID);
 
 	// Reset the visibility flag to TRUE
-	_layerVisibility[layerID] = true;
+	setLayerVisibilityFlag(layerID, true);
 
 	if (layerID == _activeLayer)
 	{
@@ -138,7 +142,8 @@ void LayerManager::reset()
 	_layers.insert(LayerMap::value_type(DEFAULT_LAYER, _(DEFAULT_LAYER_NAME)));
 
 	_layerVisibility.resize(1);
-	_layerVisibility[DEFAULT_LAYER] = true;
+	_visibleLayers.clear();
+	setLayerVisibilityFlag(DEFAULT_LAYER, true);
 
 	// Update the LayerControlDialog
 	_layersChangedSignal.emit();
@@ -236,7 +241,7 @@ void LayerManager::setLayerVisibility(int layerID, bool visible)
 	}
 
 	// Set the visibility
-	_layerVisibility[layerID] = visible;
+	setLayerVisibilityFlag(layerID, visible);
 
 	if (!visible && layerID == _activeLayer)
 	{
@@ -253,7 +258,7 @@ void LayerManager::setLayerVisibility(int layerID, bool visible)
     }
 
 	// Fire the visibility changed event
-	onLayerVisibilityChanged();
+	onLayerVisibilityChanged(layerID);
 }
 
 void LayerManager::setLayerVisibility(const std::string& layerName, bool visible) 
@@ -271,10 +276,105 @@ void LayerManager::setLayerVisibility(const std::string& layerName, bool visible
 	setLayerVisibility(layerID, visible);
 }
 
-void LayerManager::updateSceneGraphVisibility()
+void LayerManager::setLayerVisibilityFlag(int layerID, bool visible)
 {
-	UpdateNodeVisibilityWalker walker(GlobalSceneGraph().root());
-	GlobalSceneGraph().root()->traverseChildren(walker);
+	_layerVisibility[layerID] = visible;
+
+	if (visible)
+	{
+		_visibleLayers.insert(layerID);
+	}
+	else
+	{
+		_visibleLayers.erase(layerID);
+	}
+}
+
+std::vector<INodePtr> LayerManager::getLayerMembers(int layerID) const
+{
+	std::vector<INodePtr> members;
+
+	if (layerID >= 0 && layerID < static_cast<int>(_layerMembers.size()))
+	{
+		members.reserve(_layerMembers[layerID].size());
+
+		for (auto* node : _layerMembers[layerID])
+		{
+			members.push_back(node->getSelf());
+		}
+	}
+
+	return members;
+}
+
+void LayerManager::updateVisibilityOfNodes(const std::vector<INodePtr>& nodes)
+{
+	// A parent stays visible as long as one of its children is visible, so the
+	// parents of the given nodes need an update too. Collect them along with their
+	// depth in the scene, children need to be processed before their parents.
+	std::unordered_map<INode*, std::size_t> affectedNodes;
+	std::vector<std::pair<std::size_t, INodePtr>> nodesByDepth;
+
+	for (const auto& node : nodes)
+	{
+		std::vector<INodePtr> path;
+
+		for (auto n = node; n && n->getNodeType() != INode::Type::MapRoot; n = n->getParent())
+		{
+			if (affectedNodes.count(n.get()) > 0)
+			{
+				break; // this node and its parents have already been collected
+			}
+
+			path.push_back(n);
+		}
+
+		if (path.empty()) continue;
+
+		// The depth of the topmost node of the path is known if its parent has been collected before
+		auto parent = path.back()->getParent();
+		auto found = parent ? affectedNodes.find(parent.get()) : affectedNodes.end();
+		std::size_t depth = found != affectedNodes.end() ? found->second + path.size() : path.size();
+
+		for (const auto& n : path)
+		{
+			affectedNodes.emplace(n.get(), depth);
+			nodesByDepth.emplace_back(depth--, n);
+		}
+	}
+
+	std::stable_sort(nodesByDepth.begin(), nodesByDepth.end(), [](const auto& a, const auto& b)
+	{
+		return a.first > b.first;
+	});
+
+	for (const auto& pair : nodesByDepth)
+	{
+		const auto& node = pair.second;
+
+		bool isVisible = updateNodeVisibility(node);
+
+		if (!isVisible)
+		{
+			// Show the node if any of its children is visible
+			node->foreachNode([&](const INodePtr& child)
+			{
+				isVisible = !child->checkStateFlag(Node::eLayered);
+				return !isVisible;
+			});
+
+			if (isVisible)
+			{
+				node->disable(Node::eLayered);
+			}
+		}
+
+		if (node->checkStateFlag(Node::eLayered))
+		{
+			// Node is hidden by layers after update (and no children are visible), de-select
+			Node_setSelected(node, false);
+		}
+	}
 
 	// Redraw
 	SceneChangeNotify();
@@ -289,13 +389,23 @@ void LayerManager::onNodeMembershipChanged()
 {
 	_nodeMembershipChangedSignal.emit();
 
-	updateSceneGraphVisibility();
+	std::vector<INodePtr> changedNodes;
+	changedNodes.reserve(_nodesWithChangedLayers.size());
+
+	for (auto* node : _nodesWithChangedLayers)
+	{
+		changedNodes.push_back(node->getSelf());
+	}
+
+	_nodesWithChangedLayers.clear();
+
+	updateVisibilityOfNodes(changedNodes);
 }
 
-void LayerManager::onLayerVisibilityChanged()
+void LayerManager::onLayerVisibilityChanged(int layerID)
 {
-	// Update all nodes and views
-	updateSceneGraphVisibility();
+	// Update the layer members and views
+	updateVisibilityOfNodes(getLayerMembers(layerID));
 
 	// Update the LayerControlDialog
 	_layerVisibilityChangedSignal.emit();
@@ -389,36 +499,72 @@ bool LayerManager::updateNodeVisibility(const scene::INodePtr& node)
         return true; // doesn't support layers, return true for visible
     }
 
-	// Get the list of layers the node is associated with
-	const auto& layers = node->getLayers();
+	// The node is visible if any of its layers is visible
+	if (node->getLayers().intersects(_visibleLayers))
+	{
+		node->disable(Node::eLayered);
+		return true;
+	}
 
-	// We start with the assumption that a node is hidden
+	// Node is hidden, return FALSE
 	node->enable(Node::eLayered);
+	return false;
+}
 
-	// Cycle through the Node's layers, and show the node as soon as
-	// a visible layer is found.
-	for (int layerId : layers)
+void LayerManager::onNodeLayersChanged(INode& node, const LayerList& oldLayers, const LayerList& newLayers)
+{
+	for (int layerId : oldLayers)
 	{
-		if (_layerVisibility[layerId])
+		if (newLayers.count(layerId) == 0 && layerId < static_cast<int>(_layerMembers.size()))
 		{
-			// The layer is visible, set the visibility to true and quit
-			node->disable(Node::eLayered);
-			return true;
+			_layerMembers[layerId].erase(&node);
 		}
 	}
 
-	// Node is hidden, return FALSE
-	return false;
+	for (int layerId : newLayers)
+	{
+		if (oldLayers.count(layerId) == 0)
+		{
+			if (layerId >= static_cast<int>(_layerMembers.size()))
+			{
+				_layerMembers.resize(layerId + 1);
+			}
+
+			_layerMembers[layerId].insert(&node);
+		}
+	}
+
+	// Nodes leaving the scene don't need a visibility update anymore
+	if (newLayers.empty())
+	{
+		_nodesWithChangedLayers.erase(&node);
+	}
+	else if (!oldLayers.empty())
+	{
+		_nodesWithChangedLayers.insert(&node);
+	}
+}
+
+void LayerManager::foreachLayerMember(int layerID, const std::function<void(const INodePtr&)>& functor)
+{
+	for (const auto& member : getLayerMembers(layerID))
+	{
+		functor(member);
+	}
 }
 
 void LayerManager::setSelected(int layerID, bool selected)
 {
-	SetLayerSelectedWalker walker(layerID, selected);
+	for (const auto& member : getLayerMembers(layerID))
+	{
+		// Skip hidden nodes and the worldspawn
+		if (!member->visible() || Node_isWorldspawn(member))
+		{
+			continue;
+		}
 
-    if (GlobalSceneGraph().root())
-    {
-        GlobalSceneGraph().root()->traverseChildren(walker);
-    }
+		Node_setSelected(member, selected);
+	}
 }
 
 sigc::signal<void> LayerManager::signal_layersChanged()
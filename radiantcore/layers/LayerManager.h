@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <map>
+#include <unordered_set>
 #include "ilayer.h"
 #include "imap.h"
 
@@ -18,6 +19,16 @@ private:
 	typedef std::vector<bool> LayerVisibilityList;
 	LayerVisibilityList _layerVisibility;
 
+	// The IDs of all visible layers, as bit mask to be tested against the node's layers
+	LayerList _visibleLayers;
+
+	// The scene nodes of each layer, indexed by the layer id
+	typedef std::unordered_set<INode*> NodeSet;
+	std::vector<NodeSet> _layerMembers;
+
+	// Scene nodes which changed their layers since the last visibility update
+	NodeSet _nodesWithChangedLayers;
+
 	// The list of named layers, indexed by an integer ID
 	typedef std::map<int, std::string> LayerMap;
 	LayerMap _layers;
@@ -111,6 +122,9 @@ public:
 
 	bool updateNodeVisibility(const scene::INodePtr& node) override;
 
+	void onNodeLayersChanged(INode& node, const LayerList& oldLayers, const LayerList& newLayers) override;
+	void foreachLayerMember(int layerID, const std::function<void(const INodePtr&)>& functor) override;
+
 	// Selects/unselects an entire layer
 	void setSelected(int layerID, bool selected) override;
 
@@ -122,14 +136,21 @@ private:
 	// Internal event emitter
 	void onLayersChanged();
 
-	// Internal event, updates the scenegraph
-	void onLayerVisibilityChanged();
+	// Internal event, updates the members of the given layer
+	void onLayerVisibilityChanged(int layerID);
 
-	// Internal event emitter
+	// Internal event emitter, updates the nodes which changed their layers
 	void onNodeMembershipChanged();
 
-	// Updates the visibility state of the entire scenegraph
-	void updateSceneGraphVisibility();
+	// Sets the visibility flag of the given layer, no update is performed
+	void setLayerVisibilityFlag(int layerID, bool visible);
+
+	// Returns the scene nodes of the given layer
+	std::vector<INodePtr> getLayerMembers(int layerID) const;
+
+	// Updates the visibility state of the given nodes and their parents,
+	// the visibility of all other nodes in the scene is not affected
+	void updateVisibilityOfNodes(const std::vector<INodePtr>& nodes);
 
 	// Returns the highest used layer Id
 	int getHighestLayerID() const;
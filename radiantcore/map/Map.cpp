@@ -23,6 +23,7 @@
 #include "igame.h"
 #include "imru.h"
 #include "imapformat.h"
+#include "ipreferencesystem.h"
 
 #include "registry/registry.h"
 #include "entitylib.h"
@@ -41,9 +42,11 @@
 #include "map/algorithm/Export.h"
 #include "scene/Traverse.h"
 #include "map/algorithm/MapExporter.h"
+#include "map/format/BinaryMapCache.h"
 #include "model/export/ModelExporter.h"
 #include "model/export/ModelScalePreserver.h"
 #include "map/algorithm/Skins.h"
+#include "map/algorithm/NodeFootprint.h"
 #include "messages/ScopedLongRunningOperation.h"
 #include "messages/FileOverwriteConfirmation.h"
 #include "selection/algorithm/Primitives.h"
@@ -913,6 +916,7 @@ void Map::registerCommands()
     GlobalCommandSystem().addCommand("ExportMap", Map::exportMap);
     GlobalCommandSystem().addCommand("SaveSelected", Map::exportSelection);
 	GlobalCommandSystem().addCommand("ReloadSkins", map::algorithm::reloadSkins);
+    GlobalCommandSystem().addCommand("ShowSceneNodeFootprint", map::algorithm::showSceneNodeFootprint);
     GlobalCommandSystem().addCommand("FocusViews", std::bind(&Map::focusViewCmd, this, std::placeholders::_1), { cmd::ARGTYPE_VECTOR3, cmd::ARGTYPE_VECTOR3 });
 	GlobalCommandSystem().addCommand("ExportSelectedAsModel", map::algorithm::exportSelectedAsModelCmd,
         { cmd::ARGTYPE_STRING,
@@ -1360,6 +1364,7 @@ const StringSet& Map::getDependencies() const
 		_dependencies.insert(MODULE_FILETYPES);
 		_dependencies.insert(MODULE_MAPRESOURCEMANAGER);
         _dependencies.insert(MODULE_COMMANDSYSTEM);
+        _dependencies.insert(MODULE_PREFERENCESYSTEM);
     }
 
     return _dependencies;
@@ -1387,6 +1392,9 @@ void Map::initialiseModule(const IApplicationContext& ctx)
 
 	MapFileManager::registerFileTypes();
 
+    GlobalPreferenceSystem().getPage(_("Settings/Map Files")).appendCheckBox(
+        _("Save a binary cache along with the map to speed up loading"), cache::RKEY_WRITE_BINARY_MAP_CACHE);
+
     // Register an info file module to save the map property bag
     GlobalMapInfoFileManager().registerInfoFileModule(
         std::make_shared<MapPropertyInfoFileModule>()
@@ -20,6 +20,7 @@
 #include "os/path.h"
 #include "os/file.h"
 #include "os/fs.h"
+#include "registry/registry.h"
 #include "scene/Traverse.h"
 #include "scenelib.h"
 
@@ -31,6 +32,7 @@
 
 #include "algorithm/MapExporter.h"
 #include "algorithm/Import.h"
+#include "format/BinaryMapCache.h"
 #include "infofile/InfoFileExporter.h"
 #include "messages/MapFileOperation.h"
 #include "NodeCounter.h"
@@ -143,7 +145,10 @@ void MapResource::save(const MapFormatPtr& mapFormat)
 	}
 
 	// Save the actual file (throws on fail)
-	saveFile(*format, _mapRoot, scene::traverse, fullpath);
+	saveFile(*format, _mapRoot, scene::traverse, fullpath, [&](const MapExporter& exporter)
+	{
+		saveBinaryCache(*format, fullpath, exporter);
+	});
 
     refreshLastModifiedTime();
 
@@ -301,8 +306,17 @@ RootNodePtr MapResource::loadMapNode()
         // Instantiate a loader to process the map file stream
         MapResourceLoader loader(stream->getStream(), *format);
 
-        // Load the root from the primary stream (throws on failure or cancel)
-        rootNode = loader.load();
+        // Prefer an up to date binary cache of the map, if there is one
+        if (format->allowBinaryCacheCreation())
+        {
+            rootNode = loadBinaryCache(loader);
+        }
+
+        if (!rootNode)
+        {
+            // Load the root from the primary stream (throws on failure or cancel)
+            rootNode = loader.load();
+        }
 
         if (rootNode)
         {
@@ -332,6 +346,42 @@ RootNodePtr MapResource::loadMapNode()
 	return rootNode;
 }
 
+RootNodePtr MapResource::loadBinaryCache(MapResourceLoader& loader)
+{
+    auto mapFilename = getAbsoluteResourcePath();
+    auto cacheFilename = cache::getCacheFilename(mapFilename);
+
+    if (!os::fileOrDirExists(cacheFilename))
+    {
+        return RootNodePtr();
+    }
+
+    std::ifstream cacheStream(cacheFilename, std::ios::binary);
+
+    // Hash the file as saveBinaryCache() did, the map stream is opened in text mode
+    if (!cacheStream || !cache::isCacheValidForMap(cacheStream, cache::getMapFileHash(mapFilename)))
+    {
+        rMessage() << "The map cache " << cacheFilename << " is outdated, parsing the map file." << std::endl;
+        return RootNodePtr();
+    }
+
+    try
+    {
+        return loader.loadFromBinaryCache(cacheStream);
+    }
+    catch (const OperationException& ex)
+    {
+        if (ex.operationCancelled())
+        {
+            throw;
+        }
+
+        // A damaged cache file is not fatal, the map file is still there
+        rWarning() << "Failed to load the map cache " << cacheFilename << ": " << ex.what() << std::endl;
+        return RootNodePtr();
+    }
+}
+
 stream::MapResourceStream::Ptr MapResource::openFileStream(const std::string& path)
 {
     // Call the factory method to acquire a stream
@@ -397,13 +447,103 @@ void MapResource::throwIfNotWriteable(const fs::path& path)
 }
 
 void MapResource::saveFile(const MapFormat& format, const scene::IMapRootNodePtr& root,
-						   const GraphTraversalFunc& traverse, const std::string& filename)
+						   const GraphTraversalFunc& traverse, const std::string& filename,
+						   const MapWrittenFunc& onMapWritten)
 {
 	// Actual output file paths
 	fs::path outFile = filename;
 	fs::path auxFile = outFile;
 	auxFile.replace_extension(game::current::getInfoFileExtension());
 
+	writeMapFiles(format, outFile, auxFile, root, traverse,
+		[&](IMapWriter& writer, std::ostream& mapStream, std::ostream* auxStream)
+	{
+		// Check the total count of nodes to traverse
+		NodeCounter counter;
+		traverse(root, counter);
+
+		// Create our main MapExporter walker, and pass the desired 
+		// format to it. The constructor will prepare the scene
+		// and the destructor will clean it up afterwards. That way
+		// we ensure a nice and tidy scene when exceptions are thrown.
+		return auxStream != nullptr ?
+			std::make_shared<MapExporter>(writer, root, mapStream, *auxStream, counter.getCount()) :
+			std::make_shared<MapExporter>(writer, root, mapStream, counter.getCount()); // no aux stream
+	}, onMapWritten);
+}
+
+void MapResource::saveBinaryCache(const MapFormat& format, const std::string& mapFilename,
+								  const MapExporter& mapExporter)
+{
+	if (!format.allowBinaryCacheCreation() || !registry::getValue<bool>(cache::RKEY_WRITE_BINARY_MAP_CACHE))
+	{
+		return;
+	}
+
+	auto cacheFilename = cache::getCacheFilename(mapFilename);
+
+	BinaryMapCacheWriter writer(cache::getMapFileHash(mapFilename));
+
+	// Write to a temporary file first, the cache must not be picked up when incomplete
+	auto tempFilename = cacheFilename + ".tmp";
+	bool cacheWritten = false;
+
+	try
+	{
+		std::ofstream cacheStream(tempFilename, std::ios::binary);
+
+		{
+			// A second pass over the scene prepared by the map exporter, the cache
+			// receives the same entities and primitives as the map file writer did
+			MapExporter exporter(writer, mapExporter, cacheStream);
+			exporter.exportMap(_mapRoot, scene::traverse);
+		}
+
+		cacheStream.close();
+		cacheWritten = writer.canBeCached() && !cacheStream.fail();
+	}
+	catch (FileOperation::OperationCancelled&)
+	{}
+
+	std::error_code ec;
+
+	if (!cacheWritten)
+	{
+		// Any existing cache is outdated now, remove it along with the temporary file
+		fs::remove(tempFilename, ec);
+		fs::remove(cacheFilename, ec);
+		return;
+	}
+
+	fs::rename(tempFilename, cacheFilename, ec);
+
+	if (ec)
+	{
+		rWarning() << "Failed to move map cache file to " << cacheFilename << ": " << ec.message() << std::endl;
+		fs::remove(tempFilename, ec);
+	}
+}
+
+void MapResource::saveSnapshot(const MapFormat& format, const SceneSnapshot& snapshot,
+							   const std::string& filename, const std::string& infoFileExtension)
+{
+	fs::path outFile = filename;
+	fs::path auxFile = outFile;
+	auxFile.replace_extension(infoFileExtension);
+
+	writeMapFiles(format, outFile, auxFile, snapshot.getRoot(), scene::traverse,
+		[&](IMapWriter& writer, std::ostream& mapStream, std::ostream* auxStream)
+	{
+		return auxStream != nullptr ?
+			std::make_shared<MapExporter>(writer, snapshot, mapStream, *auxStream) :
+			std::make_shared<MapExporter>(writer, snapshot, mapStream);
+	});
+}
+
+void MapResource::writeMapFiles(const MapFormat& format, const fs::path& outFile, const fs::path& auxFile,
+								const scene::IMapRootNodePtr& root, const GraphTraversalFunc& traverse,
+								const ExporterFactory& createExporter, const MapWrittenFunc& onMapWritten)
+{
 	// Check writeability of the primary output file
 	throwIfNotWriteable(outFile);
 
@@ -438,25 +578,8 @@ void MapResource::saveFile(const MapFormat& format, const scene::IMapRootNodePtr
 
 	rMessage() << "success" << std::endl;
 
-	// Check the total count of nodes to traverse
-	NodeCounter counter;
-	traverse(root, counter);
-		
-	// Create our main MapExporter walker, and pass the desired 
-	// format to it. The constructor will prepare the scene
-	// and the destructor will clean it up afterwards. That way
-	// we ensure a nice and tidy scene when exceptions are thrown.
-	MapExporterPtr exporter;
 	auto mapWriter = format.getMapWriter();
-
-	if (format.allowInfoFileCreation())
-	{
-		exporter.reset(new MapExporter(*mapWriter, root, outFileStream, *auxFileStream, counter.getCount()));
-	}
-	else
-	{
-		exporter.reset(new MapExporter(*mapWriter, root, outFileStream, counter.getCount())); // no aux stream
-	}
+	auto exporter = createExporter(*mapWriter, outFileStream, auxFileStream.get());
 
 	try
 	{
@@ -468,6 +591,14 @@ void MapResource::saveFile(const MapFormat& format, const scene::IMapRootNodePtr
 		throw OperationException(_("Map writing cancelled"));
 	}
 
+	// Make the written map file available to the callback
+	outFileStream.flush();
+
+	if (onMapWritten && !outFileStream.fail())
+	{
+		onMapWritten(*exporter);
+	}
+
 	exporter.reset();
 
 	// Check for any stream failures now that we're done writing
@@ -5,6 +5,7 @@
 #include "imodel.h"
 #include "imap.h"
 #include <set>
+#include <functional>
 #include "RootNode.h"
 #include "os/fs.h"
 #include "stream/MapResourceStream.h"
@@ -12,6 +13,11 @@
 namespace map
 {
 
+class MapExporter;
+typedef std::shared_ptr<MapExporter> MapExporterPtr;
+class SceneSnapshot;
+class MapResourceLoader;
+
 class MapResource :
 	public IMapResource,
 	public util::Noncopyable
@@ -54,10 +60,22 @@ public:
     // Check if the file has been modified since it was last saved
     virtual bool fileHasBeenModifiedSinceLastSave() override;
 
+	// Invoked with the exporter after the map file has been written, while the scene is still
+	// prepared for export. Additional passes can be run through that exporter (e.g. the map cache).
+	using MapWrittenFunc = std::function<void(const MapExporter& exporter)>;
+
 	// Save the map contents to the given filename using the given MapFormat export module
 	// Throws an OperationException if anything prevents successful completion
 	static void saveFile(const MapFormat& format, const scene::IMapRootNodePtr& root,
-						 const GraphTraversalFunc& traverse, const std::string& filename);
+						 const GraphTraversalFunc& traverse, const std::string& filename,
+						 const MapWrittenFunc& onMapWritten = MapWrittenFunc());
+
+	// Save the given snapshot to the given filename, the info file extension needs to be determined
+	// by the caller. Other than saveFile() this doesn't touch the scene or the registry, it can be
+	// called from a worker thread if the format's writer supports that (see IMapWriter::createEntityWriter).
+	// Throws an OperationException if anything prevents successful completion
+	static void saveSnapshot(const MapFormat& format, const SceneSnapshot& snapshot,
+							 const std::string& filename, const std::string& infoFileExtension);
 
 protected:
     // Implementation-specific method to open the stream of the primary .map or .mapx file
@@ -85,6 +103,14 @@ private:
 
 	RootNodePtr loadMapNode();
 
+	// Loads the map from its binary cache file, returns an empty pointer
+	// if the cache doesn't exist or is not matching the map file on disk
+	RootNodePtr loadBinaryCache(MapResourceLoader& loader);
+
+	// Writes the binary cache of the given (just saved) map file, if enabled. This is an
+	// additional pass of the given exporter, the scene is not prepared a second time.
+	void saveBinaryCache(const MapFormat& format, const std::string& mapFilename, const MapExporter& mapExporter);
+
 	void connectMap();
 
 	// Opens a stream for the given path, which might be VFS path or an absolute one. 
@@ -93,6 +119,15 @@ private:
 
 	// Checks if file can be overwritten (throws on failure)
 	static void throwIfNotWriteable(const fs::path& path);
+
+	// Creates the exporter for the given streams, the aux stream is null if the format doesn't write info files
+	using ExporterFactory = std::function<MapExporterPtr(IMapWriter& writer, std::ostream& mapStream, std::ostream* auxStream)>;
+
+	// Opens the output files and exports the given root node through the exporter returned by the factory
+	static void writeMapFiles(const MapFormat& format, const fs::path& outFile, const fs::path& auxFile,
+							  const scene::IMapRootNodePtr& root, const GraphTraversalFunc& traverse,
+							  const ExporterFactory& createExporter,
+							  const MapWrittenFunc& onMapWritten = MapWrittenFunc());
 };
 
 } // namespace map
@@ -4,7 +4,9 @@
 #include "fmt/format.h"
 #include "scene/ChildPrimitives.h"
 #include "scenelib.h"
+#include "imodelcache.h"
 #include "algorithm/MapImporter.h"
+#include "format/BinaryMapCache.h"
 #include "messages/MapFileOperation.h"
 
 namespace map
@@ -16,6 +18,27 @@ MapResourceLoader::MapResourceLoader(std::istream& stream, const MapFormat& form
 {}
 
 RootNodePtr MapResourceLoader::load()
+{
+    return loadFromStream(_stream, [&](IMapImportFilter& importFilter)
+    {
+        rMessage() << "Using " << _format.getMapFormatName() << " format to load the data." << std::endl;
+
+        // Acquire a map reader/parser
+        return _format.getMapReader(importFilter);
+    });
+}
+
+RootNodePtr MapResourceLoader::loadFromBinaryCache(std::istream& cacheStream)
+{
+    return loadFromStream(cacheStream, [&](IMapImportFilter& importFilter)
+    {
+        rMessage() << "Using the binary map cache to load the data." << std::endl;
+
+        return std::make_shared<BinaryMapCacheReader>(importFilter);
+    });
+}
+
+RootNodePtr MapResourceLoader::loadFromStream(std::istream& stream, const ReaderFactory& createReader)
 {
     // Create a new map root node
     auto root = std::make_shared<RootNode>("");
@@ -23,15 +46,15 @@ RootNodePtr MapResourceLoader::load()
     try
     {
         // Our importer taking care of scene insertion
-        MapImporter importFilter(root, _stream);
+        MapImporter importFilter(root, stream);
 
-        // Acquire a map reader/parser
-        IMapReaderPtr reader = _format.getMapReader(importFilter);
-
-        rMessage() << "Using " << _format.getMapFormatName() << " format to load the data." << std::endl;
+        auto reader = createReader(importFilter);
 
         // Start parsing
-        reader->readFromStream(_stream);
+        reader->readFromStream(stream);
+
+        // The entities' models have been requested in the background, swap them in
+        GlobalModelCache().waitForPendingModels();
 
         // Prepare child primitives
         scene::addOriginToChildPrimitives(root);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <istream>
+#include <functional>
 
 #include "imapresource.h"
 #include "itextstream.h"
@@ -33,8 +34,19 @@ public:
     // Throws IMapResource::OperationException on failure or cancel
     RootNodePtr load();
 
+    // Loads the root node from the given binary map cache stream instead of
+    // the map stream, see BinaryMapCache.h.
+    // Throws IMapResource::OperationException on failure or cancel
+    RootNodePtr loadFromBinaryCache(std::istream& cacheStream);
+
     // Load the info file from the given stream, apply it to the root node
     void loadInfoFile(std::istream& stream, const RootNodePtr& root);
+
+private:
+    using ReaderFactory = std::function<IMapReaderPtr(IMapImportFilter&)>;
+
+    // Reads the given stream using the reader returned by the factory
+    RootNodePtr loadFromStream(std::istream& stream, const ReaderFactory& createReader);
 };
 
 }
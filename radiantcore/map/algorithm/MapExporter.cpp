@@ -1,6 +1,7 @@
 #include "MapExporter.h"
 
 #include <ostream>
+#include <sstream>
 #include "i18n.h"
 #include "itextstream.h"
 #include "ibrush.h"
@@ -13,7 +14,6 @@
 #include "registry/registry.h"
 #include "string/string.h"
 
-#include "scene/ChildPrimitives.h"
 #include "messages/MapFileOperation.h"
 
 namespace map
@@ -23,6 +23,9 @@ namespace map
 	{
 		const char* const RKEY_FLOAT_PRECISION = "/mapFormat/floatPrecision";
 		const char* const RKEY_MAP_SAVE_STATUS_INTERLEAVE = "user/ui/map/saveStatusInterleave";
+
+		// Number of formatted entities per worker which can be waiting to be written
+		const std::size_t MAX_PENDING_JOBS_PER_WORKER = 16;
 	}
 
 MapExporter::MapExporter(IMapWriter& writer, const scene::IMapRootNodePtr& root, std::ostream& mapStream, std::size_t nodeCount) :
@@ -34,9 +37,13 @@ MapExporter::MapExporter(IMapWriter& writer, const scene::IMapRootNodePtr& root,
 	_curNodeCount(0),
 	_entityNum(0),
 	_primitiveNum(0),
-    _sendProgressMessages(true)
+    _sendProgressMessages(true),
+	_exportingSnapshot(false),
+	_preparesScene(true),
+	_writeEntitiesInParallel(false),
+	_entityDepth(0)
 {
-	construct();
+	construct(GetGameFloatPrecision());
 }
 
 MapExporter::MapExporter(IMapWriter& writer, const scene::IMapRootNodePtr& root,
@@ -50,35 +57,120 @@ MapExporter::MapExporter(IMapWriter& writer, const scene::IMapRootNodePtr& root,
 	_curNodeCount(0),
 	_entityNum(0),
 	_primitiveNum(0),
-    _sendProgressMessages(true)
+    _sendProgressMessages(true),
+	_exportingSnapshot(false),
+	_preparesScene(true),
+	_writeEntitiesInParallel(false),
+	_entityDepth(0)
+{
+	construct(GetGameFloatPrecision());
+}
+
+MapExporter::MapExporter(IMapWriter& writer, const SceneSnapshot& snapshot, std::ostream& mapStream) :
+	_writer(writer),
+	_mapStream(mapStream),
+	_root(snapshot.getRoot()),
+	_dialogEventLimiter(0),
+	_totalNodeCount(snapshot.getNodeCount()),
+	_curNodeCount(0),
+	_entityNum(0),
+	_primitiveNum(0),
+    _sendProgressMessages(false),
+	_exportingSnapshot(true),
+	_preparesScene(false),
+	_writeEntitiesInParallel(false),
+	_entityDepth(0)
 {
-	construct();
+	construct(snapshot.getFloatPrecision());
+}
+
+MapExporter::MapExporter(IMapWriter& writer, const SceneSnapshot& snapshot,
+				std::ostream& mapStream, std::ostream& auxStream) :
+	_writer(writer),
+	_mapStream(mapStream),
+	_root(snapshot.getRoot()),
+	_dialogEventLimiter(0),
+	_totalNodeCount(snapshot.getNodeCount()),
+	_curNodeCount(0),
+	_entityNum(0),
+	_primitiveNum(0),
+    _sendProgressMessages(false),
+	_exportingSnapshot(true),
+	_preparesScene(false),
+	_writeEntitiesInParallel(false),
+	_entityDepth(0)
+{
+	construct(snapshot.getFloatPrecision());
+
+	// The info file modules have been run when the snapshot was captured
+	auxStream << snapshot.getInfoFileText();
+}
+
+MapExporter::MapExporter(IMapWriter& writer, const MapExporter& primaryExporter, std::ostream& mapStream) :
+	_writer(writer),
+	_mapStream(mapStream),
+	_root(primaryExporter._root),
+	_dialogEventLimiter(0),
+	_totalNodeCount(primaryExporter._totalNodeCount),
+	_curNodeCount(0),
+	_entityNum(0),
+	_primitiveNum(0),
+    _sendProgressMessages(false),
+	_exportingSnapshot(primaryExporter._exportingSnapshot),
+	_preparesScene(false),
+	_writeEntitiesInParallel(false),
+	_entityDepth(0)
+{
+	construct(static_cast<int>(primaryExporter._mapStream.precision()));
 }
 
 MapExporter::~MapExporter()
 {
+	// Stop any formatting still going on, the workers are accessing the scene
+	_workers.reset();
+	_pendingOutput.clear();
+
 	// Close any info file stream
 	_infoFileExporter.reset();
 
 	// The finish() call is placed in the destructor to make sure that 
 	// even on unhandled exceptions the map is left in a working state
-	finishScene();
+	if (_preparesScene)
+	{
+		finishScene();
+	}
 }
 
-void MapExporter::construct()
+int MapExporter::GetGameFloatPrecision()
 {
-	// Prepare the output stream
 	game::IGamePtr curGame = GlobalGameManager().currentGame();
 	assert(curGame);
 
 	xml::NodeList nodes = curGame->getLocalXPath(RKEY_FLOAT_PRECISION);
 	assert(!nodes.empty());
 
-	int precision = string::convert<int>(nodes[0].getAttributeValue("value"));
-	_mapStream.precision(precision);
+	return string::convert<int>(nodes[0].getAttributeValue("value"));
+}
+
+void MapExporter::construct(int floatPrecision)
+{
+	// Prepare the output stream
+	_mapStream.precision(floatPrecision);
+
+	// Writers supporting it will get their entities formatted by the workers
+	_writeEntitiesInParallel = !_exportingSnapshot && _writer.createEntityWriter(0) != nullptr;
+
+	if (_writeEntitiesInParallel)
+	{
+		_workers = std::make_unique<util::ThreadPool>();
+	}
 
-	// Add origin to func_* children before writing
-	prepareScene();
+	// A snapshot has been prepared when it was captured,
+	// additional passes are relying on the primary exporter
+	if (_preparesScene)
+	{
+		prepareScene();
+	}
 }
 
 void MapExporter::exportMap(const scene::INodePtr& root, const GraphTraversalFunc& traverse)
@@ -113,6 +205,12 @@ void MapExporter::exportMap(const scene::INodePtr& root, const GraphTraversalFun
 	// Perform the actual map traversal
 	traverse(root, *this);
 
+	if (_writeEntitiesInParallel)
+	{
+		submitCurrentJob();
+		writePendingOutput(0);
+	}
+
 	try
 	{
 		auto mapRoot = std::dynamic_pointer_cast<scene::IMapRootNode>(root);
@@ -147,8 +245,16 @@ bool MapExporter::pre(const scene::INodePtr& node)
 		{
 			// Progress dialog handling
 			onNodeProgress();
-			
-			_writer.beginWriteEntity(entity, _mapStream);
+
+			if (_writeEntitiesInParallel)
+			{
+				addJobItem(WriteJobItem::Type::BeginEntity, node);
+				_entityDepth++;
+			}
+			else
+			{
+				_writer.beginWriteEntity(entity, _mapStream);
+			}
 
 			if (_infoFileExporter) _infoFileExporter->visitEntity(node, _entityNum);
 
@@ -162,7 +268,14 @@ bool MapExporter::pre(const scene::INodePtr& node)
 			// Progress dialog handling
 			onNodeProgress();
 
-			_writer.beginWriteBrush(brush, _mapStream);
+			if (_writeEntitiesInParallel)
+			{
+				addJobItem(WriteJobItem::Type::BeginBrush, node);
+			}
+			else
+			{
+				_writer.beginWriteBrush(brush, _mapStream);
+			}
 
 			if (_infoFileExporter) _infoFileExporter->visitPrimitive(node, _entityNum, _primitiveNum);
 
@@ -176,7 +289,14 @@ bool MapExporter::pre(const scene::INodePtr& node)
 			// Progress dialog handling
 			onNodeProgress();
 
-			_writer.beginWritePatch(patch, _mapStream);
+			if (_writeEntitiesInParallel)
+			{
+				addJobItem(WriteJobItem::Type::BeginPatch, node);
+			}
+			else
+			{
+				_writer.beginWritePatch(patch, _mapStream);
+			}
 
 			if (_infoFileExporter) _infoFileExporter->visitPrimitive(node, _entityNum, _primitiveNum);
 
@@ -199,7 +319,20 @@ void MapExporter::post(const scene::INodePtr& node)
 
 		if (entity)
 		{
-			_writer.endWriteEntity(entity, _mapStream);
+			if (_writeEntitiesInParallel)
+			{
+				addJobItem(WriteJobItem::Type::EndEntity, node);
+
+				// Each top-level entity is formatted in its own job
+				if (--_entityDepth == 0)
+				{
+					submitCurrentJob();
+				}
+			}
+			else
+			{
+				_writer.endWriteEntity(entity, _mapStream);
+			}
 
 			_entityNum++;
 			return;
@@ -209,7 +342,15 @@ void MapExporter::post(const scene::INodePtr& node)
 
 		if (brush && brush->getIBrush().hasContributingFaces())
 		{
-			_writer.endWriteBrush(brush, _mapStream);
+			if (_writeEntitiesInParallel)
+			{
+				addJobItem(WriteJobItem::Type::EndBrush, node);
+			}
+			else
+			{
+				_writer.endWriteBrush(brush, _mapStream);
+			}
+
 			_primitiveNum++;
 			return;
 		}
@@ -218,7 +359,15 @@ void MapExporter::post(const scene::INodePtr& node)
 
 		if (patch)
 		{
-			_writer.endWritePatch(patch, _mapStream);
+			if (_writeEntitiesInParallel)
+			{
+				addJobItem(WriteJobItem::Type::EndPatch, node);
+			}
+			else
+			{
+				_writer.endWritePatch(patch, _mapStream);
+			}
+
 			_primitiveNum++;
 			return;
 		}
@@ -229,6 +378,108 @@ void MapExporter::post(const scene::INodePtr& node)
 	}
 }
 
+void MapExporter::addJobItem(WriteJobItem::Type type, const scene::INodePtr& node)
+{
+	if (!_currentJob)
+	{
+		// Top-level primitives end up in the job of the entity following them
+		_currentJob = std::make_unique<WriteJob>();
+		_currentJob->writer = _writer.createEntityWriter(_entityNum);
+	}
+
+	WriteJobItem item{ type };
+
+	switch (type)
+	{
+	case WriteJobItem::Type::BeginEntity:
+	case WriteJobItem::Type::EndEntity:
+		item.entity = std::dynamic_pointer_cast<IEntityNode>(node);
+		break;
+	case WriteJobItem::Type::BeginBrush:
+	case WriteJobItem::Type::EndBrush:
+		item.brush = std::dynamic_pointer_cast<IBrushNode>(node);
+		break;
+	case WriteJobItem::Type::BeginPatch:
+	case WriteJobItem::Type::EndPatch:
+		item.patch = std::dynamic_pointer_cast<IPatchNode>(node);
+		break;
+	};
+
+	_currentJob->items.emplace_back(std::move(item));
+}
+
+void MapExporter::submitCurrentJob()
+{
+	if (!_currentJob)
+	{
+		return;
+	}
+
+	std::shared_ptr<WriteJob> job(std::move(_currentJob));
+	auto task = std::make_shared<std::packaged_task<std::string()>>([this, job]()
+	{
+		return processJob(*job);
+	});
+
+	_pendingOutput.emplace_back(task->get_future());
+	_workers->enqueue([task]() { (*task)(); });
+
+	// Don't let the formatted text pile up if the workers are faster than the stream
+	writePendingOutput(_workers->getNumWorkers() * MAX_PENDING_JOBS_PER_WORKER);
+}
+
+void MapExporter::writePendingOutput(std::size_t maxPendingJobs)
+{
+	while (_pendingOutput.size() > maxPendingJobs)
+	{
+		auto text = _pendingOutput.front().get();
+		_pendingOutput.pop_front();
+
+		_mapStream.write(text.data(), text.size());
+	}
+}
+
+std::string MapExporter::processJob(const WriteJob& job)
+{
+	std::ostringstream stream;
+	stream.precision(_mapStream.precision());
+	stream.imbue(_mapStream.getloc());
+
+	for (const auto& item : job.items)
+	{
+		try
+		{
+			switch (item.type)
+			{
+			case WriteJobItem::Type::BeginEntity:
+				job.writer->beginWriteEntity(item.entity, stream);
+				break;
+			case WriteJobItem::Type::EndEntity:
+				job.writer->endWriteEntity(item.entity, stream);
+				break;
+			case WriteJobItem::Type::BeginBrush:
+				job.writer->beginWriteBrush(item.brush, stream);
+				break;
+			case WriteJobItem::Type::EndBrush:
+				job.writer->endWriteBrush(item.brush, stream);
+				break;
+			case WriteJobItem::Type::BeginPatch:
+				job.writer->beginWritePatch(item.patch, stream);
+				break;
+			case WriteJobItem::Type::EndPatch:
+				job.writer->endWritePatch(item.patch, stream);
+				break;
+			};
+		}
+		catch (IMapWriter::FailureException& ex)
+		{
+			rError() << "Failure exporting a node: " << ex.what() << std::endl;
+		}
+	}
+
+	return stream.str();
+}
+
 void MapExporter::onNodeProgress()
 {
 	_curNodeCount++;
@@ -262,12 +513,12 @@ void MapExporter::disableProgressMessages()
 
 void MapExporter::prepareScene()
 {
+	// The scene is not modified during export, the writers are positioning the child
+	// primitives relative to their entity's origin on the fly.
 	// stgatilov: Hack to disable recalculateBrushWindings for hot-reload diffs
 	if (registry::getValue<std::string>("MapExporter_IgnoreBrushes") != "yes")
 	{
-		removeOriginFromChildPrimitives(_root);
-
-		// Re-evaluate all brushes, to update the Winding calculations
+		// Make sure the windings are up to date, only brushes with changed planes are rebuilt
 		recalculateBrushWindings();
 	}
 
@@ -280,15 +531,6 @@ void MapExporter::finishScene()
 	// Emit the post-export event to give subscribers a chance to cleanup the scene
 	GlobalMapResourceManager().signal_onResourceExported().emit(_root);
 
-	// stgatilov: Hack to disable recalculateBrushWindings for hot-reload diffs
-	if (registry::getValue<std::string>("MapExporter_IgnoreBrushes") != "yes")
-	{
-		scene::addOriginToChildPrimitives(_root);
-
-		// Re-evaluate all brushes, to update the Winding calculations
-		recalculateBrushWindings();
-	}
-
     if (_sendProgressMessages)
     {
         FileOperation finishedMsg(FileOperation::Type::Export, FileOperation::Finished, _totalNodeCount > 0);
@@ -6,8 +6,16 @@
 #include "imap.h"
 #include "igame.h"
 
+#include <deque>
+#include <future>
+#include "ibrush.h"
+#include "ipatch.h"
+#include "ientity.h"
+
 #include "../infofile/InfoFileExporter.h"
+#include "SceneSnapshot.h"
 #include "EventRateLimiter.h"
+#include "ThreadPool.h"
 
 #include <sigc++/signal.h>
 
@@ -24,6 +32,21 @@ namespace map
  * If the progress dialog is enabled (i.e. nodeCount > 0 in constructor)
  * a gtkutil::OperationAbortedException& might be thrown during traversal, 
  * the calling code needs to be able to handle that.
+ *
+ * If the writer is able to create independent entity writers (see
+ * IMapWriter::createEntityWriter), each top-level entity is formatted into
+ * its own buffer on a worker thread. The buffers are appended to the map
+ * stream in traversal order, the output is the same as in sequential mode.
+ *
+ * When exporting a SceneSnapshot, the live scene is left alone: no export
+ * signals or progress messages are sent, and neither the registry nor
+ * the info file modules are accessed (the snapshot captured their data),
+ * such that the export can run in a worker thread.
+ *
+ * An additional pass exports the scene of a MapExporter which is still
+ * alive into another writer (e.g. the binary map cache). It relies on the
+ * scene preparation of that exporter and doesn't send any signals or
+ * progress messages of its own.
  */
 class MapExporter :
 	public IMapExporter,
@@ -55,6 +78,53 @@ private:
 
     bool _sendProgressMessages;
 
+	// True if the root is the one of a scene snapshot
+	bool _exportingSnapshot;
+
+	// True if this exporter prepares the scene and emits the export signals,
+	// false for snapshots and additional passes
+	bool _preparesScene;
+
+	// A node the entity writer is invoked for, in traversal order
+	struct WriteJobItem
+	{
+		enum class Type
+		{
+			BeginEntity,
+			EndEntity,
+			BeginBrush,
+			EndBrush,
+			BeginPatch,
+			EndPatch,
+		};
+
+		Type type;
+		IEntityNodePtr entity;
+		IBrushNodePtr brush;
+		IPatchNodePtr patch;
+	};
+
+	// A top-level entity including its children and any top-level primitives preceding it
+	struct WriteJob
+	{
+		IMapWriterPtr writer;
+		std::vector<WriteJobItem> items;
+	};
+
+	// True if the writer supports formatting entities in parallel
+	bool _writeEntitiesInParallel;
+
+	// Number of entities we're currently in
+	std::size_t _entityDepth;
+
+	// The job the visited nodes are added to
+	std::unique_ptr<WriteJob> _currentJob;
+
+	// The formatted output of the submitted jobs, in traversal order
+	std::deque<std::future<std::string>> _pendingOutput;
+
+	std::unique_ptr<util::ThreadPool> _workers;
+
 public:
 	// The constructor prepares the scene and the output stream
 	MapExporter(IMapWriter& writer, const scene::IMapRootNodePtr& root,
@@ -64,6 +134,16 @@ public:
 	MapExporter(IMapWriter& writer, const scene::IMapRootNodePtr& root,
 				std::ostream& mapStream, std::ostream& auxStream, std::size_t nodeCount = 0);
 
+	// Constructors exporting the given snapshot, which needs to be kept alive by the caller.
+	// Entities are written sequentially, the workers are left to the main thread.
+	MapExporter(IMapWriter& writer, const SceneSnapshot& snapshot, std::ostream& mapStream);
+	MapExporter(IMapWriter& writer, const SceneSnapshot& snapshot, std::ostream& mapStream, std::ostream& auxStream);
+
+	// Constructor for an additional pass over the scene the given exporter is writing.
+	// The primary exporter needs to be alive until this pass is done, the scene it
+	// prepared is exported as it is.
+	MapExporter(IMapWriter& writer, const MapExporter& primaryExporter, std::ostream& mapStream);
+
 	// Cleans up the scene on destruction
 	~MapExporter();
 
@@ -80,16 +160,33 @@ public:
     // Don't send any progress messages through the MessageBus while exporting
     void disableProgressMessages();
 
+	// The float precision map files of the current game are written with.
+	// Reads the game registry, so this must be called on the main thread.
+	static int GetGameFloatPrecision();
+
 private:
 	// Common code shared by the constructors
-	void construct();
+	void construct(int floatPrecision);
 
 	void onNodeProgress();
 
-	// Is called before exporting the scene to prepare func_* groups.
+	// Entity writer mode: adds the item to the current job
+	void addJobItem(WriteJobItem::Type type, const scene::INodePtr& node);
+
+	// Entity writer mode: hands the current job over to the workers
+	void submitCurrentJob();
+
+	// Entity writer mode: writes the output of the submitted jobs to the map stream,
+	// this will block until the remaining number of pending jobs is <= maxPendingJobs
+	void writePendingOutput(std::size_t maxPendingJobs);
+
+	// Runs the given job, returning the formatted text
+	std::string processJob(const WriteJob& job);
+
+	// Is called before exporting the scene, makes sure the brush windings are up to date
 	void prepareScene();
 
-	// Called after all the writing has been performed, cleans up func_* groups
+	// Called after all the writing has been performed
 	void finishScene();
 
 	void recalculateBrushWindings();
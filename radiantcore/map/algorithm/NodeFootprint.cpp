@@ -0,0 +1,92 @@
+#include "NodeFootprint.h"
+
+#include <map>
+#include <typeindex>
+#include "iscenegraph.h"
+#include "itextstream.h"
+
+#include "scene/Node.h"
+#include "brush/BrushNode.h"
+#include "patch/PatchNode.h"
+#include "entity/doom3group/Doom3GroupNode.h"
+#include "entity/eclassmodel/EclassModelNode.h"
+#include "entity/generic/GenericEntityNode.h"
+#include "entity/light/LightNode.h"
+#include "entity/speaker/SpeakerNode.h"
+#include "model/StaticModelNode.h"
+#include "model/md5/MD5ModelNode.h"
+
+namespace map
+{
+
+namespace algorithm
+{
+
+namespace
+{
+	struct NodeClassInfo
+	{
+		std::string name;
+		std::size_t size;
+		std::size_t count;
+	};
+
+	template<typename NodeType>
+	void addNodeClass(std::map<std::type_index, NodeClassInfo>& classes, const std::string& name)
+	{
+		classes.emplace(std::type_index(typeid(NodeType)), NodeClassInfo{ name, sizeof(NodeType), 0 });
+	}
+}
+
+void showSceneNodeFootprint(const cmd::ArgumentList& args)
+{
+	std::map<std::type_index, NodeClassInfo> classes;
+
+	addNodeClass<BrushNode>(classes, "BrushNode");
+	addNodeClass<PatchNode>(classes, "PatchNode");
+	addNodeClass<entity::Doom3GroupNode>(classes, "Doom3GroupNode");
+	addNodeClass<entity::EclassModelNode>(classes, "EclassModelNode");
+	addNodeClass<entity::GenericEntityNode>(classes, "GenericEntityNode");
+	addNodeClass<entity::LightNode>(classes, "LightNode");
+	addNodeClass<entity::SpeakerNode>(classes, "SpeakerNode");
+	addNodeClass<model::StaticModelNode>(classes, "StaticModelNode");
+	addNodeClass<md5::MD5ModelNode>(classes, "MD5ModelNode");
+
+	std::size_t otherNodes = 0;
+
+	GlobalSceneGraph().foreachNode([&](const scene::INodePtr& node)
+	{
+		auto found = classes.find(std::type_index(typeid(*node)));
+
+		if (found != classes.end())
+		{
+			++found->second.count;
+		}
+		else
+		{
+			++otherNodes;
+		}
+
+		return true;
+	});
+
+	rMessage() << "scene::Node base class: " << sizeof(scene::Node) << " bytes" << std::endl;
+
+	std::size_t totalBytes = 0;
+
+	for (const auto& pair : classes)
+	{
+		const auto& info = pair.second;
+		totalBytes += info.size * info.count;
+
+		rMessage() << info.name << ": " << info.size << " bytes, " << info.count << " nodes, "
+			<< (info.size * info.count / 1024) << " kB" << std::endl;
+	}
+
+	rMessage() << "Other nodes: " << otherNodes << std::endl;
+	rMessage() << "Total: " << (totalBytes / 1024) << " kB in the listed node classes" << std::endl;
+}
+
+} // namespace
+
+} // namespace
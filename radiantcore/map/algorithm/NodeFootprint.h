@@ -0,0 +1,21 @@
+#pragma once
+
+#include "icommandsystem.h"
+
+namespace map
+{
+
+namespace algorithm
+{
+
+/**
+ * Prints the number of nodes in the current map per node class, together
+ * with the class size and the memory used by the node objects themselves.
+ * Heap memory owned by the nodes (windings, vertices, spawnargs) is not
+ * included in the numbers.
+ */
+void showSceneNodeFootprint(const cmd::ArgumentList& args);
+
+} // namespace
+
+} // namespace
@@ -0,0 +1,220 @@
+#include "SceneSnapshot.h"
+
+#include <sstream>
+
+#include "ibrush.h"
+#include "ilayer.h"
+#include "iselectiongroup.h"
+#include "iselectionset.h"
+#include "ipatch.h"
+#include "ientity.h"
+
+#include "scene/BasicRootNode.h"
+#include "scene/Clone.h"
+#include "../NodeCounter.h"
+#include "../infofile/InfoFileExporter.h"
+#include "model/export/ModelScalePreserver.h"
+#include "MapExporter.h"
+
+namespace map
+{
+
+namespace
+{
+
+// Passes the cloned nodes to the info file modules, the entities
+// and primitives are numbered the same way the MapExporter does
+class InfoFileCollector :
+	public scene::NodeVisitor
+{
+private:
+	InfoFileExporter& _exporter;
+
+	std::size_t _entityNum;
+	std::size_t _primitiveNum;
+
+public:
+	InfoFileCollector(InfoFileExporter& exporter) :
+		_exporter(exporter),
+		_entityNum(0),
+		_primitiveNum(0)
+	{}
+
+	bool pre(const scene::INodePtr& node) override
+	{
+		if (Node_isEntity(node))
+		{
+			_exporter.visitEntity(node, _entityNum);
+		}
+		else if (isExportedPrimitive(node))
+		{
+			_exporter.visitPrimitive(node, _entityNum, _primitiveNum);
+		}
+
+		return true;
+	}
+
+	void post(const scene::INodePtr& node) override
+	{
+		if (Node_isEntity(node))
+		{
+			_entityNum++;
+		}
+		else if (isExportedPrimitive(node))
+		{
+			_primitiveNum++;
+		}
+	}
+
+private:
+	static bool isExportedPrimitive(const scene::INodePtr& node)
+	{
+		auto* brush = Node_getIBrush(node);
+
+		return brush != nullptr ? brush->hasContributingFaces() : Node_isPatch(node);
+	}
+};
+
+}
+
+SceneSnapshot::SceneSnapshot(const scene::IMapRootNodePtr& root, const GraphTraversalFunc& traverse) :
+	_root(std::make_shared<scene::BasicRootNode>()),
+	_nodeCount(0),
+	_floatPrecision(MapExporter::GetGameFloatPrecision())
+{
+	// The cloned faces receive the windings of the source brushes, these need
+	// to be up to date. Only brushes with changed planes are rebuilt.
+	root->foreachNode([](const scene::INodePtr& node)
+	{
+		auto* brush = Node_getIBrush(node);
+
+		if (brush != nullptr)
+		{
+			brush->evaluateBRep();
+		}
+
+		return true;
+	});
+
+	std::map<scene::INodePtr, scene::INodePtr> clonesBySource;
+
+	scene::CloneAll cloner(_root, [&](const scene::INodePtr& sourceNode, const scene::INodePtr& clone)
+	{
+		clonesBySource.emplace(sourceNode, clone);
+
+		auto* clonedEntity = Node_getEntity(clone);
+
+		if (clonedEntity != nullptr)
+		{
+			ModelScalePreserver::PreserveModelScale(sourceNode, *clonedEntity);
+		}
+	});
+
+	traverse(root, cloner);
+
+	copyRootData(root, clonesBySource);
+	captureInfoFile();
+
+	NodeCounter counter;
+	_root->traverseChildren(counter);
+
+	_nodeCount = counter.getCount();
+}
+
+const scene::IMapRootNodePtr& SceneSnapshot::getRoot() const
+{
+	return _root;
+}
+
+std::size_t SceneSnapshot::getNodeCount() const
+{
+	return _nodeCount;
+}
+
+int SceneSnapshot::getFloatPrecision() const
+{
+	return _floatPrecision;
+}
+
+const std::string& SceneSnapshot::getInfoFileText() const
+{
+	return _infoFileText;
+}
+
+void SceneSnapshot::captureInfoFile()
+{
+	std::ostringstream stream;
+
+	{
+		// The info file modules are collecting their data in member variables,
+		// they must only be used on the main thread
+		InfoFileExporter exporter(stream);
+
+		exporter.beginSaveMap(_root);
+
+		InfoFileCollector collector(exporter);
+		_root->traverseChildren(collector);
+
+		exporter.finishSaveMap(_root);
+	}
+
+	_infoFileText = stream.str();
+}
+
+void SceneSnapshot::copyRootData(const scene::IMapRootNodePtr& source,
+	const std::map<scene::INodePtr, scene::INodePtr>& clonesBySource)
+{
+	source->foreachProperty([&](const std::string& key, const std::string& value)
+	{
+		_root->setProperty(key, value);
+	});
+
+	// The cloned nodes keep their layer IDs, the layer names need to match
+	auto& layerManager = _root->getLayerManager();
+
+	source->getLayerManager().foreachLayer([&](int layerId, const std::string& layerName)
+	{
+		if (layerManager.createLayer(layerName, layerId) == -1)
+		{
+			layerManager.renameLayer(layerId, layerName); // the default layer already exists
+		}
+	});
+
+	// Group memberships are not copied along with the nodes
+	auto& groupManager = _root->getSelectionGroupManager();
+
+	source->getSelectionGroupManager().foreachSelectionGroup([&](selection::ISelectionGroup& group)
+	{
+		auto groupClone = groupManager.createSelectionGroup(group.getId());
+		groupClone->setName(group.getName());
+
+		group.foreachNode([&](const scene::INodePtr& member)
+		{
+			auto clone = clonesBySource.find(member);
+
+			if (clone != clonesBySource.end())
+			{
+				groupClone->addNode(clone->second);
+			}
+		});
+	});
+
+	auto& setManager = _root->getSelectionSetManager();
+
+	source->getSelectionSetManager().foreachSelectionSet([&](const selection::ISelectionSetPtr& set)
+	{
+		auto setClone = setManager.createSelectionSet(set->getName());
+
+		for (const auto& member : set->getNodes())
+		{
+			auto clone = clonesBySource.find(member);
+
+			if (clone != clonesBySource.end())
+			{
+				setClone->addNode(clone->second);
+			}
+		}
+	});
+}
+
+} // namespace
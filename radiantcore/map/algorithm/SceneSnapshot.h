@@ -0,0 +1,66 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include "imap.h"
+#include "imapformat.h"
+
+namespace map
+{
+
+/**
+ * A copy of (a part of) the map scene which can be exported outside the main thread.
+ *
+ * The snapshot is captured on the main thread: all nodes visited by the given
+ * traversal function are cloned into a root node which is not part of any scene graph,
+ * along with the layers, selection groups, selection sets and properties of the source root.
+ * The brush windings are copied along with the faces, they are not rebuilt.
+ * Everything the exporter would otherwise read from non-threadsafe modules is captured
+ * too: the float precision of the current game and the info file contents.
+ *
+ * No export signals are emitted, the live scene is not touched. Models with a
+ * modified scale get their scale written to the cloned entity (see ModelScalePreserver).
+ *
+ * Once captured, the cloned nodes are not referenced by anything else, such that a
+ * single worker thread can safely read them. The snapshot must be destroyed
+ * on the main thread again.
+ */
+class SceneSnapshot
+{
+private:
+	scene::IMapRootNodePtr _root;
+
+	// Number of entities and primitives in the snapshot
+	std::size_t _nodeCount;
+
+	// The float precision the map stream is set to
+	int _floatPrecision;
+
+	// The contents of the info file, using the same numbering as the MapExporter
+	std::string _infoFileText;
+
+public:
+	using Ptr = std::shared_ptr<SceneSnapshot>;
+
+	SceneSnapshot(const scene::IMapRootNodePtr& root, const GraphTraversalFunc& traverse);
+
+	// The root of the cloned nodes, traverse it using scene::traverse
+	const scene::IMapRootNodePtr& getRoot() const;
+
+	// The number of entities and primitives in this snapshot
+	std::size_t getNodeCount() const;
+
+	// The float precision defined by the game at capture time
+	int getFloatPrecision() const;
+
+	// The info file contents of this snapshot
+	const std::string& getInfoFileText() const;
+
+private:
+	void copyRootData(const scene::IMapRootNodePtr& source,
+		const std::map<scene::INodePtr, scene::INodePtr>& clonesBySource);
+
+	void captureInfoFile();
+};
+
+} // namespace
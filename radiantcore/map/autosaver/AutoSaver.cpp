@@ -10,7 +10,6 @@
 #include "iregistry.h"
 #include "igame.h"
 #include "ipreferencesystem.h"
-#include "icommandsystem.h"
 
 #include "registry/registry.h"
 
@@ -19,6 +18,7 @@
 #include "os/dir.h"
 #include "os/fs.h"
 #include "gamelib.h"
+#include "scene/Traverse.h"
 
 #include <limits.h>
 #include "string/string.h"
@@ -27,6 +27,7 @@
 #include "messages/NotificationMessage.h"
 #include "messages/AutomaticMapSaveRequest.h"
 #include "map/Map.h"
+#include "map/MapResource.h"
 
 #include <fmt/format.h>
 
@@ -38,10 +39,9 @@ namespace
 	// Registry key names
 	const char* GKEY_MAP_EXTENSION = "/mapFormat/fileExtension";
 
-	std::string constructSnapshotName(const fs::path& snapshotPath, const std::string& mapName, int num)
+	std::string constructSnapshotName(const fs::path& snapshotPath, const std::string& mapName,
+		const std::string& mapExt, int num)
 	{
-		std::string mapExt = game::current::getValue<std::string>(GKEY_MAP_EXTENSION);
-
 		// Construct the base name without numbered extension
 		std::string filename = (snapshotPath / mapName).string();
 
@@ -89,34 +89,159 @@ void AutoMapSaver::saveSnapshot()
 	// Retrieve the mapname
 	std::string mapName = fullPath.filename().string();
 
-	// Map existing snapshots (snapshot num => path)
-	std::map<int, std::string> existingSnapshots;
-
 	// Check if the folder exists and create it if necessary
-	if (os::fileOrDirExists(snapshotPath.string()) || os::makeDirectory(snapshotPath.string()))
+	if (!os::fileOrDirExists(snapshotPath.string()) && !os::makeDirectory(snapshotPath.string()))
+	{
+		rError() << "Snapshot save failed.. unable to create directory";
+		rError() << snapshotPath << std::endl;
+		return;
+	}
+
+	auto mapExt = game::current::getValue<std::string>(GKEY_MAP_EXTENSION);
+	auto infoFileExt = game::current::getInfoFileExtension();
+	auto format = GlobalMapFormatManager().getMapFormatForFilename(constructSnapshotName(snapshotPath, mapName, mapExt, 0));
+
+	startSave(format, [=](const SceneSnapshot& snapshot)
 	{
-		collectExistingSnapshots(existingSnapshots, snapshotPath, mapName);
+		SaveResult result;
+
+		result.isSnapshot = true;
+		result.snapshotPath = snapshotPath;
+		result.mapName = mapName;
+
+		try
+		{
+			// Map existing snapshots (snapshot num => path)
+			std::map<int, std::string> existingSnapshots;
+			collectExistingSnapshots(existingSnapshots, snapshotPath, mapName, mapExt);
+
+			int highestNum = existingSnapshots.empty() ? 0 : existingSnapshots.rbegin()->first + 1;
+
+			std::string filename = constructSnapshotName(snapshotPath, mapName, mapExt, highestNum);
+
+			rMessage() << "Autosaving snapshot to " << filename << std::endl;
+
+			// Dump to map to the next available filename
+			MapResource::saveSnapshot(*format, snapshot, filename, infoFileExt);
+
+			// Sum up the total folder size
+			for (const std::pair<int, std::string>& pair : existingSnapshots)
+			{
+				result.snapshotFolderSize += os::getFileSize(pair.second);
+			}
+		}
+		catch (const IMapResource::OperationException& ex)
+		{
+			result.errorMessage = ex.what();
+		}
+		catch (fs::filesystem_error& f)
+		{
+			rError() << "AutoSaver::saveSnapshot: " << f.what() << std::endl;
+		}
 
-		int highestNum = existingSnapshots.empty() ? 0 : existingSnapshots.rbegin()->first + 1;
+		return result;
+	});
+}
 
-		std::string filename = constructSnapshotName(snapshotPath, mapName, highestNum);
+void AutoMapSaver::saveBackup(const std::string& filename)
+{
+	auto format = GlobalMapFormatManager().getMapFormatForFilename(filename);
+	auto infoFileExt = game::current::getInfoFileExtension();
 
-		rMessage() << "Autosaving snapshot to " << filename << std::endl;
+	startSave(format, [=](const SceneSnapshot& snapshot)
+	{
+		SaveResult result;
 
-		// Dump to map to the next available filename
-        GlobalCommandSystem().executeCommand("SaveAutomaticBackup", filename);
+		try
+		{
+			MapResource::saveSnapshot(*format, snapshot, filename, infoFileExt);
+		}
+		catch (const IMapResource::OperationException& ex)
+		{
+			result.errorMessage = ex.what();
+		}
 
-		handleSnapshotSizeLimit(existingSnapshots, snapshotPath, mapName);
+		return result;
+	});
+}
+
+void AutoMapSaver::startSave(const MapFormatPtr& format, const SaveTask& task)
+{
+	if (!format)
+	{
+		rError() << "AutoSaver: No map format found for saving." << std::endl;
+		return;
 	}
-	else 
+
+	_pendingSnapshot = std::make_shared<SceneSnapshot>(GlobalMapModule().getRoot(), scene::traverse);
+
+	// Writers without independent entity writers might rely on non-threadsafe modules
+	if (!format->getMapWriter()->createEntityWriter(0))
 	{
-		rError() << "Snapshot save failed.. unable to create directory";
-		rError() << snapshotPath << std::endl;
+		handleSaveResult(task(*_pendingSnapshot));
+		_pendingSnapshot.reset();
+		return;
+	}
+
+	// The task doesn't take ownership, the snapshot is destroyed on the main thread
+	const auto& snapshot = *_pendingSnapshot;
+
+	_pendingSave = std::async(std::launch::async, [task, &snapshot]()
+	{
+		return task(snapshot);
+	});
+}
+
+void AutoMapSaver::waitForPendingSave()
+{
+	if (_pendingSave.valid())
+	{
+		_pendingSave.wait();
+		handleFinishedSave();
+	}
+}
+
+void AutoMapSaver::handleFinishedSave()
+{
+	if (!_pendingSave.valid() ||
+		_pendingSave.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+	{
+		return;
+	}
+
+	SaveResult result;
+
+	try
+	{
+		result = _pendingSave.get();
+	}
+	catch (const std::exception& ex)
+	{
+		// Anything the task didn't handle itself ends up here, don't let it escape the timer
+		rError() << "AutoSaver: Background save failed: " << ex.what() << std::endl;
+		result.errorMessage = fmt::format(_("Automatic map save failed: {0}"), ex.what());
+	}
+
+	_pendingSnapshot.reset();
+
+	handleSaveResult(result);
+}
+
+void AutoMapSaver::handleSaveResult(const SaveResult& result)
+{
+	if (!result.errorMessage.empty())
+	{
+		radiant::NotificationMessage::SendError(result.errorMessage);
+		return;
+	}
+
+	if (result.isSnapshot)
+	{
+		handleSnapshotSizeLimit(result.snapshotFolderSize, result.snapshotPath, result.mapName);
 	}
 }
 
-void AutoMapSaver::handleSnapshotSizeLimit(const std::map<int, std::string>& existingSnapshots, 
-	const fs::path& snapshotPath, const std::string& mapName)
+void AutoMapSaver::handleSnapshotSizeLimit(std::size_t folderSize, const fs::path& snapshotPath, const std::string& mapName)
 {
 	std::size_t maxSnapshotFolderSize =
 		registry::getValue<std::size_t>(RKEY_AUTOSAVE_MAX_SNAPSHOT_FOLDER_SIZE);
@@ -127,14 +252,6 @@ void AutoMapSaver::handleSnapshotSizeLimit(const std::map<int, std::string>& exi
 		maxSnapshotFolderSize = 100;
 	}
 
-	// Sum up the total folder size
-	std::size_t folderSize = 0;
-
-	for (const std::pair<int, std::string>& pair : existingSnapshots)
-	{
-		folderSize += os::getFileSize(pair.second);
-	}
-
 	std::size_t maxSize = maxSnapshotFolderSize * 1024 * 1024;
 
 	// The key containing the previously calculated size
@@ -176,12 +293,12 @@ void AutoMapSaver::handleSnapshotSizeLimit(const std::map<int, std::string>& exi
 }
 
 void AutoMapSaver::collectExistingSnapshots(std::map<int, std::string>& existingSnapshots, 
-	const fs::path& snapshotPath, const std::string& mapName)
+	const fs::path& snapshotPath, const std::string& mapName, const std::string& mapExtension)
 {
 	for (int num = 0; num < INT_MAX; num++)
 	{
 		// Construct the base name without numbered extension
-		std::string filename = constructSnapshotName(snapshotPath, mapName, num);
+		std::string filename = constructSnapshotName(snapshotPath, mapName, mapExtension, num);
 
 		if (!os::fileOrDirExists(filename))
 		{
@@ -194,6 +311,8 @@ void AutoMapSaver::collectExistingSnapshots(std::map<int, std::string>& existing
 
 bool AutoMapSaver::runAutosaveCheck()
 {
+    handleFinishedSave();
+
     // Check, if changes have been made since the last autosave
     if (!GlobalSceneGraph().root() || _changes == GlobalSceneGraph().root()->getUndoChangeTracker().changes())
     {
@@ -214,6 +333,9 @@ bool AutoMapSaver::runAutosaveCheck()
 
 void AutoMapSaver::performAutosave()
 {
+    // Only one save at a time, the previous one is most likely done already
+    waitForPendingSave();
+
     // Remember the change tracking counter
     _changes = GlobalSceneGraph().root()->getUndoChangeTracker().changes();
 
@@ -245,8 +367,7 @@ void AutoMapSaver::performAutosave()
 
             rMessage() << "Autosaving unnamed map to " << autoSaveFilename << std::endl;
 
-            // Invoke the save call
-            GlobalCommandSystem().executeCommand("SaveAutomaticBackup", autoSaveFilename);
+            saveBackup(autoSaveFilename);
         }
         else
         {
@@ -261,8 +382,7 @@ void AutoMapSaver::performAutosave()
 
             rMessage() << "Autosaving map to " << filename << std::endl;
 
-            // Invoke the save call
-            GlobalCommandSystem().executeCommand("SaveAutomaticBackup", filename);
+            saveBackup(filename);
         }
     }
 }
@@ -284,8 +404,13 @@ void AutoMapSaver::onMapEvent(IMap::MapEvent ev)
 	switch (ev)
 	{
 	case IMap::MapLoading:
-	case IMap::MapLoaded:
 	case IMap::MapUnloading:
+		// The info file modules are needed for loading, don't
+		// keep the snapshot of the previous map around either
+		waitForPendingSave();
+		clearChanges();
+		break;
+	case IMap::MapLoaded:
 	case IMap::MapUnloaded:
 		clearChanges();
 		break;
@@ -307,6 +432,7 @@ const StringSet& AutoMapSaver::getDependencies() const
 	if (_dependencies.empty())
 	{
 		_dependencies.insert(MODULE_MAP);
+		_dependencies.insert(MODULE_MAPFORMATMANAGER);
 		_dependencies.insert(MODULE_PREFERENCESYSTEM);
 		_dependencies.insert(MODULE_XMLREGISTRY);
 	}
@@ -339,6 +465,8 @@ void AutoMapSaver::initialiseModule(const IApplicationContext& ctx)
 
 void AutoMapSaver::shutdownModule()
 {
+	waitForPendingSave();
+
 	// Unsubscribe from all connections
 	for (sigc::connection& connection : _signalConnections)
 	{
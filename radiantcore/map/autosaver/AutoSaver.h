@@ -3,11 +3,15 @@
 #include <map>
 
 #include "imap.h"
+#include "imapformat.h"
 #include "iautosaver.h"
 
 #include <vector>
+#include <future>
+#include <functional>
 #include <sigc++/connection.h>
 #include "os/fs.h"
+#include "../algorithm/SceneSnapshot.h"
 
 namespace map
 {
@@ -15,6 +19,11 @@ namespace map
 /**
  * greebo: The AutoMapSaver class lets itself being called in distinct intervals
  * and saves the map files either to snapshots or to a single yyyy.autosave.map file.
+ *
+ * The scene is copied into a SceneSnapshot on the main thread, which is then
+ * written to disk by a worker thread (along with looking up the next free
+ * snapshot number and summing up the snapshot folder size). The outcome is
+ * processed on the main thread the next time the autosaver is invoked.
  */
 class AutoMapSaver final : 
 	public IAutomaticMapSaver
@@ -27,6 +36,26 @@ private:
 
 	std::vector<sigc::connection> _signalConnections;
 
+	// The outcome of a save, passed back to the main thread
+	struct SaveResult
+	{
+		// Set if the save failed
+		std::string errorMessage;
+
+		// Snapshot saves only: folder size before this save
+		bool isSnapshot = false;
+		fs::path snapshotPath;
+		std::string mapName;
+		std::size_t snapshotFolderSize = 0;
+	};
+
+	using SaveTask = std::function<SaveResult(const SceneSnapshot& snapshot)>;
+
+	std::future<SaveResult> _pendingSave;
+
+	// The snapshot written by the pending save, it is released on the main thread
+	SceneSnapshot::Ptr _pendingSnapshot;
+
 public:
 	// Constructor
 	AutoMapSaver();
@@ -46,6 +75,8 @@ public:
 
     void performAutosave() override;
 
+    void waitForPendingSave() override;
+
 private:
 	void constructPreferences();
 
@@ -56,11 +87,22 @@ private:
 	// Saves a snapshot of the currently active map (only named maps)
 	void saveSnapshot();
 
-	void collectExistingSnapshots(std::map<int, std::string>& existingSnapshots,
-		const fs::path& snapshotPath, const std::string& mapName);
+	// Saves the currently active map to the given file
+	void saveBackup(const std::string& filename);
+
+	// Captures the scene and passes it to the given task, which is run in the background
+	// if the format's writer supports that, or right away otherwise
+	void startSave(const MapFormatPtr& format, const SaveTask& task);
+
+	// Processes the outcome of a finished save, if there is any
+	void handleFinishedSave();
+
+	void handleSaveResult(const SaveResult& result);
+
+	static void collectExistingSnapshots(std::map<int, std::string>& existingSnapshots,
+		const fs::path& snapshotPath, const std::string& mapName, const std::string& mapExtension);
 
-	void handleSnapshotSizeLimit(const std::map<int, std::string>& existingSnapshots,
-		const fs::path& snapshotPath, const std::string& mapName);
+	void handleSnapshotSizeLimit(std::size_t folderSize, const fs::path& snapshotPath, const std::string& mapName);
 };
 
 } // namespace map
@@ -0,0 +1,582 @@
+#include "BinaryMapCache.h"
+
+#include <charconv>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include "i18n.h"
+#include "itextstream.h"
+#include "ibrush.h"
+#include "ipatch.h"
+#include "ientity.h"
+#include "math/FloatTools.h"
+#include "math/Matrix4.h"
+#include "os/fs.h"
+#include "scene/ChildPrimitives.h"
+#include "primitivewriters/ExportUtil.h"
+#include <fmt/format.h>
+
+namespace map
+{
+
+namespace cache
+{
+
+namespace
+{
+	inline std::size_t getPaddedSize(std::size_t size)
+	{
+		return (size + 7) & ~static_cast<std::size_t>(7);
+	}
+
+	template<typename RecordType>
+	void writeSection(std::ostream& stream, const RecordType* records, std::size_t count)
+	{
+		static const char padding[8] = { 0 };
+		auto size = sizeof(RecordType) * count;
+
+		stream.write(reinterpret_cast<const char*>(records), size);
+		stream.write(padding, getPaddedSize(size) - size);
+	}
+
+	// Hands out the sections of the cache data, checking them against the data size
+	class SectionReader
+	{
+	private:
+		const char* _data;
+		std::size_t _size;
+		std::size_t _offset;
+
+	public:
+		SectionReader(const char* data, std::size_t size) :
+			_data(data),
+			_size(size),
+			_offset(0)
+		{}
+
+		template<typename RecordType>
+		const RecordType* getSection(std::size_t count)
+		{
+			auto size = getPaddedSize(sizeof(RecordType) * count);
+
+			if (size > _size - _offset)
+			{
+				throw IMapReader::FailureException(_("The map cache file is truncated"));
+			}
+
+			auto section = reinterpret_cast<const RecordType*>(_data + _offset);
+			_offset += size;
+
+			return section;
+		}
+	};
+}
+
+std::string getCacheFilename(const std::string& mapFilename)
+{
+	return fs::path(mapFilename).replace_extension(".mapcache").string();
+}
+
+std::uint64_t getMapFileHash(const std::string& mapFilename)
+{
+	std::ifstream mapStream(mapFilename, std::ios::binary);
+
+	if (!mapStream)
+	{
+		return 0;
+	}
+
+	// 64-bit FNV-1a of the file contents
+	std::uint64_t hash = 14695981039346656037ull;
+	char buffer[65536];
+
+	while (mapStream)
+	{
+		mapStream.read(buffer, sizeof(buffer));
+
+		for (auto i = 0; i < mapStream.gcount(); ++i)
+		{
+			if (buffer[i] == '\r') continue;
+
+			hash ^= static_cast<unsigned char>(buffer[i]);
+			hash *= 1099511628211ull;
+		}
+	}
+
+	return hash;
+}
+
+bool isCacheValidForMap(std::istream& cacheStream, std::uint64_t mapFileHash)
+{
+	FileHeader header;
+	cacheStream.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+	bool isValid = cacheStream && std::string(header.magic, 4) == std::string(BINARY_MAP_CACHE_MAGIC, 4) &&
+		header.version == BINARY_MAP_CACHE_VERSION && header.mapFileHash == mapFileHash;
+
+	cacheStream.clear();
+	cacheStream.seekg(0, std::ios::beg);
+
+	return isValid;
+}
+
+}
+
+BinaryMapCacheWriter::BinaryMapCacheWriter(std::uint64_t mapFileHash) :
+	_mapFileHash(mapFileHash),
+	_canBeCached(true),
+	_precision(6),
+	_entityOrigin(0, 0, 0)
+{}
+
+bool BinaryMapCacheWriter::canBeCached() const
+{
+	return _canBeCached;
+}
+
+void BinaryMapCacheWriter::beginWriteMap(const scene::IMapRootNodePtr& root, std::ostream& stream)
+{
+	// The exporter has set up the float precision of the map file on this stream
+	_precision = static_cast<int>(stream.precision());
+}
+
+void BinaryMapCacheWriter::endWriteMap(const scene::IMapRootNodePtr& root, std::ostream& stream)
+{
+	if (!_canBeCached)
+	{
+		return;
+	}
+
+	// Build the string table, offsets are relative to the start of the string data
+	std::vector<std::uint32_t> stringOffsets;
+	std::string stringData;
+
+	for (const auto& str : _strings)
+	{
+		stringOffsets.push_back(static_cast<std::uint32_t>(stringData.size()));
+		stringData += str;
+	}
+
+	stringOffsets.push_back(static_cast<std::uint32_t>(stringData.size()));
+
+	cache::FileHeader header;
+
+	std::copy(cache::BINARY_MAP_CACHE_MAGIC, cache::BINARY_MAP_CACHE_MAGIC + 4, header.magic);
+	header.version = cache::BINARY_MAP_CACHE_VERSION;
+	header.mapFileHash = _mapFileHash;
+	header.numStrings = static_cast<std::uint32_t>(_strings.size());
+	header.stringDataSize = static_cast<std::uint32_t>(stringData.size());
+	header.numEntities = static_cast<std::uint32_t>(_entities.size());
+	header.numKeyValues = static_cast<std::uint32_t>(_keyValues.size());
+	header.numPrimitives = static_cast<std::uint32_t>(_primitives.size());
+	header.numFaces = static_cast<std::uint32_t>(_faces.size());
+	header.numControls = static_cast<std::uint32_t>(_controls.size());
+	header.reserved = 0;
+
+	cache::writeSection(stream, &header, 1);
+	cache::writeSection(stream, stringOffsets.data(), stringOffsets.size());
+	cache::writeSection(stream, stringData.data(), stringData.size());
+	cache::writeSection(stream, _entities.data(), _entities.size());
+	cache::writeSection(stream, _keyValues.data(), _keyValues.size());
+	cache::writeSection(stream, _primitives.data(), _primitives.size());
+	cache::writeSection(stream, _faces.data(), _faces.size());
+	cache::writeSection(stream, _controls.data(), _controls.size());
+}
+
+void BinaryMapCacheWriter::beginWriteEntity(const IEntityNodePtr& entity, std::ostream& stream)
+{
+	_entityOrigin = scene::getChildPrimitiveOrigin(entity);
+
+	cache::EntityRecord record;
+
+	record.firstKeyValue = static_cast<std::uint32_t>(_keyValues.size());
+	record.firstPrimitive = static_cast<std::uint32_t>(_primitives.size());
+	record.numPrimitives = 0;
+
+	entity->getEntity().forEachKeyValue([&](const std::string& key, const std::string& value)
+	{
+		checkStringCanBeCached(key);
+		checkStringCanBeCached(value);
+
+		_keyValues.push_back(cache::KeyValueRecord{ getStringIndex(key), getStringIndex(value) });
+	});
+
+	record.numKeyValues = static_cast<std::uint32_t>(_keyValues.size()) - record.firstKeyValue;
+
+	_entities.push_back(record);
+}
+
+void BinaryMapCacheWriter::endWriteEntity(const IEntityNodePtr& entity, std::ostream& stream)
+{
+	auto& record = _entities.back();
+	record.numPrimitives = static_cast<std::uint32_t>(_primitives.size()) - record.firstPrimitive;
+
+	_entityOrigin = Vector3(0, 0, 0);
+}
+
+void BinaryMapCacheWriter::beginWriteBrush(const IBrushNodePtr& brushNode, std::ostream& stream)
+{
+	// The text parser doesn't accept primitives outside of entities
+	if (_entities.empty())
+	{
+		_canBeCached = false;
+		return;
+	}
+
+	const auto& brush = brushNode->getIBrush();
+
+	cache::PrimitiveRecord record = {};
+
+	record.type = cache::PrimitiveType::BrushDef3;
+	record.first = static_cast<std::uint32_t>(_faces.size());
+	record.detailFlag = static_cast<std::uint32_t>(brush.getDetailFlag());
+
+	for (std::size_t i = 0; i < brush.getNumFaces(); ++i)
+	{
+		const auto& face = brush.getFace(i);
+
+		// Same as the BrushDef3Exporter, non-contributing faces are not written
+		if (face.getWinding().size() <= 2)
+		{
+			continue;
+		}
+
+		auto plane = getPlaneRelativeToOrigin(face.getPlane3(), _entityOrigin);
+		auto texdef = face.getTexDefMatrix();
+
+		cache::FaceRecord faceRecord = {};
+
+		faceRecord.plane[0] = getValueAsWritten(plane.normal().x());
+		faceRecord.plane[1] = getValueAsWritten(plane.normal().y());
+		faceRecord.plane[2] = getValueAsWritten(plane.normal().z());
+		faceRecord.plane[3] = -getValueAsWritten(-plane.dist()); // negated in the file
+
+		faceRecord.texdef[0] = getValueAsWritten(texdef.xx());
+		faceRecord.texdef[1] = getValueAsWritten(texdef.yx());
+		faceRecord.texdef[2] = getValueAsWritten(texdef.tx());
+		faceRecord.texdef[3] = getValueAsWritten(texdef.xy());
+		faceRecord.texdef[4] = getValueAsWritten(texdef.yy());
+		faceRecord.texdef[5] = getValueAsWritten(texdef.ty());
+
+		const auto& shader = face.getShader();
+		checkStringCanBeCached(shader);
+
+		faceRecord.shader = getStringIndex(shader.empty() ? "_default" : shader);
+
+		_faces.push_back(faceRecord);
+	}
+
+	record.count = static_cast<std::uint32_t>(_faces.size()) - record.first;
+
+	_primitives.push_back(record);
+}
+
+void BinaryMapCacheWriter::endWriteBrush(const IBrushNodePtr& brush, std::ostream& stream)
+{
+	// nothing
+}
+
+void BinaryMapCacheWriter::beginWritePatch(const IPatchNodePtr& patchNode, std::ostream& stream)
+{
+	if (_entities.empty())
+	{
+		_canBeCached = false;
+		return;
+	}
+
+	const auto& patch = patchNode->getPatch();
+
+	cache::PrimitiveRecord record = {};
+
+	record.first = static_cast<std::uint32_t>(_controls.size());
+	record.width = static_cast<std::uint32_t>(patch.getWidth());
+	record.height = static_cast<std::uint32_t>(patch.getHeight());
+
+	if (patch.subdivisionsFixed())
+	{
+		record.type = cache::PrimitiveType::PatchDef3;
+		record.subdivisionsX = patch.getSubdivisions().x();
+		record.subdivisionsY = patch.getSubdivisions().y();
+	}
+	else
+	{
+		record.type = cache::PrimitiveType::PatchDef2;
+	}
+
+	const auto& shader = patch.getShader();
+	checkStringCanBeCached(shader);
+
+	record.shader = getStringIndex(shader.empty() ? "_default" : shader);
+
+	// Same order as the control matrix in the map file, column by column
+	for (std::size_t c = 0; c < patch.getWidth(); c++)
+	{
+		for (std::size_t r = 0; r < patch.getHeight(); r++)
+		{
+			const auto& ctrl = patch.ctrlAt(r, c);
+
+			_controls.push_back(cache::ControlRecord
+			{
+				getValueAsWritten(ctrl.vertex[0]),
+				getValueAsWritten(ctrl.vertex[1]),
+				getValueAsWritten(ctrl.vertex[2]),
+				getValueAsWritten(ctrl.texcoord[0]),
+				getValueAsWritten(ctrl.texcoord[1]),
+			});
+		}
+	}
+
+	record.count = static_cast<std::uint32_t>(_controls.size()) - record.first;
+
+	_primitives.push_back(record);
+}
+
+void BinaryMapCacheWriter::endWritePatch(const IPatchNodePtr& patch, std::ostream& stream)
+{
+	// nothing
+}
+
+std::uint32_t BinaryMapCacheWriter::getStringIndex(const std::string& str)
+{
+	auto existing = _stringIndices.emplace(str, static_cast<std::uint32_t>(_strings.size()));
+
+	if (existing.second)
+	{
+		_strings.push_back(str);
+	}
+
+	return existing.first->second;
+}
+
+void BinaryMapCacheWriter::checkStringCanBeCached(const std::string& str)
+{
+	// Quotes and backslashes are subject to unescaping, braces would be parsed as block delimiters
+	if (str.find_first_of("\"\\") != std::string::npos || str == "{" || str == "}")
+	{
+		if (_canBeCached)
+		{
+			rMessage() << "Map contains the string " << str << " which is not cached, the map cache will not be written" << std::endl;
+		}
+
+		_canBeCached = false;
+	}
+}
+
+double BinaryMapCacheWriter::getValueAsWritten(double value) const
+{
+	// writeDoubleSafe() writes NaN, infinity and -0 as 0
+	if (!isValid(value) || value == 0)
+	{
+		return 0;
+	}
+
+	// Format the value like writeDoubleSafe() does, and parse it like the map parser does
+	char buffer[64];
+#if defined(__cpp_lib_to_chars)
+	auto result = std::to_chars(buffer, buffer + sizeof(buffer) - 1, value, std::chars_format::general, _precision);
+	*result.ptr = '\0';
+#else
+	std::snprintf(buffer, sizeof(buffer), "%.*g", _precision, value);
+#endif
+
+	return std::atof(buffer);
+}
+
+BinaryMapCacheReader::BinaryMapCacheReader(IMapImportFilter& importFilter) :
+	Doom3MapReader(importFilter)
+{}
+
+void BinaryMapCacheReader::readFromStream(std::istream& stream)
+{
+	stream.seekg(0, std::ios::end);
+	auto size = static_cast<std::size_t>(stream.tellg());
+	stream.seekg(0, std::ios::beg);
+
+	// Read the whole file in one go, 8-byte aligned such that the records can be used in place
+	std::vector<std::uint64_t> buffer(cache::getPaddedSize(size) / 8);
+	stream.read(reinterpret_cast<char*>(buffer.data()), size);
+
+	if (!stream)
+	{
+		throw FailureException(_("Could not read the map cache file"));
+	}
+
+	cache::SectionReader reader(reinterpret_cast<const char*>(buffer.data()), buffer.size() * 8);
+
+	const auto& header = *reader.getSection<cache::FileHeader>(1);
+
+	if (std::string(header.magic, 4) != std::string(cache::BINARY_MAP_CACHE_MAGIC, 4) ||
+		header.version != cache::BINARY_MAP_CACHE_VERSION)
+	{
+		throw FailureException(_("The map cache file version is not supported"));
+	}
+
+	auto stringOffsets = reader.getSection<std::uint32_t>(header.numStrings + 1);
+	auto stringData = reader.getSection<char>(header.stringDataSize);
+	auto entities = reader.getSection<cache::EntityRecord>(header.numEntities);
+	auto keyValues = reader.getSection<cache::KeyValueRecord>(header.numKeyValues);
+	auto primitives = reader.getSection<cache::PrimitiveRecord>(header.numPrimitives);
+	auto faces = reader.getSection<cache::FaceRecord>(header.numFaces);
+	auto controls = reader.getSection<cache::ControlRecord>(header.numControls);
+
+	std::vector<std::string> strings;
+	strings.reserve(header.numStrings);
+
+	for (std::uint32_t i = 0; i < header.numStrings; ++i)
+	{
+		if (stringOffsets[i] > stringOffsets[i + 1] || stringOffsets[i + 1] > header.stringDataSize)
+		{
+			throw FailureException(_("The map cache file contains an invalid string table"));
+		}
+
+		strings.emplace_back(stringData + stringOffsets[i], stringOffsets[i + 1] - stringOffsets[i]);
+	}
+
+	auto checkRange = [](std::uint64_t first, std::uint64_t count, std::uint64_t size)
+	{
+		if (first + count > size)
+		{
+			throw FailureException(_("The map cache file contains an invalid index"));
+		}
+	};
+
+	for (std::uint32_t e = 0; e < header.numEntities; ++e)
+	{
+		const auto& entityRecord = entities[e];
+
+		checkRange(entityRecord.firstKeyValue, entityRecord.numKeyValues, header.numKeyValues);
+		checkRange(entityRecord.firstPrimitive, entityRecord.numPrimitives, header.numPrimitives);
+
+		try
+		{
+			EntityKeyValues entityKeyValues;
+
+			for (auto kv = entityRecord.firstKeyValue; kv < entityRecord.firstKeyValue + entityRecord.numKeyValues; ++kv)
+			{
+				checkRange(keyValues[kv].key, 1, strings.size());
+				checkRange(keyValues[kv].value, 1, strings.size());
+
+				entityKeyValues.insert(EntityKeyValues::value_type(strings[keyValues[kv].key], strings[keyValues[kv].value]));
+			}
+
+			auto entity = createEntity(entityKeyValues);
+
+			_primitiveCount = 0;
+
+			for (auto p = entityRecord.firstPrimitive; p < entityRecord.firstPrimitive + entityRecord.numPrimitives; ++p)
+			{
+				_primitiveCount++;
+
+				const auto& record = primitives[p];
+
+				if (record.type == cache::PrimitiveType::BrushDef3)
+				{
+					checkRange(record.first, record.count, header.numFaces);
+					_importFilter.addPrimitiveToEntity(createBrush(record, faces + record.first, strings), entity);
+				}
+				else
+				{
+					checkRange(record.first, record.count, header.numControls);
+					_importFilter.addPrimitiveToEntity(createPatch(record, controls + record.first, strings), entity);
+				}
+			}
+
+			_importFilter.addEntity(entity);
+		}
+		catch (FailureException& ex)
+		{
+			throw FailureException(fmt::format(_("Failed reading entity {0:d}:\n{1}"), _entityCount, ex.what()));
+		}
+
+		_entityCount++;
+	}
+}
+
+scene::INodePtr BinaryMapCacheReader::createBrush(const cache::PrimitiveRecord& record,
+	const cache::FaceRecord* faces, const std::vector<std::string>& strings)
+{
+	auto node = GlobalBrushCreator().createBrush();
+
+	auto brushNode = std::dynamic_pointer_cast<IBrushNode>(node);
+	assert(brushNode);
+
+	auto& brush = brushNode->getIBrush();
+
+	// Same calls as the BrushDef3Parser
+	for (std::uint32_t i = 0; i < record.count; ++i)
+	{
+		const auto& face = faces[i];
+
+		if (face.shader >= strings.size())
+		{
+			throw FailureException(_("The map cache file contains an invalid index"));
+		}
+
+		Plane3 plane(face.plane[0], face.plane[1], face.plane[2], face.plane[3]);
+
+		Matrix4 texdef;
+		texdef.xx() = face.texdef[0];
+		texdef.yx() = face.texdef[1];
+		texdef.tx() = face.texdef[2];
+		texdef.xy() = face.texdef[3];
+		texdef.yy() = face.texdef[4];
+		texdef.ty() = face.texdef[5];
+
+		brush.setDetailFlag(static_cast<IBrush::DetailFlag>(record.detailFlag));
+		brush.addFace(plane, texdef, strings[face.shader]);
+	}
+
+	return node;
+}
+
+scene::INodePtr BinaryMapCacheReader::createPatch(const cache::PrimitiveRecord& record,
+	const cache::ControlRecord* controls, const std::vector<std::string>& strings)
+{
+	if (record.shader >= strings.size())
+	{
+		throw FailureException(_("The map cache file contains an invalid index"));
+	}
+
+	bool fixedSubdivisions = record.type == cache::PrimitiveType::PatchDef3;
+
+	auto node = GlobalPatchModule().createPatch(fixedSubdivisions ? patch::PatchDefType::Def3 : patch::PatchDefType::Def2);
+
+	auto patchNode = std::dynamic_pointer_cast<IPatchNode>(node);
+	assert(patchNode);
+
+	auto& patch = patchNode->getPatch();
+
+	// Same calls as the PatchDef2/PatchDef3 parsers
+	patch.setShader(strings[record.shader]);
+	patch.setDims(record.width, record.height);
+
+	if (fixedSubdivisions)
+	{
+		patch.setFixedSubdivisions(true, Subdivisions(record.subdivisionsX, record.subdivisionsY));
+	}
+
+	if (patch.getWidth() * patch.getHeight() != record.count)
+	{
+		throw FailureException(fmt::format(_("Primitive #{0:d}: invalid patch dimensions"), _primitiveCount));
+	}
+
+	const auto* ctrl = controls;
+
+	for (std::size_t c = 0; c < patch.getWidth(); c++)
+	{
+		for (std::size_t r = 0; r < patch.getHeight(); r++, ctrl++)
+		{
+			patch.ctrlAt(r, c).vertex[0] = ctrl->values[0];
+			patch.ctrlAt(r, c).vertex[1] = ctrl->values[1];
+			patch.ctrlAt(r, c).vertex[2] = ctrl->values[2];
+			patch.ctrlAt(r, c).texcoord[0] = ctrl->values[3];
+			patch.ctrlAt(r, c).texcoord[1] = ctrl->values[4];
+		}
+	}
+
+	patch.controlPointsChanged();
+
+	return node;
+}
+
+}
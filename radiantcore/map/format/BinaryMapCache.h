@@ -0,0 +1,205 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "imapformat.h"
+#include "math/Vector3.h"
+#include "Doom3MapReader.h"
+
+namespace map
+{
+
+/**
+ * The binary map cache is an optional file written next to a Doom 3 map
+ * on save (e.g. "arkham.mapcache" for "arkham.map"), holding the entities
+ * and primitives in the exact form the map parser would produce them.
+ * Loading the cache saves the map tokenising and number parsing.
+ *
+ * The cache is keyed by the hash of the .map file contents, it is only
+ * used when the map file is still the one it has been written for.
+ *
+ * All sections are arrays of fixed-size records, 8-byte aligned, such that
+ * the file contents can be accessed in place once read into memory:
+ *
+ * Header | string offsets | string data | entities | keyvalues | primitives | faces | control points
+ */
+namespace cache
+{
+
+// Enables writing the cache file when saving a map
+constexpr const char* const RKEY_WRITE_BINARY_MAP_CACHE = "user/ui/map/writeBinaryMapCache";
+
+// Bump this when the file format changes
+constexpr std::uint32_t BINARY_MAP_CACHE_VERSION = 1;
+constexpr char BINARY_MAP_CACHE_MAGIC[4] = { 'D', 'R', 'M', 'C' };
+
+struct FileHeader
+{
+	char magic[4];
+	std::uint32_t version;
+	std::uint64_t mapFileHash;
+	std::uint32_t numStrings;
+	std::uint32_t stringDataSize; // padded to 8 bytes
+	std::uint32_t numEntities;
+	std::uint32_t numKeyValues;
+	std::uint32_t numPrimitives;
+	std::uint32_t numFaces;
+	std::uint32_t numControls;
+	std::uint32_t reserved;
+};
+
+struct EntityRecord
+{
+	std::uint32_t firstKeyValue;
+	std::uint32_t numKeyValues;
+	std::uint32_t firstPrimitive;
+	std::uint32_t numPrimitives;
+};
+
+// Key and value are indices into the string table
+struct KeyValueRecord
+{
+	std::uint32_t key;
+	std::uint32_t value;
+};
+
+enum class PrimitiveType : std::uint32_t
+{
+	BrushDef3 = 0,
+	PatchDef2 = 1,
+	PatchDef3 = 2,
+};
+
+// Brushes refer to a range of faces, patches to a range of control points
+struct PrimitiveRecord
+{
+	PrimitiveType type;
+	std::uint32_t first;
+	std::uint32_t count;
+	std::uint32_t detailFlag; // brushes only
+	std::uint32_t shader;     // patches only
+	std::uint32_t width;
+	std::uint32_t height;
+	std::uint32_t subdivisionsX;
+	std::uint32_t subdivisionsY;
+	std::uint32_t reserved;
+};
+
+// Plane (normal, dist) and texdef (xx, yx, tx, xy, yy, ty) as they would be parsed
+struct FaceRecord
+{
+	double plane[4];
+	double texdef[6];
+	std::uint32_t shader;
+	std::uint32_t reserved;
+};
+
+// Control point (vertex, texcoord) in the order of the patch matrix in the map file
+struct ControlRecord
+{
+	double values[5];
+};
+
+// Returns the path of the cache file belonging to the given map file
+std::string getCacheFilename(const std::string& mapFilename);
+
+// Calculates the hash of the contents of the given map file. The file is read in
+// binary mode, such that saving and loading agree on the hash on all platforms.
+// Carriage returns are skipped: the map parser treats CRLF and LF line endings the
+// same, converting the line endings of the map file doesn't outdate its cache.
+// Returns 0 if the file cannot be read.
+std::uint64_t getMapFileHash(const std::string& mapFilename);
+
+// Returns true if the given stream contains a cache of the current version,
+// created for a map with the given hash. The stream is rewound afterwards.
+bool isCacheValidForMap(std::istream& cacheStream, std::uint64_t mapFileHash);
+
+}
+
+/**
+ * Map writer collecting the scene in the binary cache format, mirroring
+ * the output of the Doom3MapWriter: all numbers are stored as the text
+ * parser reads them back from the map file written with the same float
+ * precision. The data is written to the stream in endWriteMap().
+ *
+ * Entities with keys or values that cannot be represented in the text
+ * format without change (e.g. containing quotes) make the cache unusable,
+ * no cache data is written in that case.
+ */
+class BinaryMapCacheWriter :
+	public IMapWriter
+{
+private:
+	std::uint64_t _mapFileHash;
+
+	// Cache is written only if this is still true when the map is done
+	bool _canBeCached;
+
+	int _precision;
+
+	Vector3 _entityOrigin;
+
+	std::vector<std::string> _strings;
+	std::unordered_map<std::string, std::uint32_t> _stringIndices;
+
+	std::vector<cache::EntityRecord> _entities;
+	std::vector<cache::KeyValueRecord> _keyValues;
+	std::vector<cache::PrimitiveRecord> _primitives;
+	std::vector<cache::FaceRecord> _faces;
+	std::vector<cache::ControlRecord> _controls;
+
+public:
+	// The hash of the map file this cache is written for
+	BinaryMapCacheWriter(std::uint64_t mapFileHash);
+
+	// False if the map cannot be represented by the cache, nothing has been written then
+	bool canBeCached() const;
+
+	void beginWriteMap(const scene::IMapRootNodePtr& root, std::ostream& stream) override;
+	void endWriteMap(const scene::IMapRootNodePtr& root, std::ostream& stream) override;
+
+	void beginWriteEntity(const IEntityNodePtr& entity, std::ostream& stream) override;
+	void endWriteEntity(const IEntityNodePtr& entity, std::ostream& stream) override;
+
+	void beginWriteBrush(const IBrushNodePtr& brush, std::ostream& stream) override;
+	void endWriteBrush(const IBrushNodePtr& brush, std::ostream& stream) override;
+
+	void beginWritePatch(const IPatchNodePtr& patch, std::ostream& stream) override;
+	void endWritePatch(const IPatchNodePtr& patch, std::ostream& stream) override;
+
+private:
+	std::uint32_t getStringIndex(const std::string& str);
+
+	// Checks whether the given (quoted) string is read back unchanged from the map file
+	void checkStringCanBeCached(const std::string& str);
+
+	// Returns the value as it is read back from the text map file
+	double getValueAsWritten(double value) const;
+};
+
+/**
+ * Reads the binary cache written by the BinaryMapCacheWriter and sends
+ * the entities and primitives to the import filter, in the same order
+ * and using the same calls as the Doom3MapReader does.
+ */
+class BinaryMapCacheReader :
+	public Doom3MapReader
+{
+public:
+	BinaryMapCacheReader(IMapImportFilter& importFilter);
+
+	// Reads the cache data from the given (binary) stream
+	void readFromStream(std::istream& stream) override;
+
+private:
+	scene::INodePtr createBrush(const cache::PrimitiveRecord& record, const cache::FaceRecord* faces,
+		const std::vector<std::string>& strings);
+	scene::INodePtr createPatch(const cache::PrimitiveRecord& record, const cache::ControlRecord* controls,
+		const std::vector<std::string>& strings);
+};
+
+}
@@ -73,6 +73,11 @@ bool Doom3MapFormat::allowInfoFileCreation() const
 	return true;
 }
 
+bool Doom3MapFormat::allowBinaryCacheCreation() const
+{
+	return true;
+}
+
 bool Doom3MapFormat::canLoad(std::istream& stream) const
 {
 	// Instantiate a tokeniser to read the first few tokens
@@ -27,6 +27,7 @@ public:
 	virtual IMapWriterPtr getMapWriter() const;
 
 	virtual bool allowInfoFileCreation() const;
+	virtual bool allowBinaryCacheCreation() const;
 
 	virtual bool canLoad(std::istream& stream) const;
 };
@@ -2,6 +2,7 @@
 
 #include "igame.h"
 #include "ientity.h"
+#include "scene/ChildPrimitives.h"
 
 #include "primitivewriters/BrushDef3Exporter.h"
 #include "primitivewriters/PatchDefExporter.h"
@@ -24,13 +25,14 @@ inline std::string escapeLineBreaks(const std::string& input)
 
 Doom3MapWriter::Doom3MapWriter() :
 	_entityCount(0),
-	_primitiveCount(0)
+	_primitiveCount(0),
+	_entityOrigin(0, 0, 0)
 {}
 
 void Doom3MapWriter::beginWriteMap(const scene::IMapRootNodePtr& root, std::ostream& stream)
 {
 	// Write the version tag
-    stream << "Version " << MAP_VERSION_D3 << std::endl;
+    stream << "Version " << MAP_VERSION_D3 << "\n";
 }
 
 void Doom3MapWriter::endWriteMap(const scene::IMapRootNodePtr& root, std::ostream& stream)
@@ -40,11 +42,13 @@ void Doom3MapWriter::endWriteMap(const scene::IMapRootNodePtr& root, std::ostrea
 
 void Doom3MapWriter::beginWriteEntity(const IEntityNodePtr& entity, std::ostream& stream)
 {
+	_entityOrigin = scene::getChildPrimitiveOrigin(entity);
+
 	// Write out the entity number comment
-	stream << "// entity " << _entityCount++ << std::endl;
+	stream << "// entity " << _entityCount++ << "\n";
 
 	// Entity opening brace
-	stream << "{" << std::endl;
+	stream << "{\n";
 
 	// Entity key values
 	writeEntityKeyValues(entity, stream);
@@ -55,26 +59,27 @@ void Doom3MapWriter::writeEntityKeyValues(const IEntityNodePtr& entity, std::ost
 	// Export the entity key values
     entity->getEntity().forEachKeyValue([&](const std::string& key, const std::string& value)
     {
-        stream << "\"" << key << "\" \"" << escapeLineBreaks(value) << "\"" << std::endl;
+        stream << "\"" << key << "\" \"" << escapeLineBreaks(value) << "\"\n";
     });
 }
 
 void Doom3MapWriter::endWriteEntity(const IEntityNodePtr& entity, std::ostream& stream)
 {
 	// Write the closing brace for the entity
-	stream << "}" << std::endl;
+	stream << "}\n";
 
 	// Reset the primitive count again
 	_primitiveCount = 0;
+	_entityOrigin = Vector3(0, 0, 0);
 }
 
 void Doom3MapWriter::beginWriteBrush(const IBrushNodePtr& brush, std::ostream& stream)
 {
 	// Primitive count comment
-	stream << "// primitive " << _primitiveCount++ << std::endl;
+	stream << "// primitive " << _primitiveCount++ << "\n";
 
 	// Export brushDef3 definition to stream
-	BrushDef3Exporter::exportBrush(stream, brush);
+	BrushDef3Exporter::exportBrush(stream, brush, _entityOrigin);
 }
 
 void Doom3MapWriter::endWriteBrush(const IBrushNodePtr& brush, std::ostream& stream)
@@ -85,7 +90,7 @@ void Doom3MapWriter::endWriteBrush(const IBrushNodePtr& brush, std::ostream& str
 void Doom3MapWriter::beginWritePatch(const IPatchNodePtr& patch, std::ostream& stream)
 {
 	// Primitive count comment
-	stream << "// primitive " << _primitiveCount++ << std::endl;
+	stream << "// primitive " << _primitiveCount++ << "\n";
 
 	// Export patch here _mapStream
 	PatchDefExporter::exportPatch(stream, patch);
@@ -96,4 +101,9 @@ void Doom3MapWriter::endWritePatch(const IPatchNodePtr& patch, std::ostream& str
 	// nothing
 }
 
+IMapWriterPtr Doom3MapWriter::createEntityWriter(std::size_t entityNumber)
+{
+	return createWriterForEntity<Doom3MapWriter>(entityNumber);
+}
+
 } // namespace
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "imapformat.h"
+#include "math/Vector3.h"
 
 namespace map
 {
@@ -18,6 +19,9 @@ protected:
 	std::size_t _entityCount;
 	std::size_t _primitiveCount;
 
+	// The origin of the entity currently being written, the primitives are written relative to it
+	Vector3 _entityOrigin;
+
 public:
 	Doom3MapWriter();
 
@@ -36,7 +40,19 @@ public:
 	virtual void beginWritePatch(const IPatchNodePtr& patch, std::ostream& stream) override;
 	virtual void endWritePatch(const IPatchNodePtr& patch, std::ostream& stream) override;
 
+	virtual IMapWriterPtr createEntityWriter(std::size_t entityNumber) override;
+
 protected:
+	// Creates a writer of the given type, numbering the entities starting at the given number
+	template<typename WriterType>
+	static IMapWriterPtr createWriterForEntity(std::size_t entityNumber)
+	{
+		auto writer = std::make_shared<WriterType>();
+		writer->_entityCount = entityNumber;
+
+		return writer;
+	}
+
 	void writeEntityKeyValues(const IEntityNodePtr& entity, std::ostream& stream);
 };
 
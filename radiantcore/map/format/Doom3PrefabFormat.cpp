@@ -39,6 +39,11 @@ bool Doom3PrefabFormat::allowInfoFileCreation() const
 	return false;
 }
 
+bool Doom3PrefabFormat::allowBinaryCacheCreation() const
+{
+	return false;
+}
+
 module::StaticModule<Doom3PrefabFormat> d3PrefabModule;
 
 } // namespace
@@ -20,6 +20,7 @@ public:
 
 	virtual const std::string& getMapFormatName() const;
 	virtual bool allowInfoFileCreation() const;
+	virtual bool allowBinaryCacheCreation() const;
 };
 typedef std::shared_ptr<Doom3PrefabFormat> Doom3PrefabFormatPtr;
 
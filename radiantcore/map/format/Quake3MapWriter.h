@@ -19,26 +19,32 @@ public:
 	virtual void beginWriteMap(const scene::IMapRootNodePtr& root, std::ostream& stream) override
 	{
 		// Write an empty line at the beginning of the file
-		stream << std::endl;
+		stream << "\n";
 	}
 
 	virtual void beginWriteBrush(const IBrushNodePtr& brush, std::ostream& stream) override
 	{
 		// Primitive count comment
-		stream << "// brush " << _primitiveCount++ << std::endl;
+		stream << "// brush " << _primitiveCount++ << "\n";
 
 		// Export old brush syntax to stream
-		LegacyBrushDefExporter::exportBrush(stream, brush);
+		LegacyBrushDefExporter::exportBrush(stream, brush, _entityOrigin);
 	}
 
 	virtual void beginWritePatch(const IPatchNodePtr& patch, std::ostream& stream) override
 	{
 		// Primitive count comment, not a typo, patches also seem to have "brush" in their comments
-		stream << "// brush " << _primitiveCount++ << std::endl;
+		stream << "// brush " << _primitiveCount++ << "\n";
 
 		// Export patchDef2 to stream (patchDef3 is not supported)
 		PatchDefExporter::exportQ3PatchDef2(stream, patch);
 	}
+
+	// The Q3 brush exporters are accessing the material manager, entities are written in sequence
+	virtual IMapWriterPtr createEntityWriter(std::size_t entityNumber) override
+	{
+		return IMapWriterPtr();
+	}
 };
 
 class Quake3AlternateMapWriter :
@@ -49,10 +55,16 @@ public:
     virtual void beginWriteBrush(const IBrushNodePtr& brush, std::ostream& stream) override
     {
         // Primitive count comment
-        stream << "// brush " << _primitiveCount++ << std::endl;
+        stream << "// brush " << _primitiveCount++ << "\n";
 
         // Export brushDef definition to stream
-        BrushDefExporter::exportBrush(stream, brush);
+        BrushDefExporter::exportBrush(stream, brush, _entityOrigin);
+    }
+
+    // The shader names are shortened using the game's texture prefix, entities are written in sequence
+    virtual IMapWriterPtr createEntityWriter(std::size_t entityNumber) override
+    {
+        return IMapWriterPtr();
     }
 };
 
@@ -17,16 +17,21 @@ public:
 	virtual void beginWriteMap(const scene::IMapRootNodePtr& root, std::ostream& stream) override
 	{
 		// Write the version tag
-		stream << "Version " << MAP_VERSION_Q4 << std::endl;
+		stream << "Version " << MAP_VERSION_Q4 << "\n";
 	}
 
 	virtual void beginWriteBrush(const IBrushNodePtr& brush, std::ostream& stream) override
 	{
 		// Primitive count comment
-		stream << "// primitive " << _primitiveCount++ << std::endl;
+		stream << "// primitive " << _primitiveCount++ << "\n";
 
 		// Export brushDef3 definition to stream, but without contents flags
-		BrushDef3Exporter::exportBrush(stream, brush, false);
+		BrushDef3Exporter::exportBrush(stream, brush, _entityOrigin, false);
+	}
+
+	virtual IMapWriterPtr createEntityWriter(std::size_t entityNumber) override
+	{
+		return createWriterForEntity<Quake4MapWriter>(entityNumber);
 	}
 };
 
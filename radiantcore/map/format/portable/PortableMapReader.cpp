@@ -1,6 +1,9 @@
 #include "PortableMapReader.h"
 
 #include <regex>
+#include <functional>
+#include <libxml/xmlreader.h>
+
 #include "itextstream.h"
 #include "iselectionset.h"
 #include "iselectiongroup.h"
@@ -45,173 +48,270 @@ namespace
 
 		return children.front();
 	}
-}
 
-using namespace map::format::constants;
+	// Input callback of the xmlTextReader, pulling the data from the std::istream
+	int readFromInputStream(void* context, char* buffer, int length)
+	{
+		auto& stream = *static_cast<std::istream*>(context);
 
-PortableMapReader::PortableMapReader(IMapImportFilter& importFilter) :
-	_importFilter(importFilter)
-{}
+		if (stream.bad()) return -1;
 
-void PortableMapReader::readFromStream(std::istream& stream)
-{
-	xml::Document doc(stream);
+		stream.read(buffer, length);
 
-	auto mapNode = doc.getTopLevelNode();
+		return static_cast<int>(stream.gcount());
+	}
 
-	if (string::convert<std::size_t>(mapNode.getAttributeValue(ATTR_VERSION)) != PortableMapFormat::Version)
+	int closeInputStream(void* context)
 	{
-		throw FailureException("Unsupported format version.");
+		return 0;
 	}
-
-	readLayers(mapNode);
-	readSelectionGroups(mapNode);
-	readSelectionSets(mapNode);
-	readMapProperties(mapNode);
-
-	readEntities(mapNode);
 }
 
-void PortableMapReader::readLayers(const xml::Node& mapNode)
+/**
+ * Thin wrapper around the xmlTextReader, walking the elements of the
+ * document while it is read from the stream. The subtree of the current
+ * element can be expanded into xml::Nodes, which stay valid until the
+ * reader moves on to the next element.
+ */
+class PortableMapReader::StreamReader
 {
-	try
-	{
-		_importFilter.getRootNode()->getLayerManager().reset();
+private:
+	xmlTextReaderPtr _reader;
 
-		auto mapLayers = getNamedChild(mapNode, TAG_MAP_LAYERS);
+public:
+	StreamReader(std::istream& stream) :
+		_reader(xmlReaderForIO(readFromInputStream, closeInputStream, &stream, nullptr, nullptr, 0))
+	{
+		if (_reader == nullptr)
+		{
+			throw FailureException("Failed to create the XML reader");
+		}
+	}
 
-		auto layers = mapLayers.getNamedChildren(TAG_MAP_LAYER);
+	~StreamReader()
+	{
+		xmlFreeTextReader(_reader);
+	}
 
-		for (const auto& layer : layers)
+	// Advances the reader to the top-level element of the document
+	void moveToRootElement()
+	{
+		while (readNext())
 		{
-			auto id = string::convert<int>(layer.getAttributeValue(ATTR_MAP_LAYER_ID));
-			auto name = layer.getAttributeValue(ATTR_MAP_LAYER_NAME);
-
-			_importFilter.getRootNode()->getLayerManager().createLayer(name, id);
+			if (xmlTextReaderNodeType(_reader) == XML_READER_TYPE_ELEMENT) return;
 		}
+
+		throw FailureException("No root element found.");
 	}
-	catch (const BadDocumentFormatException& ex)
+
+	// The name of the current element
+	std::string getName() const
 	{
-		rError() << "PortableMapReader: " << ex.what() << std::endl;
+		auto name = xmlTextReaderConstName(_reader);
+		return name != nullptr ? reinterpret_cast<const char*>(name) : "";
 	}
-}
 
-void PortableMapReader::readSelectionGroups(const xml::Node& mapNode)
-{
-	try
+	// Returns the value of the given attribute of the current element, or an empty string
+	std::string getAttributeValue(const std::string& name) const
 	{
-		assert(_importFilter.getRootNode());
-		_importFilter.getRootNode()->getSelectionGroupManager().deleteAllSelectionGroups();
-
-		auto mapSelGroups = getNamedChild(mapNode, TAG_SELECTIONGROUPS);
+		auto value = xmlTextReaderGetAttribute(_reader, BAD_CAST name.c_str());
 
-		auto groups = mapSelGroups.getNamedChildren(TAG_SELECTIONGROUP);
+		if (value == nullptr) return std::string();
 
-		for (const auto& group : groups)
-		{
-			auto id = string::convert<std::size_t>(group.getAttributeValue(ATTR_SELECTIONGROUP_ID));
-			auto name = group.getAttributeValue(ATTR_SELECTIONGROUP_NAME);
+		std::string result(reinterpret_cast<const char*>(value));
+		xmlFree(value);
 
-			auto newGroup = _importFilter.getRootNode()->getSelectionGroupManager().createSelectionGroup(id);
-			newGroup->setName(name);
-		}
+		return result;
 	}
-	catch (const BadDocumentFormatException & ex)
+
+	// Reads the subtree of the current element
+	xml::Node expand()
 	{
-		rError() << "PortableMapReader: " << ex.what() << std::endl;
+		auto node = xmlTextReaderExpand(_reader);
+
+		if (node == nullptr)
+		{
+			throw FailureException("Failed to read " + getName() + " element.");
+		}
+
+		return xml::Node(node);
 	}
-}
 
-void PortableMapReader::readSelectionSets(const xml::Node& mapNode)
-{
-	try
+	// Invokes the functor for every direct child element of the current element,
+	// the reader is positioned on the child element during the call.
+	// When done the reader is positioned on the end of the current element.
+	void foreachChildElement(const std::function<void()>& functor)
 	{
-		_selectionSets.clear();
+		if (xmlTextReaderIsEmptyElement(_reader) == 1) return;
 
-		assert(_importFilter.getRootNode());
-		_importFilter.getRootNode()->getSelectionSetManager().deleteAllSelectionSets();
+		auto depth = xmlTextReaderDepth(_reader);
+		auto hasNode = readNext();
+
+		while (hasNode)
+		{
+			auto type = xmlTextReaderNodeType(_reader);
+			auto nodeDepth = xmlTextReaderDepth(_reader);
 
-		auto mapSelSets = getNamedChild(mapNode, TAG_SELECTIONSETS);
+			if (type == XML_READER_TYPE_END_ELEMENT && nodeDepth == depth)
+			{
+				return;
+			}
 
-		auto setNodes = mapSelSets.getNamedChildren(TAG_SELECTIONSET);
+			if (type == XML_READER_TYPE_ELEMENT && nodeDepth == depth + 1)
+			{
+				functor();
 
-		for (const auto& setNode : setNodes)
-		{
-			auto id = string::convert<std::size_t>(setNode.getAttributeValue(ATTR_SELECTIONSET_ID));
-			auto name = setNode.getAttributeValue(ATTR_SELECTIONSET_NAME);
+				// Skip the rest of the child's subtree
+				hasNode = skipSubtree();
+				continue;
+			}
 
-			auto set = _importFilter.getRootNode()->getSelectionSetManager().createSelectionSet(name);
-			_selectionSets[id] = set;
+			hasNode = readNext();
 		}
+
+		throw FailureException("Unexpected end of document.");
 	}
-	catch (const BadDocumentFormatException & ex)
+
+private:
+	bool readNext()
 	{
-		rError() << "PortableMapReader: " << ex.what() << std::endl;
+		return check(xmlTextReaderRead(_reader));
+	}
+
+	bool skipSubtree()
+	{
+		return check(xmlTextReaderNext(_reader));
 	}
-}
 
-void PortableMapReader::readMapProperties(const xml::Node& mapNode)
+	bool check(int result)
+	{
+		if (result < 0)
+		{
+			throw FailureException("Failed to parse the XML document.");
+		}
+
+		return result == 1;
+	}
+};
+
+using namespace map::format::constants;
+
+PortableMapReader::PortableMapReader(IMapImportFilter& importFilter) :
+	_importFilter(importFilter),
+	_entityCount(0),
+	_primitiveCount(0)
+{}
+
+void PortableMapReader::readFromStream(std::istream& stream)
 {
-	try
+	StreamReader reader(stream);
+	reader.moveToRootElement();
+
+	if (string::convert<std::size_t>(reader.getAttributeValue(ATTR_VERSION)) != PortableMapFormat::Version)
 	{
-		_importFilter.getRootNode()->clearProperties();
+		throw FailureException("Unsupported format version.");
+	}
 
-		auto mapProperties = getNamedChild(mapNode, TAG_MAP_PROPERTIES);
+	auto root = _importFilter.getRootNode();
+	assert(root);
 
-		auto propertyNodes = mapProperties.getNamedChildren(TAG_MAP_PROPERTY);
+	// Clear the existing data, the header tags are processed as they come in
+	root->getLayerManager().reset();
+	root->getSelectionGroupManager().deleteAllSelectionGroups();
+	root->getSelectionSetManager().deleteAllSelectionSets();
+	root->clearProperties();
 
-		for (const auto& propertyNode : propertyNodes)
-		{
-			auto key = propertyNode.getAttributeValue(ATTR_MAP_PROPERTY_KEY);
-			auto value = propertyNode.getAttributeValue(ATTR_MAP_PROPERTY_VALUE);
+	_selectionSets.clear();
+
+	reader.foreachChildElement([&]()
+	{
+		auto name = reader.getName();
 
-			_importFilter.getRootNode()->setProperty(key, value);
+		if (name == TAG_ENTITY)
+		{
+			try
+			{
+				readEntity(reader);
+			}
+			catch (const BadDocumentFormatException& ex)
+			{
+				rError() << "PortableMapReader: Failed to parse entity: " << ex.what() << std::endl;
+			}
+		}
+		else if (name == TAG_MAP_LAYERS)
+		{
+			readLayers(reader.expand());
 		}
+		else if (name == TAG_SELECTIONGROUPS)
+		{
+			readSelectionGroups(reader.expand());
+		}
+		else if (name == TAG_SELECTIONSETS)
+		{
+			readSelectionSets(reader.expand());
+		}
+		else if (name == TAG_MAP_PROPERTIES)
+		{
+			readMapProperties(reader.expand());
+		}
+	});
+}
+
+void PortableMapReader::readLayers(const xml::Node& layersTag)
+{
+	auto layers = layersTag.getNamedChildren(TAG_MAP_LAYER);
+
+	for (const auto& layer : layers)
+	{
+		auto id = string::convert<int>(layer.getAttributeValue(ATTR_MAP_LAYER_ID));
+		auto name = layer.getAttributeValue(ATTR_MAP_LAYER_NAME);
+
+		_importFilter.getRootNode()->getLayerManager().createLayer(name, id);
 	}
-	catch (const BadDocumentFormatException & ex)
+}
+
+void PortableMapReader::readSelectionGroups(const xml::Node& groupsTag)
+{
+	auto groups = groupsTag.getNamedChildren(TAG_SELECTIONGROUP);
+
+	for (const auto& group : groups)
 	{
-		rError() << "PortableMapReader: " << ex.what() << std::endl;
+		auto id = string::convert<std::size_t>(group.getAttributeValue(ATTR_SELECTIONGROUP_ID));
+		auto name = group.getAttributeValue(ATTR_SELECTIONGROUP_NAME);
+
+		auto newGroup = _importFilter.getRootNode()->getSelectionGroupManager().createSelectionGroup(id);
+		newGroup->setName(name);
 	}
 }
 
-void PortableMapReader::readEntities(const xml::Node& mapNode)
+void PortableMapReader::readSelectionSets(const xml::Node& setsTag)
 {
-	auto entityNodes = mapNode.getNamedChildren(TAG_ENTITY);
+	auto setNodes = setsTag.getNamedChildren(TAG_SELECTIONSET);
 
-	for (const auto& entityNode : entityNodes)
+	for (const auto& setNode : setNodes)
 	{
-		try
-		{
-			readEntity(entityNode);
-		}
-		catch (const BadDocumentFormatException & ex)
-		{
-			rError() << "PortableMapReader: Failed to parse entity: " << ex.what() << std::endl;
-			continue;
-		}
+		auto id = string::convert<std::size_t>(setNode.getAttributeValue(ATTR_SELECTIONSET_ID));
+		auto name = setNode.getAttributeValue(ATTR_SELECTIONSET_NAME);
+
+		auto set = _importFilter.getRootNode()->getSelectionSetManager().createSelectionSet(name);
+		_selectionSets[id] = set;
 	}
 }
 
-void PortableMapReader::readPrimitives(const xml::Node& primitivesNode, const scene::INodePtr& entity)
+void PortableMapReader::readMapProperties(const xml::Node& propertiesTag)
 {
-	auto childNodes = primitivesNode.getChildren();
-	
-	for (const auto childNode : childNodes)
+	auto propertyNodes = propertiesTag.getNamedChildren(TAG_MAP_PROPERTY);
+
+	for (const auto& propertyNode : propertyNodes)
 	{
-		const std::string name = childNode.getName();
+		auto key = propertyNode.getAttributeValue(ATTR_MAP_PROPERTY_KEY);
+		auto value = propertyNode.getAttributeValue(ATTR_MAP_PROPERTY_VALUE);
 
-		if (name == TAG_BRUSH)
-		{
-			readBrush(childNode, entity);
-		}
-		else if (name == TAG_PATCH)
-		{
-			readPatch(childNode, entity);
-		}
+		_importFilter.getRootNode()->setProperty(key, value);
 	}
 }
 
-void PortableMapReader::readBrush(const xml::Node& brushTag, const scene::INodePtr& entity)
+scene::INodePtr PortableMapReader::readBrush(const xml::Node& brushTag)
 {
 	// Create a new brush
 	auto node = GlobalBrushCreator().createBrush();
@@ -267,20 +367,16 @@ void PortableMapReader::readBrush(const xml::Node& brushTag, const scene::INodeP
 		}
 		catch (const BadDocumentFormatException& ex)
 		{
-			rError() << "PortableMapReader: Entity " << entity->name() << ", Brush " << 
+			rError() << "PortableMapReader: Entity " << _entityCount << ", Brush " << 
 				brushTag.getAttributeValue(ATTR_BRUSH_NUMBER) << ": " << ex.what() << std::endl;
 			continue;
 		}
 	}
 
-	_importFilter.addPrimitiveToEntity(node, entity);
-
-	readLayerInformation(brushTag, node);
-	readSelectionGroupInformation(brushTag, node);
-	readSelectionSetInformation(brushTag, node);
+	return node;
 }
 
-void PortableMapReader::readPatch(const xml::Node& patchTag, const scene::INodePtr& entity)
+scene::INodePtr PortableMapReader::readPatch(const xml::Node& patchTag)
 {
 	bool isFixedSubdiv = patchTag.getAttributeValue(ATTR_PATCH_FIXED_SUBDIV) == ATTR_VALUE_TRUE;
 
@@ -331,26 +427,81 @@ void PortableMapReader::readPatch(const xml::Node& patchTag, const scene::INodeP
 
 	patch.controlPointsChanged();
 
-	_importFilter.addPrimitiveToEntity(node, entity);
-
-	readLayerInformation(patchTag, node);
-	readSelectionGroupInformation(patchTag, node);
-	readSelectionSetInformation(patchTag, node);
+	return node;
 }
 
-void PortableMapReader::readEntity(const xml::Node& entityTag)
+void PortableMapReader::readEntity(StreamReader& reader)
 {
 	std::map<std::string, std::string> entityKeyValues{};
+	NodeMemberships memberships;
+
+	// The primitives are listed before the key values, they are parsed right away
+	// and added to the entity after it has been created
+	std::vector<PendingPrimitive> primitives;
 
-	auto keyValuesTag = getNamedChild(entityTag, TAG_ENTITY_KEYVALUES);
-	auto keyValueTags = keyValuesTag.getNamedChildren(TAG_ENTITY_KEYVALUE);
+	// Counts the occurrences of each entity child tag
+	std::map<std::string, std::size_t> tagCount;
 
-	for (const auto& keyValue : keyValueTags)
+	_entityCount++;
+
+	reader.foreachChildElement([&]()
 	{
-		auto key = keyValue.getAttributeValue(ATTR_ENTITY_PROPERTY_KEY);
-		auto value = keyValue.getAttributeValue(ATTR_ENTITY_PROPERTY_VALUE);
+		auto name = reader.getName();
+		tagCount[name]++;
+
+		if (name == TAG_ENTITY_PRIMITIVES)
+		{
+			reader.foreachChildElement([&]()
+			{
+				auto primitiveName = reader.getName();
+
+				if (primitiveName != TAG_BRUSH && primitiveName != TAG_PATCH) return;
+
+				try
+				{
+					auto primitiveTag = reader.expand();
+					auto node = primitiveName == TAG_BRUSH ? readBrush(primitiveTag) : readPatch(primitiveTag);
+
+					primitives.push_back(PendingPrimitive{ node, readMemberships(primitiveTag) });
+				}
+				catch (const BadDocumentFormatException& ex)
+				{
+					rError() << "PortableMapReader: Entity " << _entityCount << ": " << ex.what() << std::endl;
+				}
+			});
+		}
+		else if (name == TAG_ENTITY_KEYVALUES)
+		{
+			auto keyValueTags = reader.expand().getNamedChildren(TAG_ENTITY_KEYVALUE);
+
+			for (const auto& keyValue : keyValueTags)
+			{
+				auto key = keyValue.getAttributeValue(ATTR_ENTITY_PROPERTY_KEY);
+				auto value = keyValue.getAttributeValue(ATTR_ENTITY_PROPERTY_VALUE);
+
+				entityKeyValues[key] = value;
+			}
+		}
+		else if (name == TAG_OBJECT_LAYERS)
+		{
+			readLayerIds(reader.expand(), memberships);
+		}
+		else if (name == TAG_OBJECT_SELECTIONGROUPS)
+		{
+			readSelectionGroupIds(reader.expand(), memberships);
+		}
+		else if (name == TAG_OBJECT_SELECTIONSETS)
+		{
+			readSelectionSetIds(reader.expand(), memberships);
+		}
+	});
 
-		entityKeyValues[key] = value;
+	for (auto tagName : { TAG_ENTITY_KEYVALUES, TAG_OBJECT_LAYERS, TAG_OBJECT_SELECTIONGROUPS, TAG_OBJECT_SELECTIONSETS })
+	{
+		if (tagCount[tagName] != 1)
+		{
+			throw BadDocumentFormatException("Odd number of " + std::string(tagName) + " nodes encountered.");
+		}
 	}
 
 	// Get the classname from the EntityKeyValues
@@ -381,85 +532,102 @@ void PortableMapReader::readEntity(const xml::Node& entityTag)
 		entityNode->getEntity().setKeyValue(pair.first, pair.second);
 	}
 
-	readLayerInformation(entityTag, entityNode);
-	readSelectionGroupInformation(entityTag, entityNode);
-	readSelectionSetInformation(entityTag, entityNode);
+	applyMemberships(memberships, entityNode);
 
 	_importFilter.addEntity(entityNode);
 
-	try
+	if (tagCount[TAG_ENTITY_PRIMITIVES] != 1)
 	{
-		readPrimitives(getNamedChild(entityTag, TAG_ENTITY_PRIMITIVES), entityNode);
+		rError() << "PortableMapReader: Entity " << entityNode->name() << ": Odd number of " << 
+			TAG_ENTITY_PRIMITIVES << " nodes encountered." << std::endl;
+		return;
 	}
-	catch (const BadDocumentFormatException & ex)
+
+	for (const auto& primitive : primitives)
 	{
-		rError() << "PortableMapReader: Entity " << entityNode->name() << ": " << ex.what() << std::endl;
+		_importFilter.addPrimitiveToEntity(primitive.node, entityNode);
+		applyMemberships(primitive.memberships, primitive.node);
 	}
 }
 
-void PortableMapReader::readLayerInformation(const xml::Node& tag, const scene::INodePtr& sceneNode)
+PortableMapReader::NodeMemberships PortableMapReader::readMemberships(const xml::Node& tag)
 {
-	auto layersTag = getNamedChild(tag, TAG_OBJECT_LAYERS);
+	NodeMemberships memberships;
+
+	readLayerIds(getNamedChild(tag, TAG_OBJECT_LAYERS), memberships);
+	readSelectionGroupIds(getNamedChild(tag, TAG_OBJECT_SELECTIONGROUPS), memberships);
+	readSelectionSetIds(getNamedChild(tag, TAG_OBJECT_SELECTIONSETS), memberships);
 
+	return memberships;
+}
+
+void PortableMapReader::readLayerIds(const xml::Node& layersTag, NodeMemberships& memberships)
+{
 	auto layerTags = layersTag.getNamedChildren(TAG_OBJECT_LAYER);
-	auto layers = scene::LayerList{};
 
 	// Read the list of node IDs
 	for (const auto& layerTag : layerTags)
 	{
-		layers.insert(string::convert<int>(layerTag.getAttributeValue(ATTR_OBJECT_LAYER_ID)));
+		memberships.layers.insert(string::convert<int>(layerTag.getAttributeValue(ATTR_OBJECT_LAYER_ID)));
 	}
+}
 
-	sceneNode->assignToLayers(layers);
+void PortableMapReader::readSelectionGroupIds(const xml::Node& groupsTag, NodeMemberships& memberships)
+{
+	auto groupTags = groupsTag.getNamedChildren(TAG_OBJECT_SELECTIONGROUP);
+
+	// Read the list of group IDs
+	for (const auto& groupTag : groupTags)
+	{
+		memberships.groupIds.push_back(string::convert<IGroupSelectable::GroupIds::value_type>(
+			groupTag.getAttributeValue(ATTR_OBJECT_SELECTIONGROUP_ID)
+		));
+	}
+}
+
+void PortableMapReader::readSelectionSetIds(const xml::Node& setsTag, NodeMemberships& memberships)
+{
+	auto setTags = setsTag.getNamedChildren(TAG_OBJECT_SELECTIONSET);
+
+	// Read the list of set indices
+	for (const auto& setTag : setTags)
+	{
+		memberships.setIds.push_back(string::convert<std::size_t>(
+			setTag.getAttributeValue(ATTR_OBJECT_SELECTIONSET_ID)
+		));
+	}
+}
+
+void PortableMapReader::applyMemberships(const NodeMemberships& memberships, const scene::INodePtr& sceneNode)
+{
+	sceneNode->assignToLayers(memberships.layers);
 
 	sceneNode->foreachNode([&](const scene::INodePtr& child)
 	{
 		if (!Node_isEntity(child) && !Node_isPrimitive(child))
 		{
-			child->assignToLayers(layers);
+			child->assignToLayers(memberships.layers);
 		}
 
 		return true;
 	});
-}
-
-void PortableMapReader::readSelectionGroupInformation(const xml::Node& tag, const scene::INodePtr& sceneNode)
-{
-    auto groupsTag = getNamedChild(tag, TAG_OBJECT_SELECTIONGROUPS);
-    auto groupTags = groupsTag.getNamedChildren(TAG_OBJECT_SELECTIONGROUP);
-
-    auto& groupManager = _importFilter.getRootNode()->getSelectionGroupManager();
-
-    // Read the list of group IDs
-    for (const auto& groupTag : groupTags)
-    {
-        auto groupId = string::convert<IGroupSelectable::GroupIds::value_type>(
-            groupTag.getAttributeValue(ATTR_OBJECT_SELECTIONGROUP_ID)
-        );
 
-        auto group = groupManager.getSelectionGroup(groupId);
+	auto& groupManager = _importFilter.getRootNode()->getSelectionGroupManager();
 
-        if (group)
-        {
-            group->addNode(sceneNode);
-        }
-    }
-}
+	for (auto groupId : memberships.groupIds)
+	{
+		auto group = groupManager.getSelectionGroup(groupId);
 
-void PortableMapReader::readSelectionSetInformation(const xml::Node& tag, const scene::INodePtr& sceneNode)
-{
-	auto setsTag = getNamedChild(tag, TAG_OBJECT_SELECTIONSETS);
-	auto setTags = setsTag.getNamedChildren(TAG_OBJECT_SELECTIONSET);
+		if (group)
+		{
+			group->addNode(sceneNode);
+		}
+	}
 
-	// Read the list of set indices
-	for (const auto& setTag : setTags)
+	for (auto setId : memberships.setIds)
 	{
-		auto id = string::convert<std::size_t>(
-			setTag.getAttributeValue(ATTR_OBJECT_SELECTIONSET_ID)
-		);
+		auto setIter = _selectionSets.find(setId);
 
-		auto setIter = _selectionSets.find(id);
-		
 		if (setIter != _selectionSets.end())
 		{
 			setIter->second->addNode(sceneNode);
@@ -4,7 +4,7 @@
 #include "inode.h"
 #include "imapformat.h"
 #include "iselectionset.h"
-#include "parser/DefTokeniser.h"
+#include "ilayer.h"
 
 namespace xml { class Node; }
 
@@ -14,6 +14,12 @@ namespace map
 namespace format
 {
 
+/**
+ * Reader for the XML-based portable map format. The file is read
+ * using a streaming parser, only the tag of the primitive that is
+ * currently being parsed is held in memory as a whole, the entities
+ * are sent to the import filter as soon as their tag has been read.
+ */
 class PortableMapReader :
 	public IMapReader
 {
@@ -32,6 +38,24 @@ protected:
 	typedef std::map<std::size_t, selection::ISelectionSetPtr> SelectionSets;
 	SelectionSets _selectionSets;
 
+	// The layers, selection groups and sets a node has been assigned to in the file
+	struct NodeMemberships
+	{
+		scene::LayerList layers;
+		std::vector<std::size_t> groupIds;
+		std::vector<std::size_t> setIds;
+	};
+
+	// A primitive which can be added to its entity once the entity tag is complete
+	struct PendingPrimitive
+	{
+		scene::INodePtr node;
+		NodeMemberships memberships;
+	};
+
+	// Wraps the libxml2 stream reader, defined in the .cpp file
+	class StreamReader;
+
 public:
 	PortableMapReader(IMapImportFilter& importFilter);
 
@@ -41,18 +65,23 @@ public:
 	static bool CanLoad(std::istream& stream);
 
 private:
-	void readLayers(const xml::Node& mapNode);
-	void readSelectionGroups(const xml::Node& mapNode);
-	void readSelectionSets(const xml::Node& mapNode);
-	void readMapProperties(const xml::Node& mapNode);
-	void readEntities(const xml::Node& mapNode);
-	void readEntity(const xml::Node& entityNode);
-	void readPrimitives(const xml::Node& primitivesNode, const scene::INodePtr& entity);
-	void readBrush(const xml::Node& brushNode, const scene::INodePtr& entity);
-	void readPatch(const xml::Node& patchNode, const scene::INodePtr& entity);
-	void readLayerInformation(const xml::Node& parentTag, const scene::INodePtr& sceneNode);
-	void readSelectionGroupInformation(const xml::Node& parentTag, const scene::INodePtr& sceneNode);
-	void readSelectionSetInformation(const xml::Node& parentTag, const scene::INodePtr& sceneNode);
+	void readLayers(const xml::Node& layersTag);
+	void readSelectionGroups(const xml::Node& groupsTag);
+	void readSelectionSets(const xml::Node& setsTag);
+	void readMapProperties(const xml::Node& propertiesTag);
+	void readEntity(StreamReader& reader);
+	scene::INodePtr readBrush(const xml::Node& brushNode);
+	scene::INodePtr readPatch(const xml::Node& patchNode);
+
+	// Reads the tags holding the layer, group and set IDs of a primitive
+	NodeMemberships readMemberships(const xml::Node& parentTag);
+
+	void readLayerIds(const xml::Node& layersTag, NodeMemberships& memberships);
+	void readSelectionGroupIds(const xml::Node& groupsTag, NodeMemberships& memberships);
+	void readSelectionSetIds(const xml::Node& setsTag, NodeMemberships& memberships);
+
+	// Assigns the node to the layers, groups and sets
+	void applyMemberships(const NodeMemberships& memberships, const scene::INodePtr& sceneNode);
 };
 
 }
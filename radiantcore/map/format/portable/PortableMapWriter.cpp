@@ -12,9 +12,13 @@
 #include "math/Plane3.h"
 #include "math/Matrix4.h"
 #include "string/convert.h"
+#include "scene/ChildPrimitives.h"
+#include "../primitivewriters/ExportUtil.h"
 #include "PortableMapFormat.h"
 #include "Constants.h"
 
+#include <libxml/xmlwriter.h>
+
 namespace map
 {
 
@@ -45,6 +49,31 @@ inline std::string getSafeDouble(double d)
 	}
 }
 
+// Output callback of the xmlOutputBuffer, passing the data on to the std::ostream
+// The context points to the stream pointer, which is cleared if the export is aborted
+int writeToStream(void* context, const char* buffer, int length)
+{
+	auto* stream = *static_cast<std::ostream**>(context);
+
+	if (stream == nullptr) return length; // discard
+
+	stream->write(buffer, length);
+
+	return *stream ? length : -1;
+}
+
+int closeStream(void* context)
+{
+	auto* stream = *static_cast<std::ostream**>(context);
+
+	if (stream != nullptr)
+	{
+		stream->flush();
+	}
+
+	return 0;
+}
+
 }
 
 using namespace map::format::constants;
@@ -52,54 +81,117 @@ using namespace map::format::constants;
 PortableMapWriter::PortableMapWriter() :
 	_entityCount(0),
 	_primitiveCount(0),
-	_document(xml::Document::create()),
-	_map(_document.addTopLevelNode("map")),
-	_curEntityPrimitives(nullptr)
+	_writer(nullptr),
+	_outputStream(nullptr),
+	_entityOrigin(0, 0, 0)
+{}
+
+PortableMapWriter::~PortableMapWriter()
 {
-	// Export name and version tag
-	_map.setAttributeValue(ATTR_VERSION, string::to_string(PortableMapFormat::Version));
-	_map.setAttributeValue(ATTR_FORMAT, ATTR_FORMAT_VALUE);
+	// Release the writer if the export has been aborted,
+	// the stream might be gone already, discard the pending output
+	if (_writer != nullptr)
+	{
+		_outputStream = nullptr;
+		xmlFreeTextWriter(_writer);
+	}
+}
+
+void PortableMapWriter::startElement(const char* name)
+{
+	if (xmlTextWriterStartElement(_writer, BAD_CAST name) < 0)
+	{
+		throw FailureException("Failed to write the XML element " + std::string(name));
+	}
+}
+
+void PortableMapWriter::endElement()
+{
+	if (xmlTextWriterEndElement(_writer) < 0)
+	{
+		throw FailureException("Failed to close XML element");
+	}
+}
+
+void PortableMapWriter::writeAttribute(const char* name, const std::string& value)
+{
+	if (xmlTextWriterWriteAttribute(_writer, BAD_CAST name, BAD_CAST value.c_str()) < 0)
+	{
+		throw FailureException("Failed to write the XML attribute " + std::string(name));
+	}
 }
 
 void PortableMapWriter::beginWriteMap(const scene::IMapRootNodePtr& root, std::ostream& stream)
 {
+	// The writer takes ownership of the output buffer, closing it will flush the stream
+	_outputStream = &stream;
+	auto* outputBuffer = xmlOutputBufferCreateIO(writeToStream, closeStream, &_outputStream, nullptr);
+
+	if (outputBuffer == nullptr || (_writer = xmlNewTextWriter(outputBuffer)) == nullptr)
+	{
+		if (outputBuffer != nullptr)
+		{
+			xmlOutputBufferClose(outputBuffer);
+		}
+
+		throw FailureException("Failed to create the XML writer");
+	}
+
+	xmlTextWriterSetIndent(_writer, 1);
+	xmlTextWriterSetIndentString(_writer, BAD_CAST "  ");
+
+	// Write the declaration ourselves, xmlTextWriterStartDocument doesn't keep the encoding name as it is
+	if (xmlTextWriterWriteRaw(_writer, BAD_CAST "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n") < 0)
+	{
+		throw FailureException("Failed to write the XML declaration");
+	}
+
+	// Export name and version tag
+	startElement("map");
+	writeAttribute(ATTR_VERSION, string::to_string(PortableMapFormat::Version));
+	writeAttribute(ATTR_FORMAT, ATTR_FORMAT_VALUE);
+
 	// Write layer information to the header
-	auto layers = _map.createChild(TAG_MAP_LAYERS);
+	startElement(TAG_MAP_LAYERS);
 
 	// Visit all layers and add a tag for each
 	root->getLayerManager().foreachLayer([&](int layerId, const std::string& layerName)
 	{
-		auto layer = layers.createChild(TAG_MAP_LAYER);
-
-		layer.setAttributeValue(ATTR_MAP_LAYER_ID, string::to_string(layerId));
-		layer.setAttributeValue(ATTR_MAP_LAYER_NAME, layerName);
+		startElement(TAG_MAP_LAYER);
+		writeAttribute(ATTR_MAP_LAYER_ID, string::to_string(layerId));
+		writeAttribute(ATTR_MAP_LAYER_NAME, layerName);
+		endElement();
 	});
 
+	endElement();
+
 	// Write selection groups
-	auto selGroups = _map.createChild(TAG_SELECTIONGROUPS);
+	startElement(TAG_SELECTIONGROUPS);
 
 	root->getSelectionGroupManager().foreachSelectionGroup([&](selection::ISelectionGroup& group)
 	{
 		// Ignore empty groups
 		if (group.size() == 0) return;
 
-		auto selGroup = selGroups.createChild(TAG_SELECTIONGROUP);
-
-		selGroup.setAttributeValue(ATTR_SELECTIONGROUP_ID, string::to_string(group.getId()));
-		selGroup.setAttributeValue(ATTR_SELECTIONGROUP_NAME, group.getName());
+		startElement(TAG_SELECTIONGROUP);
+		writeAttribute(ATTR_SELECTIONGROUP_ID, string::to_string(group.getId()));
+		writeAttribute(ATTR_SELECTIONGROUP_NAME, group.getName());
+		endElement();
 	});
 
+	endElement();
+
 	// Write selection sets
-	auto selSets = _map.createChild(TAG_SELECTIONSETS);
+	startElement(TAG_SELECTIONSETS);
 	std::size_t selectionSetCount = 0;
 
 	// Visit all selection sets
 	root->getSelectionSetManager().foreachSelectionSet([&](const selection::ISelectionSetPtr& set)
 	{
-		auto selSet = selSets.createChild(TAG_SELECTIONSET);
-
-		selSet.setAttributeValue(ATTR_SELECTIONSET_ID, string::to_string(selectionSetCount));
-		selSet.setAttributeValue(ATTR_SELECTIONSET_NAME, set->getName());
+		startElement(TAG_SELECTIONSET);
+		writeAttribute(ATTR_SELECTIONSET_ID, string::to_string(selectionSetCount));
+		writeAttribute(ATTR_SELECTIONSET_NAME, set->getName());
+		endElement();
 
 		// Get all nodes of this selection set and store them for later lookup
 		_selectionSets.push_back(SelectionSetExportInfo());
@@ -110,64 +202,91 @@ void PortableMapWriter::beginWriteMap(const scene::IMapRootNodePtr& root, std::o
 		selectionSetCount++;
 	});
 
+	endElement();
+
 	// Export all map properties
-	auto props = _map.createChild(TAG_MAP_PROPERTIES);
+	startElement(TAG_MAP_PROPERTIES);
 
 	root->foreachProperty([&](const std::string& key, const std::string& value)
 	{
-		auto property = props.createChild(TAG_MAP_PROPERTY);
-
-		property.setAttributeValue(ATTR_MAP_PROPERTY_KEY, key);
-		property.setAttributeValue(ATTR_MAP_PROPERTY_VALUE, value);
+		startElement(TAG_MAP_PROPERTY);
+		writeAttribute(ATTR_MAP_PROPERTY_KEY, key);
+		writeAttribute(ATTR_MAP_PROPERTY_VALUE, value);
+		endElement();
 	});
+
+	endElement();
 }
 
 void PortableMapWriter::endWriteMap(const scene::IMapRootNodePtr& root, std::ostream& stream)
 {
-	stream << _document.saveToString();
+	assert(_writer != nullptr);
+
+	// Closes the map tag and all other open elements
+	if (xmlTextWriterEndDocument(_writer) < 0)
+	{
+		throw FailureException("Failed to finish the XML document");
+	}
+
+	// Flushes the remaining data to the stream
+	xmlFreeTextWriter(_writer);
+	_writer = nullptr;
+	_outputStream = nullptr;
 }
 
 void PortableMapWriter::beginWriteEntity(const IEntityNodePtr& entity, std::ostream& stream)
 {
-	auto node = _map.createChild(TAG_ENTITY);
-	node.setAttributeValue(ATTR_ENTITY_NUMBER, string::to_string(_entityCount++));
+	assert(_writer != nullptr);
 
-	auto primitiveNode = node.createChild(TAG_ENTITY_PRIMITIVES);
-	_curEntityPrimitives = xml::Node(primitiveNode.getNodePtr());
+	startElement(TAG_ENTITY);
+	writeAttribute(ATTR_ENTITY_NUMBER, string::to_string(_entityCount++));
 
-	auto keyValues = node.createChild(TAG_ENTITY_KEYVALUES);
+	// The primitives follow, the remaining entity tags are written in endWriteEntity
+	startElement(TAG_ENTITY_PRIMITIVES);
+
+	_entityOrigin = scene::getChildPrimitiveOrigin(entity);
+}
+
+void PortableMapWriter::endWriteEntity(const IEntityNodePtr& entity, std::ostream& stream)
+{
+	// Close the primitives tag
+	endElement();
+
+	startElement(TAG_ENTITY_KEYVALUES);
 
 	// Export the entity key values
 	entity->getEntity().forEachKeyValue([&](const std::string& key, const std::string& value)
 	{
-		auto kv = keyValues.createChild(TAG_ENTITY_KEYVALUE);
-		kv.setAttributeValue(ATTR_ENTITY_PROPERTY_KEY, key);
-		kv.setAttributeValue(ATTR_ENTITY_PROPERTY_VALUE, value);
+		startElement(TAG_ENTITY_KEYVALUE);
+		writeAttribute(ATTR_ENTITY_PROPERTY_KEY, key);
+		writeAttribute(ATTR_ENTITY_PROPERTY_VALUE, value);
+		endElement();
 	});
 
-	appendLayerInformation(node, entity);
-	appendSelectionGroupInformation(node, entity);
-	appendSelectionSetInformation(node, entity);
-}
+	endElement();
+
+	writeLayerInformation(entity);
+	writeSelectionGroupInformation(entity);
+	writeSelectionSetInformation(entity);
+
+	endElement();
 
-void PortableMapWriter::endWriteEntity(const IEntityNodePtr& entity, std::ostream& stream)
-{
 	// Reset the primitive count again
 	_primitiveCount = 0;
 
-	_curEntityPrimitives = xml::Node(nullptr);
+	_entityOrigin = Vector3(0, 0, 0);
 }
 
 void PortableMapWriter::beginWriteBrush(const IBrushNodePtr& brushNode, std::ostream& stream)
 {
-	assert(_curEntityPrimitives.getNodePtr() != nullptr);
+	assert(_writer != nullptr);
 
-	auto brushTag = _curEntityPrimitives.createChild(TAG_BRUSH);
-	brushTag.setAttributeValue(ATTR_BRUSH_NUMBER, string::to_string(_primitiveCount++));
+	startElement(TAG_BRUSH);
+	writeAttribute(ATTR_BRUSH_NUMBER, string::to_string(_primitiveCount++));
 
 	const auto& brush = brushNode->getIBrush();
 
-	auto facesTag = brushTag.createChild(TAG_FACES);
+	startElement(TAG_FACES);
 
 	// Iterate over each brush face, exporting the tags for each
 	for (std::size_t i = 0; i < brush.getNumFaces(); ++i)
@@ -177,44 +296,54 @@ void PortableMapWriter::beginWriteBrush(const IBrushNodePtr& brushNode, std::ost
 		// greebo: Don't export faces with degenerate or empty windings (they are "non-contributing")
 		if (face.getWinding().size() <= 2)
 		{
-			return;
+			continue;
 		}
 
-		auto faceTag = facesTag.createChild(TAG_FACE);
+		startElement(TAG_FACE);
 
 		// Write the plane equation
-		const Plane3& plane = face.getPlane3();
+		auto plane = getPlaneRelativeToOrigin(face.getPlane3(), _entityOrigin);
 
-		auto planeTag = faceTag.createChild(TAG_FACE_PLANE);
-		planeTag.setAttributeValue(ATTR_FACE_PLANE_X, getSafeDouble(plane.normal().x()));
-		planeTag.setAttributeValue(ATTR_FACE_PLANE_Y, getSafeDouble(plane.normal().y()));
-		planeTag.setAttributeValue(ATTR_FACE_PLANE_Z, getSafeDouble(plane.normal().z()));
-		planeTag.setAttributeValue(ATTR_FACE_PLANE_D, getSafeDouble(-plane.dist()));
+		startElement(TAG_FACE_PLANE);
+		writeAttribute(ATTR_FACE_PLANE_X, getSafeDouble(plane.normal().x()));
+		writeAttribute(ATTR_FACE_PLANE_Y, getSafeDouble(plane.normal().y()));
+		writeAttribute(ATTR_FACE_PLANE_Z, getSafeDouble(plane.normal().z()));
+		writeAttribute(ATTR_FACE_PLANE_D, getSafeDouble(-plane.dist()));
+		endElement();
 
 		// Write TexDef
 		Matrix4 texdef = face.getTexDefMatrix();
 
-		auto texTag = faceTag.createChild(TAG_FACE_TEXPROJ);
-		texTag.setAttributeValue(ATTR_FACE_TEXTPROJ_XX, getSafeDouble(texdef.xx()));
-		texTag.setAttributeValue(ATTR_FACE_TEXTPROJ_YX, getSafeDouble(texdef.yx()));
-		texTag.setAttributeValue(ATTR_FACE_TEXTPROJ_TX, getSafeDouble(texdef.tx()));
-		texTag.setAttributeValue(ATTR_FACE_TEXTPROJ_XY, getSafeDouble(texdef.xy()));
-		texTag.setAttributeValue(ATTR_FACE_TEXTPROJ_YY, getSafeDouble(texdef.yy()));
-		texTag.setAttributeValue(ATTR_FACE_TEXTPROJ_TY, getSafeDouble(texdef.ty()));
+		startElement(TAG_FACE_TEXPROJ);
+		writeAttribute(ATTR_FACE_TEXTPROJ_XX, getSafeDouble(texdef.xx()));
+		writeAttribute(ATTR_FACE_TEXTPROJ_YX, getSafeDouble(texdef.yx()));
+		writeAttribute(ATTR_FACE_TEXTPROJ_TX, getSafeDouble(texdef.tx()));
+		writeAttribute(ATTR_FACE_TEXTPROJ_XY, getSafeDouble(texdef.xy()));
+		writeAttribute(ATTR_FACE_TEXTPROJ_YY, getSafeDouble(texdef.yy()));
+		writeAttribute(ATTR_FACE_TEXTPROJ_TY, getSafeDouble(texdef.ty()));
+		endElement();
 
 		// Write Shader
-		auto shaderTag = faceTag.createChild(TAG_FACE_MATERIAL);
-		shaderTag.setAttributeValue(ATTR_FACE_MATERIAL_NAME, face.getShader());
+		startElement(TAG_FACE_MATERIAL);
+		writeAttribute(ATTR_FACE_MATERIAL_NAME, face.getShader());
+		endElement();
 
 		// Export (dummy) contents/flags
-		auto detailTag = faceTag.createChild(TAG_FACE_CONTENTSFLAG);
-		detailTag.setAttributeValue(ATTR_FACE_CONTENTSFLAG_VALUE, string::to_string(brush.getDetailFlag()));
+		startElement(TAG_FACE_CONTENTSFLAG);
+		writeAttribute(ATTR_FACE_CONTENTSFLAG_VALUE, string::to_string(brush.getDetailFlag()));
+		endElement();
+
+		endElement();
 	}
 
+	endElement();
+
 	auto sceneNode = std::dynamic_pointer_cast<scene::INode>(brushNode);
-	appendLayerInformation(brushTag, sceneNode);
-	appendSelectionGroupInformation(brushTag, sceneNode);
-	appendSelectionSetInformation(brushTag, sceneNode);
+	writeLayerInformation(sceneNode);
+	writeSelectionGroupInformation(sceneNode);
+	writeSelectionSetInformation(sceneNode);
+
+	endElement();
 }
 
 void PortableMapWriter::endWriteBrush(const IBrushNodePtr& brush, std::ostream& stream)
@@ -224,56 +353,63 @@ void PortableMapWriter::endWriteBrush(const IBrushNodePtr& brush, std::ostream&
 
 void PortableMapWriter::beginWritePatch(const IPatchNodePtr& patchNode, std::ostream& stream)
 {
-	assert(_curEntityPrimitives.getNodePtr() != nullptr);
+	assert(_writer != nullptr);
 
-	auto patchTag = _curEntityPrimitives.createChild(TAG_PATCH);
-	patchTag.setAttributeValue(ATTR_PATCH_NUMBER, string::to_string(_primitiveCount++));
+	startElement(TAG_PATCH);
+	writeAttribute(ATTR_PATCH_NUMBER, string::to_string(_primitiveCount++));
 
 	const IPatch& patch = patchNode->getPatch();
 
-	patchTag.setAttributeValue(ATTR_PATCH_WIDTH, string::to_string(patch.getWidth()));
-	patchTag.setAttributeValue(ATTR_PATCH_HEIGHT, string::to_string(patch.getHeight()));
+	writeAttribute(ATTR_PATCH_WIDTH, string::to_string(patch.getWidth()));
+	writeAttribute(ATTR_PATCH_HEIGHT, string::to_string(patch.getHeight()));
 
-	patchTag.setAttributeValue(ATTR_PATCH_FIXED_SUBDIV, patch.subdivisionsFixed() ? ATTR_VALUE_TRUE : ATTR_VALUE_FALSE);
+	writeAttribute(ATTR_PATCH_FIXED_SUBDIV, patch.subdivisionsFixed() ? ATTR_VALUE_TRUE : ATTR_VALUE_FALSE);
 
 	if (patch.subdivisionsFixed())
 	{
 		Subdivisions divisions = patch.getSubdivisions();
 
-		patchTag.setAttributeValue(ATTR_PATCH_FIXED_SUBDIV_X, string::to_string(divisions.x()));
-		patchTag.setAttributeValue(ATTR_PATCH_FIXED_SUBDIV_Y, string::to_string(divisions.y()));
+		writeAttribute(ATTR_PATCH_FIXED_SUBDIV_X, string::to_string(divisions.x()));
+		writeAttribute(ATTR_PATCH_FIXED_SUBDIV_Y, string::to_string(divisions.y()));
 	}
 
 	// Write Shader
-	auto shaderTag = patchTag.createChild(TAG_PATCH_MATERIAL);
-	shaderTag.setAttributeValue(ATTR_PATCH_MATERIAL_NAME, patch.getShader());
+	startElement(TAG_PATCH_MATERIAL);
+	writeAttribute(ATTR_PATCH_MATERIAL_NAME, patch.getShader());
+	endElement();
 
-	auto cvTag = patchTag.createChild(TAG_PATCH_CONTROL_VERTICES);
+	startElement(TAG_PATCH_CONTROL_VERTICES);
 
 	for (std::size_t c = 0; c < patch.getWidth(); c++)
 	{
 		for (std::size_t r = 0; r < patch.getHeight(); r++)
 		{
-			auto cv = cvTag.createChild(TAG_PATCH_CONTROL_VERTEX);
+			startElement(TAG_PATCH_CONTROL_VERTEX);
 
-			cv.setAttributeValue(ATTR_PATCH_CONTROL_VERTEX_ROW, string::to_string(r));
-			cv.setAttributeValue(ATTR_PATCH_CONTROL_VERTEX_COL, string::to_string(c));
+			writeAttribute(ATTR_PATCH_CONTROL_VERTEX_ROW, string::to_string(r));
+			writeAttribute(ATTR_PATCH_CONTROL_VERTEX_COL, string::to_string(c));
 
 			const auto& patchControl = patch.ctrlAt(r, c);
 
-			cv.setAttributeValue(ATTR_PATCH_CONTROL_VERTEX_X, getSafeDouble(patchControl.vertex.x()));
-			cv.setAttributeValue(ATTR_PATCH_CONTROL_VERTEX_Y, getSafeDouble(patchControl.vertex.y()));
-			cv.setAttributeValue(ATTR_PATCH_CONTROL_VERTEX_Z, getSafeDouble(patchControl.vertex.z()));
+			writeAttribute(ATTR_PATCH_CONTROL_VERTEX_X, getSafeDouble(patchControl.vertex.x()));
+			writeAttribute(ATTR_PATCH_CONTROL_VERTEX_Y, getSafeDouble(patchControl.vertex.y()));
+			writeAttribute(ATTR_PATCH_CONTROL_VERTEX_Z, getSafeDouble(patchControl.vertex.z()));
 
-			cv.setAttributeValue(ATTR_PATCH_CONTROL_VERTEX_U, getSafeDouble(patchControl.texcoord.x()));
-			cv.setAttributeValue(ATTR_PATCH_CONTROL_VERTEX_V, getSafeDouble(patchControl.texcoord.y()));
+			writeAttribute(ATTR_PATCH_CONTROL_VERTEX_U, getSafeDouble(patchControl.texcoord.x()));
+			writeAttribute(ATTR_PATCH_CONTROL_VERTEX_V, getSafeDouble(patchControl.texcoord.y()));
+
+			endElement();
 		}
 	}
 
+	endElement();
+
 	auto sceneNode = std::dynamic_pointer_cast<scene::INode>(patchNode);
-	appendLayerInformation(patchTag, sceneNode);
-	appendSelectionGroupInformation(patchTag, sceneNode);
-	appendSelectionSetInformation(patchTag, sceneNode);
+	writeLayerInformation(sceneNode);
+	writeSelectionGroupInformation(sceneNode);
+	writeSelectionSetInformation(sceneNode);
+
+	endElement();
 }
 
 void PortableMapWriter::endWritePatch(const IPatchNodePtr& patch, std::ostream& stream)
@@ -281,48 +417,55 @@ void PortableMapWriter::endWritePatch(const IPatchNodePtr& patch, std::ostream&
 	// nothing
 }
 
-void PortableMapWriter::appendLayerInformation(xml::Node& xmlNode, const scene::INodePtr& sceneNode)
+void PortableMapWriter::writeLayerInformation(const scene::INodePtr& sceneNode)
 {
-	const auto& layers = sceneNode->getLayers();
-	auto layersTag = xmlNode.createChild(TAG_OBJECT_LAYERS);
+	startElement(TAG_OBJECT_LAYERS);
 
 	// Write the list of node IDs
-	for (const auto& layerId : layers)
+	for (const auto& layerId : sceneNode->getLayers())
 	{
-		auto layerTag = layersTag.createChild(TAG_OBJECT_LAYER);
-		layerTag.setAttributeValue(ATTR_OBJECT_LAYER_ID, string::to_string(layerId));
+		startElement(TAG_OBJECT_LAYER);
+		writeAttribute(ATTR_OBJECT_LAYER_ID, string::to_string(layerId));
+		endElement();
 	}
+
+	endElement();
 }
 
-void PortableMapWriter::appendSelectionGroupInformation(xml::Node& xmlNode, const scene::INodePtr& sceneNode)
+void PortableMapWriter::writeSelectionGroupInformation(const scene::INodePtr& sceneNode)
 {
 	auto selectable = std::dynamic_pointer_cast<IGroupSelectable>(sceneNode);
 
 	if (!selectable) return;
 
-	auto groupIds = selectable->getGroupIds();
-	auto groupsTag = xmlNode.createChild(TAG_OBJECT_SELECTIONGROUPS);
+	startElement(TAG_OBJECT_SELECTIONGROUPS);
 
 	// Write the list of group IDs
-	for (auto groupId : groupIds)
+	for (auto groupId : selectable->getGroupIds())
 	{
-		auto groupTag = groupsTag.createChild(TAG_OBJECT_SELECTIONGROUP);
-		groupTag.setAttributeValue(ATTR_OBJECT_SELECTIONGROUP_ID, string::to_string(groupId));
+		startElement(TAG_OBJECT_SELECTIONGROUP);
+		writeAttribute(ATTR_OBJECT_SELECTIONGROUP_ID, string::to_string(groupId));
+		endElement();
 	}
+
+	endElement();
 }
 
-void PortableMapWriter::appendSelectionSetInformation(xml::Node& xmlNode, const scene::INodePtr& sceneNode)
+void PortableMapWriter::writeSelectionSetInformation(const scene::INodePtr& sceneNode)
 {
-	auto sets = xmlNode.createChild(TAG_OBJECT_SELECTIONSETS);
+	startElement(TAG_OBJECT_SELECTIONSETS);
 
 	for (const auto& info : _selectionSets)
 	{
 		if (info.nodes.find(sceneNode) != info.nodes.end())
 		{
-			auto setTag = sets.createChild(TAG_OBJECT_SELECTIONSET);
-			setTag.setAttributeValue(ATTR_OBJECT_SELECTIONSET_ID, string::to_string(info.index));
+			startElement(TAG_OBJECT_SELECTIONSET);
+			writeAttribute(ATTR_OBJECT_SELECTIONSET_ID, string::to_string(info.index));
+			endElement();
 		}
 	}
+
+	endElement();
 }
 
 }
@@ -3,7 +3,9 @@
 #include "imapformat.h"
 #include "iselectionset.h"
 
-#include "xmlutil/Document.h"
+#include "math/Vector3.h"
+
+typedef struct _xmlTextWriter xmlTextWriter;
 
 namespace map
 {
@@ -13,6 +15,11 @@ namespace format
 
 /**
  * Exporter class writing the map data into an XML-based file format.
+ *
+ * The XML is streamed to the output stream while the scene is traversed,
+ * no document tree is built in memory. Each entity tag is opened in
+ * beginWriteEntity(), followed by the primitives of this entity, the
+ * key values and group information are written in endWriteEntity().
  */
 class PortableMapWriter :
 	public IMapWriter
@@ -22,10 +29,14 @@ protected:
 	std::size_t _entityCount;
 	std::size_t _primitiveCount;
 
-	xml::Document _document;
+	// Writer attached to the output stream, between beginWriteMap and endWriteMap
+	xmlTextWriter* _writer;
+
+	// The stream the writer is sending its output to
+	std::ostream* _outputStream;
 
-	xml::Node _map;
-	xml::Node _curEntityPrimitives;
+	// The origin of the entity currently being written, the brushes are written relative to it
+	Vector3 _entityOrigin;
 
 	struct SelectionSetExportInfo
 	{
@@ -41,6 +52,7 @@ protected:
 
 public:
 	PortableMapWriter();
+	~PortableMapWriter();
 
 	virtual void beginWriteMap(const scene::IMapRootNodePtr& root, std::ostream& stream) override;
 	virtual void endWriteMap(const scene::IMapRootNodePtr& root, std::ostream& stream) override;
@@ -58,9 +70,14 @@ public:
 	virtual void endWritePatch(const IPatchNodePtr& patch, std::ostream& stream) override;
 
 private:
-	void appendLayerInformation(xml::Node& xmlNode, const scene::INodePtr& sceneNode);
-	void appendSelectionGroupInformation(xml::Node& xmlNode, const scene::INodePtr& sceneNode);
-	void appendSelectionSetInformation(xml::Node& xmlNode, const scene::INodePtr& sceneNode);
+	// Wrappers around the xmlTextWriter calls, throwing FailureException on error
+	void startElement(const char* name);
+	void endElement();
+	void writeAttribute(const char* name, const std::string& value);
+
+	void writeLayerInformation(const scene::INodePtr& sceneNode);
+	void writeSelectionGroupInformation(const scene::INodePtr& sceneNode);
+	void writeSelectionSetInformation(const scene::INodePtr& sceneNode);
 };
 
 }
@@ -12,29 +12,32 @@ class BrushDef3Exporter
 {
 public:
 
-	// Writes a brushDef3 definition from the given brush to the given stream
-	static void exportBrush(std::ostream& stream, const IBrushNodePtr& brushNode, bool writeContentsFlags = true)
+	// Writes a brushDef3 definition from the given brush to the given stream,
+	// the planes are written relative to the given (parent entity) origin
+	static void exportBrush(std::ostream& stream, const IBrushNodePtr& brushNode, const Vector3& origin,
+		bool writeContentsFlags = true)
 	{
 		const IBrush& brush = brushNode->getIBrush();
 
 		// Brush decl header
-		stream << "{" << std::endl;
-		stream << "brushDef3" << std::endl;
-		stream << "{" << std::endl;
+		stream << "{\n";
+		stream << "brushDef3\n";
+		stream << "{\n";
 
 		// Iterate over each brush face, exporting the tokens from all faces
 		for (std::size_t i = 0; i < brush.getNumFaces(); ++i)
 		{
-			writeFace(stream, brush.getFace(i), writeContentsFlags, brush.getDetailFlag());
+			writeFace(stream, brush.getFace(i), origin, writeContentsFlags, brush.getDetailFlag());
 		}
 
 		// Close brush contents and header
-		stream << "}" << std::endl << "}" << std::endl;
+		stream << "}\n}\n";
 	}
 
 private:
 
-	static void writeFace(std::ostream& stream, const IFace& face, bool writeContentsFlags, IBrush::DetailFlag detailFlag)
+	static void writeFace(std::ostream& stream, const IFace& face, const Vector3& origin,
+		bool writeContentsFlags, IBrush::DetailFlag detailFlag)
 	{
 		// greebo: Don't export faces with degenerate or empty windings (they are "non-contributing")
 		if (face.getWinding().size() <= 2)
@@ -43,7 +46,7 @@ private:
 		}
 
 		// Write the plane equation
-		const Plane3& plane = face.getPlane3();
+		auto plane = getPlaneRelativeToOrigin(face.getPlane3(), origin);
 
 		stream << "( ";
 		writeDoubleSafe(plane.normal().x(), stream);
@@ -94,7 +97,7 @@ private:
 			stream << detailFlag << " 0 0";
 		}
 
-		stream << std::endl;
+		stream << "\n";
 	}
 };
 
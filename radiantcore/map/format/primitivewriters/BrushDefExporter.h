@@ -16,23 +16,23 @@ class BrushDefExporter
 public:
 
 	// Writes a Q3-style brushDef definition from the given brush to the given stream
-	static void exportBrush(std::ostream& stream, const IBrushNodePtr& brushNode)
+	static void exportBrush(std::ostream& stream, const IBrushNodePtr& brushNode, const Vector3& origin)
 	{
 		const IBrush& brush = brushNode->getIBrush();
 
 		// Brush decl header
-		stream << "{" << std::endl;
-		stream << "brushDef" << std::endl;
-		stream << "{" << std::endl;
+		stream << "{\n";
+		stream << "brushDef\n";
+		stream << "{\n";
 
 		// Iterate over each brush face, exporting the tokens from all faces
 		for (std::size_t i = 0; i < brush.getNumFaces(); ++i)
 		{
-			writeFace(stream, brush.getFace(i), brush.getDetailFlag());
+			writeFace(stream, brush.getFace(i), origin, brush.getDetailFlag());
 		}
 
 		// Close brush contents and header
-		stream << "}" << std::endl << "}" << std::endl;
+		stream << "}\n}\n";
 	}
 
 	/* 
@@ -49,7 +49,7 @@ public:
 
 private:
 
-	static void writeFace(std::ostream& stream, const IFace& face, IBrush::DetailFlag detailFlag)
+	static void writeFace(std::ostream& stream, const IFace& face, const Vector3& origin, IBrush::DetailFlag detailFlag)
 	{
 		// greebo: Don't export faces with degenerate or empty windings (they are "non-contributing")
 		const IWinding& winding = face.getWinding();
@@ -59,34 +59,25 @@ private:
 			return;
 		}
 
-		// Each face plane is defined by three points
-
-		stream << "( ";
-		writeDoubleSafe(winding[2].vertex.x(), stream);
-		stream << " ";
-		writeDoubleSafe(winding[2].vertex.y(), stream);
-		stream << " ";
-		writeDoubleSafe(winding[2].vertex.z(), stream);
-		stream << " ";
-		stream << ") ";
-
-		stream << "( ";
-		writeDoubleSafe(winding[0].vertex.x(), stream);
-		stream << " ";
-		writeDoubleSafe(winding[0].vertex.y(), stream);
-		stream << " ";
-		writeDoubleSafe(winding[0].vertex.z(), stream);
-		stream << " ";
-		stream << ") ";
+		// Each face plane is defined by three points, relative to the entity origin
+		Vector3 points[3] =
+		{
+			winding[2].vertex - origin,
+			winding[0].vertex - origin,
+			winding[1].vertex - origin
+		};
 
-		stream << "( ";
-		writeDoubleSafe(winding[1].vertex.x(), stream);
-		stream << " ";
-		writeDoubleSafe(winding[1].vertex.y(), stream);
-		stream << " ";
-		writeDoubleSafe(winding[1].vertex.z(), stream);
-		stream << " ";
-		stream << ") ";
+		for (const auto& point : points)
+		{
+			stream << "( ";
+			writeDoubleSafe(point.x(), stream);
+			stream << " ";
+			writeDoubleSafe(point.y(), stream);
+			stream << " ";
+			writeDoubleSafe(point.z(), stream);
+			stream << " ";
+			stream << ") ";
+		}
 
 		// Write TexDef
 		Matrix4 texdef = face.getTexDefMatrix();
@@ -133,7 +124,7 @@ private:
 		// Export (dummy) contents/flags
 		stream << detailFlag << " 0 0";
 		
-		stream << std::endl;
+		stream << "\n";
 	}
 };
 
@@ -1,11 +1,27 @@
 #pragma once
 
 #include <ostream>
+#include <charconv>
+#include <cstdio>
 #include "math/FloatTools.h"
+#include "math/Plane3.h"
 
 namespace map
 {
 
+// Returns the given face plane relative to the given origin, using the same
+// calculation as the face would when being translated by -origin
+inline Plane3 getPlaneRelativeToOrigin(const Plane3& facePlane, const Vector3& origin)
+{
+	Plane3 plane(facePlane);
+
+	plane.dist() = -plane.dist();
+	plane.translate(-origin);
+	plane.dist() = -plane.dist();
+
+	return plane;
+}
+
 // Writes a double to the given stream and checks for NaN and infinity
 inline void writeDoubleSafe(const double d, std::ostream& os)
 {
@@ -15,10 +31,24 @@ inline void writeDoubleSafe(const double d, std::ostream& os)
 		{
 			os << 0; // convert -0 to 0
 		}
-		else
+		else if ((os.flags() & (std::ios::floatfield | std::ios::showpoint | std::ios::showpos | std::ios::uppercase)) != 0)
 		{
 			os << d;
 		}
+		else
+		{
+			// Produces the same characters as os << d in the default float format (%.*g),
+			// without going through the locale facets. Map files always use '.' as separator.
+			char buffer[64];
+			auto precision = static_cast<int>(os.precision());
+#if defined(__cpp_lib_to_chars)
+			auto result = std::to_chars(buffer, buffer + sizeof(buffer), d, std::chars_format::general, precision);
+			os.write(buffer, result.ptr - buffer);
+#else
+			auto length = std::snprintf(buffer, sizeof(buffer), "%.*g", precision, d);
+			os.write(buffer, length);
+#endif
+		}
 	}
 	else
 	{
@@ -17,21 +17,21 @@ class LegacyBrushDefExporter
 public:
 
 	// Writes an old Q3-style brush definition from the given brush to the given stream
-	static void exportBrush(std::ostream& stream, const IBrushNodePtr& brushNode)
+	static void exportBrush(std::ostream& stream, const IBrushNodePtr& brushNode, const Vector3& origin)
 	{
 		const IBrush& brush = brushNode->getIBrush();
 
 		// Curly braces surround the brush contents
-		stream << "{" << std::endl;
+		stream << "{\n";
 
 		// Iterate over each brush face, exporting the tokens from all faces
 		for (std::size_t i = 0; i < brush.getNumFaces(); ++i)
 		{
-			writeFace(stream, brush.getFace(i), brush.getDetailFlag());
+			writeFace(stream, brush.getFace(i), origin, brush.getDetailFlag());
 		}
 
 		// Close brush contents
-		stream << "}" << std::endl;
+		stream << "}\n";
 	}
 
     /*
@@ -47,7 +47,7 @@ public:
 
 private:
 
-    static void writeFace(std::ostream& stream, const IFace& face, IBrush::DetailFlag detailFlag)
+    static void writeFace(std::ostream& stream, const IFace& face, const Vector3& origin, IBrush::DetailFlag detailFlag)
     {
         // greebo: Don't export faces with degenerate or empty windings (they are "non-contributing")
         const IWinding& winding = face.getWinding();
@@ -60,34 +60,25 @@ private:
         // ( 16 192 96 ) ( 16 128 96 ) ( 0 192 96 ) shared_vega/trim03a 0 0 0 0.125 0.125 134217728 0 0
         // ( Point 1 ) ( Point 2 ) ( Point 3 ) path/to/material shiftS shiftT rotate scaleS scaleT DetailFlag 0 0
 
-        // Each face plane is defined by three points
-
-        stream << "( ";
-        writeDoubleSafe(winding[2].vertex.x(), stream);
-        stream << " ";
-        writeDoubleSafe(winding[2].vertex.y(), stream);
-        stream << " ";
-        writeDoubleSafe(winding[2].vertex.z(), stream);
-        stream << " ";
-        stream << ") ";
-
-        stream << "( ";
-        writeDoubleSafe(winding[0].vertex.x(), stream);
-        stream << " ";
-        writeDoubleSafe(winding[0].vertex.y(), stream);
-        stream << " ";
-        writeDoubleSafe(winding[0].vertex.z(), stream);
-        stream << " ";
-        stream << ") ";
+        // Each face plane is defined by three points, relative to the entity origin
+        Vector3 points[3] =
+        {
+            winding[2].vertex - origin,
+            winding[0].vertex - origin,
+            winding[1].vertex - origin
+        };
 
-        stream << "( ";
-        writeDoubleSafe(winding[1].vertex.x(), stream);
-        stream << " ";
-        writeDoubleSafe(winding[1].vertex.y(), stream);
-        stream << " ";
-        writeDoubleSafe(winding[1].vertex.z(), stream);
-        stream << " ";
-        stream << ") ";
+        for (const auto& point : points)
+        {
+            stream << "( ";
+            writeDoubleSafe(point.x(), stream);
+            stream << " ";
+            writeDoubleSafe(point.y(), stream);
+            stream << " ";
+            writeDoubleSafe(point.z(), stream);
+            stream << " ";
+            stream << ") ";
+        }
 
         // Write Shader (without quotes)
         const std::string& shaderName = face.getShader();
@@ -150,7 +141,7 @@ private:
 		// Export contents flags and the two zeroes at the end
 		stream << detailFlag << " 0 0";
 		
-		stream << std::endl;
+		stream << "\n";
 	}
 };
 
@@ -23,35 +23,89 @@ std::string ComplexName::getFullname() const
     return _name + (_postFix != EMPTY_POSTFIX ? _postFix : "");
 }
 
-namespace
+bool PostfixSet::insert(const std::string& postfix)
 {
-    // Find the first integer not in the given set
-    std::string findFirstUnusedNumber(const PostfixSet& set)
+    auto number = getNumber(postfix);
+
+    return number != -1 ? _numbers.insert(number).second : _otherPostfixes.insert(postfix).second;
+}
+
+bool PostfixSet::erase(const std::string& postfix)
+{
+    auto number = getNumber(postfix);
+
+    if (number == -1)
     {
-        static const int LOWEST_VAL = 1;
+        return _otherPostfixes.erase(postfix) > 0;
+    }
 
-        for (int i = LOWEST_VAL; i < INT_MAX; ++i)
-        {
-			std::string testPostfix = string::to_string(i);
+    if (_numbers.erase(number) == 0)
+    {
+        return false;
+    }
+
+    // The number is free again
+    if (number < _firstUnusedCandidate)
+    {
+        _firstUnusedCandidate = number;
+    }
+
+    return true;
+}
+
+bool PostfixSet::contains(const std::string& postfix) const
+{
+    auto number = getNumber(postfix);
+
+    return number != -1 ? _numbers.count(number) > 0 : _otherPostfixes.count(postfix) > 0;
+}
 
-            if (set.find(testPostfix) == set.end())
-            {
-                // Found an unused value
-                return testPostfix;
-            }
+void PostfixSet::merge(const PostfixSet& other)
+{
+    _numbers.insert(other._numbers.begin(), other._numbers.end());
+    _otherPostfixes.insert(other._otherPostfixes.begin(), other._otherPostfixes.end());
+}
+
+int PostfixSet::findFirstUnusedNumber() const
+{
+    // Advance the candidate past the numbers which have been taken in the meantime
+    while (_firstUnusedCandidate < INT_MAX && _numbers.count(_firstUnusedCandidate) > 0)
+    {
+        ++_firstUnusedCandidate;
+    }
+
+    return _firstUnusedCandidate;
+}
+
+int PostfixSet::getNumber(const std::string& postfix)
+{
+    // Numbers with leading zeros are different postfixes than the plain ones
+    if (postfix.empty() || postfix.size() > 10 || postfix[0] == '0')
+    {
+        return -1;
+    }
+
+    long long value = 0;
+
+    for (auto c : postfix)
+    {
+        if (c < '0' || c > '9')
+        {
+            return -1;
         }
 
-        // Pathological case, could not find a value
-        return string::to_string(INT_MAX);
+        value = value * 10 + (c - '0');
     }
+
+    return value <= INT_MAX ? static_cast<int>(value) : -1;
 }
 
 std::string ComplexName::makePostfixUnique(const PostfixSet& postfixes)
 {
     // If our postfix is already in the set, change it to a unique value
-    if (postfixes.find(_postFix) != postfixes.end())
+    if (postfixes.contains(_postFix))
     {
-        _postFix = findFirstUnusedNumber(postfixes);
+        _postFix = string::to_string(postfixes.findFirstUnusedNumber());
     }
 
     return _postFix;
@@ -1,10 +1,53 @@
 #pragma once
 
 #include <string>
-#include <set>
+#include <unordered_set>
 
-/// Set of unique postfixes, e.g. "1", "6" or "04"
-typedef std::set<std::string> PostfixSet;
+/**
+ * Set of unique postfixes, e.g. "1", "6" or "04".
+ *
+ * Postfixes which are plain numbers (no leading zeros) are stored as integers,
+ * together with a counter remembering up to which number all postfixes are
+ * taken. Finding an unused number doesn't need to start over at 1 every time.
+ */
+class PostfixSet
+{
+    std::unordered_set<int> _numbers;
+
+    // All other postfixes, like "-", "04" or numbers beyond the int range
+    std::unordered_set<std::string> _otherPostfixes;
+
+    // All numbers below this one are known to be in use
+    mutable int _firstUnusedCandidate;
+
+public:
+    PostfixSet() :
+        _firstUnusedCandidate(1)
+    {}
+
+    /// Returns true if the postfix has been inserted (i.e. it wasn't there before)
+    bool insert(const std::string& postfix);
+
+    /// Returns true if the postfix has been in the set
+    bool erase(const std::string& postfix);
+
+    bool contains(const std::string& postfix) const;
+
+    bool empty() const
+    {
+        return _numbers.empty() && _otherPostfixes.empty();
+    }
+
+    /// Adds all postfixes of the other set to this one
+    void merge(const PostfixSet& other);
+
+    /// Returns the lowest number (starting at 1) which is not in this set
+    int findFirstUnusedNumber() const;
+
+private:
+    // Returns the value of the given postfix, or -1 if it is not a plain number
+    static int getNumber(const std::string& postfix);
+};
 
 /// Name consisting of initial text and optional unique-making number-postfix 
 /// e.g. "Carl" + "6", or "Mary" + "03"
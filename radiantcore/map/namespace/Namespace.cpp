@@ -280,11 +280,12 @@ void Namespace::ensureNoConflicts(const scene::INodePtr& foreignRoot, const std:
     rDebug() << "Namespace::ensureNoConflicts(): importing set of "
         << foreignNodes.size() << " namespaced nodes" << std::endl;
 
-    // Build a union set containing all imported names and all existing names.
-    // We need to know all existing names to ensure that newly created names are
-    // unique in *both* namespaces
-    UniqueNameSet allNames = _uniqueNames;
-    allNames.merge(foreignNamespace._uniqueNames);
+    // Build a union set containing all imported names and the existing names.
+    // We need to know the existing names to ensure that newly created names are
+    // unique in *both* namespaces. Only the existing names sharing a prefix with
+    // an imported name can get in the way, there's no need to copy the others.
+    UniqueNameSet allNames = foreignNamespace._uniqueNames;
+    allNames.mergeKnownPrefixes(_uniqueNames);
 
     // Process each object in the to-be-imported tree of nodes, ensuring that it
     // has a unique name
@@ -1,7 +1,6 @@
 #pragma once
 
-#include <set>
-#include <map>
+#include <unordered_map>
 
 #include "ComplexName.h"
 
@@ -15,7 +14,7 @@ class UniqueNameSet
     // This maps name prefixes to a set of used postfixes
     // e.g. "func_static_" => ["1","3","4","5","05","10"]
     // Allows fairly quick lookup of used names and postfixes
-    typedef std::map<std::string, PostfixSet> Names;
+    typedef std::unordered_map<std::string, PostfixSet> Names;
     Names _names;
 
 public:
@@ -59,10 +58,8 @@ public:
         }
 
         // The prefix is inserted at this point, add the postfix to the set
-        auto result = found->second.insert(name.getPostfix());
-
-        // Return the boolean of the insertion result, it is true on successful insertion
-        return result.second;
+        // The result is true on successful insertion
+        return found->second.insert(name.getPostfix());
     }
 
     /**
@@ -155,7 +152,7 @@ public:
             const PostfixSet& postfixSet = found->second;
 
             // If we know the number too, the full name exists
-            return postfixSet.find(name.getPostfix()) != postfixSet.end();
+            return postfixSet.contains(name.getPostfix());
         }
 
         // Prefix is not known, hence full name is not known
@@ -178,7 +175,7 @@ public:
             if (local != _names.end())
 			{
                 // Prefix exists, merge the postfixes
-                local->second.insert(i.second.begin(), i.second.end());
+                local->second.merge(i.second);
             }
             else
 			{
@@ -187,4 +184,21 @@ public:
             }
         }
     }
+
+    /**
+     * Copies the names of the <other> UniqueNameSet into this one, but only
+     * the ones with a prefix that is already present in this set.
+     */
+    void mergeKnownPrefixes(const UniqueNameSet& other)
+    {
+        for (auto& i : _names)
+        {
+            auto found = other._names.find(i.first);
+
+            if (found != other._names.end())
+            {
+                i.second.merge(found->second);
+            }
+        }
+    }
 };
@@ -17,12 +17,18 @@
 #include <functional>
 
 #include "map/algorithm/Models.h"
+#include "import/ModelImporterBase.h"
+#include "ModelPlaceholderNode.h"
+#include "StaticModel.h"
+#include "StaticModelSurface.h"
 
 namespace model 
 {
 
 ModelCache::ModelCache() :
-	_enabled(true)
+	_enabled(true),
+	_numHits(0),
+	_numMisses(0)
 {}
 
 scene::INodePtr ModelCache::getModelNode(const std::string& modelPath)
@@ -100,6 +106,116 @@ scene::INodePtr ModelCache::getModelNode(const std::string& modelPath)
 	return loadNullModel(actualModelPath);
 }
 
+scene::INodePtr ModelCache::getModelNodeAsync(const std::string& modelPath)
+{
+	// Model defs need their idle animation set up, load them right away
+	if (!_loaderPool || GlobalEntityClassManager().findModel(modelPath))
+	{
+		return getModelNode(modelPath);
+	}
+
+	// Only the static model formats can be parsed on a worker thread,
+	// everything else (particles, the NullModel fallback) is handled synchronously
+	auto importer = std::dynamic_pointer_cast<ModelImporterBase>(
+		GlobalModelFormatManager().getImporter(os::getExtension(modelPath)));
+
+	if (!importer)
+	{
+		return getModelNode(modelPath);
+	}
+
+	auto cachePath = importer->getModelCachePath(modelPath);
+
+	if (_enabled && _modelMap.find(cachePath) != _modelMap.end())
+	{
+		return getModelNode(modelPath); // cache hit, nothing to wait for
+	}
+
+	auto pending = _pendingModels.find(cachePath);
+
+	if (pending != _pendingModels.end())
+	{
+		++_numHits; // the model is on its way already
+	}
+	else
+	{
+		// First request for this model, schedule the load
+		++_numMisses;
+		pending = _pendingModels.emplace(cachePath, PendingModel()).first;
+		pending->second.importer = importer;
+
+		// The workers must not access the registry or other modules, the importer
+		// reads what it needs before and completes the model in finishPendingModel()
+		auto loadModel = importer->getBackgroundLoadFunc(cachePath);
+
+		pending->second.result = _loaderPool->submit([importer, loadModel]()
+		{
+			return loadModel();
+		}).share();
+	}
+
+	auto placeholder = std::make_shared<ModelPlaceholderNode>(modelPath);
+	pending->second.placeholders.push_back(placeholder);
+
+	return placeholder;
+}
+
+void ModelCache::waitForPendingModels()
+{
+	// Swapping in the models might request further ones, repeat until nothing is left
+	while (!_pendingModels.empty())
+	{
+		PendingModelMap pendingModels;
+		pendingModels.swap(_pendingModels);
+
+		for (auto& pair : pendingModels)
+		{
+			auto model = finishPendingModel(pair.first, pair.second);
+
+			for (const auto& weakPlaceholder : pair.second.placeholders)
+			{
+				auto placeholder = weakPlaceholder.lock();
+
+				if (!placeholder)
+				{
+					continue; // the node requesting this model is gone
+				}
+
+				const auto& modelPath = placeholder->getRequestedModelPath();
+
+				// The model is in the cache now, the node is constructed without parsing
+				auto node = model ? getModelNode(modelPath) : loadNullModel(modelPath);
+
+				placeholder->signal_modelLoaded().emit(node);
+			}
+		}
+	}
+}
+
+IModelPtr ModelCache::finishPendingModel(const std::string& cachePath, PendingModel& pending)
+{
+	IModelPtr model;
+
+	try
+	{
+		model = pending.result.get();
+	}
+	catch (const std::exception& ex)
+	{
+		rError() << "Failed to load model " << cachePath << ": " << ex.what() << std::endl;
+	}
+
+	if (model)
+	{
+		pending.importer->finishBackgroundLoad(model);
+
+		// In case the model got loaded synchronously in the meantime, stick to that one
+		model = _modelMap.emplace(cachePath, model).first->second;
+	}
+
+	return model;
+}
+
 IModelPtr ModelCache::getModel(const std::string& modelPath)
 {
 	// Try to lookup the existing model
@@ -107,9 +223,21 @@ IModelPtr ModelCache::getModel(const std::string& modelPath)
 
 	if (_enabled && found != _modelMap.end())
 	{
+		++_numHits;
 		return found->second;
 	}
 
+	// If this model is being loaded in the background, wait for it instead of parsing it twice
+	auto pending = _pendingModels.find(modelPath);
+
+	if (_enabled && pending != _pendingModels.end())
+	{
+		++_numHits;
+		return finishPendingModel(modelPath, pending->second);
+	}
+
+	++_numMisses;
+
 	// The model is not cached or the cache is disabled, load afresh
 
 	// Get the extension of this model
@@ -152,6 +280,38 @@ scene::INodePtr ModelCache::loadNullModel(const std::string& modelPath)
     return nullModelLoader->loadModel(modelPath);
 }
 
+ModelCache::Statistics ModelCache::getStatistics() const
+{
+	Statistics stats;
+
+	stats.numModels = _modelMap.size();
+	stats.numHits = _numHits;
+	stats.numMisses = _numMisses;
+
+	for (const auto& pair : _modelMap)
+	{
+		auto staticModel = std::dynamic_pointer_cast<StaticModel>(pair.second);
+
+		if (staticModel)
+		{
+			// The nodes are sharing the geometry of the cached surfaces
+			for (const auto& surface : staticModel->getSurfaces())
+			{
+				stats.vertexDataSize += surface.originalSurface->getVertexDataSize();
+				stats.indexDataSize += surface.originalSurface->getIndexDataSize();
+			}
+
+			continue;
+		}
+
+		// Other model types are estimated from their vertex and triangle counts
+		stats.vertexDataSize += pair.second->getVertexCount() * sizeof(ArbitraryMeshVertex);
+		stats.indexDataSize += pair.second->getPolyCount() * 3 * sizeof(unsigned int);
+	}
+
+	return stats;
+}
+
 void ModelCache::removeModel(const std::string& modelPath)
 {
 	// greebo: Disable the modelcache. During map::clear(), the nodes
@@ -214,10 +374,18 @@ void ModelCache::initialiseModule(const IApplicationContext& ctx)
 		std::bind(&ModelCache::refreshModelsCmd, this, std::placeholders::_1));
 	GlobalCommandSystem().addCommand("RefreshSelectedModels", 
 		std::bind(&ModelCache::refreshSelectedModelsCmd, this, std::placeholders::_1));
+	GlobalCommandSystem().addCommand("ShowModelCacheStatistics",
+		std::bind(&ModelCache::showModelCacheStatisticsCmd, this, std::placeholders::_1));
+
+	_loaderPool = std::make_unique<util::ThreadPool>();
 }
 
 void ModelCache::shutdownModule()
 {
+	// Blocks until the running loads are done, unstarted ones are discarded
+	_loaderPool.reset();
+	_pendingModels.clear();
+
 	clear();
 }
 
@@ -241,6 +409,24 @@ void ModelCache::refreshSelectedModelsCmd(const cmd::ArgumentList& args)
 	map::algorithm::refreshSelectedModels(true);
 }
 
+void ModelCache::showModelCacheStatisticsCmd(const cmd::ArgumentList& args)
+{
+	auto stats = getStatistics();
+	auto numRequests = stats.numHits + stats.numMisses;
+
+	rMessage() << "Models in cache: " << stats.numModels << std::endl;
+	rMessage() << "Vertex data: " << stats.vertexDataSize / 1024 << " KiB" << std::endl;
+	rMessage() << "Index data: " << stats.indexDataSize / 1024 << " KiB" << std::endl;
+	rMessage() << "Cache hits: " << stats.numHits << ", misses: " << stats.numMisses;
+
+	if (numRequests > 0)
+	{
+		rMessage() << " (hit rate " << (100 * stats.numHits / numRequests) << "%)";
+	}
+
+	rMessage() << std::endl;
+}
+
 // The static module
 module::StaticModule<ModelCache> modelCacheModule;
 
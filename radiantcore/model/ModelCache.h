@@ -1,13 +1,20 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include <string>
+#include <vector>
+#include <future>
 #include "imodelcache.h"
 #include "icommandsystem.h"
+#include "ThreadPool.h"
 
 namespace model
 {
 
+class ModelPlaceholderNode;
+class ModelImporterBase;
+
 class ModelCache :
 	public IModelCache
 {
@@ -19,6 +26,28 @@ private:
 	// Flag to disable the cache on demand (used during clear())
 	bool _enabled;
 
+	// A model requested through getModelNodeAsync() which is (possibly) still loading
+	struct PendingModel
+	{
+		std::shared_future<IModelPtr> result;
+
+		// The importer completing the model on the main thread
+		std::shared_ptr<ModelImporterBase> importer;
+
+		// The placeholders handed out for this model, expired ones belong to discarded nodes
+		std::vector<std::weak_ptr<ModelPlaceholderNode>> placeholders;
+	};
+
+	// Pending models, keyed by the path used in the model map
+	typedef std::map<std::string, PendingModel> PendingModelMap;
+	PendingModelMap _pendingModels;
+
+	// The workers parsing the models requested through getModelNodeAsync()
+	std::unique_ptr<util::ThreadPool> _loaderPool;
+
+	std::size_t _numHits;
+	std::size_t _numMisses;
+
 	sigc::signal<void> _sigModelsReloaded;
 
 public:
@@ -27,11 +56,16 @@ public:
 	// greebo: For documentation, see the abstract base class.
 	scene::INodePtr getModelNode(const std::string& modelPath) override;
 
+	scene::INodePtr getModelNodeAsync(const std::string& modelPath) override;
+	void waitForPendingModels() override;
+
 	// greebo: For documentation, see the abstract base class.
 	IModelPtr getModel(const std::string& modelPath) override;
 
     scene::INodePtr getModelNodeForStaticResource(const std::string& resourcePath) override;
 
+	Statistics getStatistics() const override;
+
 	// Clear methods
 	void removeModel(const std::string& modelPath) override;
 	void clear() override;
@@ -51,9 +85,13 @@ public:
 private:
     scene::INodePtr loadNullModel(const std::string& modelPath);
 
+	// Waits for the given pending model and moves it to the model map, returns NULL on failure
+	IModelPtr finishPendingModel(const std::string& cachePath, PendingModel& pending);
+
 	// Command targets
 	void refreshModelsCmd(const cmd::ArgumentList& args);
 	void refreshSelectedModelsCmd(const cmd::ArgumentList& args);
+	void showModelCacheStatisticsCmd(const cmd::ArgumentList& args);
 };
 
 } // namespace model
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "imodelcache.h"
+#include "NullModelNode.h"
+
+namespace model
+{
+
+/**
+ * Bounds-only stand-in for a model which is loaded in the background,
+ * handed out by the ModelCache for models requested through getModelNodeAsync().
+ */
+class ModelPlaceholderNode :
+	public NullModelNode,
+	public IModelPlaceholder
+{
+private:
+	std::string _requestedModelPath;
+
+	sigc::signal<void, const scene::INodePtr&> _sigModelLoaded;
+
+public:
+	ModelPlaceholderNode(const std::string& modelPath) :
+		NullModelNode(createNullModel(modelPath)),
+		_requestedModelPath(modelPath)
+	{}
+
+	std::string name() const override
+	{
+		return "modelplaceholder";
+	}
+
+	const std::string& getRequestedModelPath() const override
+	{
+		return _requestedModelPath;
+	}
+
+	sigc::signal<void, const scene::INodePtr&> signal_modelLoaded() override
+	{
+		return _sigModelLoaded;
+	}
+
+private:
+	static NullModelPtr createNullModel(const std::string& modelPath)
+	{
+		auto model = std::make_shared<NullModel>();
+		model->setModelPath(modelPath);
+		return model;
+	}
+};
+
+}
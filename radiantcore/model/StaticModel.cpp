@@ -43,7 +43,8 @@ StaticModel::StaticModel(const StaticModel& other) :
     // Copy the other model's surfaces, but not its shaders, revert to default
     for (std::size_t i = 0; i < other._surfVec.size(); ++i)
     {
-        // Copy-construct the other surface, inheriting any applied scale
+        // Copy-construct the other surface, inheriting any applied scale.
+        // The copy is sharing the geometry, we just need our own active material.
         _surfVec[i].surface = std::make_shared<StaticModelSurface>(*(other._surfVec[i].surface));
         _surfVec[i].originalSurface = other._surfVec[i].originalSurface;
         _surfVec[i].surface->setActiveMaterial(_surfVec[i].surface->getDefaultMaterial());
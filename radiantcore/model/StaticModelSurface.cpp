@@ -7,6 +7,7 @@
 #include "iselectiontest.h"
 #include "irenderable.h"
 #include "gamelib.h"
+#include "render/VBO.h"
 
 #include "string/replace.h"
 
@@ -14,63 +15,61 @@ namespace model
 {
 
 StaticModelSurface::StaticModelSurface(std::vector<ArbitraryMeshVertex>&& vertices, std::vector<unsigned int>&& indices) :
-    _vertices(vertices),
-    _indices(indices),
-    _dlRegular(0),
-    _dlProgramVcol(0),
-    _dlProgramNoVCol(0)
+    _geometry(std::make_shared<Geometry>())
 {
+    _geometry->indices = std::move(indices);
+
     // Expand the local AABB to include all vertices
-    for (const auto& vertex : _vertices)
+    for (const auto& vertex : vertices)
     {
-        _localAABB.includePoint(vertex.vertex);
+        _geometry->localAABB.includePoint(vertex.vertex);
     }
 
-    calculateTangents();
-    createDisplayLists();
+    packVertices(vertices);
 }
 
 StaticModelSurface::StaticModelSurface(const StaticModelSurface& other) :
 	_defaultMaterial(other._defaultMaterial),
-	_vertices(other._vertices),
-	_indices(other._indices),
-	_nIndices(other._nIndices),
-	_localAABB(other._localAABB),
-	_dlRegular(0),
-	_dlProgramVcol(0),
-	_dlProgramNoVCol(0)
+	_geometry(other._geometry)
+{}
+
+// Release the GL buffer objects along with the last surface using them
+StaticModelSurface::Geometry::~Geometry()
+{
+	render::deleteVBO(vertexBuffer);
+	render::deleteVBO(indexBuffer);
+}
+
+std::size_t StaticModelSurface::getVertexDataSize() const
 {
-	createDisplayLists();
+	return _geometry->packedVertices.size() * sizeof(render::PackedMeshVertex);
 }
 
-// Destructor. Release the GL display lists.
-StaticModelSurface::~StaticModelSurface()
+std::size_t StaticModelSurface::getIndexDataSize() const
 {
-	glDeleteLists(_dlRegular, 1);
-	glDeleteLists(_dlProgramNoVCol, 1);
-	glDeleteLists(_dlProgramVcol, 1);
+	return _geometry->indices.size() * sizeof(unsigned int);
 }
 
 // Tangent calculation
-void StaticModelSurface::calculateTangents()
+void StaticModelSurface::calculateTangents(VertexVector& vertices) const
 {
 	// Calculate the tangents and bitangents using the indices into the vertex
 	// array.
-	for (Indices::iterator i = _indices.begin();
-		 i != _indices.end();
+	for (Indices::const_iterator i = _geometry->indices.begin();
+		 i != _geometry->indices.end();
 		 i += 3)
 	{
-		ArbitraryMeshVertex& a = _vertices[*i];
-		ArbitraryMeshVertex& b = _vertices[*(i + 1)];
-		ArbitraryMeshVertex& c = _vertices[*(i + 2)];
+		ArbitraryMeshVertex& a = vertices[*i];
+		ArbitraryMeshVertex& b = vertices[*(i + 1)];
+		ArbitraryMeshVertex& c = vertices[*(i + 2)];
 
 		// Call the tangent calculation function
 		ArbitraryMeshTriangle_sumTangents(a, b, c);
 	}
 
 	// Normalise all of the tangent and bitangent vectors
-	for (VertexVector::iterator j = _vertices.begin();
-		 j != _vertices.end();
+	for (VertexVector::iterator j = vertices.begin();
+		 j != vertices.end();
 		 ++j)
 	{
 		j->tangent.normalise();
@@ -78,111 +77,148 @@ void StaticModelSurface::calculateTangents()
 	}
 }
 
-// Back-end render function
-void StaticModelSurface::render(const RenderInfo& info) const
+void StaticModelSurface::packVertices(VertexVector& vertices)
 {
-	// Invoke appropriate display list
-	if (info.checkFlag(RENDER_PROGRAM))
-    {
-        if (info.checkFlag(RENDER_VERTEX_COLOUR))
-        {
-            glCallList(_dlProgramVcol);
-        }
-        else
-        {
-            glCallList(_dlProgramNoVCol);
-        }
+	calculateTangents(vertices);
+
+	auto& packedVertices = _geometry->packedVertices;
+
+	packedVertices.clear();
+	packedVertices.reserve(vertices.size());
+
+	for (const auto& vertex : vertices)
+	{
+		packedVertices.push_back(render::packMeshVertex(vertex));
 	}
-	else
-    {
-		glCallList(_dlRegular);
+
+	// Discard the outdated double-precision vertices
+	releaseVertexArray();
+
+	_geometry->buffersNeedUpdate = true;
+}
+
+void StaticModelSurface::ensureVertexArray() const
+{
+	auto& vertices = _geometry->vertices;
+
+	if (vertices.size() == _geometry->packedVertices.size())
+	{
+		return;
+	}
+
+	vertices.clear();
+	vertices.reserve(_geometry->packedVertices.size());
+
+	for (const auto& packed : _geometry->packedVertices)
+	{
+		vertices.push_back(render::unpackMeshVertex(packed));
 	}
 }
 
-// Construct a list for GLProgram mode, either with or without vertex colour
-GLuint StaticModelSurface::compileProgramList(bool includeColour)
+void StaticModelSurface::ensureBuffers() const
 {
-    GLuint list = glGenLists(1);
-	assert(list != 0); // check if we run out of display lists
-    glNewList(list, GL_COMPILE);
-
-	glBegin(GL_TRIANGLES);
-	for (Indices::const_iterator i = _indices.begin();
-		 i != _indices.end();
-		 ++i)
+	auto& geometry = *_geometry;
+
+	if (geometry.vertexBuffer == 0 || geometry.indexBuffer == 0)
 	{
-		// Get the vertex for this index
-		ArbitraryMeshVertex& v = _vertices[*i];
+		// The buffers are created with the current data
+		render::deleteVBO(geometry.vertexBuffer);
+		render::deleteVBO(geometry.indexBuffer);
 
-		// Submit the vertex attributes and coordinate
-		if (GLEW_ARB_vertex_program)
-        {
-			glVertexAttrib2dvARB(ATTR_TEXCOORD, v.texcoord);
-			glVertexAttrib3dvARB(ATTR_TANGENT, v.tangent);
-			glVertexAttrib3dvARB(ATTR_BITANGENT, v.bitangent);
-			glVertexAttrib3dvARB(ATTR_NORMAL, v.normal);
-		}
+		geometry.vertexBuffer = render::makeVBOFromArray(GL_ARRAY_BUFFER, geometry.packedVertices);
+		geometry.indexBuffer = render::makeVBOFromArray(GL_ELEMENT_ARRAY_BUFFER, geometry.indices);
+	}
+	else if (geometry.buffersNeedUpdate)
+	{
+		// The vertex count doesn't change when scaling, the buffer can be overwritten in place
+		render::replaceVBOData(GL_ARRAY_BUFFER, geometry.vertexBuffer, geometry.packedVertices);
+	}
+
+	geometry.buffersNeedUpdate = false;
+}
+
+// Back-end render function
+void StaticModelSurface::render(const RenderInfo& info) const
+{
+	if (_geometry->packedVertices.empty() || _geometry->indices.empty())
+	{
+		return;
+	}
+
+	ensureBuffers();
+
+	glBindBuffer(GL_ARRAY_BUFFER, _geometry->vertexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _geometry->indexBuffer);
+
+	const GLsizei stride = sizeof(render::PackedMeshVertex);
+
+	glVertexPointer(3, GL_FLOAT, stride, reinterpret_cast<const GLvoid*>(offsetof(render::PackedMeshVertex, vertex)));
+
+	bool includeColour = false;
+
+	if (info.checkFlag(RENDER_PROGRAM))
+    {
+		// Submit the vertex attributes, the normal and tangent vectors are normalised shorts
+		glVertexAttribPointer(ATTR_TEXCOORD, 2, GL_FLOAT, GL_FALSE, stride,
+			reinterpret_cast<const GLvoid*>(offsetof(render::PackedMeshVertex, texcoord)));
+		glVertexAttribPointer(ATTR_TANGENT, 3, GL_SHORT, GL_TRUE, stride,
+			reinterpret_cast<const GLvoid*>(offsetof(render::PackedMeshVertex, tangent)));
+		glVertexAttribPointer(ATTR_BITANGENT, 3, GL_SHORT, GL_TRUE, stride,
+			reinterpret_cast<const GLvoid*>(offsetof(render::PackedMeshVertex, bitangent)));
+		glVertexAttribPointer(ATTR_NORMAL, 3, GL_SHORT, GL_TRUE, stride,
+			reinterpret_cast<const GLvoid*>(offsetof(render::PackedMeshVertex, normal)));
 
         // Optional vertex colour
+        includeColour = info.checkFlag(RENDER_VERTEX_COLOUR);
+
         if (includeColour)
         {
-            glColor3dv(v.colour);
+            glEnableClientState(GL_COLOR_ARRAY);
+            glColorPointer(4, GL_UNSIGNED_BYTE, stride,
+                reinterpret_cast<const GLvoid*>(offsetof(render::PackedMeshVertex, colour)));
         }
-
-        // Submit the vertex itself
-		glVertex3dv(v.vertex);
 	}
-	glEnd();
-
-	glEndList();
+	else
+    {
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		glTexCoordPointer(2, GL_FLOAT, stride, reinterpret_cast<const GLvoid*>(offsetof(render::PackedMeshVertex, texcoord)));
+		glNormalPointer(GL_SHORT, stride, reinterpret_cast<const GLvoid*>(offsetof(render::PackedMeshVertex, normal)));
+	}
 
-    return list;
-}
+	glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(_geometry->indices.size()), GL_UNSIGNED_INT, nullptr);
 
-// Construct the two display lists
-void StaticModelSurface::createDisplayLists()
-{
-	// Generate the lists for lighting mode
-    _dlProgramNoVCol = compileProgramList(false);
-    _dlProgramVcol = compileProgramList(true);
-
-	// Generate the list for flat-shaded (unlit) mode
-	_dlRegular = glGenLists(1);
-	assert(_dlRegular != 0); // check if we run out of display lists
-	glNewList(_dlRegular, GL_COMPILE);
-
-	glBegin(GL_TRIANGLES);
-	for (Indices::const_iterator i = _indices.begin();
-		 i != _indices.end();
-		 ++i)
+	if (includeColour)
 	{
-		// Get the vertex for this index
-		ArbitraryMeshVertex& v = _vertices[*i];
+		glDisableClientState(GL_COLOR_ARRAY);
+	}
 
-		// Submit attributes
-		glNormal3dv(v.normal);
-		glTexCoord2dv(v.texcoord);
-		glVertex3dv(v.vertex);
+	if (!info.checkFlag(RENDER_PROGRAM))
+	{
+		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
 	}
-	glEnd();
 
-	glEndList();
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 // Perform selection test for this surface
 void StaticModelSurface::testSelect(Selector& selector, SelectionTest& test,
     const Matrix4& localToWorld, bool twoSided) const
 {
-	if (!_vertices.empty() && !_indices.empty())
+	const auto& packedVertices = _geometry->packedVertices;
+	const auto& indices = _geometry->indices;
+
+	if (!packedVertices.empty() && !indices.empty())
 	{
 		// Test for triangle selection
 		test.BeginMesh(localToWorld, twoSided);
 		SelectionIntersection result;
 
+		// The float positions are read right from the packed vertices
 		test.TestTriangles(
-			VertexPointer(&_vertices[0].vertex, sizeof(ArbitraryMeshVertex)),
-      		IndexPointer(&_indices[0],
-      					 IndexPointer::index_type(_indices.size())),
+			FloatVertexPointer(packedVertices[0].vertex, sizeof(render::PackedMeshVertex)),
+      		IndexPointer(&indices[0],
+      					 IndexPointer::index_type(indices.size())),
 			result
 		);
 
@@ -195,23 +231,28 @@ void StaticModelSurface::testSelect(Selector& selector, SelectionTest& test,
 
 int StaticModelSurface::getNumVertices() const
 {
-	return static_cast<int>(_vertices.size());
+	return static_cast<int>(_geometry->packedVertices.size());
 }
 
 int StaticModelSurface::getNumTriangles() const
 {
-	return static_cast<int>(_indices.size() / 3); // 3 indices per triangle
+	return static_cast<int>(_geometry->indices.size() / 3); // 3 indices per triangle
 }
 
 const ArbitraryMeshVertex& StaticModelSurface::getVertex(int vertexIndex) const
 {
-	assert(vertexIndex >= 0 && vertexIndex < static_cast<int>(_vertices.size()));
-	return _vertices[vertexIndex];
+	ensureVertexArray();
+
+	assert(vertexIndex >= 0 && vertexIndex < static_cast<int>(_geometry->vertices.size()));
+	return _geometry->vertices[vertexIndex];
 }
 
 ModelPolygon StaticModelSurface::getPolygon(int polygonIndex) const
 {
-	assert(polygonIndex >= 0 && polygonIndex*3 < static_cast<int>(_indices.size()));
+	const auto& packedVertices = _geometry->packedVertices;
+	const auto& indices = _geometry->indices;
+
+	assert(polygonIndex >= 0 && polygonIndex*3 < static_cast<int>(indices.size()));
 
 	ModelPolygon poly;
 
@@ -219,21 +260,29 @@ ModelPolygon StaticModelSurface::getPolygon(int polygonIndex) const
 	// The common convention is to use CCW winding direction, so reverse the index order
 	// ASE models define tris in the usual CCW order, but it appears that the pm_ase.c file
 	// reverses the vertex indices during parsing.
-	poly.c = _vertices[_indices[polygonIndex*3]];
-	poly.b = _vertices[_indices[polygonIndex*3 + 1]];
-	poly.a = _vertices[_indices[polygonIndex*3 + 2]];
+	poly.c = render::unpackMeshVertex(packedVertices[indices[polygonIndex*3]]);
+	poly.b = render::unpackMeshVertex(packedVertices[indices[polygonIndex*3 + 1]]);
+	poly.a = render::unpackMeshVertex(packedVertices[indices[polygonIndex*3 + 2]]);
 
 	return poly;
 }
 
 const std::vector<ArbitraryMeshVertex>& StaticModelSurface::getVertexArray() const
 {
-	return _vertices;
+	ensureVertexArray();
+
+	return _geometry->vertices;
 }
 
 const std::vector<unsigned int>& StaticModelSurface::getIndexArray() const
 {
-	return _indices;
+	return _geometry->indices;
+}
+
+void StaticModelSurface::releaseVertexArray() const
+{
+	// Swap to actually give the memory back, the packed vertices stay resident
+	VertexVector().swap(_geometry->vertices);
 }
 
 const std::string& StaticModelSurface::getDefaultMaterial() const
@@ -246,6 +295,16 @@ void StaticModelSurface::setDefaultMaterial(const std::string& defaultMaterial)
 	_defaultMaterial = defaultMaterial;
 }
 
+const std::string& StaticModelSurface::getFallbackMaterial() const
+{
+	return _fallbackMaterial;
+}
+
+void StaticModelSurface::setFallbackMaterial(const std::string& fallbackMaterial)
+{
+	_fallbackMaterial = fallbackMaterial;
+}
+
 const std::string& StaticModelSurface::getActiveMaterial() const
 {
     return !_activeMaterial.empty() ? _activeMaterial : _defaultMaterial;
@@ -261,17 +320,19 @@ bool StaticModelSurface::getIntersection(const Ray& ray, Vector3& intersection,
 	Vector3 bestIntersection = ray.origin;
 	Vector3 triIntersection;
 
-	for (Indices::const_iterator i = _indices.begin();
-		 i != _indices.end();
+	const auto& packedVertices = _geometry->packedVertices;
+
+	for (Indices::const_iterator i = _geometry->indices.begin();
+		 i != _geometry->indices.end();
 		 i += 3)
 	{
 		// Get the vertices for this triangle
-		const ArbitraryMeshVertex& p1 = _vertices[*(i)];
-		const ArbitraryMeshVertex& p2 = _vertices[*(i+1)];
-		const ArbitraryMeshVertex& p3 = _vertices[*(i+2)];
+		auto p1 = packedVertices[*(i)].getVertex();
+		auto p2 = packedVertices[*(i+1)].getVertex();
+		auto p3 = packedVertices[*(i+2)].getVertex();
 
-		if (ray.intersectTriangle(localToWorld.transformPoint(p1.vertex), 
-			localToWorld.transformPoint(p2.vertex), localToWorld.transformPoint(p3.vertex), triIntersection))
+		if (ray.intersectTriangle(localToWorld.transformPoint(p1), 
+			localToWorld.transformPoint(p2), localToWorld.transformPoint(p3), triIntersection))
 		{
 			intersection = triIntersection;
 			
@@ -305,29 +366,48 @@ void StaticModelSurface::applyScale(const Vector3& scale, const StaticModelSurfa
 		return;
 	}
 
-	_localAABB = AABB();
+	if (scale == Vector3(1, 1, 1))
+	{
+		// Unscaled, go back to the original geometry
+		_geometry = originalSurface._geometry;
+		return;
+	}
+
+	// The geometry is shared with the original (and possibly other copies),
+	// the scaled vertices go into our own instance. If we own it already,
+	// it's overwritten in place, keeping the buffer objects.
+	if (_geometry == originalSurface._geometry || _geometry.use_count() > 1)
+	{
+		auto scaled = std::make_shared<Geometry>();
+		scaled->indices = originalSurface._geometry->indices;
+
+		_geometry = scaled;
+	}
+
+	_geometry->localAABB = AABB();
 
 	Matrix4 scaleMatrix = Matrix4::getScale(scale);
 	Matrix4 invTranspScale = Matrix4::getScale(Vector3(1/scale.x(), 1/scale.y(), 1/scale.z()));
 
-	assert(originalSurface.getNumVertices() == getNumVertices());
+	VertexVector vertices;
+	vertices.reserve(originalSurface._geometry->packedVertices.size());
 
-	for (std::size_t i = 0; i < _vertices.size(); ++i)
+	for (const auto& original : originalSurface._geometry->packedVertices)
 	{
-		_vertices[i].vertex = scaleMatrix.transformPoint(originalSurface._vertices[i].vertex);
-		_vertices[i].normal = invTranspScale.transformPoint(originalSurface._vertices[i].normal).getNormalised();
+		auto vertex = render::unpackMeshVertex(original);
 
-		// Expand the AABB to include this new vertex
-		_localAABB.includePoint(_vertices[i].vertex);
-	}
+		vertex.vertex = scaleMatrix.transformPoint(vertex.vertex);
+		vertex.normal = invTranspScale.transformPoint(vertex.normal).getNormalised();
+		vertex.tangent = vertex.bitangent = Normal3f(0, 0, 0);
 
-	calculateTangents();
+		// Expand the AABB to include this new vertex
+		_geometry->localAABB.includePoint(vertex.vertex);
 
-	glDeleteLists(_dlRegular, 1);
-	glDeleteLists(_dlProgramNoVCol, 1);
-	glDeleteLists(_dlProgramVcol, 1);
+		vertices.push_back(vertex);
+	}
 
-	createDisplayLists();
+	// Recalculates the tangents and schedules the buffer update
+	packVertices(vertices);
 }
 
 } // namespace model
@@ -2,6 +2,7 @@
 
 #include "GLProgramAttributes.h"
 #include "render.h"
+#include "render/PackedMeshVertex.h"
 #include "math/AABB.h"
 
 #include "ishaders.h"
@@ -37,45 +38,62 @@ private:
 	// Name of the material with skin remaps applied
 	std::string _activeMaterial;
 
-	// Vector of ArbitraryMeshVertex structures, containing the coordinates,
-	// normals, tangents and texture coordinates of the component vertices
-	typedef std::vector<ArbitraryMeshVertex> VertexVector;
-	VertexVector _vertices;
+	// Material to use instead of the default one if that doesn't exist,
+	// this is resolved by the importer once the surface is loaded
+	std::string _fallbackMaterial;
 
-	// Vector of render indices, representing the groups of vertices to be
-	// used to create triangles
+	typedef std::vector<ArbitraryMeshVertex> VertexVector;
 	typedef std::vector<unsigned int> Indices;
-	Indices _indices;
 
-	// Keep track of the number of indices to iterate over, since vector::size()
-	// may not be fast
-	unsigned int _nIndices;
+	// The mesh data of this surface. Copies of a surface (one for each model node
+	// using the same model) are sharing this data, it is only duplicated when scaling.
+	struct Geometry
+	{
+		// The vertices in the compact format, containing the coordinates,
+		// normals, tangents and texture coordinates as they are uploaded to GL
+		std::vector<render::PackedMeshVertex> packedVertices;
+
+		// The vertices in the form exposed through IModelSurface, converted from
+		// the packed vertices on first access and freed by releaseVertexArray()
+		mutable VertexVector vertices;
+
+		// Vector of render indices, representing the groups of vertices to be
+		// used to create triangles
+		Indices indices;
+
+		// The AABB containing this surface, in local object space.
+		AABB localAABB;
+
+		// The GL buffer objects holding the geometry, created on first render
+		mutable GLuint vertexBuffer = 0;
+		mutable GLuint indexBuffer = 0;
+		mutable bool buffersNeedUpdate = false;
 
-	// The AABB containing this surface, in local object space.
-	AABB _localAABB;
+		~Geometry();
+	};
 
-	// The GL display lists for this surface's geometry
-	GLuint _dlRegular;
-	GLuint _dlProgramVcol;
-    GLuint _dlProgramNoVCol;
+	std::shared_ptr<Geometry> _geometry;
 
 private:
-	// Calculate tangent and bitangent vectors for all vertices.
-	void calculateTangents();
+	// Calculate tangent and bitangent vectors for all given vertices.
+	void calculateTangents(VertexVector& vertices) const;
 
-	// Create the display lists
-    GLuint compileProgramList(bool includeColour);
-	void createDisplayLists();
+	// Calculates the tangents and stores the vertices in the compact format
+	void packVertices(VertexVector& vertices);
+
+	// Refresh the vertex array from the packed vertices, if necessary
+	void ensureVertexArray() const;
+
+	// Upload the geometry to the buffer objects, if necessary
+	void ensureBuffers() const;
 
 public:
     // Move-construct this static model surface from the given vertex- and index array
 	StaticModelSurface(std::vector<ArbitraryMeshVertex>&& vertices, std::vector<unsigned int>&& indices);
 
-	// Copy-constructor.
+	// Copy-constructor, the copy is sharing the geometry of the other surface
 	StaticModelSurface(const StaticModelSurface& other);
 
-	~StaticModelSurface();
-
 	/**
 	 * Render function from OpenGLRenderable
 	 */
@@ -84,9 +102,13 @@ public:
 	/** Get the containing AABB for this surface.
 	 */
 	const AABB& getAABB() const {
-		return _localAABB;
+		return _geometry->localAABB;
 	}
 
+	// The number of bytes occupied by the (packed) vertices and the indices
+	std::size_t getVertexDataSize() const;
+	std::size_t getIndexDataSize() const;
+
 	/**
 	 * Perform a selection test on this surface.
 	 */
@@ -102,10 +124,14 @@ public:
 
 	const std::vector<ArbitraryMeshVertex>& getVertexArray() const override;
 	const std::vector<unsigned int>& getIndexArray() const override;
+	void releaseVertexArray() const override;
 
 	const std::string& getDefaultMaterial() const override;
 	void setDefaultMaterial(const std::string& defaultMaterial);
 
+	const std::string& getFallbackMaterial() const;
+	void setFallbackMaterial(const std::string& fallbackMaterial);
+
 	const std::string& getActiveMaterial() const override;
 	void setActiveMaterial(const std::string& activeMaterial);
 
@@ -51,7 +51,6 @@ public:
 			// Cast succeeded, load the vertices and indices directly into here
 			unsigned int indexStart = static_cast<unsigned int>(surface.vertices.size());
 			
-			const auto& vertices = indexedSurf.getVertexArray();
 			const auto& indices = indexedSurf.getIndexArray();
 
 			if (indices.size() < 3)
@@ -61,6 +60,8 @@ public:
 				return;
 			}
 
+			const auto& vertices = indexedSurf.getVertexArray();
+
 			// Transform vertices before inserting them
 			for (const auto& meshVertex : vertices)
 			{
@@ -73,6 +74,9 @@ public:
                     meshVertex.texcoord,
                     meshVertex.colour);
 			}
+
+			// The vertices have been copied, don't keep the surface's expanded array around
+			indexedSurf.releaseVertexArray();
 			
 			surface.indices.reserve(surface.indices.size() + indices.size());
 
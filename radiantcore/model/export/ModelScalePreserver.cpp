@@ -85,6 +85,21 @@ void ModelScalePreserver::onResourceExported(const scene::IMapRootNodePtr& root)
 	});
 }
 
+void ModelScalePreserver::PreserveModelScale(const scene::INodePtr& sourceEntity, Entity& clonedEntity)
+{
+	sourceEntity->foreachNode([&](const scene::INodePtr& child)
+	{
+		auto model = Node_getModel(child);
+
+		if (model && model->hasModifiedScale())
+		{
+			clonedEntity.setKeyValue(MODELSCALE_KEY, string::to_string(model->getModelScale()));
+		}
+
+		return true;
+	});
+}
+
 void ModelScalePreserver::restoreModelScale(const scene::IMapRootNodePtr& root)
 {
 	root->foreachNode([this](const scene::INodePtr& node)
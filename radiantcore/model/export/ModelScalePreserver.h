@@ -37,6 +37,11 @@ public:
     ModelScalePreserver(const ModelScalePreserver&) = delete;
     ModelScalePreserver& operator=(const ModelScalePreserver&) = delete;
 
+    // Scene snapshots (used by the auto-saver) are not emitting the export signals.
+    // This writes the modified scale of any model below the given source entity
+    // to the spawnargs of its clone.
+    static void PreserveModelScale(const scene::INodePtr& sourceEntity, Entity& clonedEntity);
+
 private:
     void forEachScaledModel(const scene::IMapRootNodePtr& root, 
         const std::function<void(Entity&, model::ModelNode&)>& func);
@@ -1,12 +1,14 @@
 #include "AseModel.h"
 
 #include <unordered_map>
+#include <string_view>
+#include <charconv>
+#include <cctype>
+#include <cstdlib>
+#include <iterator>
 #include <fmt/format.h>
-#include "parser/Tokeniser.h"
 #include "parser/ParseException.h"
-#include "string/case_conv.h"
 #include "string/trim.h"
-#include "string/convert.h"
 
 #include "render/VertexHashing.h"
 
@@ -49,6 +51,119 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 namespace model
 {
 
+namespace
+{
+
+// Case-insensitive comparison of the token against the given lowercase keyword
+inline bool isKeyword(std::string_view token, std::string_view keyword)
+{
+    if (token.size() != keyword.size()) return false;
+
+    for (std::size_t i = 0; i < token.size(); ++i)
+    {
+        if (std::tolower(static_cast<unsigned char>(token[i])) != keyword[i]) return false;
+    }
+
+    return true;
+}
+
+}
+
+/**
+ * Single-pass scanner splitting the ASE file contents into whitespace-separated
+ * tokens, which are referencing the buffer without copying it. Numbers are
+ * converted in place, any trailing characters after a number (like the colon
+ * of the face indices) are ignored, unparseable numbers evaluate to 0.
+ */
+class AseModel::Scanner
+{
+private:
+    const char* _pos;
+    const char* _end;
+
+public:
+    Scanner(const std::string& buffer) :
+        _pos(buffer.data()),
+        _end(buffer.data() + buffer.size())
+    {}
+
+    bool hasMoreTokens()
+    {
+        while (_pos != _end && isWhitespace(*_pos)) ++_pos;
+
+        return _pos != _end;
+    }
+
+    std::string_view nextToken()
+    {
+        if (!hasMoreTokens())
+        {
+            throw parser::ParseException("Tokeniser: no more tokens");
+        }
+
+        auto start = _pos;
+
+        while (_pos != _end && !isWhitespace(*_pos)) ++_pos;
+
+        return std::string_view(start, _pos - start);
+    }
+
+    void skipTokens(std::size_t numTokens)
+    {
+        while (numTokens-- > 0)
+        {
+            nextToken();
+        }
+    }
+
+    void assertNextToken(std::string_view expected)
+    {
+        auto token = nextToken();
+
+        if (token != expected)
+        {
+            throw parser::ParseException(fmt::format(
+                "Tokeniser: Assertion failed: Required \"{0}\", Found \"{1}\"", expected, token));
+        }
+    }
+
+    double nextDouble()
+    {
+        auto token = nextToken();
+        double value = 0;
+
+#if defined(__cpp_lib_to_chars)
+        if (std::from_chars(token.data(), token.data() + token.size(), value).ec != std::errc())
+        {
+            return 0;
+        }
+#else
+        // No floating point from_chars in this library, strtod stops at the whitespace after the token
+        value = std::strtod(token.data(), nullptr);
+#endif
+        return value;
+    }
+
+    std::size_t nextIndex()
+    {
+        auto token = nextToken();
+        std::size_t value = 0;
+
+        if (std::from_chars(token.data(), token.data() + token.size(), value).ec != std::errc())
+        {
+            return 0;
+        }
+
+        return value;
+    }
+
+private:
+    static bool isWhitespace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\r';
+    }
+};
+
 struct AseModel::Face
 {
     Face()
@@ -166,16 +281,15 @@ std::vector<AseModel::Surface>& AseModel::getSurfaces()
     return _surfaces;
 }
 
-void AseModel::parseMaterialList(parser::StringTokeniser& tokeniser)
+void AseModel::parseMaterialList(Scanner& scanner)
 {
     _materials.clear();
 
     int blockLevel = 0;
 
-    while (tokeniser.hasMoreTokens())
+    while (scanner.hasMoreTokens())
     {
-        auto token = tokeniser.nextToken();
-        string::to_lower(token);
+        auto token = scanner.nextToken();
 
         if (token == "}")
         {
@@ -185,26 +299,25 @@ void AseModel::parseMaterialList(parser::StringTokeniser& tokeniser)
         {
             ++blockLevel;
         }
-        else if (token == "*material_count")
+        else if (isKeyword(token, "*material_count"))
         {
             // Material count is ignored, we just add every *MATERIAL block we encounter
-            tokeniser.skipTokens(1);
+            scanner.skipTokens(1);
         }
-        else if (token == "*material")
+        else if (isKeyword(token, "*material"))
         {
             // The next token must be numeric, but we ignore it
-            string::convert<std::size_t>(tokeniser.nextToken());
+            scanner.nextIndex();
 
             auto& material = _materials.emplace_back();
 
-            tokeniser.assertNextToken("{");
+            scanner.assertNextToken("{");
             int level = 1;
 
             /* parse material block */
-            while (tokeniser.hasMoreTokens())
+            while (scanner.hasMoreTokens())
             {
-                token = tokeniser.nextToken();
-                string::to_lower(token);
+                token = scanner.nextToken();
 
                 if (token.empty()) continue;
 
@@ -215,20 +328,19 @@ void AseModel::parseMaterialList(parser::StringTokeniser& tokeniser)
                 if (level == 0) break;
 
                 /* parse material name */
-                if (token == "*material_name")
+                if (isKeyword(token, "*material_name"))
                 {
-                    material.materialName = string::trim_copy(tokeniser.nextToken(), "\"");
+                    material.materialName = string::trim_copy(std::string(scanner.nextToken()), "\"");
                 }
                 /* material diffuse map */
-                else if (token == "*map_diffuse")
+                else if (isKeyword(token, "*map_diffuse"))
                 {
                     int sublevel = 0;
 
                     /* parse material block */
-                    while (tokeniser.hasMoreTokens())
+                    while (scanner.hasMoreTokens())
                     {
-                        token = tokeniser.nextToken();
-                        string::to_lower(token);
+                        token = scanner.nextToken();
 
                         if (token.empty()) continue;
 
@@ -239,30 +351,30 @@ void AseModel::parseMaterialList(parser::StringTokeniser& tokeniser)
                         if (sublevel == 0) break;
 
                         /* parse diffuse map bitmap */
-                        if (token == "*bitmap")
+                        if (isKeyword(token, "*bitmap"))
                         {
-                            material.diffuseBitmap = string::trim_copy(tokeniser.nextToken(), "\"");
+                            material.diffuseBitmap = string::trim_copy(std::string(scanner.nextToken()), "\"");
                         }
-                        else if (token == "*uvw_u_offset")
+                        else if (isKeyword(token, "*uvw_u_offset"))
                         {
                             // Negate the u offset value
-                            material.uOffset = -string::convert<float>(tokeniser.nextToken());
+                            material.uOffset = -static_cast<float>(scanner.nextDouble());
                         }
-                        else if (token == "*uvw_v_offset")
+                        else if (isKeyword(token, "*uvw_v_offset"))
                         {
-                            material.vOffset = string::convert<float>(tokeniser.nextToken());
+                            material.vOffset = static_cast<float>(scanner.nextDouble());
                         }
-                        else if (token == "*uvw_u_tiling")
+                        else if (isKeyword(token, "*uvw_u_tiling"))
                         {
-                            material.uTiling = string::convert<float>(tokeniser.nextToken());
+                            material.uTiling = static_cast<float>(scanner.nextDouble());
                         }
-                        else if (token == "*uvw_v_tiling")
+                        else if (isKeyword(token, "*uvw_v_tiling"))
                         {
-                            material.vTiling = string::convert<float>(tokeniser.nextToken());
+                            material.vTiling = static_cast<float>(scanner.nextDouble());
                         }
-                        else if (token == "*uvw_angle")
+                        else if (isKeyword(token, "*uvw_angle"))
                         {
-                            material.uvAngle = string::convert<float>(tokeniser.nextToken());
+                            material.uvAngle = static_cast<float>(scanner.nextDouble());
                         }
                     }
                 } // end map_diffuse block
@@ -271,17 +383,17 @@ void AseModel::parseMaterialList(parser::StringTokeniser& tokeniser)
     }
 }
 
-void AseModel::parseFaceNormals(Mesh& mesh, parser::StringTokeniser& tokeniser)
+void AseModel::parseFaceNormals(Mesh& mesh, Scanner& scanner)
 {
     // *MESH_FACENORMAL 0   -1.0000   0.0000  0.0000
     
     // Get the face index from this keyword, disregard the normal itself
-    auto faceIndex = string::convert<std::size_t>(tokeniser.nextToken());
+    auto faceIndex = scanner.nextIndex();
 
     if (faceIndex >= mesh.faces.size()) throw parser::ParseException("MESH_FACENORMAL index out of bounds >= MESH_NUMFACES");
     if (faceIndex * 3 + 2 >= mesh.normals.size()) throw parser::ParseException("Not enough normals allocated < 3*MESH_NUMFACES");
 
-    tokeniser.skipTokens(3); // skip the 3 face normal components
+    scanner.skipTokens(3); // skip the 3 face normal components
 
     auto& face = mesh.faces[faceIndex];
 
@@ -289,7 +401,7 @@ void AseModel::parseFaceNormals(Mesh& mesh, parser::StringTokeniser& tokeniser)
     for (int i = 0; i < 3; ++i)
     {
         // model mesh vertex normal
-        if (string::to_lower_copy(tokeniser.nextToken()) != "*mesh_vertexnormal")
+        if (!isKeyword(scanner.nextToken(), "*mesh_vertexnormal"))
         {
             throw parser::ParseException("Expected three *MESH_VERTEXNORMAL after *MESH_FACENORMAL");
         }
@@ -297,7 +409,7 @@ void AseModel::parseFaceNormals(Mesh& mesh, parser::StringTokeniser& tokeniser)
         // *MESH_VERTEXNORMAL 1  -1.0000  0.0000  0.0000
 
         // Validate the index, just in case
-        auto index = string::convert<std::size_t>(tokeniser.nextToken());
+        auto index = scanner.nextIndex();
         if (index >= mesh.vertices.size()) throw parser::ParseException("MESH_VERTEXNORMAL index out of bounds >= MESH_NUMVERTEX");
 
         // Parse the normal and add it to the pile (don't bother checking for duplicates)
@@ -305,9 +417,9 @@ void AseModel::parseFaceNormals(Mesh& mesh, parser::StringTokeniser& tokeniser)
 
         auto& normal = mesh.normals[normalIndex];
 
-        normal.x() = string::convert<double>(tokeniser.nextToken());
-        normal.y() = string::convert<double>(tokeniser.nextToken());
-        normal.z() = string::convert<double>(tokeniser.nextToken());
+        normal.x() = scanner.nextDouble();
+        normal.y() = scanner.nextDouble();
+        normal.z() = scanner.nextDouble();
 
         // To keep the same winding order, look up the [0..2] index by matching the normal index
         // against what is already stored in the face.vertexIndices array.
@@ -330,14 +442,13 @@ void AseModel::parseFaceNormals(Mesh& mesh, parser::StringTokeniser& tokeniser)
     }
 }
 
-void AseModel::parseMesh(Mesh& mesh, parser::StringTokeniser& tokeniser)
+void AseModel::parseMesh(Mesh& mesh, Scanner& scanner)
 {
     int blockLevel = 0;
 
-    while (tokeniser.hasMoreTokens())
+    while (scanner.hasMoreTokens())
     {
-        auto token = tokeniser.nextToken();
-        string::to_lower(token);
+        auto token = scanner.nextToken();
 
         if (token == "}")
         {
@@ -347,65 +458,65 @@ void AseModel::parseMesh(Mesh& mesh, parser::StringTokeniser& tokeniser)
         {
             ++blockLevel;
         }
-        else if (token == "*mesh_numvertex")
+        else if (isKeyword(token, "*mesh_numvertex"))
         {
             // Parse the number to allocate space in the vertex vector
-            auto numVertices = string::convert<std::size_t>(tokeniser.nextToken());
+            auto numVertices = scanner.nextIndex();
             mesh.vertices.resize(numVertices);
         }
-        else if (token == "*mesh_numfaces")
+        else if (isKeyword(token, "*mesh_numfaces"))
         {
-            auto numFaces = string::convert<std::size_t>(tokeniser.nextToken());
+            auto numFaces = scanner.nextIndex();
             mesh.faces.resize(numFaces);
 
             // We will get 3 vertex normals per face, make room for that
             mesh.normals.resize(numFaces * 3);
         }
-        else if (token == "*mesh_numtvertex")
+        else if (isKeyword(token, "*mesh_numtvertex"))
         {
-            auto numTextureVertices = string::convert<std::size_t>(tokeniser.nextToken());
+            auto numTextureVertices = scanner.nextIndex();
             mesh.texcoords.resize(numTextureVertices);
         }
-        else if (token == "*mesh_numcvertex")
+        else if (isKeyword(token, "*mesh_numcvertex"))
         {
-            auto numColorVertices = string::convert<std::size_t>(tokeniser.nextToken());
+            auto numColorVertices = scanner.nextIndex();
             mesh.colours.resize(numColorVertices, Vector3(1.0, 1.0, 1.0));
         }
         /* model mesh vertex */
-        else if (token == "*mesh_vertex")
+        else if (isKeyword(token, "*mesh_vertex"))
         {
-            auto index = string::convert<std::size_t>(tokeniser.nextToken());
+            auto index = scanner.nextIndex();
 
             if (index >= mesh.vertices.size()) throw parser::ParseException("MESH_VERTEX index out of bounds >= MESH_NUMVERTEX");
 
             auto& vertex = mesh.vertices[index];
-            vertex.x() = string::convert<double>(tokeniser.nextToken());
-            vertex.y() = string::convert<double>(tokeniser.nextToken());
-            vertex.z() = string::convert<double>(tokeniser.nextToken());
+            vertex.x() = scanner.nextDouble();
+            vertex.y() = scanner.nextDouble();
+            vertex.z() = scanner.nextDouble();
         }
-        else if (token == "*mesh_facenormal")
+        else if (isKeyword(token, "*mesh_facenormal"))
         {
-            parseFaceNormals(mesh, tokeniser);
+            parseFaceNormals(mesh, scanner);
         }
         /* model mesh face */
-        else if (token == "*mesh_face")
+        else if (isKeyword(token, "*mesh_face"))
         {
             // *MESH_FACE    0:    A:    3 B:    1 C:    2 [AB:    0 BC:    0 CA:    0]	 [*MESH_SMOOTHING 0]	 *MESH_MTLID 0
-            auto index = string::convert<std::size_t>(string::trim_right_copy(tokeniser.nextToken(), ":"));
+            auto index = scanner.nextIndex(); // the trailing colon is ignored
 
             if (index >= mesh.faces.size()) throw parser::ParseException("MESH_FACE index out of bounds >= MESH_NUMFACES");
 
             auto& face = mesh.faces[index];
 
             // Note: we're reversing the winding to get CW ordering
-            tokeniser.assertNextToken("A:");
-            face.vertexIndices[2] = string::convert<std::size_t>(tokeniser.nextToken());
+            scanner.assertNextToken("A:");
+            face.vertexIndices[2] = scanner.nextIndex();
 
-            tokeniser.assertNextToken("B:");
-            face.vertexIndices[1] = string::convert<std::size_t>(tokeniser.nextToken());
+            scanner.assertNextToken("B:");
+            face.vertexIndices[1] = scanner.nextIndex();
 
-            tokeniser.assertNextToken("C:");
-            face.vertexIndices[0] = string::convert<std::size_t>(tokeniser.nextToken());
+            scanner.assertNextToken("C:");
+            face.vertexIndices[0] = scanner.nextIndex();
 
             if (face.vertexIndices[2] >= mesh.vertices.size()) throw parser::ParseException("MESH_FACE vertex index 0 out of bounds >= MESH_NUMFACES");
             if (face.vertexIndices[1] >= mesh.vertices.size()) throw parser::ParseException("MESH_FACE vertex index 1 out of bounds >= MESH_NUMFACES");
@@ -415,64 +526,64 @@ void AseModel::parseMesh(Mesh& mesh, parser::StringTokeniser& tokeniser)
             // and let the outer loop deal with any keywords that might follow or might not follow
         }
         /* model texture vertex */
-        else if (token == "*mesh_tvert")
+        else if (isKeyword(token, "*mesh_tvert"))
         {
-            auto index = string::convert<std::size_t>(tokeniser.nextToken());
+            auto index = scanner.nextIndex();
 
             if (index >= mesh.texcoords.size()) throw parser::ParseException("MESH_TVERT index out of bounds >= MESH_NUMTVERTEX");
 
             auto& texcoord = mesh.texcoords[index];
-            texcoord.x() = string::convert<double>(tokeniser.nextToken());
+            texcoord.x() = scanner.nextDouble();
             /* ydnar: invert t */
-            texcoord.y() = 1.0 - string::convert<double>(tokeniser.nextToken());
+            texcoord.y() = 1.0 - scanner.nextDouble();
             // ignore the third texcoord value
-            tokeniser.nextToken();
+            scanner.nextToken();
         }
         /* ydnar: model mesh texture face */
-        else if (token == "*mesh_tface")
+        else if (isKeyword(token, "*mesh_tface"))
         {
             // *MESH_TFACE 0    0   1   2
-            auto index = string::convert<std::size_t>(tokeniser.nextToken());
+            auto index = scanner.nextIndex();
 
             if (index >= mesh.faces.size()) throw parser::ParseException("MESH_TFACE index out of bounds >= MESH_NUMFACES");
 
             auto& face = mesh.faces[index];
 
             // Reverse the winding order
-            face.texcoordIndices[2] = string::convert<std::size_t>(tokeniser.nextToken());
-            face.texcoordIndices[1] = string::convert<std::size_t>(tokeniser.nextToken());
-            face.texcoordIndices[0] = string::convert<std::size_t>(tokeniser.nextToken());
+            face.texcoordIndices[2] = scanner.nextIndex();
+            face.texcoordIndices[1] = scanner.nextIndex();
+            face.texcoordIndices[0] = scanner.nextIndex();
 
             if (face.texcoordIndices[2] >= mesh.texcoords.size()) throw parser::ParseException("MESH_TFACE texcoord index 0 out of bounds >= MESH_NUMTVERTEX");
             if (face.texcoordIndices[1] >= mesh.texcoords.size()) throw parser::ParseException("MESH_TFACE texcoord index 1 out of bounds >= MESH_NUMTVERTEX");
             if (face.texcoordIndices[0] >= mesh.texcoords.size()) throw parser::ParseException("MESH_TFACE texcoord index 2 out of bounds >= MESH_NUMTVERTEX");
         }
         /* model color vertex */
-        else if (token == "*mesh_vertcol")
+        else if (isKeyword(token, "*mesh_vertcol"))
         {
-            auto index = string::convert<std::size_t>(tokeniser.nextToken());
+            auto index = scanner.nextIndex();
 
             if (index >= mesh.colours.size()) throw parser::ParseException("MESH_VERTCOL index out of bounds >= MESH_NUMCVERTEX");
 
             auto& colour = mesh.colours[index];
-            colour.x() = string::convert<double>(tokeniser.nextToken());
-            colour.y() = string::convert<double>(tokeniser.nextToken());
-            colour.z() = string::convert<double>(tokeniser.nextToken());
+            colour.x() = scanner.nextDouble();
+            colour.y() = scanner.nextDouble();
+            colour.z() = scanner.nextDouble();
         }
         /* model color face */
-        else if (token == "*mesh_cface")
+        else if (isKeyword(token, "*mesh_cface"))
         {
             // *MESH_CFACE 0    0   1   2
-            auto index = string::convert<std::size_t>(tokeniser.nextToken());
+            auto index = scanner.nextIndex();
 
             if (index >= mesh.faces.size()) throw parser::ParseException("MESH_CFACE index out of bounds >= MESH_NUMFACES");
 
             auto& face = mesh.faces[index];
 
             // Reverse the winding order
-            face.colourIndices[2] = string::convert<std::size_t>(tokeniser.nextToken());
-            face.colourIndices[1] = string::convert<std::size_t>(tokeniser.nextToken());
-            face.colourIndices[0] = string::convert<std::size_t>(tokeniser.nextToken());
+            face.colourIndices[2] = scanner.nextIndex();
+            face.colourIndices[1] = scanner.nextIndex();
+            face.colourIndices[0] = scanner.nextIndex();
 
             if (face.colourIndices[2] >= mesh.colours.size()) throw parser::ParseException("MESH_CFACE colour index 0 out of bounds >= MESH_NUMCVERTEX");
             if (face.colourIndices[1] >= mesh.colours.size()) throw parser::ParseException("MESH_CFACE colour index 1 out of bounds >= MESH_NUMCVERTEX");
@@ -481,16 +592,15 @@ void AseModel::parseMesh(Mesh& mesh, parser::StringTokeniser& tokeniser)
     }
 }
 
-void AseModel::parseNodeMatrix(Matrix4& matrix, parser::StringTokeniser& tokeniser)
+void AseModel::parseNodeMatrix(Matrix4& matrix, Scanner& scanner)
 {
     int blockLevel = 0;
 
     // We parse the rows in the ASE file into the columns of the matrix
     // to be able to just use Matrix4::transformDirection() to transform the normal
-    while (tokeniser.hasMoreTokens())
+    while (scanner.hasMoreTokens())
     {
-        auto token = tokeniser.nextToken();
-        string::to_lower(token);
+        auto token = scanner.nextToken();
 
         if (token == "}")
         {
@@ -500,29 +610,29 @@ void AseModel::parseNodeMatrix(Matrix4& matrix, parser::StringTokeniser& tokenis
         {
             ++blockLevel;
         }
-        else if (token == "*tm_row0")
+        else if (isKeyword(token, "*tm_row0"))
         {
-            matrix.xx() = string::convert<double>(tokeniser.nextToken());
-            matrix.xy() = string::convert<double>(tokeniser.nextToken());
-            matrix.xz() = string::convert<double>(tokeniser.nextToken());
+            matrix.xx() = scanner.nextDouble();
+            matrix.xy() = scanner.nextDouble();
+            matrix.xz() = scanner.nextDouble();
         }
-        else if (token == "*tm_row1")
+        else if (isKeyword(token, "*tm_row1"))
         {
-            matrix.yx() = string::convert<double>(tokeniser.nextToken());
-            matrix.yy() = string::convert<double>(tokeniser.nextToken());
-            matrix.yz() = string::convert<double>(tokeniser.nextToken());
+            matrix.yx() = scanner.nextDouble();
+            matrix.yy() = scanner.nextDouble();
+            matrix.yz() = scanner.nextDouble();
         }
-        else if (token == "*tm_row2")
+        else if (isKeyword(token, "*tm_row2"))
         {
-            matrix.zx() = string::convert<double>(tokeniser.nextToken());
-            matrix.zy() = string::convert<double>(tokeniser.nextToken());
-            matrix.zz() = string::convert<double>(tokeniser.nextToken());
+            matrix.zx() = scanner.nextDouble();
+            matrix.zy() = scanner.nextDouble();
+            matrix.zz() = scanner.nextDouble();
         }
         // The fourth row *TM_ROW3 is ignored, translations are not applicable to normals
     }
 }
 
-void AseModel::parseGeomObject(parser::StringTokeniser& tokeniser)
+void AseModel::parseGeomObject(Scanner& scanner)
 {
     Mesh mesh;
     Matrix4 nodeMatrix = Matrix4::getIdentity();
@@ -531,10 +641,9 @@ void AseModel::parseGeomObject(parser::StringTokeniser& tokeniser)
 
     int blockLevel = 0;
 
-    while (tokeniser.hasMoreTokens())
+    while (scanner.hasMoreTokens())
     {
-        auto token = tokeniser.nextToken();
-        string::to_lower(token);
+        auto token = scanner.nextToken();
 
         if (token == "}")
         {
@@ -544,23 +653,23 @@ void AseModel::parseGeomObject(parser::StringTokeniser& tokeniser)
         {
             ++blockLevel;
         }
-        else if (token == "*mesh")
+        else if (isKeyword(token, "*mesh"))
         {
-            parseMesh(mesh, tokeniser);
+            parseMesh(mesh, scanner);
         }
-        else if (token == "*node_tm")
+        else if (isKeyword(token, "*node_tm"))
         {
             // The NODE_TM block is parsed by the engine and applied to the
             // normals of the mesh.
-            parseNodeMatrix(nodeMatrix, tokeniser);
+            parseNodeMatrix(nodeMatrix, scanner);
         }
         /* Optional: mesh material reference. This usually comes at the end of
          * geomobjects after the mesh blocks. we must assume that the
          * new mesh was already created so all we can do here is assign
          * the material reference id (shader index) now. */
-        else if (token == "*material_ref")
+        else if (isKeyword(token, "*material_ref"))
         {
-            auto index = string::convert<std::size_t>(tokeniser.nextToken());
+            auto index = scanner.nextIndex();
 
             if (index >= _materials.size()) throw parser::ParseException("MATERIAL_REF index out of bounds >= MATERIAL_COUNT");
 
@@ -571,17 +680,16 @@ void AseModel::parseGeomObject(parser::StringTokeniser& tokeniser)
     finishSurface(mesh, materialIndex, nodeMatrix);
 }
 
-void AseModel::parseFromTokens(parser::StringTokeniser& tokeniser)
+void AseModel::parseFromTokens(Scanner& scanner)
 {
-    if (string::to_lower_copy(tokeniser.nextToken()) != "*3dsmax_asciiexport")
+    if (!isKeyword(scanner.nextToken(), "*3dsmax_asciiexport"))
     {
         throw parser::ParseException("Missing 3DSMAX_ASCIIEXPORT header");
     }
 
-    while (tokeniser.hasMoreTokens())
+    while (scanner.hasMoreTokens())
     {
-        auto token = tokeniser.nextToken();
-        string::to_lower(token);
+        auto token = scanner.nextToken();
 
         // skip invalid ase statements
         if (token[0] != '*' && token[0] != '{' && token[0] != '}')
@@ -589,13 +697,13 @@ void AseModel::parseFromTokens(parser::StringTokeniser& tokeniser)
             continue;
         }
 
-        if (token == "*material_list")
+        if (isKeyword(token, "*material_list"))
         {
-            parseMaterialList(tokeniser);
+            parseMaterialList(scanner);
         }
-        else if (token== "*geomobject")
+        else if (isKeyword(token, "*geomobject"))
         {
-            parseGeomObject(tokeniser);
+            parseGeomObject(scanner);
         }
     }
 }
@@ -604,8 +712,11 @@ std::shared_ptr<AseModel> AseModel::CreateFromStream(std::istream& stream)
 {
     auto model = std::make_shared<AseModel>();
 
-    parser::BasicStringTokeniser tokeniser(stream);
-    model->parseFromTokens(tokeniser);
+    // Read the whole file at once, the scanner is working on the contents in memory
+    std::string buffer(std::istreambuf_iterator<char>(stream), {});
+
+    Scanner scanner(buffer);
+    model->parseFromTokens(scanner);
 
     return model;
 }
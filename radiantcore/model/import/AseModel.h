@@ -3,7 +3,6 @@
 #include <istream>
 #include "math/Matrix4.h"
 #include "../StaticModelSurface.h"
-#include "parser/Tokeniser.h"
 
 namespace model
 {
@@ -27,6 +26,8 @@ private:
 
     struct Face;
 
+    class Scanner;
+
     struct Mesh
     {
         std::vector<Vertex3f> vertices;
@@ -63,13 +64,13 @@ public:
     static std::shared_ptr<AseModel> CreateFromStream(std::istream& stream);
 
 private:
-    void parseFromTokens(parser::StringTokeniser& tokeniser);
+    void parseFromTokens(Scanner& scanner);
 
-    void parseMaterialList(parser::StringTokeniser& tokeniser);
-    void parseGeomObject(parser::StringTokeniser& tokeniser);
-    void parseFaceNormals(Mesh& mesh, parser::StringTokeniser& tokeniser);
-    void parseMesh(Mesh& mesh, parser::StringTokeniser& tokeniser);
-    void parseNodeMatrix(Matrix4& matrix, parser::StringTokeniser& tokeniser);
+    void parseMaterialList(Scanner& scanner);
+    void parseGeomObject(Scanner& scanner);
+    void parseFaceNormals(Mesh& mesh, Scanner& scanner);
+    void parseMesh(Mesh& mesh, Scanner& scanner);
+    void parseNodeMatrix(Matrix4& matrix, Scanner& scanner);
 
     void finishSurface(Mesh& mesh, std::size_t materialIndex, const Matrix4& nodeMatrix);
 };
@@ -33,16 +33,27 @@ const std::string& ModelImporterBase::getExtension() const
     return _extension;
 }
 
-scene::INodePtr ModelImporterBase::loadModel(const std::string& modelName)
+std::string ModelImporterBase::getModelCachePath(const std::string& modelName) const
 {
     // Initialise the paths, this is all needed for realisation
     std::string path = rootPath(modelName);
-    std::string name = os::getRelativePath(modelName, path);
 
     // greebo: Path is empty for models in PK4 files, don't check this
+    return os::getRelativePath(modelName, path);
+}
+
+std::function<IModelPtr()> ModelImporterBase::getBackgroundLoadFunc(const std::string& path)
+{
+    return [this, path]() { return loadModelFromPath(path); };
+}
+
+void ModelImporterBase::finishBackgroundLoad(const IModelPtr& model)
+{}
 
+scene::INodePtr ModelImporterBase::loadModel(const std::string& modelName)
+{
     // Try to load the model from the given VFS path
-    IModelPtr model = GlobalModelCache().getModel(name);
+    IModelPtr model = GlobalModelCache().getModel(getModelCachePath(modelName));
 
     if (!model)
     {
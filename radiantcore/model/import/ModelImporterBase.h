@@ -1,6 +1,7 @@
 #pragma once
 
 #include "imodel.h"
+#include <functional>
 
 namespace model
 {
@@ -19,6 +20,18 @@ public:
 
     // Returns a new ModelNode for the given model name
     scene::INodePtr loadModel(const std::string& modelName) override;
+
+    // Returns the path loadModel() is using to look up the model in the cache
+    std::string getModelCachePath(const std::string& modelName) const;
+
+    // Returns a function loading the given model on a worker thread. This is called
+    // on the main thread, any settings the load depends on are read right here.
+    // The default implementation is calling loadModelFromPath().
+    virtual std::function<IModelPtr()> getBackgroundLoadFunc(const std::string& path);
+
+    // Completes a model returned by the background load function, this is called
+    // on the main thread before the model is inserted into the cache.
+    virtual void finishBackgroundLoad(const IModelPtr& model);
 };
 
 }
@@ -1,11 +1,72 @@
 #include "MD5Anim.h"
 
+#include <cstdlib>
 #include "itextstream.h"
 #include "string/convert.h"
 
 namespace md5
 {
 
+namespace
+{
+	// greebo: this code has been mostly taken from the web, with some additional fixes on my behalf and the D3 SDK
+	inline Quaternion slerp(const Quaternion& qa, const Quaternion& qb, float fraction)
+	{
+		// quaternion to return
+		Quaternion qm;
+
+		// Calculate angle between them.
+		double cosHalfTheta = qa.w() * qb.w() + qa.x() * qb.x() + qa.y() * qb.y() + qa.z() * qb.z();
+
+		// if qa=qb or qa=-qb then theta = 0 and we can return qa
+        if (std::abs(cosHalfTheta) > 1.0)
+		{
+ 			return qb;
+		}
+
+		// greebo: I spotted this fix in the D3 SDK - sometimes we run into rotations
+		// of theta being almost 2*pi which can lead to huge rotational steps (~90 degrees)
+		// in a single frame - use this to rectify that.
+		Quaternion temp;
+
+		if (cosHalfTheta < 0.0)
+		{
+			temp = qb*(-1);
+			cosHalfTheta = -cosHalfTheta;
+		} 
+		else
+		{
+			temp = qb;
+		}
+
+		// Calculate temporary values.
+		double halfTheta = acos(cosHalfTheta);
+		double sinHalfTheta = sqrt(1.0 - cosHalfTheta*cosHalfTheta);
+
+		// if theta = 180 degrees then result is not fully defined
+		// we could rotate around any axis normal to qa or qb
+		if (fabs(sinHalfTheta) < 0.006)
+		{ 
+			qm.w() = (qa.w() * (1-fraction) + temp.w() * fraction);
+			qm.x() = (qa.x() * (1-fraction) + temp.x() * fraction);
+			qm.y() = (qa.y() * (1-fraction) + temp.y() * fraction);
+			qm.z() = (qa.z() * (1-fraction) + temp.z() * fraction);
+			return qm;
+		}
+
+		double ratioA = sin((1 - fraction) * halfTheta) / sinHalfTheta;
+		double ratioB = sin(fraction * halfTheta) / sinHalfTheta;
+
+		//calculate Quaternion.
+		qm.w() = (qa.w() * ratioA + temp.w() * ratioB);
+		qm.x() = (qa.x() * ratioA + temp.x() * ratioB);
+		qm.y() = (qa.y() * ratioA + temp.y() * ratioB);
+		qm.z() = (qa.z() * ratioA + temp.z() * ratioB);
+
+		return qm;
+	}
+}
+
 MD5Anim::MD5Anim() :
 	_frameRate(0),
 	_numAnimatedComponents(0)
@@ -188,6 +249,8 @@ void MD5Anim::parseFromTokens(parser::DefTokeniser& tok)
 		{
 			parseFrame(i, tok);
 		}
+
+		decodeFramePoses();
 	}
 	catch (parser::ParseException& ex)
 	{
@@ -195,4 +258,186 @@ void MD5Anim::parseFromTokens(parser::DefTokeniser& tok)
 	}
 }
 
+void MD5Anim::FramePoses::resize(std::size_t size)
+{
+	originX.resize(size);
+	originY.resize(size);
+	originZ.resize(size);
+	orientationX.resize(size);
+	orientationY.resize(size);
+	orientationZ.resize(size);
+	orientationW.resize(size);
+}
+
+void MD5Anim::decodeFramePoses()
+{
+	std::size_t numJoints = _joints.size();
+
+	_framePoses.resize(_frames.size() * numJoints);
+
+	for (std::size_t frame = 0; frame < _frames.size(); ++frame)
+	{
+		const FrameKeys& keys = _frames[frame];
+
+		for (std::size_t i = 0; i < numJoints; ++i)
+		{
+			const Joint& joint = _joints[i];
+
+			// Start with the base frame, the frame keys override the animated components
+			Vector3 origin = _baseFrame[i].origin;
+			Quaternion orientation = _baseFrame[i].orientation;
+
+			// The joint.firstKey member holds the offset into the frame data array
+			std::size_t key = joint.firstKey;
+
+			if (joint.animComponents & Joint::X) origin.x() = keys[key++];
+			if (joint.animComponents & Joint::Y) origin.y() = keys[key++];
+			if (joint.animComponents & Joint::Z) origin.z() = keys[key++];
+			if (joint.animComponents & Joint::YAW) orientation.x() = keys[key++];
+			if (joint.animComponents & Joint::PITCH) orientation.y() = keys[key++];
+			if (joint.animComponents & Joint::ROLL) orientation.z() = keys[key++];
+
+			if (joint.animComponents & (Joint::YAW | Joint::PITCH | Joint::ROLL))
+			{
+				// Calculate the fourth component of the quaternion
+				auto lSq = orientation.getVector3().getLengthSquared();
+				auto w = -sqrt(1.0 - lSq);
+
+				orientation.w() = isNaN(w) ? 0 : w;
+			}
+
+			std::size_t index = frame * numJoints + i;
+
+			_framePoses.originX[index] = static_cast<float>(origin.x());
+			_framePoses.originY[index] = static_cast<float>(origin.y());
+			_framePoses.originZ[index] = static_cast<float>(origin.z());
+			_framePoses.orientationX[index] = static_cast<float>(orientation.x());
+			_framePoses.orientationY[index] = static_cast<float>(orientation.y());
+			_framePoses.orientationZ[index] = static_cast<float>(orientation.z());
+			_framePoses.orientationW[index] = static_cast<float>(orientation.w());
+		}
+	}
+}
+
+IMD5Anim::PosePtr MD5Anim::getPose(std::size_t time) const
+{
+	std::lock_guard<std::mutex> lock(_poseCacheLock);
+
+	auto found = _cachedPosesByTime.find(time);
+
+	if (found != _cachedPosesByTime.end())
+	{
+		// Move the pose to the front of the list, it's the most recently used one now
+		_cachedPoses.splice(_cachedPoses.begin(), _cachedPoses, found->second);
+		return found->second->second;
+	}
+
+	auto pose = calculatePose(time);
+
+	_cachedPoses.emplace_front(time, pose);
+	_cachedPosesByTime[time] = _cachedPoses.begin();
+
+	if (_cachedPoses.size() > MAX_CACHED_POSES)
+	{
+		_cachedPosesByTime.erase(_cachedPoses.back().first);
+		_cachedPoses.pop_back();
+	}
+
+	return pose;
+}
+
+IMD5Anim::PosePtr MD5Anim::calculatePose(std::size_t time) const
+{
+	std::size_t numJoints = _joints.size();
+	std::size_t numFrames = _frames.size();
+
+	auto pose = std::make_shared<Pose>(numJoints);
+
+	if (_frameRate <= 0 || numFrames == 0 || _framePoses.originX.size() != numFrames * numJoints)
+	{
+		// Nothing to interpolate (the anim failed to parse), stick to the base frame
+		for (std::size_t i = 0; i < numJoints; ++i)
+		{
+			(*pose)[i] = _baseFrame[i];
+		}
+	}
+	else
+	{
+		// Calculate the current frame number
+		float timePerFrameMsec = 1000 / static_cast<float>(_frameRate);
+
+		float frameTime = time / timePerFrameMsec;
+
+		// Pre-calculate the weighting of each frame
+		float nextFrameFrac = float_mod(frameTime, 1.0f);
+		float curFrameFrac = 1.0f - nextFrameFrac;
+
+		std::size_t curFrame = static_cast<std::size_t>(std::floor(frameTime)) % numFrames;
+		std::size_t nextFrame = curFrame == numFrames - 1 ? curFrame : (curFrame + 1) % numFrames;
+
+		const FramePoses& poses = _framePoses;
+		std::size_t cur = curFrame * numJoints;
+		std::size_t next = nextFrame * numJoints;
+
+		for (std::size_t i = 0; i < numJoints; ++i)
+		{
+			(*pose)[i].origin = Vector3(
+				poses.originX[cur + i] * curFrameFrac + poses.originX[next + i] * nextFrameFrac,
+				poses.originY[cur + i] * curFrameFrac + poses.originY[next + i] * nextFrameFrac,
+				poses.originZ[cur + i] * curFrameFrac + poses.originZ[next + i] * nextFrameFrac
+			);
+		}
+
+		for (std::size_t i = 0; i < numJoints; ++i)
+		{
+			if (!(_joints[i].animComponents & (Joint::YAW | Joint::PITCH | Joint::ROLL)))
+			{
+				(*pose)[i].orientation = _baseFrame[i].orientation;
+				continue;
+			}
+
+			Quaternion orientation(poses.orientationX[cur + i], poses.orientationY[cur + i],
+				poses.orientationZ[cur + i], poses.orientationW[cur + i]);
+			Quaternion nextOrientation(poses.orientationX[next + i], poses.orientationY[next + i],
+				poses.orientationZ[next + i], poses.orientationW[next + i]);
+
+			(*pose)[i].orientation = slerp(orientation, nextOrientation, nextFrameFrac).getNormalised();
+		}
+	}
+
+	// Move the joints to model space, starting from the root joints
+	for (std::size_t i = 0; i < numJoints; ++i)
+	{
+		if (_joints[i].parentId == -1)
+		{
+			transformJointRecursively(*pose, i);
+		}
+	}
+
+	return pose;
+}
+
+void MD5Anim::transformJointRecursively(Pose& pose, std::size_t jointId) const
+{
+	const Joint& joint = _joints[jointId];
+
+	if (joint.parentId >= 0)
+	{
+		// Joint has a parent, update this position and rotation
+		pose[joint.id].orientation.preMultiplyBy(pose[joint.parentId].orientation);
+
+		// Transform the origin of this joint using the rotation of the parent joint
+		pose[joint.id].origin = pose[joint.parentId].orientation.transformPoint(pose[joint.id].origin);
+
+		// Apply the parent joint's translation to this child bone
+		pose[joint.id].origin += pose[joint.parentId].origin;
+	}
+
+	// Update all children as well
+	for (int child : joint.children)
+	{
+		transformJointRecursively(pose, child);
+	}
+}
+
 } // namespace
@@ -2,6 +2,9 @@
 
 #include "imd5anim.h"
 #include <vector>
+#include <list>
+#include <mutex>
+#include <unordered_map>
 #include "parser/DefTokeniser.h"
 #include "math/AABB.h"
 #include "math/Vector3.h"
@@ -34,6 +37,33 @@ private:
 	// Each frame has <numAnimatedComponents> float values
 	std::vector<FrameKeys> _frames;
 
+	// The joint-space origin and orientation of every joint in every frame,
+	// decoded from the frame keys and the base frame after parsing.
+	// Index of joint j in frame f is f * numJoints + j.
+	struct FramePoses
+	{
+		std::vector<float> originX;
+		std::vector<float> originY;
+		std::vector<float> originZ;
+		std::vector<float> orientationX;
+		std::vector<float> orientationY;
+		std::vector<float> orientationZ;
+		std::vector<float> orientationW;
+
+		void resize(std::size_t size);
+	};
+
+	FramePoses _framePoses;
+
+	// The most recently requested interpolated poses, shared by all models playing this anim
+	// The least recently used one is at the end of the list
+	static constexpr std::size_t MAX_CACHED_POSES = 32;
+
+	typedef std::list<std::pair<std::size_t, PosePtr>> PoseList;
+	mutable PoseList _cachedPoses;
+	mutable std::unordered_map<std::size_t, PoseList::iterator> _cachedPosesByTime;
+	mutable std::mutex _poseCacheLock;
+
 public:
 	MD5Anim();
 
@@ -72,9 +102,15 @@ public:
 		return _frames[index];
 	}
 
+	PosePtr getPose(std::size_t time) const override;
+
 	void parseFromStream(std::istream& stream);
 
 private:
+	void decodeFramePoses();
+	PosePtr calculatePose(std::size_t time) const;
+	void transformJointRecursively(Pose& pose, std::size_t jointId) const;
+
 	void parseFromTokens(parser::DefTokeniser& tok);
 	void parseJointHierarchy(parser::DefTokeniser& tok);
 	void parseFrameBounds(parser::DefTokeniser& tok);
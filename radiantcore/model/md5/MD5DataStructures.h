@@ -3,6 +3,7 @@
 #include <vector>
 #include "math/Vector3.h"
 #include "math/Quaternion.h"
+#include "render/MeshSkinning.h"
 
 /** greebo: Some data structures used in MD5 model code
  */
@@ -85,6 +86,10 @@ struct MD5Mesh
 	MD5Verts	vertices;
 	MD5Tris		triangles;
 	MD5Weights	weights;
+
+	// The weights in the form used by the skinning kernel, one influence per vertex
+	std::vector<render::SkinningWeight> skinningWeights;
+	std::vector<render::SkinningInfluence> skinningInfluences;
 };
 typedef std::shared_ptr<MD5Mesh> MD5MeshPtr;
 
@@ -362,6 +362,7 @@ Vector3 MD5Model::parseVector3(parser::DefTokeniser& tok) {
 void MD5Model::setAnim(const IMD5AnimPtr& anim)
 {
 	_anim = anim;
+	_skeleton.clear();
 
 	if (!_anim)
 	{
@@ -381,8 +382,8 @@ void MD5Model::updateAnim(std::size_t time)
 {
 	if (!_anim) return; // nothing to do
 
-	// Update our joint hierarchy first
-	_skeleton.update(_anim, time);
+	// Update our joint hierarchy first, the surfaces are still matching an unchanged pose
+	if (!_skeleton.update(_anim, time)) return;
 
 	for (SurfaceList::iterator i = _surfaces.begin(); i != _surfaces.end(); ++i)
 	{
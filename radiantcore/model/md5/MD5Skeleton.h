@@ -10,37 +10,41 @@ namespace md5
  * This object represents a joint hierarchy as used
  * by animated MD5 models. At any point in time
  * the joints (bones) have a defined origin and orientation.
+ *
+ * The joint poses are owned by the animation, all skeletons
+ * showing the same anim at the same time share them.
  */
 class MD5Skeleton
 {
 protected:
 	// The position and orientation of the animated joints at the current time
-	std::vector<IMD5Anim::Key> _skeleton;
+	IMD5Anim::PosePtr _pose;
 
 	// The current animation, needed to get joint information etc.
 	IMD5AnimPtr _anim;
 
 public:
-	// Update the skeleton to match the given animation at the given time
-	void update(const IMD5AnimPtr& anim, std::size_t time);
+	// Update the skeleton to match the given animation at the given time.
+	// Returns false if the joint poses didn't change.
+	bool update(const IMD5AnimPtr& anim, std::size_t time);
+
+	// Discards the current pose, the next update() will report a change
+	void clear();
 
 	std::size_t size() const
 	{
-		return _skeleton.size();
+		return _pose ? _pose->size() : 0;
 	}
 
 	const IMD5Anim::Key& getKey(std::size_t jointIndex) const
 	{
-		return _skeleton[jointIndex];
+		return (*_pose)[jointIndex];
 	}
 
 	const Joint& getJoint(std::size_t index) const
 	{
 		return _anim->getJoint(index);
 	}
-
-private:
-	void updateJointRecursively(std::size_t jointId);
 };
 
 } // namespace
@@ -4,7 +4,9 @@
 #include "GLProgramAttributes.h"
 #include "string/convert.h"
 #include "MD5Model.h"
+#include "MD5Skeleton.h"
 #include "math/Ray.h"
+#include "render/VBO.h"
 
 namespace md5
 {
@@ -18,22 +20,26 @@ inline VertexPointer vertexpointer_arbitrarymeshvertex(const ArbitraryMeshVertex
 MD5Surface::MD5Surface() :
 	_originalShaderName(""),
 	_mesh(new MD5Mesh),
-	_normalList(0),
-	_lightingList(0)
+	_verticesNeedUpdate(false),
+	_vertexBuffer(0),
+	_indexBuffer(0),
+	_buffersNeedUpdate(false)
 {}
 
 MD5Surface::MD5Surface(const MD5Surface& other) :
 	_aabb_local(other._aabb_local),
 	_originalShaderName(other._originalShaderName),
 	_mesh(other._mesh),
-	_normalList(0),
-	_lightingList(0)
+	_verticesNeedUpdate(false),
+	_vertexBuffer(0),
+	_indexBuffer(0),
+	_buffersNeedUpdate(false)
 {}
 
 // Destructor
 MD5Surface::~MD5Surface()
 {
-    releaseDisplayLists();
+    releaseBuffers();
 }
 
 // Update geometry
@@ -41,117 +47,109 @@ void MD5Surface::updateGeometry()
 {
 	_aabb_local = AABB();
 
-	for (Vertices::const_iterator i = _vertices.begin(); i != _vertices.end(); ++i)
+	for (const auto& vertex : _skinnedVertices)
 	{
-		_aabb_local.includePoint(i->vertex);
+		_aabb_local.includePoint(Vector3(vertex.vertex[0], vertex.vertex[1], vertex.vertex[2]));
 	}
 
-	for (Indices::iterator i = _indices.begin();
-		 i != _indices.end();
-		 i += 3)
-	{
-		ArbitraryMeshVertex& a = _vertices[*(i + 0)];
-		ArbitraryMeshVertex& b = _vertices[*(i + 1)];
-		ArbitraryMeshVertex& c = _vertices[*(i + 2)];
-
-		ArbitraryMeshTriangle_sumTangents(a, b, c);
-	}
-
-	for (Vertices::iterator i = _vertices.begin();
-		 i != _vertices.end();
-		 ++i)
-	{
-		i->tangent.normalise();
-		i->bitangent.normalise();
-	}
-
-	// Build the display lists
-	createDisplayLists();
+	_verticesNeedUpdate = true;
+	_buffersNeedUpdate = true;
 }
 
 // Back-end render
 void MD5Surface::render(const RenderInfo& info) const
 {
+	if (_skinnedVertices.empty() || _indices.empty())
+	{
+		return;
+	}
+
+	ensureBuffers();
+
+	glBindBuffer(GL_ARRAY_BUFFER, _vertexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBuffer);
+
+	const GLsizei stride = sizeof(render::SkinnedVertex);
+
+	glVertexPointer(3, GL_FLOAT, stride, reinterpret_cast<const GLvoid*>(offsetof(render::SkinnedVertex, vertex)));
+
 	if (info.checkFlag(RENDER_BUMP))
     {
-		glCallList(_lightingList);
+		// Lighting mode, submit normals, tangents and texcoords to the shader program
+		glVertexAttribPointer(ATTR_TEXCOORD, 2, GL_FLOAT, GL_FALSE, stride,
+			reinterpret_cast<const GLvoid*>(offsetof(render::SkinnedVertex, texcoord)));
+		glVertexAttribPointer(ATTR_TANGENT, 3, GL_FLOAT, GL_FALSE, stride,
+			reinterpret_cast<const GLvoid*>(offsetof(render::SkinnedVertex, tangent)));
+		glVertexAttribPointer(ATTR_BITANGENT, 3, GL_FLOAT, GL_FALSE, stride,
+			reinterpret_cast<const GLvoid*>(offsetof(render::SkinnedVertex, bitangent)));
+		glVertexAttribPointer(ATTR_NORMAL, 3, GL_FLOAT, GL_FALSE, stride,
+			reinterpret_cast<const GLvoid*>(offsetof(render::SkinnedVertex, normal)));
 	}
 	else
     {
-		glCallList(_normalList);
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		glTexCoordPointer(2, GL_FLOAT, stride, reinterpret_cast<const GLvoid*>(offsetof(render::SkinnedVertex, texcoord)));
+		glNormalPointer(GL_FLOAT, stride, reinterpret_cast<const GLvoid*>(offsetof(render::SkinnedVertex, normal)));
 	}
-}
 
-// Construct the display lists
-void MD5Surface::createDisplayLists()
-{
-    // Release old display lists first
-    releaseDisplayLists();
+	glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(_indices.size()), RenderIndexTypeID, nullptr);
 
-	// Create the list for lighting mode
-	_lightingList = glGenLists(1);
-	assert(_lightingList != 0);
-	glNewList(_lightingList, GL_COMPILE);
-
-	glBegin(GL_TRIANGLES);
-	for (Indices::const_iterator i = _indices.begin();
-		 i != _indices.end();
-		 ++i)
+	if (!info.checkFlag(RENDER_BUMP))
 	{
-		// Get the vertex for this index
-		ArbitraryMeshVertex& v = _vertices[*i];
-
-		// Submit the vertex attributes and coordinate
-		if (GLEW_ARB_vertex_program) {
-			// Submit the vertex attributes and coordinate
-			glVertexAttrib2dvARB(ATTR_TEXCOORD, v.texcoord);
-			glVertexAttrib3dvARB(ATTR_TANGENT, v.tangent);
-			glVertexAttrib3dvARB(ATTR_BITANGENT, v.bitangent);
-			glVertexAttrib3dvARB(ATTR_NORMAL, v.normal);
-		}
-		glVertex3dv(v.vertex);
+		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
 	}
-	glEnd();
-
-	glEndList();
 
-	// Generate the list for flat-shaded (unlit) mode
-	_normalList = glGenLists(1);
-	assert(_normalList != 0);
-	glNewList(_normalList, GL_COMPILE);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
 
-	glBegin(GL_TRIANGLES);
-	for (Indices::const_iterator i = _indices.begin();
-		 i != _indices.end();
-		 ++i)
+void MD5Surface::ensureBuffers() const
+{
+	if (_vertexBuffer == 0 || _indexBuffer == 0)
 	{
-		// Get the vertex for this index
-		ArbitraryMeshVertex& v = _vertices[*i];
+		// The buffers are created with the current data
+		render::deleteVBO(_vertexBuffer);
+		render::deleteVBO(_indexBuffer);
 
-		// Submit attributes
-		glNormal3dv(v.normal);
-		glTexCoord2dv(v.texcoord);
-		glVertex3dv(v.vertex);
+		_vertexBuffer = render::makeVBOFromArray(GL_ARRAY_BUFFER, _skinnedVertices, GL_DYNAMIC_DRAW);
+		_indexBuffer = render::makeVBOFromArray(GL_ELEMENT_ARRAY_BUFFER, _indices);
+	}
+	else if (_buffersNeedUpdate)
+	{
+		// The vertex count never changes after parsing, the buffer can be overwritten in place
+		render::replaceVBOData(GL_ARRAY_BUFFER, _vertexBuffer, _skinnedVertices);
 	}
-	glEnd();
 
-	glEndList();
+	_buffersNeedUpdate = false;
 }
 
-void MD5Surface::releaseDisplayLists()
+void MD5Surface::releaseBuffers()
 {
-    // Release GL display lists if applicable
-    if (_normalList != 0)
-    {
-        glDeleteLists(_normalList, 1);
-        _normalList = 0;
-    }
+	render::deleteVBO(_vertexBuffer);
+	render::deleteVBO(_indexBuffer);
+}
 
-    if (_lightingList != 0)
-    {
-        glDeleteLists(_lightingList, 1);
-        _lightingList = 0;
-    }
+void MD5Surface::ensureVertexArray() const
+{
+	if (!_verticesNeedUpdate)
+	{
+		return;
+	}
+
+	_verticesNeedUpdate = false;
+	_vertices.resize(_skinnedVertices.size());
+
+	for (std::size_t i = 0; i < _skinnedVertices.size(); ++i)
+	{
+		const auto& source = _skinnedVertices[i];
+		auto& target = _vertices[i];
+
+		target.vertex = Vertex3f(source.vertex[0], source.vertex[1], source.vertex[2]);
+		target.normal = Normal3f(source.normal[0], source.normal[1], source.normal[2]);
+		target.texcoord = TexCoord2f(source.texcoord[0], source.texcoord[1]);
+		target.tangent = Normal3f(source.tangent[0], source.tangent[1], source.tangent[2]);
+		target.bitangent = Normal3f(source.bitangent[0], source.bitangent[1], source.bitangent[2]);
+	}
 }
 
 // Selection test
@@ -159,6 +157,8 @@ void MD5Surface::testSelect(Selector& selector,
 							SelectionTest& test,
 							const Matrix4& localToWorld)
 {
+	ensureVertexArray();
+
 	test.BeginMesh(localToWorld);
 
 	SelectionIntersection best;
@@ -175,6 +175,8 @@ void MD5Surface::testSelect(Selector& selector,
 
 bool MD5Surface::getIntersection(const Ray& ray, Vector3& intersection, const Matrix4& localToWorld)
 {
+	ensureVertexArray();
+
 	Vector3 bestIntersection = ray.origin;
 	Vector3 triIntersection;
 
@@ -225,7 +227,7 @@ const AABB& MD5Surface::localAABB() const {
 
 int MD5Surface::getNumVertices() const
 {
-	return static_cast<int>(_vertices.size());
+	return static_cast<int>(_skinnedVertices.size());
 }
 
 int MD5Surface::getNumTriangles() const
@@ -235,6 +237,8 @@ int MD5Surface::getNumTriangles() const
 
 const ArbitraryMeshVertex& MD5Surface::getVertex(int vertexIndex) const
 {
+	ensureVertexArray();
+
 	assert(vertexIndex >= 0 && vertexIndex < static_cast<int>(_vertices.size()));
 	return _vertices[vertexIndex];
 }
@@ -243,6 +247,8 @@ model::ModelPolygon MD5Surface::getPolygon(int polygonIndex) const
 {
 	assert(polygonIndex >= 0 && polygonIndex*3 < static_cast<int>(_indices.size()));
 
+	ensureVertexArray();
+
 	model::ModelPolygon poly;
 
 	poly.a = _vertices[_indices[polygonIndex*3]];
@@ -254,6 +260,8 @@ model::ModelPolygon MD5Surface::getPolygon(int polygonIndex) const
 
 const std::vector<ArbitraryMeshVertex>& MD5Surface::getVertexArray() const
 {
+	ensureVertexArray();
+
 	return _vertices;
 }
 
@@ -279,70 +287,46 @@ void MD5Surface::setActiveMaterial(const std::string& activeMaterial)
 
 void MD5Surface::updateToDefaultPose(const MD5Joints& joints)
 {
-	if (_vertices.size() != _mesh->vertices.size())
-	{
-		_vertices.resize(_mesh->vertices.size());
-	}
+	_joints.resize(joints.size());
 
-	for (std::size_t j = 0; j < _mesh->vertices.size(); ++j)
+	for (std::size_t i = 0; i < joints.size(); ++i)
 	{
-		MD5Vert& vert = _mesh->vertices[j];
-
-		Vector3 skinned(0, 0, 0);
-
-		for (std::size_t k = 0; k != vert.weight_count; ++k)
-		{
-			MD5Weight& weight = _mesh->weights[vert.weight_index + k];
-			const MD5Joint& joint = joints[weight.joint];
+		_joints[i] = render::createSkinningJoint(joints[i].rotation, joints[i].position);
+	}
 
-			Vector3 rotatedPoint = joint.rotation.transformPoint(weight.v);
-			skinned += (rotatedPoint + joint.position) * weight.t;
-		}
+	skinToJoints();
+}
 
-		_vertices[j].vertex = skinned;
-		_vertices[j].texcoord = TexCoord2f(vert.u, vert.v);
-		_vertices[j].normal = Normal3f(0,0,0);
-	}
+void MD5Surface::updateToSkeleton(const MD5Skeleton& skeleton)
+{
+	_joints.resize(skeleton.size());
 
-	// Ensure the index array is ok
-	if (_indices.empty())
+	for (std::size_t i = 0; i < skeleton.size(); ++i)
 	{
-		buildIndexArray();
+		const IMD5Anim::Key& key = skeleton.getKey(i);
+		_joints[i] = render::createSkinningJoint(key.orientation, key.origin);
 	}
 
-	buildVertexNormals();
-
-	updateGeometry();
+	skinToJoints();
 }
 
-void MD5Surface::updateToSkeleton(const MD5Skeleton& skeleton)
+void MD5Surface::skinToJoints()
 {
-	// Ensure we have all vertices allocated
-	if (_vertices.size() != _mesh->vertices.size())
+	if (_mesh->skinningInfluences.size() != _mesh->vertices.size())
 	{
-		_vertices.resize(_mesh->vertices.size());
+		prepareSkinningWeights(*_mesh);
 	}
 
-	// Deform vertices to fit the skeleton
-	for (std::size_t j = 0; j < _mesh->vertices.size(); ++j)
+	// Ensure we have all vertices allocated, the texcoords are not affected by skinning
+	if (_skinnedVertices.size() != _mesh->vertices.size())
 	{
-		MD5Vert& vert = _mesh->vertices[j];
-
-		Vector3 skinned(0, 0, 0);
+		_skinnedVertices.resize(_mesh->vertices.size());
 
-		for (std::size_t k = 0; k != vert.weight_count; ++k)
+		for (std::size_t i = 0; i < _mesh->vertices.size(); ++i)
 		{
-			MD5Weight& weight = _mesh->weights[vert.weight_index + k];
-			const IMD5Anim::Key& key = skeleton.getKey(weight.joint);
-			//const Joint& joint = skeleton.getJoint(weight.joint);
-
-			Vector3 rotatedPoint = key.orientation.transformPoint(weight.v);
-			skinned += (rotatedPoint + key.origin) * weight.t;
+			_skinnedVertices[i].texcoord[0] = _mesh->vertices[i].u;
+			_skinnedVertices[i].texcoord[1] = _mesh->vertices[i].v;
 		}
-
-		_vertices[j].vertex = skinned;
-		_vertices[j].texcoord = TexCoord2f(vert.u, vert.v);
-		_vertices[j].normal = Normal3f(0,0,0);
 	}
 
 	// Ensure the index array is ok
@@ -351,30 +335,32 @@ void MD5Surface::updateToSkeleton(const MD5Skeleton& skeleton)
 		buildIndexArray();
 	}
 
-	buildVertexNormals();
+	// Deform vertices to fit the skeleton and calculate the normals and tangents
+	render::skinMesh(_joints, _mesh->skinningWeights, _mesh->skinningInfluences, _indices, _skinnedVertices);
 
 	updateGeometry();
 }
 
-void MD5Surface::buildVertexNormals()
+void MD5Surface::prepareSkinningWeights(MD5Mesh& mesh)
 {
-	for (Indices::iterator j = _indices.begin(); j != _indices.end(); j += 3)
-	{
-		ArbitraryMeshVertex& a = _vertices[*(j + 0)];
-		ArbitraryMeshVertex& b = _vertices[*(j + 1)];
-		ArbitraryMeshVertex& c = _vertices[*(j + 2)];
-
-		Vector3 weightedNormal((c.vertex - a.vertex).cross(b.vertex - a.vertex));
+	mesh.skinningWeights.clear();
+	mesh.skinningWeights.reserve(mesh.weights.size());
 
-		a.normal += weightedNormal;
-		b.normal += weightedNormal;
-		c.normal += weightedNormal;
+	for (const auto& weight : mesh.weights)
+	{
+		mesh.skinningWeights.push_back(render::createSkinningWeight(weight.v, weight.t, weight.joint));
 	}
 
-	// Normalise all normal vectors
-	for (Vertices::iterator j = _vertices.begin(); j != _vertices.end(); ++j)
+	mesh.skinningInfluences.clear();
+	mesh.skinningInfluences.reserve(mesh.vertices.size());
+
+	for (const auto& vert : mesh.vertices)
 	{
-		j->normal = Normal3f(j->normal.getNormalised());
+		mesh.skinningInfluences.push_back(render::SkinningInfluence
+		{
+			static_cast<std::uint32_t>(vert.weight_index),
+			static_cast<std::uint32_t>(vert.weight_count)
+		});
 	}
 }
 
@@ -487,6 +473,8 @@ void MD5Surface::parseFromTokens(parser::DefTokeniser& tok)
 	// ----- END OF MESH DECL -----
 
 	tok.assertNextToken("}");
+
+	prepareSkinningWeights(mesh);
 }
 
 } // namespace md5
@@ -40,24 +40,37 @@ private:
 	// Several MD5Surfaces can share the same mesh
 	MD5MeshPtr _mesh;
 
-	// Our render data
-	Vertices _vertices;
+	// The skinned vertices, as uploaded to the vertex buffer
+	std::vector<render::SkinnedVertex> _skinnedVertices;
+
+	// The joint transforms of the current pose, kept to save reallocations
+	std::vector<render::SkinningJoint> _joints;
+
+	// The vertices in the form exposed through IModelSurface, these
+	// are converted from the skinned vertices on demand
+	mutable Vertices _vertices;
+	mutable bool _verticesNeedUpdate;
+
 	Indices _indices;
 
-	// The GL display lists for this surface's geometry
-	GLuint _normalList;
-	GLuint _lightingList;
+	// The GL buffer objects holding this surface's geometry, created on first render
+	mutable GLuint _vertexBuffer;
+	mutable GLuint _indexBuffer;
+	mutable bool _buffersNeedUpdate;
 
 private:
 
-	// Create the display lists
-	void createDisplayLists();
+	// Deforms the mesh to the pose defined by the current joint transforms
+	void skinToJoints();
 
-    // Frees any display list in use
-    void releaseDisplayLists();
+	// Refresh the vertex array from the skinned vertices, if necessary
+	void ensureVertexArray() const;
 
-	// Re-calculate the normal vectors
-	void buildVertexNormals();
+	// Upload the geometry to the buffer objects, if necessary
+	void ensureBuffers() const;
+
+	// Frees any buffer objects in use
+	void releaseBuffers();
 
 public:
 
@@ -80,7 +93,7 @@ public:
 	void setDefaultMaterial(const std::string& name);
 	
 	/**
-	 * Calculate the AABB and build the display lists for rendering.
+	 * Calculate the AABB and schedule the buffer objects for an update.
 	 */
 	void updateGeometry();
 
@@ -122,6 +135,9 @@ public:
 
 	void parseFromTokens(parser::DefTokeniser& tok);
 
+	// Convert the weights of the mesh definition into the form used by the skinning kernel
+	static void prepareSkinningWeights(MD5Mesh& mesh);
+
 	// Rebuild the render index array - usually needs to be called only once
 	void buildIndexArray();
 };
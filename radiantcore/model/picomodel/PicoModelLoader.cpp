@@ -43,6 +43,37 @@ PicoModelLoader::PicoModelLoader(const picoModule_t* module, const std::string&
 
 // Load the given model from the VFS path
 IModelPtr PicoModelLoader::loadModelFromPath(const std::string& path)
+{
+	auto model = parseModel(path, UseMaterialNameFallback());
+
+	if (model)
+	{
+		ResolveFallbackMaterials(static_cast<const StaticModel&>(*model));
+	}
+
+	return model;
+}
+
+std::function<IModelPtr()> PicoModelLoader::getBackgroundLoadFunc(const std::string& path)
+{
+	// Read the game setting now, the function is run by a worker
+	auto useMaterialNameFallback = UseMaterialNameFallback();
+
+	return [this, path, useMaterialNameFallback]()
+	{
+		return parseModel(path, useMaterialNameFallback);
+	};
+}
+
+void PicoModelLoader::finishBackgroundLoad(const IModelPtr& model)
+{
+	if (model)
+	{
+		ResolveFallbackMaterials(static_cast<const StaticModel&>(*model));
+	}
+}
+
+IModelPtr PicoModelLoader::parseModel(const std::string& path, bool useMaterialNameFallback)
 {
 	// Open an ArchiveFile to load
 	auto file = path_is_absolute(path.c_str()) ?
@@ -76,7 +107,7 @@ IModelPtr PicoModelLoader::loadModelFromPath(const std::string& path)
 	}
 
     // Convert the pico model surfaces to StaticModelSurfaces
-    auto surfaces = CreateSurfaces(model, fExt);
+    auto surfaces = CreateSurfaces(model, fExt, useMaterialNameFallback);
 
 	auto modelObj = std::make_shared<StaticModel>(surfaces);
 
@@ -89,7 +120,8 @@ IModelPtr PicoModelLoader::loadModelFromPath(const std::string& path)
 	return modelObj;
 }
 
-std::vector<StaticModelSurfacePtr> PicoModelLoader::CreateSurfaces(picoModel_t* picoModel, const std::string& extension)
+std::vector<StaticModelSurfacePtr> PicoModelLoader::CreateSurfaces(picoModel_t* picoModel, const std::string& extension,
+    bool useMaterialNameFallback)
 {
     // Convert the pico model surfaces to StaticModelSurfaces
     std::vector<StaticModelSurfacePtr> surfaces;
@@ -103,7 +135,7 @@ std::vector<StaticModelSurfacePtr> PicoModelLoader::CreateSurfaces(picoModel_t*
         // Retrieve the surface, discarding it if it is null or non-triangulated (?)
         picoSurface_t* surf = PicoGetModelSurface(picoModel, n);
 
-        auto rSurf = CreateSurface(surf, extension);
+        auto rSurf = CreateSurface(surf, extension, useMaterialNameFallback);
 
         if (!rSurf) continue;
 
@@ -161,7 +193,6 @@ std::string PicoModelLoader::DetermineDefaultMaterial(picoSurface_t* picoSurface
     // the material name to select the shader, while for an ASE model the
     // bitmap path should be used.
     picoShader_t* shader = PicoGetSurfaceShader(picoSurface);
-    std::string rawName = "";
     std::string defaultMaterial;
 
     if (shader != 0)
@@ -172,7 +203,6 @@ std::string PicoModelLoader::DetermineDefaultMaterial(picoSurface_t* picoSurface
         }
         else if (extension == "ase")
         {
-            rawName = PicoGetShaderName(shader);
             std::string rawMapName = PicoGetShaderMapName(shader);
             defaultMaterial = CleanupShaderName(rawMapName);
         }
@@ -182,24 +212,55 @@ std::string PicoModelLoader::DetermineDefaultMaterial(picoSurface_t* picoSurface
         }
     }
 
+    return defaultMaterial;
+}
+
+std::string PicoModelLoader::DetermineFallbackMaterial(picoSurface_t* picoSurface, const std::string& extension)
+{
+    // The fallback (introduced in #2499) is the *MATERIAL_NAME of an ASE material
+    picoShader_t* shader = PicoGetSurfaceShader(picoSurface);
+
+    if (shader == 0 || extension != "ase")
+    {
+        return std::string();
+    }
+
+    std::string rawName = PicoGetShaderName(shader);
+
+    return !rawName.empty() ? CleanupShaderName(rawName) : std::string();
+}
+
+bool PicoModelLoader::UseMaterialNameFallback()
+{
     // #4644: Doom3 / TDM don't use the *MATERIAL_NAME in ASE models, only *BITMAP is used
-    // Use the fallback (introduced in #2499) only when the game allows it
-    if (game::current::getValue<bool>("/modelFormat/ase/useMaterialNameIfNoBitmapFound"))
+    return game::current::getValue<bool>("/modelFormat/ase/useMaterialNameIfNoBitmapFound");
+}
+
+void PicoModelLoader::ResolveFallbackMaterials(const StaticModel& model)
+{
+    for (const auto& surface : model.getSurfaces())
     {
-        // If shader not found, fallback to alternative if available
-        // _defaultMaterial is empty if the ase material has no BITMAP
-        // materialIsValid is false if _defaultMaterial is not an existing shader
-        if ((defaultMaterial.empty() || !GlobalMaterialManager().materialExists(defaultMaterial)) &&
-            !rawName.empty())
+        const auto& fallbackMaterial = surface.surface->getFallbackMaterial();
+
+        if (fallbackMaterial.empty())
         {
-            defaultMaterial = CleanupShaderName(rawName);
+            continue;
         }
-    }
 
-    return defaultMaterial;
+        // The default material is empty if the ase material has no BITMAP
+        const auto& defaultMaterial = surface.surface->getDefaultMaterial();
+
+        if (defaultMaterial.empty() || !GlobalMaterialManager().materialExists(defaultMaterial))
+        {
+            surface.surface->setDefaultMaterial(fallbackMaterial);
+        }
+
+        surface.surface->setFallbackMaterial(std::string());
+    }
 }
 
-StaticModelSurfacePtr PicoModelLoader::CreateSurface(picoSurface_t* picoSurface, const std::string& extension)
+StaticModelSurfacePtr PicoModelLoader::CreateSurface(picoSurface_t* picoSurface, const std::string& extension,
+    bool useMaterialNameFallback)
 {
     if (picoSurface == 0 || PicoGetSurfaceType(picoSurface) != PICO_TRIANGLES)
     {
@@ -251,6 +312,12 @@ StaticModelSurfacePtr PicoModelLoader::CreateSurface(picoSurface_t* picoSurface,
 
     staticSurface->setDefaultMaterial(DetermineDefaultMaterial(picoSurface, extension));
 
+    if (useMaterialNameFallback)
+    {
+        // Whether the default material exists is checked on the main thread
+        staticSurface->setFallbackMaterial(DetermineFallbackMaterial(picoSurface, extension));
+    }
+
     return staticSurface;
 }
 
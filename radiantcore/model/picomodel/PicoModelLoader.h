@@ -22,14 +22,34 @@ public:
   	// Load the given model from the path, VFS or absolute
 	IModelPtr loadModelFromPath(const std::string& name) override;
 
+	// The background load doesn't touch the registry nor the material manager,
+	// the material fallback is resolved by finishBackgroundLoad()
+	std::function<IModelPtr()> getBackgroundLoadFunc(const std::string& path) override;
+	void finishBackgroundLoad(const IModelPtr& model) override;
+
 public:
-    static std::vector<StaticModelSurfacePtr> CreateSurfaces(picoModel_t* picoModel, const std::string& extension);
+    // Surfaces get the material name assigned as fallback material if
+    // useMaterialNameFallback is true, see ResolveFallbackMaterials()
+    static std::vector<StaticModelSurfacePtr> CreateSurfaces(picoModel_t* picoModel, const std::string& extension,
+        bool useMaterialNameFallback);
 
     static std::string DetermineDefaultMaterial(picoSurface_t* picoSurface, const std::string& extension);
     static std::string CleanupShaderName(const std::string& inName);
 
+    // #4644: Returns true if the current game allows falling back to the ASE material name
+    // if the bitmap is not an existing material. Reads the game registry.
+    static bool UseMaterialNameFallback();
+
+    // Switches every surface with a fallback material to that one if its default material
+    // doesn't exist. This is accessing the material manager, call it on the main thread.
+    static void ResolveFallbackMaterials(const StaticModel& model);
+
 private:
-    static StaticModelSurfacePtr CreateSurface(picoSurface_t* picoSurface, const std::string& extension);
+    IModelPtr parseModel(const std::string& path, bool useMaterialNameFallback);
+
+    static std::string DetermineFallbackMaterial(picoSurface_t* picoSurface, const std::string& extension);
+    static StaticModelSurfacePtr CreateSurface(picoSurface_t* picoSurface, const std::string& extension,
+        bool useMaterialNameFallback);
 };
 
 } // namespace model
@@ -25,7 +25,12 @@ read requests until flen is reset.
 #define INT_MIN     (-2147483647 - 1) /* minimum (signed) int value */
 #define FLEN_ERROR INT_MIN
 
-static int flen;
+/* models are loaded on multiple threads, each of them keeps its own count */
+#if defined( _MSC_VER )
+static __declspec( thread ) int flen;
+#else
+static __thread int flen;
+#endif
 
 void set_flen( int i ) { flen = i; }
 
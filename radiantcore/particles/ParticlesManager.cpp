@@ -21,11 +21,13 @@
 #include "os/fs.h"
 
 #include "debugging/ScopedDebugTimer.h"
+#include "ThreadPool.h"
 
 #include <fstream>
 #include <iostream>
 #include <functional>
 #include <regex>
+#include <set>
 #include "string/predicate.h"
 #include "module/StaticModule.h"
 
@@ -44,7 +46,8 @@ namespace
 }
 
 ParticlesManager::ParticlesManager() :
-    _defLoader(std::bind(&ParticlesManager::reloadParticleDefs, this))
+    _defLoader(std::bind(&ParticlesManager::loadParticleDefs, this)),
+    _particleFiles(PARTICLES_DIR, PARTICLES_EXT, 1) // depth == 1: don't search subdirectories
 {}
 
 sigc::signal<void> ParticlesManager::signal_particlesReloaded() const
@@ -154,20 +157,48 @@ void ParticlesManager::ensureDefsLoaded()
     _defLoader.ensureFinished();
 }
 
-// Parse particle defs from string
-void ParticlesManager::parseStream(std::istream& contents, const std::string& filename)
+ParticlesManager::ParsedParticleFile ParticlesManager::parseParticleFile(const vfs::FileInfo& fileInfo)
 {
-	// Usual ritual, get a parser::DefTokeniser and start tokenising the DEFs
-	parser::BasicDefTokeniser<std::istream> tok(contents);
+    ParsedParticleFile result;
 
-	while (tok.hasMoreTokens())
-	{
-		parseParticleDef(tok, filename);
-	}
+    // Attempt to open the file in text mode
+    ArchiveTextFilePtr file = GlobalFileSystem().openTextFile(PARTICLES_DIR + fileInfo.name);
+
+    if (!file)
+    {
+        rError() << "[particles] Unable to open " << fileInfo.name << std::endl;
+        return result;
+    }
+
+    // File is open, so parse the tokens
+    try
+    {
+        std::istream is(&(file->getInputStream()));
+
+        // Usual ritual, get a parser::DefTokeniser and start tokenising the DEFs
+        parser::BasicDefTokeniser<std::istream> tok(is);
+
+        while (tok.hasMoreTokens())
+        {
+            auto particle = parseParticleDef(tok, fileInfo.name);
+
+            if (particle)
+            {
+                result.push_back(particle);
+            }
+        }
+    }
+    catch (parser::ParseException& e)
+    {
+        rError() << "[particles] Failed to parse " << fileInfo.name
+            << ": " << e.what() << std::endl;
+    }
+
+    return result;
 }
 
 // Parse a single particle def
-void ParticlesManager::parseParticleDef(parser::DefTokeniser& tok, const std::string& filename)
+ParticleDefPtr ParticlesManager::parseParticleDef(parser::DefTokeniser& tok, const std::string& filename)
 {
 	// Standard DEF, starts with "particle <name> {"
 	std::string declName = tok.nextToken();
@@ -193,20 +224,43 @@ void ParticlesManager::parseParticleDef(parser::DefTokeniser& tok, const std::st
 			}
 		}
 
-		return;
+		return ParticleDefPtr();
 	}
 
 	// Valid particle declaration, go ahead parsing the name
 	std::string name = tok.nextToken();
 	tok.assertNextToken("{");
 
-    // Find the particle def (use the non-blocking, internal lookup)
-	ParticleDefPtr pdef = findOrInsertParticleDefInternal(name);
+	auto pdef = std::make_shared<ParticleDef>(name);
 
 	pdef->setFilename(filename);
 
 	// Let the particle construct itself from the token stream
 	pdef->parseFromTokens(tok);
+
+	return pdef;
+}
+
+void ParticlesManager::mergeParticleFile(const ParsedParticleFile& parsedFile, const std::set<std::string>* names)
+{
+    for (const auto& parsed : parsedFile)
+    {
+        if (names && names->count(parsed->getName()) == 0)
+        {
+            continue;
+        }
+
+        auto result = _particleDefs.emplace(parsed->getName(), parsed);
+
+        if (!result.second)
+        {
+            // Keep the existing object, it might be referenced by renderables and editors
+            const auto& existing = result.first->second;
+
+            existing->setFilename(parsed->getFilename());
+            existing->copyFrom(*parsed);
+        }
+    }
 }
 
 const std::string& ParticlesManager::getName() const
@@ -245,37 +299,43 @@ void ParticlesManager::initialiseModule(const IApplicationContext& ctx)
 }
 
 void ParticlesManager::reloadParticleDefs()
+{
+    // Wait for the initial load, the changed files are parsed on top of that
+    ensureDefsLoaded();
+    loadParticleDefs();
+}
+
+void ParticlesManager::loadParticleDefs()
 {
 	ScopedDebugTimer timer("Particle definitions parsed: ");
 
-    GlobalFileSystem().forEachFile(
-        PARTICLES_DIR, PARTICLES_EXT,
-        [&](const vfs::FileInfo& fileInfo)
+    if (!_particleFiles.hasSnapshot())
+    {
+        auto files = _particleFiles.scan();
+        auto parsedFiles = parseParticleFiles(files);
+
+        // Merge the results in the order the VFS has been listing the files,
+        // such that the outcome is the same as parsing them one after the other
+        for (const auto& fileInfo : files)
         {
-            // Attempt to open the file in text mode
-            ArchiveTextFilePtr file = GlobalFileSystem().openTextFile(PARTICLES_DIR + fileInfo.name);
+            const auto& parsedFile = parsedFiles.at(fileInfo.fullPath());
 
-            if (file != NULL)
-            {
-                // File is open, so parse the tokens
-                try 
-                {
-                    std::istream is(&(file->getInputStream()));
-                    parseStream(is, fileInfo.name);
-                }
-                catch (parser::ParseException& e)
-                {
-                    rError() << "[particles] Failed to parse " << fileInfo.name
-                        << ": " << e.what() << std::endl;
-                }
-            }
-            else
-            {
-                rError() << "[particles] Unable to open " << fileInfo.name << std::endl;
-            }
-        },
-        1 // depth == 1: don't search subdirectories
-    );
+            _particleFiles.setDeclaredNames(fileInfo.fullPath(), getParticleNames(parsedFile));
+            mergeParticleFile(parsedFile);
+        }
+    }
+    else
+    {
+        auto changes = _particleFiles.scanForChanges();
+
+        if (changes.empty())
+        {
+            rMessage() << "No changed particle files found." << std::endl;
+            return;
+        }
+
+        reloadChangedParticleFiles(changes);
+    }
 
     rMessage() << "Found " << _particleDefs.size() << " particle definitions." << std::endl;
 
@@ -283,6 +343,96 @@ void ParticlesManager::reloadParticleDefs()
     _particlesReloadedSignal.emit();
 }
 
+void ParticlesManager::reloadChangedParticleFiles(const decl::DeclFileTracker::Changes& changes)
+{
+    auto affectedPaths = changes.getAffectedPaths();
+
+    // The defs declared by the changed and removed files, before and after the change
+    auto affectedNames = _particleFiles.getDeclaredNames(affectedPaths);
+    auto parsedFiles = parseParticleFiles(changes.changedFiles);
+
+    for (const auto& fileInfo : changes.removedFiles)
+    {
+        _particleFiles.setDeclaredNames(fileInfo.fullPath(), {});
+    }
+
+    for (const auto& pair : parsedFiles)
+    {
+        auto names = getParticleNames(pair.second);
+        affectedNames.insert(names.begin(), names.end());
+
+        _particleFiles.setDeclaredNames(pair.first, std::move(names));
+    }
+
+    // The unchanged files declaring any of these defs compete for them, the
+    // file listed last by the VFS wins. These need to be parsed again too.
+    auto files = _particleFiles.getFilesDeclaring(affectedNames, affectedPaths);
+    auto otherParsedFiles = parseParticleFiles(files);
+
+    parsedFiles.insert(otherParsedFiles.begin(), otherParsedFiles.end());
+
+    files.insert(files.end(), changes.changedFiles.begin(), changes.changedFiles.end());
+    _particleFiles.sortInScanOrder(files);
+
+    std::set<std::string> declaredNames;
+
+    for (const auto& fileInfo : files)
+    {
+        const auto& parsedFile = parsedFiles.at(fileInfo.fullPath());
+
+        for (const auto& def : parsedFile)
+        {
+            declaredNames.insert(def->getName());
+        }
+
+        mergeParticleFile(parsedFile, &affectedNames);
+    }
+
+    // Defs which are no longer declared by any file remain in memory, but are emptied
+    for (const auto& name : affectedNames)
+    {
+        auto found = _particleDefs.find(name);
+
+        if (found != _particleDefs.end() && declaredNames.count(name) == 0)
+        {
+            found->second->copyFrom(ParticleDef(name));
+        }
+    }
+}
+
+std::map<std::string, ParticlesManager::ParsedParticleFile> ParticlesManager::parseParticleFiles(
+    const std::vector<vfs::FileInfo>& files)
+{
+    util::ThreadPool workers;
+    std::vector<std::future<ParsedParticleFile>> parsedFiles;
+
+    for (const auto& fileInfo : files)
+    {
+        parsedFiles.emplace_back(workers.submit([fileInfo]() { return parseParticleFile(fileInfo); }));
+    }
+
+    std::map<std::string, ParsedParticleFile> result;
+
+    for (std::size_t i = 0; i < parsedFiles.size(); ++i)
+    {
+        result.emplace(files[i].fullPath(), parsedFiles[i].get());
+    }
+
+    return result;
+}
+
+std::set<std::string> ParticlesManager::getParticleNames(const ParsedParticleFile& parsedFile)
+{
+    std::set<std::string> names;
+
+    for (const auto& def : parsedFile)
+    {
+        names.insert(def->getName());
+    }
+
+    return names;
+}
+
 void ParticlesManager::saveParticleDef(const std::string& particleName)
 {
     ensureDefsLoaded();
@@ -4,10 +4,13 @@
 #include "StageDef.h"
 
 #include "ThreadedDefLoader.h"
+#include "decl/DeclFileTracker.h"
 #include "iparticles.h"
+#include "ifilesystem.h"
 #include "parser/DefTokeniser.h"
 
 #include <map>
+#include <set>
 
 namespace particles
 {
@@ -22,6 +25,9 @@ class ParticlesManager :
 
     util::ThreadedDefLoader<void> _defLoader;
 
+    // The .prt files found during the last load, to reload the changed ones only
+    decl::DeclFileTracker _particleFiles;
+
     // Reloaded signal
     sigc::signal<void> _particlesReloadedSignal;
 
@@ -65,14 +71,32 @@ private:
     // that it's done loading before accessing any defs.
     void ensureDefsLoaded();
 
-    /**
-    * Accept a stream containing particle definitions to parse and add to the
-    * list.
-    */
-    void parseStream(std::istream& s, const std::string& filename);
+    // Parses the .prt files, the first call loads all of them, subsequent
+    // calls only the ones that changed since the last run
+    void loadParticleDefs();
+
+    // The particle defs of a single .prt file, in the order of declaration
+    typedef std::vector<ParticleDefPtr> ParsedParticleFile;
+
+    // Re-parses the changed files and the unchanged ones declaring the same
+    // defs, then merges the affected defs in VFS order
+    void reloadChangedParticleFiles(const decl::DeclFileTracker::Changes& changes);
+
+    // Parses the given files in parallel, the results are mapped by the file path
+    static std::map<std::string, ParsedParticleFile> parseParticleFiles(const std::vector<vfs::FileInfo>& files);
+
+    // Parse the given .prt file, to be called from worker threads
+    static ParsedParticleFile parseParticleFile(const vfs::FileInfo& fileInfo);
+
+    static std::set<std::string> getParticleNames(const ParsedParticleFile& parsedFile);
+
+	// Recursive-descent parse functions, returns an empty pointer for non-particle decls
+	static ParticleDefPtr parseParticleDef(parser::DefTokeniser& tok, const std::string& filename);
 
-	// Recursive-descent parse functions
-	void parseParticleDef(parser::DefTokeniser& tok, const std::string& filename);
+    // Adds the parsed defs to the map. Existing ParticleDef objects are kept and
+    // take the contents of the parsed ones, the last definition of a name wins.
+    // If names is given, only the defs of these names are merged.
+    void mergeParticleFile(const ParsedParticleFile& parsedFile, const std::set<std::string>* names = nullptr);
 
 	static void stripParticleDefFromStream(std::istream& input, std::ostream& output, const std::string& particleName);
 };
@@ -44,6 +44,7 @@ OpenGLRenderSystem::OpenGLRenderSystem() :
     _shaderProgramsAvailable(false),
     _glProgramFactory(std::make_shared<GLProgramFactory>()),
     _currentShaderProgram(SHADER_PROGRAM_NONE),
+    _stateChangeCount(0),
     _time(0),
     m_traverseRenderablesMutex(false)
 {
@@ -202,21 +203,32 @@ void OpenGLRenderSystem::render(RenderStateFlags globalstate,
     glHint(GL_FOG_HINT, GL_NICEST);
     glDisable(GL_FOG);
 
-    // Iterate over the sorted mapping between OpenGLStates and their
-    // OpenGLShaderPasses (containing the renderable geometry), and render the
-    // contents of each bucket. Each pass is passed a reference to the "current"
-    // state, which it can change.
-    for (OpenGLStates::iterator i = _state_sorted.begin();
-        i != _state_sorted.end();
-        ++i)
+    // Queue the non-empty OpenGLShaderPasses (containing the renderable geometry),
+    // ordered by their sort position and then by the GL state which is expensive
+    // to switch (program, depth and blend flags, textures).
+    _renderQueue.clear();
+
+    for (const auto& pair : _state_sorted)
     {
-        // Render the OpenGLShaderPass
-        if (!i->second->empty())
+        if (!pair.second->empty())
         {
-            i->second->render(current, globalstate, viewer, _time);
+            _renderQueue.add(*pair.first, globalstate, pair.second.get());
         }
     }
 
+    _renderQueue.sort();
+
+    // Render the contents of each bucket. Each pass is passed a reference
+    // to the "current" state, which it can change.
+    _stateChangeCount = 0;
+
+    for (const auto& entry : _renderQueue)
+    {
+        entry.pass->render(current, globalstate, viewer, _time, _stateChangeCount);
+    }
+
+    _renderQueue.clear();
+
     glPopAttrib();
 }
 
@@ -285,6 +297,11 @@ void OpenGLRenderSystem::setTime(std::size_t milliSeconds)
     _time = milliSeconds;
 }
 
+std::size_t OpenGLRenderSystem::getStateChangeCount() const
+{
+    return _stateChangeCount;
+}
+
 RenderSystem::ShaderProgram OpenGLRenderSystem::getCurrentShaderProgram() const
 {
     return _currentShaderProgram;
@@ -7,6 +7,7 @@
 #include "backend/OpenGLStateManager.h"
 #include "backend/OpenGLShader.h"
 #include "backend/OpenGLStateLess.h"
+#include "render/RenderQueue.h"
 
 namespace render
 {
@@ -40,6 +41,12 @@ class OpenGLRenderSystem
 	// Map of OpenGLState references, with access functions.
 	OpenGLStates _state_sorted;
 
+	// The non-empty passes in the order they are rendered, refilled every frame
+	RenderQueue<OpenGLShaderPass> _renderQueue;
+
+	// Number of GL state changes performed during the last render() call
+	std::size_t _stateChangeCount;
+
 	// Render time
 	std::size_t _time;
 
@@ -74,6 +81,8 @@ public:
 	std::size_t getTime() const override;
 	void setTime(std::size_t milliSeconds) override;
 
+	std::size_t getStateChangeCount() const override;
+
     ShaderProgram getCurrentShaderProgram() const override;
     void setShaderProgram(ShaderProgram prog) override;
 
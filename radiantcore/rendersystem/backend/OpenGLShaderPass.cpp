@@ -13,6 +13,8 @@
 
 #include "glprogram/GLSLDepthFillAlphaProgram.h"
 
+#include <bitset>
+
 namespace render
 {
 
@@ -82,6 +84,65 @@ inline void evaluateStage(const IShaderLayer::Ptr& stage, std::size_t time, cons
     }
 }
 
+// The parts of the current GL state which are tracked to count the state changes
+struct StateSnapshot
+{
+    unsigned int renderFlags;
+    GLProgram* glProgram;
+    GLint textures[5];
+    GLenum depthFunc;
+    GLenum blendSrc;
+    GLenum blendDst;
+    GLenum alphaFunc;
+    GLfloat alphaThreshold;
+    float polygonOffset;
+    GLfloat lineWidth;
+    GLfloat pointSize;
+    GLint lineStippleFactor;
+    GLushort lineStipplePattern;
+
+    StateSnapshot(const OpenGLState& state) :
+        renderFlags(state.getRenderFlags()),
+        glProgram(state.glProgram),
+        textures{ state.texture0, state.texture1, state.texture2, state.texture3, state.texture4 },
+        depthFunc(state.getDepthFunc()),
+        blendSrc(state.m_blend_src),
+        blendDst(state.m_blend_dst),
+        alphaFunc(state.alphaFunc),
+        alphaThreshold(state.alphaThreshold),
+        polygonOffset(state.polygonOffset),
+        lineWidth(state.m_linewidth),
+        pointSize(state.m_pointsize),
+        lineStippleFactor(state.m_linestipple_factor),
+        lineStipplePattern(state.m_linestipple_pattern)
+    {}
+
+    // Returns the number of state changes needed to get from this snapshot to the given state
+    std::size_t countChanges(const OpenGLState& state) const
+    {
+        std::size_t changes = std::bitset<32>(renderFlags ^ state.getRenderFlags()).count();
+
+        const GLint newTextures[] = { state.texture0, state.texture1, state.texture2, state.texture3, state.texture4 };
+
+        for (std::size_t i = 0; i < 5; ++i)
+        {
+            if (textures[i] != newTextures[i]) ++changes;
+        }
+
+        if (glProgram != state.glProgram) ++changes;
+        if (depthFunc != state.getDepthFunc()) ++changes;
+        if (blendSrc != state.m_blend_src || blendDst != state.m_blend_dst) ++changes;
+        if (alphaFunc != state.alphaFunc || alphaThreshold != state.alphaThreshold) ++changes;
+        if (polygonOffset != state.polygonOffset) ++changes;
+        if (lineWidth != state.m_linewidth) ++changes;
+        if (pointSize != state.m_pointsize) ++changes;
+        if (lineStippleFactor != state.m_linestipple_factor ||
+            lineStipplePattern != state.m_linestipple_pattern) ++changes;
+
+        return changes;
+    }
+};
+
 } // namespace
 
 // GL state enabling/disabling helpers
@@ -539,33 +600,29 @@ void OpenGLShaderPass::addRenderable(const OpenGLRenderable& renderable,
                                      const RendererLight* light,
                                      const IRenderEntity* entity)
 {
-    if (entity)
-    {
-        // Find or insert the render entity in our map
-        auto i = _renderables.find(entity);
-        if (i == _renderables.end())
-        {
-            i = _renderables.insert(std::make_pair(entity, Renderables())).first;
-        }
+    // Renderables without entity are using index 0, entities are numbered in submission order
+    std::size_t entityIndex = 0;
 
-        // Add this renderable to the list of renderables associated with the entity
-        i->second.push_back(
-            TransformedRenderable(renderable, modelview, light, entity)
-        );
-    }
-    else
+    if (entity)
     {
-        _renderablesWithoutEntity.push_back(
-            TransformedRenderable(renderable, modelview, light, nullptr)
-        );
+        entityIndex = _entityIndices.emplace(entity, _entityIndices.size() + 1).first->second;
     }
+
+    static const Matrix4 identity = Matrix4::getIdentity();
+
+    // Blended geometry needs to be drawn in the order it has been submitted
+    auto key = getRenderableSortKey(entityIndex, modelview.isAffineEqual(identity), _glState.testRenderFlag(RENDER_BLEND));
+
+    _sortedRenderables.push_back(SortedRenderable{ key, _renderables.size() });
+    _renderables.emplace_back(renderable, modelview, light, entity);
 }
 
 // Render the bucket contents
 void OpenGLShaderPass::render(OpenGLState& current,
                               unsigned int flagsMask,
                               const Vector3& viewer,
-                              std::size_t time)
+                              std::size_t time,
+                              std::size_t& stateChanges)
 {
     // Reset the texture matrix
     glMatrixMode(GL_TEXTURE);
@@ -573,31 +630,46 @@ void OpenGLShaderPass::render(OpenGLState& current,
 
     glMatrixMode(GL_MODELVIEW);
 
+    // Group the renderables by entity, each group is rendered with the state applied once
+    radixSortByKey(_sortedRenderables, _sortBuffer);
+
     // Apply our state to the current state object
-    applyState(current, flagsMask, viewer, time, NULL);
+    StateSnapshot snapshot(current);
+    applyState(current, flagsMask, viewer, time, nullptr);
+    stateChanges += snapshot.countChanges(current);
 
-    if (!_renderablesWithoutEntity.empty())
-    {
-        renderAllContained(_renderablesWithoutEntity, current, viewer, time);
-    }
+    auto i = _sortedRenderables.cbegin();
 
-    for (RenderablesByEntity::const_iterator i = _renderables.begin();
-         i != _renderables.end();
-         ++i)
+    while (i != _sortedRenderables.cend())
     {
-        // Apply our state to the current state object
-        applyState(current, flagsMask, viewer, time, i->first);
+        // Find the end of this entity's group (the lowest key bit is the transform order)
+        auto entityIndex = i->key >> 1;
+        auto groupEnd = i;
 
-        if (!stateIsActive())
+        while (groupEnd != _sortedRenderables.cend() && (groupEnd->key >> 1) == entityIndex)
         {
-            continue;
+            ++groupEnd;
         }
 
-        renderAllContained(i->second, current, viewer, time);
+        if (entityIndex > 0)
+        {
+            // Apply our state to the current state object
+            StateSnapshot entitySnapshot(current);
+            applyState(current, flagsMask, viewer, time, _renderables[i->index].entity);
+            stateChanges += entitySnapshot.countChanges(current);
+        }
+
+        if (entityIndex == 0 || stateIsActive())
+        {
+            stateChanges += renderAllContained(i, groupEnd, current, viewer, time);
+        }
+
+        i = groupEnd;
     }
 
-    _renderablesWithoutEntity.clear();
     _renderables.clear();
+    _sortedRenderables.clear();
+    _entityIndices.clear();
 }
 
 bool OpenGLShaderPass::stateIsActive()
@@ -665,24 +737,29 @@ void OpenGLShaderPass::setUpLightingCalculation(OpenGLState& current,
 }
 
 // Flush renderables
-void OpenGLShaderPass::renderAllContained(const Renderables& renderables,
+std::size_t OpenGLShaderPass::renderAllContained(SortedRenderables::const_iterator begin,
+                                          SortedRenderables::const_iterator end,
                                           OpenGLState& current,
                                           const Vector3& viewer,
                                           std::size_t time)
 {
     // Keep a pointer to the last transform matrix used
     const Matrix4* transform = nullptr;
+    std::size_t transformChanges = 0;
 
     glPushMatrix();
 
-    // Iterate over each transformed renderable in the vector
-    for (const TransformedRenderable& r : renderables)
+    // Iterate over each transformed renderable in the range
+    for (auto i = begin; i != end; ++i)
     {
+        const TransformedRenderable& r = _renderables[i->index];
+
         // If the current iteration's transform matrix was different from the
         // last, apply it and store for the next iteration
         if (!transform || !transform->isAffineEqual(r.transform))
         {
             transform = &r.transform;
+            ++transformChanges;
             glPopMatrix();
             glPushMatrix();
             glMultMatrixd(*transform);
@@ -714,6 +791,8 @@ void OpenGLShaderPass::renderAllContained(const Renderables& renderables,
 
     // Cleanup
     glPopMatrix();
+
+    return transformChanges;
 }
 
 // Stream insertion operator
@@ -3,9 +3,10 @@
 #include "math/Vector3.h"
 #include "math/Matrix4.h"
 #include "iglrender.h"
+#include "render/RenderQueue.h"
 
 #include <vector>
-#include <map>
+#include <unordered_map>
 
 /* FORWARD DECLS */
 class Matrix4;
@@ -62,13 +63,22 @@ protected:
 		{}
 	};
 
-	// Vector of transformed renderables using this state
+	// Vector of transformed renderables using this state, in submission order
 	typedef std::vector<TransformedRenderable> Renderables;
-	Renderables _renderablesWithoutEntity;
+	Renderables _renderables;
 
-	// Renderables sorted by RenderEntity
-	typedef std::map<const IRenderEntity*, Renderables> RenderablesByEntity;
-	RenderablesByEntity _renderables;
+	// Sort key and index of each renderable, see getRenderableSortKey()
+	struct SortedRenderable
+	{
+		std::uint64_t key;
+		std::size_t index;
+	};
+	typedef std::vector<SortedRenderable> SortedRenderables;
+	SortedRenderables _sortedRenderables;
+	SortedRenderables _sortBuffer;
+
+	// Render entities in the order they have been submitted, starting at 1
+	std::unordered_map<const IRenderEntity*, std::size_t> _entityIndices;
 
 protected:
 
@@ -95,8 +105,10 @@ protected:
 
 	void setupTextureMatrix(GLenum textureUnit, const IShaderLayer::Ptr& stage);
 
-	// Render all of the given TransformedRenderables
-	void renderAllContained(const Renderables& renderables,
+	// Render the TransformedRenderables in the given range of sorted renderables,
+	// returns the number of transform changes
+	std::size_t renderAllContained(SortedRenderables::const_iterator begin,
+							SortedRenderables::const_iterator end,
 							OpenGLState& current,
 						    const Vector3& viewer,
 							std::size_t time);
@@ -185,18 +197,22 @@ public:
      * \param viewer
      * Viewer location in world space.
      *
+     * \param stateChanges
+     * Counter which is incremented by the number of GL state changes
+     * (including transform changes) performed by this pass.
      */
 	void render(OpenGLState& current,
 				unsigned int flagsMask,
 				const Vector3& viewer,
-				std::size_t time);
+				std::size_t time,
+				std::size_t& stateChanges);
 
 	/**
 	 * Returns true if this shaderpass doesn't have anything to render.
 	 */
 	bool empty() const
 	{
-		return _renderables.empty() && _renderablesWithoutEntity.empty();
+		return _renderables.empty();
 	}
 
 	friend std::ostream& operator<<(std::ostream& st, const OpenGLShaderPass& self);
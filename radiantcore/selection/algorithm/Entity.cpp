@@ -139,7 +139,10 @@ void setEntityKeyValue(const std::string& key, const std::string& value)
 		return;
 	}
 	
-	// Regular key change, set value on all selected entities
+	// Regular key change, set value on all selected entities,
+	// the observers get to see the new value when all are done
+	KeyValueChangeScope changeScope;
+
 	GlobalSelectionSystem().foreachSelected([&](const scene::INodePtr& node)
 	{
 		setEntityKeyValue(node, key, value);
@@ -884,6 +884,8 @@ Vector3 getLowestVertexOfModel(const model::IModel& model, const Matrix4& localT
 				bestValue = candidate;
 			}
 		}
+
+		surface.releaseVertexArray();
 	}
 
 	return bestValue;
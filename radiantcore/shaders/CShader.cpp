@@ -28,8 +28,8 @@ CShader::CShader(const std::string& name, const ShaderDefinition& definition) :
 
 CShader::CShader(const std::string& name, const ShaderDefinition& definition, bool isInternal) :
     _isInternal(isInternal),
-    _originalTemplate(definition.shaderTemplate),
-    _template(definition.shaderTemplate),
+    _originalTemplate(definition.getTemplate()),
+    _template(definition.getTemplate()),
     _fileInfo(definition.file),
     _name(name),
     m_bInUse(false),
@@ -390,6 +390,32 @@ void CShader::revertModifications()
     _sigMaterialModified.emit();
 }
 
+void CShader::refreshFromDefinition(const ShaderDefinition& definition)
+{
+    _fileInfo = definition.file;
+
+    if (isModified())
+    {
+        _originalTemplate = definition.getTemplate();
+        return;
+    }
+
+    _originalTemplate = definition.getTemplate();
+    _template = _originalTemplate;
+
+    subscribeToTemplateChanges();
+
+    // The images will be requested again from the new template
+    _editorTexture.reset();
+    _texLightFalloff.reset();
+
+    // We need to update that layer reference vector on change
+    unrealise();
+    realise();
+
+    _sigMaterialModified.emit();
+}
+
 sigc::signal<void>& CShader::sig_materialChanged()
 {
     return _sigMaterialModified;
@@ -152,6 +152,10 @@ public:
 
     void commitModifications();
     void revertModifications() override;
+
+    // Takes the template of the given (re-parsed) definition. Pending modifications
+    // are kept, the new template will be used when they are reverted.
+    void refreshFromDefinition(const ShaderDefinition& definition);
     sigc::signal<void>& sig_materialChanged() override;
 
     void refreshImageMaps() override;
@@ -91,12 +91,20 @@ ShaderLibraryPtr Doom3ShaderSystem::loadMaterialFiles()
     // Load the shader files from the VFS
     ShaderLibraryPtr library = std::make_shared<ShaderLibrary>();
 
+    // Remember the state of the files, to pick up the changed ones later on
+    _materialFiles = std::make_unique<decl::DeclFileTracker>(materialsFolder, extension, 0);
+
     // Load each file from the global filesystem
     {
         ScopedDebugTimer timer("ShaderFiles parsed: ");
         ShaderFileLoader<ShaderLibrary> loader(GlobalFileSystem(), *library,
-            materialsFolder, extension);
+            _materialFiles->scan());
         loader.parseFiles();
+
+        for (const auto& pair : loader.getDeclaredNames())
+        {
+            _materialFiles->setDeclaredNames(pair.first, pair.second);
+        }
     }
 
     rMessage() << library->getNumDefinitions() << " shader definitions found." << std::endl;
@@ -148,6 +156,7 @@ void Doom3ShaderSystem::onFileSystemShutdown()
 void Doom3ShaderSystem::freeShaders() {
     _library->clear();
     _defLoader.reset();
+    _materialFiles.reset();
     _textureManager->checkBindings();
     activeShadersChangedNotify();
 }
@@ -157,6 +166,92 @@ void Doom3ShaderSystem::refresh() {
     realise();
 }
 
+void Doom3ShaderSystem::reloadChangedMaterials()
+{
+    ensureDefsLoaded();
+
+    if (!_materialFiles) return;
+
+    auto changes = _materialFiles->scanForChanges();
+
+    if (changes.empty())
+    {
+        rMessage() << "No changed material files found." << std::endl;
+        return;
+    }
+
+    rMessage() << "Reloading " << changes.changedFiles.size() << " changed material files, " <<
+        changes.removedFiles.size() << " files have been removed." << std::endl;
+
+    auto affectedPaths = changes.getAffectedPaths();
+
+    // The materials and tables declared by the changed and removed files, before and after the change
+    auto affectedNames = _materialFiles->getDeclaredNames(affectedPaths);
+
+    for (const auto& path : affectedPaths)
+    {
+        _materialFiles->setDeclaredNames(path, {});
+    }
+
+    // Parse the changed files into a separate library, which is spliced into ours
+    auto parsed = std::make_unique<ShaderLibrary>();
+
+    try
+    {
+        ShaderFileLoader<ShaderLibrary> loader(GlobalFileSystem(), *parsed, changes.changedFiles);
+        loader.parseFiles();
+
+        for (const auto& pair : loader.getDeclaredNames())
+        {
+            affectedNames.insert(pair.second.begin(), pair.second.end());
+            _materialFiles->setDeclaredNames(pair.first, pair.second);
+        }
+
+        // The unchanged files declaring any of these names compete for them, the file
+        // listed first by the VFS wins. Parse all of them again, in VFS order.
+        auto files = _materialFiles->getFilesDeclaring(affectedNames, affectedPaths);
+
+        if (!files.empty())
+        {
+            files.insert(files.end(), changes.changedFiles.begin(), changes.changedFiles.end());
+            _materialFiles->sortInScanOrder(files);
+
+            parsed = std::make_unique<ShaderLibrary>();
+
+            ShaderFileLoader<ShaderLibrary> precedenceLoader(GlobalFileSystem(), *parsed, files);
+            precedenceLoader.parseFiles();
+        }
+    }
+    catch (const std::runtime_error& ex)
+    {
+        rError() << ex.what() << std::endl;
+
+        // Consider all files as changed in the next run
+        _materialFiles->clear();
+        return;
+    }
+
+    auto result = _library->replaceDefinitions(affectedNames, *parsed);
+
+    for (const auto& name : result.removed)
+    {
+        _sigMaterialRemoved.emit(name);
+    }
+
+    for (const auto& name : result.added)
+    {
+        _sigMaterialCreated.emit(name);
+    }
+
+    if (!result.added.empty() || !result.removed.empty())
+    {
+        activeShadersChangedNotify();
+    }
+
+    rMessage() << result.changed.size() << " materials changed, " << result.added.size() << " added, " <<
+        result.removed.size() << " removed." << std::endl;
+}
+
 // Is the shader system realised
 bool Doom3ShaderSystem::isRealised()
 {
@@ -542,6 +637,7 @@ const StringSet& Doom3ShaderSystem::getDependencies() const
         _dependencies.insert(MODULE_XMLREGISTRY);
         _dependencies.insert(MODULE_GAMEMANAGER);
         _dependencies.insert(MODULE_FILETYPES);
+        _dependencies.insert(MODULE_COMMANDSYSTEM);
     }
 
     return _dependencies;
@@ -560,6 +656,25 @@ void Doom3ShaderSystem::initialiseModule(const IApplicationContext& ctx)
 
     // Register the mtr file extension
     GlobalFiletypes().registerPattern("material", FileTypePattern(_("Material File"), "mtr", "*.mtr"));
+
+    GlobalCommandSystem().addCommand("ShowMaterialStatistics",
+        std::bind(&Doom3ShaderSystem::showMaterialStatisticsCmd, this, std::placeholders::_1));
+    GlobalCommandSystem().addCommand("ReloadChangedMaterials",
+        std::bind(&Doom3ShaderSystem::reloadChangedMaterialsCmd, this, std::placeholders::_1));
+}
+
+void Doom3ShaderSystem::showMaterialStatisticsCmd(const cmd::ArgumentList& args)
+{
+    ensureDefsLoaded();
+
+    rMessage() << "Material definitions indexed: " << _library->getNumDefinitions() << std::endl;
+    rMessage() << "Material templates instantiated: " << _library->getNumInstantiatedTemplates() << std::endl;
+    rMessage() << "Material templates parsed: " << _library->getNumParsedTemplates() << std::endl;
+}
+
+void Doom3ShaderSystem::reloadChangedMaterialsCmd(const cmd::ArgumentList& args)
+{
+    reloadChangedMaterials();
 }
 
 // Horrible evil macro to avoid assertion failures if expr is NULL
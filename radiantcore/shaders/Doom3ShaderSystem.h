@@ -12,6 +12,7 @@
 #include "TableDefinition.h"
 #include "textures/GLTextureManager.h"
 #include "ThreadedDefLoader.h"
+#include "decl/DeclFileTracker.h"
 
 namespace shaders
 {
@@ -31,6 +32,9 @@ class Doom3ShaderSystem :
     // The ShaderFileLoader will provide a new ShaderLibrary once complete
     util::ThreadedDefLoader<ShaderLibraryPtr> _defLoader;
 
+    // The material files found by the loader, to reload the changed ones only
+    std::unique_ptr<decl::DeclFileTracker> _materialFiles;
+
 	// The manager that handles the texture caching.
 	GLTextureManagerPtr _textureManager;
 
@@ -71,6 +75,9 @@ public:
 	// Flushes the shaders from memory and reloads the material files
     void refresh() override;
 
+    // Re-parses the material files that changed since they have been loaded
+    void reloadChangedMaterials() override;
+
 	// Is the shader system realised
     bool isRealised() override;
 
@@ -154,6 +161,11 @@ private:
 
 	void testShaderExpressionParsing();
 
+    // Prints the number of indexed, instantiated and parsed material templates
+    void showMaterialStatisticsCmd(const cmd::ArgumentList& args);
+
+    void reloadChangedMaterialsCmd(const cmd::ArgumentList& args);
+
     std::string ensureNonConflictingName(const std::string& name);
 };
 
@@ -163,6 +163,11 @@ ImagePtr HeightMapExpression::getImage() const {
 	return normalMap;
 }
 
+void HeightMapExpression::forEachImageName(const std::function<void(const std::string&)>& functor) const
+{
+    heightMapExp->forEachImageName(functor);
+}
+
 std::string HeightMapExpression::getIdentifier() const {
 	std::string identifier = "_heightmap_";
 	identifier.append(heightMapExp->getIdentifier() + string::to_string(scale));
@@ -242,6 +247,12 @@ ImagePtr AddNormalsExpression::getImage() const {
     return result;
 }
 
+void AddNormalsExpression::forEachImageName(const std::function<void(const std::string&)>& functor) const
+{
+    mapExpOne->forEachImageName(functor);
+    mapExpTwo->forEachImageName(functor);
+}
+
 std::string AddNormalsExpression::getIdentifier() const {
 	std::string identifier = "_addnormals_";
 	identifier.append(mapExpOne->getIdentifier() + mapExpTwo->getIdentifier());
@@ -329,6 +340,11 @@ ImagePtr SmoothNormalsExpression::getImage() const {
     return result;
 }
 
+void SmoothNormalsExpression::forEachImageName(const std::function<void(const std::string&)>& functor) const
+{
+    mapExp->forEachImageName(functor);
+}
+
 std::string SmoothNormalsExpression::getIdentifier() const {
 	std::string identifier = "_smoothnormals_";
 	identifier.append(mapExp->getIdentifier());
@@ -395,6 +411,12 @@ ImagePtr AddExpression::getImage() const {
 	return result;
 }
 
+void AddExpression::forEachImageName(const std::function<void(const std::string&)>& functor) const
+{
+    mapExpOne->forEachImageName(functor);
+    mapExpTwo->forEachImageName(functor);
+}
+
 std::string AddExpression::getIdentifier() const
 {
 	std::string identifier = "_add_";
@@ -482,6 +504,11 @@ ImagePtr ScaleExpression::getImage() const
 	return result;
 }
 
+void ScaleExpression::forEachImageName(const std::function<void(const std::string&)>& functor) const
+{
+    mapExp->forEachImageName(functor);
+}
+
 std::string ScaleExpression::getIdentifier() const {
 	std::string identifier = "_scale_";
 	identifier.append(mapExp->getIdentifier() + string::to_string(scaleRed) + string::to_string(scaleGreen) + string::to_string(scaleBlue) + string::to_string(scaleAlpha));
@@ -541,6 +568,11 @@ ImagePtr InvertAlphaExpression::getImage() const {
 	return result;
 }
 
+void InvertAlphaExpression::forEachImageName(const std::function<void(const std::string&)>& functor) const
+{
+    mapExp->forEachImageName(functor);
+}
+
 std::string InvertAlphaExpression::getIdentifier() const {
 	std::string identifier = "_invertalpha_";
 	identifier.append(mapExp->getIdentifier());
@@ -594,6 +626,11 @@ ImagePtr InvertColorExpression::getImage() const {
 	return result;
 }
 
+void InvertColorExpression::forEachImageName(const std::function<void(const std::string&)>& functor) const
+{
+    mapExp->forEachImageName(functor);
+}
+
 std::string InvertColorExpression::getIdentifier() const {
 	std::string identifier = "_invertcolor_";
 	identifier.append(mapExp->getIdentifier());
@@ -649,6 +686,11 @@ ImagePtr MakeIntensityExpression::getImage() const {
 	return result;
 }
 
+void MakeIntensityExpression::forEachImageName(const std::function<void(const std::string&)>& functor) const
+{
+    mapExp->forEachImageName(functor);
+}
+
 std::string MakeIntensityExpression::getIdentifier() const
 {
 	std::string identifier = "_makeintensity_";
@@ -707,6 +749,11 @@ ImagePtr MakeAlphaExpression::getImage() const
 	return result;
 }
 
+void MakeAlphaExpression::forEachImageName(const std::function<void(const std::string&)>& functor) const
+{
+    mapExp->forEachImageName(functor);
+}
+
 std::string MakeAlphaExpression::getIdentifier() const
 {
 	std::string identifier = "_makealpha_";
@@ -808,6 +855,15 @@ ImagePtr ImageExpression::getImage() const
 	}
 }
 
+void ImageExpression::forEachImageName(const std::function<void(const std::string&)>& functor) const
+{
+    // Keywords like _black or _flat are resolving to the built-in bitmaps
+    if (!string::starts_with(_imgName, "_"))
+    {
+        functor(_imgName);
+    }
+}
+
 std::string ImageExpression::getIdentifier() const
 {
 	return _imgName;
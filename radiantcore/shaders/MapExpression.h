@@ -3,6 +3,7 @@
 #include <string>
 
 #include <memory>
+#include <functional>
 
 #include "ishaderexpression.h"
 #include "NamedBindable.h"
@@ -49,6 +50,10 @@ public:
     // Abstract method to be implemented
     virtual ImagePtr getImage() const = 0;
 
+    // Invokes the functor with the name of every VFS image this expression
+    // is referencing. Built-in keyword images like _black are not reported.
+    virtual void forEachImageName(const std::function<void(const std::string&)>& functor) const = 0;
+
 public: /* STATIC CONSTRUCTION METHODS */
 
 	/** Creates the a MapExpression out of the given token. Nested mapexpressions
@@ -81,6 +86,7 @@ class HeightMapExpression :
 public:
 	HeightMapExpression(DefTokeniser& token);
 	ImagePtr getImage() const override;
+    void forEachImageName(const std::function<void(const std::string&)>& functor) const override;
 	std::string getIdentifier() const override;
     std::string getExpressionString() override;
 };
@@ -93,6 +99,7 @@ class AddNormalsExpression :
 public:
 	AddNormalsExpression(DefTokeniser& token);
 	ImagePtr getImage() const override;
+    void forEachImageName(const std::function<void(const std::string&)>& functor) const override;
 	std::string getIdentifier() const override;
     std::string getExpressionString() override;
 };
@@ -104,6 +111,7 @@ class SmoothNormalsExpression :
 public:
 	SmoothNormalsExpression(DefTokeniser& token);
 	ImagePtr getImage() const override;
+    void forEachImageName(const std::function<void(const std::string&)>& functor) const override;
 	std::string getIdentifier() const override;
     std::string getExpressionString() override;
 };
@@ -114,6 +122,7 @@ class AddExpression : public MapExpression {
 public:
 	AddExpression(DefTokeniser& token);
 	ImagePtr getImage() const override;
+    void forEachImageName(const std::function<void(const std::string&)>& functor) const override;
 	std::string getIdentifier() const override;
     std::string getExpressionString() override;
 };
@@ -129,6 +138,7 @@ class ScaleExpression :
 public:
 	ScaleExpression(DefTokeniser& token);
 	ImagePtr getImage() const override;
+    void forEachImageName(const std::function<void(const std::string&)>& functor) const override;
 	std::string getIdentifier() const override;
     std::string getExpressionString() override;
 };
@@ -140,6 +150,7 @@ class InvertAlphaExpression :
 public:
 	InvertAlphaExpression(DefTokeniser& token);
 	ImagePtr getImage() const override;
+    void forEachImageName(const std::function<void(const std::string&)>& functor) const override;
 	std::string getIdentifier() const override;
     std::string getExpressionString() override;
 };
@@ -151,6 +162,7 @@ class InvertColorExpression :
 public:
 	InvertColorExpression(DefTokeniser& token);
 	ImagePtr getImage() const;
+    void forEachImageName(const std::function<void(const std::string&)>& functor) const override;
 	std::string getIdentifier() const;
     std::string getExpressionString() override;
 };
@@ -162,6 +174,7 @@ class MakeIntensityExpression :
 public:
 	MakeIntensityExpression(DefTokeniser& token);
 	ImagePtr getImage() const override;
+    void forEachImageName(const std::function<void(const std::string&)>& functor) const override;
 	std::string getIdentifier() const override;
     std::string getExpressionString() override;
 };
@@ -173,6 +186,7 @@ class MakeAlphaExpression :
 public:
 	MakeAlphaExpression(DefTokeniser& token);
 	ImagePtr getImage() const override;
+    void forEachImageName(const std::function<void(const std::string&)>& functor) const override;
 	std::string getIdentifier() const override;
     std::string getExpressionString() override;
 };
@@ -193,6 +207,7 @@ public:
 	ImageExpression(const std::string& imgName);
 
 	ImagePtr getImage() const override;
+    void forEachImageName(const std::function<void(const std::string&)>& functor) const override;
 	std::string getIdentifier() const override;
     std::string getExpressionString() override;
 };
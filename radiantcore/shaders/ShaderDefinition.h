@@ -7,18 +7,30 @@
 #include "ShaderTemplate.h"
 
 #include "string/string.h"
+#include "string/case_conv.h"
 
 namespace shaders
 {
 
 /**
  * Wrapper class that associates a ShaderTemplate with its filename.
+ *
+ * Definitions parsed from material files only store the raw block contents,
+ * the ShaderTemplate is constructed on demand the first time it is requested
+ * (usually when a CShader is created for this definition). This keeps the
+ * memory footprint of the thousands of unused material decls to a minimum.
  */
 struct ShaderDefinition
 {
-    // The shader template
-    ShaderTemplatePtr shaderTemplate;
+private:
+    // The shader template, might be empty until requested
+    mutable ShaderTemplatePtr _template;
 
+    // Name and raw decl contents, used to construct the template on demand
+    mutable std::string _name;
+    mutable std::string _blockContents;
+
+public:
     // File from which the shader was parsed
     vfs::FileInfo file;
 
@@ -26,12 +38,60 @@ struct ShaderDefinition
      */
     explicit ShaderDefinition(const ShaderTemplatePtr& templ,
                               const vfs::FileInfo& f):
-        shaderTemplate(templ),
+        _template(templ),
+        file(f)
+    {}
+
+    // Construct a definition which is lazily instantiating its template
+    explicit ShaderDefinition(const std::string& name, std::string blockContents,
+                              const vfs::FileInfo& f) :
+        _name(name),
+        _blockContents(std::move(blockContents)),
         file(f)
     {}
 
+    // Returns the shader template, constructing it if necessary
+    const ShaderTemplatePtr& getTemplate() const
+    {
+        if (!_template)
+        {
+            _template = std::make_shared<ShaderTemplate>(_name, _blockContents);
+
+            // The template is holding its own copy from now on
+            _name.clear();
+            _name.shrink_to_fit();
+            _blockContents.clear();
+            _blockContents.shrink_to_fit();
+        }
+
+        return _template;
+    }
+
+    // True if the shader template has already been instantiated
+    bool hasTemplate() const
+    {
+        return _template != nullptr;
+    }
+
+    // True if the shader template has been instantiated and its block has been parsed
+    bool isParsed() const
+    {
+        return _template && _template->isParsed();
+    }
 };
 
 typedef std::map<std::string, ShaderDefinition, string::ILess> ShaderDefinitionMap;
 
+// The names under which the material and table declarations of each file are
+// recorded for incremental reloads. The names are case-insensitive.
+inline std::string getMaterialDeclName(const std::string& materialName)
+{
+    return string::to_lower_copy(materialName);
+}
+
+inline std::string getTableDeclName(const std::string& tableName)
+{
+    return "table " + string::to_lower_copy(tableName);
+}
+
 }
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <map>
 #include <regex>
+#include <set>
 
 #include "iarchive.h"
 #include "ifilesystem.h"
@@ -27,6 +29,10 @@ template<typename ShaderLibrary_T> class ShaderFileLoader
     // List of shader definition files to parse
     std::vector<vfs::FileInfo> _files;
 
+    // The material and table declarations found in each file, including the
+    // ones that have been rejected since an earlier file defined them already
+    std::map<std::string, std::set<std::string>> _declaredNames;
+
 private:
 
     bool parseTable(const parser::BlockTokeniser::Block& block, const vfs::FileInfo& fileInfo)
@@ -47,6 +53,8 @@ private:
 
             auto table = std::make_shared<TableDefinition>(tableName, block.contents);
 
+            _declaredNames[fileInfo.fullPath()].insert(getTableDeclName(tableName));
+
             if (!_library.addTableDefinition(table))
             {
                 rError() << "[shaders] " << fileInfo.name << ": table " << tableName << " already defined." << std::endl;
@@ -88,10 +96,11 @@ private:
 
             string::replace_all(block.name, "\\", "/"); // use forward slashes
 
-            auto shaderTemplate = std::make_shared<ShaderTemplate>(block.name, block.contents);
+            // Construct the ShaderDefinition wrapper class, the template
+            // itself will be instantiated and parsed on demand
+            ShaderDefinition def(block.name, std::move(block.contents), fileInfo);
 
-            // Construct the ShaderDefinition wrapper class
-            ShaderDefinition def(shaderTemplate, fileInfo);
+            _declaredNames[fileInfo.fullPath()].insert(getMaterialDeclName(block.name));
 
             // Insert into the definitions map, if not already present
             if (!_library.addDefinition(block.name, def))
@@ -119,6 +128,19 @@ public:
         );
     }
 
+    /// Construct a ShaderFileLoader parsing the given files only
+    ShaderFileLoader(vfs::VirtualFileSystem& fs, ShaderLibrary_T& library,
+                     std::vector<vfs::FileInfo> files)
+    : _vfs(fs), _library(library), _files(std::move(files))
+    {}
+
+    // The names of the material and table declarations found in each parsed file,
+    // mapped by the file's mod-relative path (see getMaterialDeclName/getTableDeclName)
+    const std::map<std::string, std::set<std::string>>& getDeclaredNames() const
+    {
+        return _declaredNames;
+    }
+
     void parseFiles()
     {
         for (const vfs::FileInfo& fileInfo: _files)
@@ -9,13 +9,16 @@
 namespace shaders 
 {
 
+namespace
+{
+    // The file name assigned to definitions generated for missing materials and plain images
+    const char* const AUTOGENERATED_FILENAME = "_autogenerated_by_darkradiant_.mtr";
+}
+
 // Insert into the definitions map, if not already present
-bool ShaderLibrary::addDefinition(const std::string& name,
-								  const ShaderDefinition& def)
+bool ShaderLibrary::addDefinition(const std::string& name, ShaderDefinition def)
 {
-	std::pair<ShaderDefinitionMap::iterator, bool> result = _definitions.insert(
-		ShaderDefinitionMap::value_type(name, def)
-	);
+	auto result = _definitions.emplace(name, std::move(def));
 
 	return result.second;
 }
@@ -32,10 +35,8 @@ ShaderDefinition& ShaderLibrary::getDefinition(const std::string& name)
 	}
 
 	// The shader definition hasn't been found, let's check if the name
-	// refers to a file in the VFS
-	ImagePtr img = GlobalImageLoader().imageFromVFS(name);
-
-	if (img)
+	// refers to a file in the VFS (without decoding the image)
+	if (GlobalImageLoader().imageExistsInVFS(name))
 	{
 		// Create a new template with this name
 		ShaderTemplatePtr shaderTemplate(new ShaderTemplate(name, ""));
@@ -46,7 +47,7 @@ ShaderDefinition& ShaderLibrary::getDefinition(const std::string& name)
 
 		// Take this empty shadertemplate and create a ShaderDefinition
 		ShaderDefinition def(shaderTemplate,
-            vfs::FileInfo("materials/", "_autogenerated_by_darkradiant_.mtr", vfs::Visibility::HIDDEN));
+            vfs::FileInfo("materials/", AUTOGENERATED_FILENAME, vfs::Visibility::HIDDEN));
 
 		// Insert the shader definition and set the iterator to it
 		i = _definitions.emplace(name, def).first;
@@ -64,7 +65,7 @@ ShaderDefinition& ShaderLibrary::getDefinition(const std::string& name)
 		// Take this empty shadertemplate and create a ShaderDefinition
         // Make the definition VFS-visible to let them show in MediaBrowser (#5475)
 		ShaderDefinition def(shaderTemplate,
-            vfs::FileInfo("materials/", "_autogenerated_by_darkradiant_.mtr", vfs::Visibility::NORMAL));
+            vfs::FileInfo("materials/", AUTOGENERATED_FILENAME, vfs::Visibility::NORMAL));
 
 		// Insert the shader definition and set the iterator to it
 		i = _definitions.emplace(name, def).first;
@@ -99,6 +100,9 @@ void ShaderLibrary::copyDefinition(const std::string& nameOfOriginal, const std:
 
     auto found = _definitions.find(nameOfOriginal);
 
+    // Instantiate the template before copying, both definitions share the same one
+    found->second.getTemplate();
+
     auto result = _definitions.emplace(nameOfCopy, found->second);
     result.first->second.file = vfs::FileInfo{"", "", vfs::Visibility::HIDDEN};
 }
@@ -147,7 +151,7 @@ ShaderDefinition& ShaderLibrary::getEmptyDefinition()
             "\"description\"\t\"This material is internal and has no corresponding declaration\"");
 
         _emptyDefinition = std::make_unique<ShaderDefinition>(shaderTemplate,
-            vfs::FileInfo("materials/", "_autogenerated_by_darkradiant_.mtr", vfs::Visibility::HIDDEN));
+            vfs::FileInfo("materials/", AUTOGENERATED_FILENAME, vfs::Visibility::HIDDEN));
     }
 
     return *_emptyDefinition;
@@ -191,6 +195,30 @@ std::size_t ShaderLibrary::getNumDefinitions()
 	return _definitions.size();
 }
 
+std::size_t ShaderLibrary::getNumInstantiatedTemplates()
+{
+    std::size_t count = 0;
+
+    for (const auto& pair : _definitions)
+    {
+        if (pair.second.hasTemplate()) ++count;
+    }
+
+    return count;
+}
+
+std::size_t ShaderLibrary::getNumParsedTemplates()
+{
+    std::size_t count = 0;
+
+    for (const auto& pair : _definitions)
+    {
+        if (pair.second.isParsed()) ++count;
+    }
+
+    return count;
+}
+
 void ShaderLibrary::foreachShaderName(const ShaderNameCallback& callback)
 {
     for (const auto& pair : _definitions)
@@ -222,4 +250,87 @@ bool ShaderLibrary::addTableDefinition(const TableDefinitionPtr& def)
     return result.second;
 }
 
+ShaderLibrary::ReplacedDefinitions ShaderLibrary::replaceDefinitions(
+    const std::set<std::string>& declNames, ShaderLibrary& parsed)
+{
+    ReplacedDefinitions result;
+
+    // Definitions which are no longer declared by any file,
+    // materials with unsaved modifications are left alone
+    for (const auto& pair : _definitions)
+    {
+        if (declNames.count(getMaterialDeclName(pair.first)) == 0 || parsed.definitionExists(pair.first))
+        {
+            continue;
+        }
+
+        auto shader = _shaders.find(pair.first);
+
+        if (shader == _shaders.end() || !shader->second->isModified())
+        {
+            result.removed.push_back(pair.first);
+        }
+    }
+
+    for (const auto& name : result.removed)
+    {
+        removeDefinition(name);
+    }
+
+    for (auto& pair : parsed._definitions)
+    {
+        // The parsed files might declare other materials too, these are left alone
+        if (declNames.count(getMaterialDeclName(pair.first)) == 0)
+        {
+            continue;
+        }
+
+        auto existing = _definitions.find(pair.first);
+
+        if (existing == _definitions.end())
+        {
+            _definitions.emplace(pair.first, std::move(pair.second));
+            result.added.push_back(pair.first);
+            continue;
+        }
+
+        // This replaces the definitions generated for missing materials too
+        existing->second = std::move(pair.second);
+        result.changed.push_back(pair.first);
+    }
+
+    for (auto i = _tables.begin(); i != _tables.end();)
+    {
+        if (declNames.count(getTableDeclName(i->first)) > 0 && parsed._tables.count(i->first) == 0)
+        {
+            i = _tables.erase(i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    for (const auto& pair : parsed._tables)
+    {
+        if (declNames.count(getTableDeclName(pair.first)) > 0)
+        {
+            _tables[pair.first] = pair.second;
+        }
+    }
+
+    // Let the active shaders pick up their new template
+    for (const auto& name : result.changed)
+    {
+        auto shader = _shaders.find(name);
+
+        if (shader != _shaders.end())
+        {
+            shader->second->refreshFromDefinition(_definitions.at(name));
+        }
+    }
+
+    return result;
+}
+
 } // namespace shaders
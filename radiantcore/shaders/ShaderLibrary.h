@@ -2,6 +2,8 @@
 
 #include <string>
 #include <map>
+#include <set>
+#include <vector>
 #include <memory>
 #include "CShader.h"
 #include "TableDefinition.h"
@@ -29,7 +31,7 @@ public:
 	/* greebo: Add a shader definition to the internal list
 	 * @returns: FALSE, if such a name already exists, TRUE otherwise
 	 */
-	bool addDefinition(const std::string& name, const ShaderDefinition& def);
+	bool addDefinition(const std::string& name, ShaderDefinition def);
 
 	/* greebo: Trys to lookup the named shader definition and returns
 	 * its reference. Always returns a valid reference.
@@ -63,6 +65,12 @@ public:
 	// Get the number of known shaders
 	std::size_t getNumDefinitions();
 
+    // Returns the number of definitions which had their ShaderTemplate instantiated
+    std::size_t getNumInstantiatedTemplates();
+
+    // Returns the number of definitions which had their decl block parsed
+    std::size_t getNumParsedTemplates();
+
 	/* greebo: Retrieves the shader with the given name.
 	 *
 	 * @returns: the according CShaderPtr, this may also
@@ -80,6 +88,20 @@ public:
 
     // Method for adding tables, returns FALSE if a def with the same name already exists
     bool addTableDefinition(const TableDefinitionPtr& def);
+
+    // The names affected by replaceDefinitions()
+    struct ReplacedDefinitions
+    {
+        std::vector<std::string> added;
+        std::vector<std::string> changed;
+        std::vector<std::string> removed;
+    };
+
+    // Replaces the materials and tables of the given declaration names (see getMaterialDeclName
+    // and getTableDeclName) with the ones of the given library, which has to contain all files
+    // declaring these names. The ones missing in that library are removed. Existing shaders
+    // are refreshed from their new definition, all other declarations are left alone.
+    ReplacedDefinitions replaceDefinitions(const std::set<std::string>& declNames, ShaderLibrary& parsed);
 };
 typedef std::shared_ptr<ShaderLibrary> ShaderLibraryPtr;
 
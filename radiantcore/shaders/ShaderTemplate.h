@@ -167,6 +167,12 @@ public:
 		_name = name;
 	}
 
+    // Returns true if the block contents have already been parsed
+    bool isParsed() const
+    {
+        return _parsed;
+    }
+
 	const std::string& getDescription()
 	{
 		if (!_parsed) parseDefinition();
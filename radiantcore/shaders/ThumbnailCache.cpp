@@ -0,0 +1,419 @@
+#include "ThumbnailCache.h"
+
+#include <fstream>
+#include <thread>
+#include "itextstream.h"
+#include "ifilesystem.h"
+#include "iimage.h"
+
+#include "MapExpression.h"
+#include "image/ThumbnailGenerator.h"
+#include "module/StaticModule.h"
+#include "os/dir.h"
+#include "os/file.h"
+#include "fmt/format.h"
+
+namespace shaders
+{
+
+namespace
+{
+    // Thumbnails are fitting into a square of this size
+    constexpr std::size_t THUMBNAIL_SIZE = 128;
+
+    // Bump this when the file format or the generation algorithm changes
+    constexpr std::uint32_t THUMBNAIL_FILE_VERSION = 2;
+    constexpr char THUMBNAIL_FILE_MAGIC[4] = { 'D', 'R', 'T', 'N' };
+
+    struct ThumbnailFileHeader
+    {
+        char magic[4];
+        std::uint32_t version;
+        std::uint64_t fingerprint;
+        std::uint32_t sourceWidth;
+        std::uint32_t sourceHeight;
+        std::uint32_t width;
+        std::uint32_t height;
+    };
+
+    // 64-bit FNV-1a, to get file names and fingerprints that are stable across builds
+    inline std::uint64_t hashString(const std::string& str, std::uint64_t hash = 14695981039346656037ull)
+    {
+        for (auto c : str)
+        {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211ull;
+        }
+
+        return hash;
+    }
+
+    // Returns the expression the material's editor image is generated from
+    // This is the editor image expression, or the first non-bump and non-specular stage
+    std::string getEditorImageExpressionString(Material& material)
+    {
+        auto editorImage = material.getEditorImageExpression();
+
+        if (editorImage)
+        {
+            return editorImage->getExpressionString();
+        }
+
+        for (const auto& layer : material.getAllLayers())
+        {
+            if (layer->getType() != IShaderLayer::BUMP && layer->getType() != IShaderLayer::SPECULAR &&
+                layer->getMapExpression())
+            {
+                return layer->getMapExpression()->getExpressionString();
+            }
+        }
+
+        return std::string();
+    }
+
+    // The fingerprint covers the expression and the VFS setup, the same path might
+    // resolve to a different image file when switching mods. The size and
+    // modification stamp of every referenced image file are included too,
+    // such that edited textures are getting a new thumbnail.
+    std::uint64_t calculateFingerprint(const std::string& expression)
+    {
+        auto fingerprint = hashString(expression);
+
+        for (const auto& searchPath : GlobalFileSystem().getVfsSearchPaths())
+        {
+            fingerprint = hashString(searchPath, fingerprint);
+        }
+
+        auto mapExpression = MapExpression::createForString(expression);
+
+        if (!mapExpression)
+        {
+            return fingerprint;
+        }
+
+        mapExpression->forEachImageName([&](const std::string& imageName)
+        {
+            auto imagePath = GlobalImageLoader().findImageFileInVFS(imageName);
+
+            if (imagePath.empty())
+            {
+                return;
+            }
+
+            auto fileInfo = GlobalFileSystem().getFileInfo(imagePath);
+
+            fingerprint = hashString(imagePath, fingerprint);
+            fingerprint = hashString(std::to_string(fileInfo.getSize()), fingerprint);
+            fingerprint = hashString(std::to_string(fileInfo.getLastModified()), fingerprint);
+        });
+
+        return fingerprint;
+    }
+}
+
+ThumbnailCache::ThumbnailCache() :
+    _generation(0),
+    _clearCount(0)
+{}
+
+image::Thumbnail::Ptr ThumbnailCache::getThumbnail(const std::string& materialName)
+{
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+
+        auto existing = _thumbnails.find(materialName);
+
+        if (existing != _thumbnails.end())
+        {
+            return existing->second;
+        }
+
+        if (_pending.count(materialName) > 0)
+        {
+            return image::Thumbnail::Ptr();
+        }
+    }
+
+    // Materials can only be acquired on the main thread
+    auto material = GlobalMaterialManager().getMaterial(materialName);
+    auto expression = material ? getEditorImageExpressionString(*material) : std::string();
+
+    std::lock_guard<std::mutex> lock(_lock);
+
+    if (expression.empty() || !_workers)
+    {
+        // Nothing to generate, client code is supposed to use the material's editor image
+        return _thumbnails.emplace(materialName, std::make_shared<image::Thumbnail>()).first->second;
+    }
+
+    _pending.insert(materialName);
+
+    auto clearCount = _clearCount;
+
+    _workers->enqueue([=]()
+    {
+        processThumbnail(materialName, expression, clearCount);
+    });
+
+    return image::Thumbnail::Ptr();
+}
+
+std::size_t ThumbnailCache::getGeneration() const
+{
+    return _generation;
+}
+
+bool ThumbnailCache::hasPendingThumbnails() const
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    return !_pending.empty();
+}
+
+void ThumbnailCache::waitForPendingThumbnails()
+{
+    if (_workers)
+    {
+        _workers->waitForIdle();
+    }
+}
+
+void ThumbnailCache::clear()
+{
+    if (_workers)
+    {
+        _workers->clearPendingTasks();
+    }
+
+    std::lock_guard<std::mutex> lock(_lock);
+
+    _thumbnails.clear();
+    _pending.clear();
+    ++_clearCount;
+}
+
+void ThumbnailCache::processThumbnail(const std::string& materialName, const std::string& expression,
+    std::size_t clearCount)
+{
+    // The workers are looking up and reading the image files through the VFS. Concurrent
+    // reads are fine (archives guard their streams, the decl managers are parsing their
+    // files on worker threads too), only a VFS shutdown would pull the archives from under
+    // our feet, which is why onFileSystemShutdown() waits for the running tasks.
+    auto fingerprint = calculateFingerprint(expression);
+    auto filename = getCacheFilename(expression);
+    auto thumbnail = loadThumbnailFile(filename, fingerprint);
+
+    if (!thumbnail)
+    {
+        thumbnail = generateThumbnail(expression);
+
+        if (thumbnail->image)
+        {
+            saveThumbnailFile(filename, fingerprint, *thumbnail);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+
+        // Discard the result if the cache has been cleared in the meantime
+        if (clearCount != _clearCount)
+        {
+            return;
+        }
+
+        _thumbnails[materialName] = thumbnail;
+        _pending.erase(materialName);
+    }
+
+    ++_generation;
+}
+
+image::Thumbnail::Ptr ThumbnailCache::generateThumbnail(const std::string& expression)
+{
+    auto thumbnail = std::make_shared<image::Thumbnail>();
+
+    try
+    {
+        auto mapExpression = MapExpression::createForString(expression);
+        auto sourceImage = mapExpression ? mapExpression->getImage() : ImagePtr();
+
+        if (!sourceImage)
+        {
+            return thumbnail;
+        }
+
+        // Precompressed images are not supported, the image will remain empty
+        thumbnail->image = image::createThumbnail(*sourceImage, THUMBNAIL_SIZE);
+        thumbnail->sourceWidth = sourceImage->getWidth();
+        thumbnail->sourceHeight = sourceImage->getHeight();
+    }
+    catch (const std::exception& ex)
+    {
+        rWarning() << "Failed to generate thumbnail for " << expression << ": " << ex.what() << std::endl;
+    }
+
+    return thumbnail;
+}
+
+std::string ThumbnailCache::getCacheFilename(const std::string& expression) const
+{
+    return fmt::format("{0}{1:016x}.thumb", _cachePath, hashString(expression));
+}
+
+image::Thumbnail::Ptr ThumbnailCache::loadThumbnailFile(const std::string& filename, std::uint64_t fingerprint)
+{
+    std::ifstream stream(filename, std::ios::binary);
+
+    if (!stream)
+    {
+        return image::Thumbnail::Ptr();
+    }
+
+    ThumbnailFileHeader header;
+    stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    if (!stream || std::string(header.magic, 4) != std::string(THUMBNAIL_FILE_MAGIC, 4) ||
+        header.version != THUMBNAIL_FILE_VERSION || header.fingerprint != fingerprint ||
+        header.width == 0 || header.height == 0 ||
+        header.width > THUMBNAIL_SIZE || header.height > THUMBNAIL_SIZE)
+    {
+        return image::Thumbnail::Ptr(); // outdated or invalid, will be overwritten
+    }
+
+    auto thumbnailImage = std::make_shared<RGBAImage>(header.width, header.height);
+    stream.read(reinterpret_cast<char*>(thumbnailImage->getPixels()), header.width * header.height * sizeof(RGBAPixel));
+
+    if (!stream)
+    {
+        return image::Thumbnail::Ptr();
+    }
+
+    auto thumbnail = std::make_shared<image::Thumbnail>();
+
+    thumbnail->image = thumbnailImage;
+    thumbnail->sourceWidth = header.sourceWidth;
+    thumbnail->sourceHeight = header.sourceHeight;
+
+    return thumbnail;
+}
+
+void ThumbnailCache::saveThumbnailFile(const std::string& filename, std::uint64_t fingerprint, const image::Thumbnail& thumbnail)
+{
+    ThumbnailFileHeader header;
+
+    std::copy(THUMBNAIL_FILE_MAGIC, THUMBNAIL_FILE_MAGIC + 4, header.magic);
+    header.version = THUMBNAIL_FILE_VERSION;
+    header.fingerprint = fingerprint;
+    header.sourceWidth = static_cast<std::uint32_t>(thumbnail.sourceWidth);
+    header.sourceHeight = static_cast<std::uint32_t>(thumbnail.sourceHeight);
+    header.width = static_cast<std::uint32_t>(thumbnail.image->getWidth());
+    header.height = static_cast<std::uint32_t>(thumbnail.image->getHeight());
+
+    // Write to a temporary file first, such that no other thread or
+    // DarkRadiant instance can pick up a half-written file
+    auto tempFilename = fmt::format("{0}.{1}.tmp", filename, std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+    {
+        std::ofstream stream(tempFilename, std::ios::binary);
+
+        stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        stream.write(reinterpret_cast<const char*>(thumbnail.image->getPixels()),
+            header.width * header.height * sizeof(RGBAPixel));
+
+        if (!stream)
+        {
+            rWarning() << "Failed to write thumbnail file " << tempFilename << std::endl;
+            return;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(tempFilename, filename, ec);
+
+    if (ec)
+    {
+        rWarning() << "Failed to move thumbnail file to " << filename << ": " << ec.message() << std::endl;
+        fs::remove(tempFilename, ec);
+    }
+}
+
+void ThumbnailCache::onFileSystemShutdown()
+{
+    // Discard the queued tasks and let the running ones finish before the archives are gone
+    clear();
+    waitForPendingThumbnails();
+}
+
+void ThumbnailCache::clearThumbnailCacheCmd(const cmd::ArgumentList& args)
+{
+    clear();
+
+    if (os::fileOrDirExists(_cachePath))
+    {
+        os::removeDirectory(_cachePath);
+    }
+
+    os::makeDirectory(_cachePath);
+
+    rMessage() << "Thumbnail cache cleared." << std::endl;
+}
+
+const std::string& ThumbnailCache::getName() const
+{
+    static std::string _name(MODULE_THUMBNAILCACHE);
+    return _name;
+}
+
+const StringSet& ThumbnailCache::getDependencies() const
+{
+    static StringSet _dependencies;
+
+    if (_dependencies.empty())
+    {
+        _dependencies.insert(MODULE_SHADERSYSTEM);
+        _dependencies.insert(MODULE_IMAGELOADER);
+        _dependencies.insert(MODULE_VIRTUALFILESYSTEM);
+        _dependencies.insert(MODULE_COMMANDSYSTEM);
+    }
+
+    return _dependencies;
+}
+
+void ThumbnailCache::initialiseModule(const IApplicationContext& ctx)
+{
+    rMessage() << getName() << "::initialiseModule called." << std::endl;
+
+    _cachePath = ctx.getCacheDataPath() + "thumbnails/";
+    os::makeDirectory(_cachePath);
+
+    // Leave one core to the main thread
+    _workers = std::make_unique<util::ThreadPool>(std::max<std::size_t>(util::ThreadPool::GetDefaultNumWorkers() - 1, 1));
+
+    // Material definitions might change on reload, discard everything in that case
+    GlobalFileSystem().addObserver(*this);
+
+    _materialsUnloadedConn = GlobalMaterialManager().signal_DefsUnloaded().connect(
+        sigc::mem_fun(this, &ThumbnailCache::clear)
+    );
+
+    GlobalCommandSystem().addCommand("ClearThumbnailCache",
+        std::bind(&ThumbnailCache::clearThumbnailCacheCmd, this, std::placeholders::_1));
+}
+
+void ThumbnailCache::shutdownModule()
+{
+    _materialsUnloadedConn.disconnect();
+    GlobalFileSystem().removeObserver(*this);
+
+    // Discard any unstarted tasks and wait for the running ones
+    _workers.reset();
+
+    std::lock_guard<std::mutex> lock(_lock);
+    _thumbnails.clear();
+    _pending.clear();
+}
+
+// Static module instance
+module::StaticModule<ThumbnailCache> thumbnailCacheModule;
+
+}
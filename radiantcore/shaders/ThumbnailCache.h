@@ -0,0 +1,87 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <sigc++/connection.h>
+
+#include "ishaders.h"
+#include "ithumbnailcache.h"
+#include "icommandsystem.h"
+#include "ifilesystem.h"
+#include "ThreadPool.h"
+#include "string/string.h"
+
+namespace shaders
+{
+
+/**
+ * Implementation of the IThumbnailCache module. Thumbnails are generated
+ * from the material's editor image expression on a pool of worker threads,
+ * and written to the thumbnails/ folder in the cache data path.
+ *
+ * The on-disk files are named after the editor image expression, such
+ * that materials sharing the same editor image share the same thumbnail.
+ */
+class ThumbnailCache final :
+    public image::IThumbnailCache,
+    public vfs::VirtualFileSystem::Observer
+{
+private:
+    // Folder the thumbnail files are stored in
+    std::string _cachePath;
+
+    mutable std::mutex _lock;
+
+    // Thumbnails by material name, the contained image is empty
+    // for materials we failed to generate thumbnails for
+    std::map<std::string, image::Thumbnail::Ptr, string::ILess> _thumbnails;
+
+    // Names of the materials currently queued for generation
+    std::set<std::string, string::ILess> _pending;
+
+    std::atomic<std::size_t> _generation;
+
+    // Incremented on clear(), results of tasks started before are discarded
+    std::size_t _clearCount;
+
+    std::unique_ptr<util::ThreadPool> _workers;
+
+    sigc::connection _materialsUnloadedConn;
+
+public:
+    ThumbnailCache();
+
+    image::Thumbnail::Ptr getThumbnail(const std::string& materialName) override;
+    std::size_t getGeneration() const override;
+    bool hasPendingThumbnails() const override;
+    void waitForPendingThumbnails() override;
+    void clear() override;
+
+    // RegisterableModule implementation
+    const std::string& getName() const override;
+    const StringSet& getDependencies() const override;
+    void initialiseModule(const IApplicationContext& ctx) override;
+    void shutdownModule() override;
+
+    // VirtualFileSystem::Observer implementation
+    void onFileSystemShutdown() override;
+
+private:
+    // Worker function, loads the thumbnail from disk or generates a new one
+    void processThumbnail(const std::string& materialName, const std::string& expression,
+                          std::size_t clearCount);
+
+    image::Thumbnail::Ptr generateThumbnail(const std::string& expression);
+
+    std::string getCacheFilename(const std::string& expression) const;
+
+    image::Thumbnail::Ptr loadThumbnailFile(const std::string& filename, std::uint64_t fingerprint);
+    void saveThumbnailFile(const std::string& filename, std::uint64_t fingerprint, const image::Thumbnail& thumbnail);
+
+    void clearThumbnailCacheCmd(const cmd::ArgumentList& args);
+};
+
+}
@@ -4,8 +4,11 @@
 #include "ifilesystem.h"
 #include "iarchive.h"
 #include "module/StaticModule.h"
+#include "ThreadPool.h"
 
+#include <algorithm>
 #include <iostream>
+#include <iterator>
 
 namespace skins
 {
@@ -16,8 +19,30 @@ namespace
     const char* const SKINS_FOLDER = "skins/";
 }
 
+struct Doom3SkinCache::ParsedSkinFile
+{
+    std::string filename;
+
+    // The skins in the order they appear in the file, with
+    // the models each of them has been associated to
+    std::vector<std::pair<Doom3ModelSkinPtr, StringList>> skins;
+
+    std::set<std::string> getSkinNames() const
+    {
+        std::set<std::string> names;
+
+        for (const auto& pair : skins)
+        {
+            names.insert(pair.first->getName());
+        }
+
+        return names;
+    }
+};
+
 Doom3SkinCache::Doom3SkinCache() :
     _defLoader(std::bind(&Doom3SkinCache::loadSkinFiles, this)),
+    _skinFiles(SKINS_FOLDER, "skin"),
     _nullSkin("")
 {}
 
@@ -32,8 +57,12 @@ ModelSkin& Doom3SkinCache::capture(const std::string& name)
 
 const StringList& Doom3SkinCache::getSkinsForModel(const std::string& model) 
 {
+    static StringList _emptyList;
+
     ensureDefsLoaded();
-    return _modelSkins[model];
+
+    auto found = _modelSkins.find(model);
+    return found != _modelSkins.end() ? found->second : _emptyList;
 }
 
 const StringList& Doom3SkinCache::getAllSkins()
@@ -69,38 +98,28 @@ void Doom3SkinCache::ensureDefsLoaded()
 
 void Doom3SkinCache::loadSkinFiles()
 {
-	rMessage() << "[skins] Loading skins." << std::endl;
+    if (!_skinFiles.hasSnapshot())
+    {
+        rMessage() << "[skins] Loading skins." << std::endl;
 
-	// Use a functor to traverse the skins directory, catching any parse
-	// exceptions that may be thrown
-	try
-	{
-        GlobalFileSystem().forEachFile(
-            SKINS_FOLDER, "skin",
-            [&] (const vfs::FileInfo& fileInfo)
-            {
-                // Open the .skin file and get its contents as a std::string
-                auto file = GlobalFileSystem().openTextFile(SKINS_FOLDER + fileInfo.name);
-                assert(file);
-
-                std::istream is(&(file->getInputStream()));
-
-                try 
-                {
-                    // Pass the contents back to the SkinCache module for parsing
-                    parseFile(is, fileInfo.name);
-                }
-                catch (parser::ParseException& e)
-                {
-                    rError() << "[skins]: in " << fileInfo.name << ": " << e.what() << std::endl;
-                }
-            }
-        );
-	}
-	catch (parser::ParseException& e)
-	{
-        rError() << "[skins]: " << e.what() << std::endl;
-	}
+        auto files = _skinFiles.scan();
+        auto parsedFiles = parseSkinFiles(files);
+
+        for (auto& parsedFile : parsedFiles)
+        {
+            _skinFiles.setDeclaredNames(SKINS_FOLDER + parsedFile.filename, parsedFile.getSkinNames());
+            mergeSkinFile(parsedFile);
+        }
+    }
+    else
+    {
+        auto changes = _skinFiles.scanForChanges();
+
+        rMessage() << "[skins] Reloading " << changes.changedFiles.size() << " changed skin files, " <<
+            changes.removedFiles.size() << " files have been removed." << std::endl;
+
+        reloadChangedSkinFiles(changes);
+    }
 
     rMessage() << "[skins] Found " << _allSkins.size() << " skins." << std::endl;
 
@@ -108,50 +127,197 @@ void Doom3SkinCache::loadSkinFiles()
 	_sigSkinsReloaded.emit();
 }
 
-// Parse the contents of a .skin file
-void Doom3SkinCache::parseFile(std::istream& contents, const std::string& filename)
+void Doom3SkinCache::reloadChangedSkinFiles(const decl::DeclFileTracker::Changes& changes)
 {
-    // Construct a DefTokeniser to parse the file
-	parser::BasicDefTokeniser<std::istream> tok(contents);
+    auto affectedPaths = changes.getAffectedPaths();
+
+    // The skins declared by the changed and removed files, before and after the change
+    auto affectedSkins = _skinFiles.getDeclaredNames(affectedPaths);
+    auto parsedFiles = parseSkinFiles(changes.changedFiles);
+
+    for (const auto& fileInfo : changes.removedFiles)
+    {
+        _skinFiles.setDeclaredNames(fileInfo.fullPath(), {});
+    }
+
+    for (const auto& parsedFile : parsedFiles)
+    {
+        auto names = parsedFile.getSkinNames();
+        affectedSkins.insert(names.begin(), names.end());
+
+        _skinFiles.setDeclaredNames(SKINS_FOLDER + parsedFile.filename, std::move(names));
+    }
+
+    // The unchanged files declaring any of these skins compete for them,
+    // the file listed first by the VFS wins. These need to be parsed again too.
+    auto otherFiles = _skinFiles.getFilesDeclaring(affectedSkins, affectedPaths);
+    auto otherParsedFiles = parseSkinFiles(otherFiles);
+
+    std::move(otherParsedFiles.begin(), otherParsedFiles.end(), std::back_inserter(parsedFiles));
+
+    // Bring the parsed files into VFS order
+    auto files = changes.changedFiles;
+    files.insert(files.end(), otherFiles.begin(), otherFiles.end());
+    _skinFiles.sortInScanOrder(files);
+
+    std::map<std::string, ParsedSkinFile*> parsedFilesByName;
+
+    for (auto& parsedFile : parsedFiles)
+    {
+        parsedFilesByName.emplace(parsedFile.filename, &parsedFile);
+    }
+
+    // Drop the affected skins and merge them again, like a full load would do
+    removeSkins(affectedSkins);
+
+    for (const auto& fileInfo : files)
+    {
+        mergeSkinFile(*parsedFilesByName.at(fileInfo.name), &affectedSkins);
+    }
+}
+
+std::vector<Doom3SkinCache::ParsedSkinFile> Doom3SkinCache::parseSkinFiles(const std::vector<vfs::FileInfo>& files)
+{
+    util::ThreadPool workers;
+    std::vector<std::future<ParsedSkinFile>> parsedFiles;
+
+    for (const auto& fileInfo : files)
+    {
+        parsedFiles.emplace_back(workers.submit([fileInfo]() { return parseSkinFile(fileInfo); }));
+    }
+
+    // The results are returned in the order of the given files
+    std::vector<ParsedSkinFile> result;
+    result.reserve(parsedFiles.size());
 
-	// Call the parseSkin() function for each skin decl
-	while (tok.hasMoreTokens())
+    for (auto& parsedFile : parsedFiles)
     {
-		try
+        result.emplace_back(parsedFile.get());
+    }
+
+    return result;
+}
+
+void Doom3SkinCache::removeSkins(const std::set<std::string>& skinNames)
+{
+    std::set<std::string> removedSkins;
+
+    for (const auto& name : skinNames)
+    {
+        if (_namedSkins.erase(name) > 0)
+        {
+            removedSkins.insert(name);
+        }
+    }
+
+    if (removedSkins.empty()) return;
+
+    auto isRemoved = [&](const std::string& skinName) { return removedSkins.count(skinName) > 0; };
+
+    _allSkins.erase(std::remove_if(_allSkins.begin(), _allSkins.end(), isRemoved), _allSkins.end());
+
+    for (auto i = _modelSkins.begin(); i != _modelSkins.end();)
+    {
+        auto& skins = i->second;
+        skins.erase(std::remove_if(skins.begin(), skins.end(), isRemoved), skins.end());
+
+        if (skins.empty())
         {
-			// Try to parse the skin
-			Doom3ModelSkinPtr modelSkin = parseSkin(tok);
-			std::string skinName = modelSkin->getName();
+            i = _modelSkins.erase(i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
+Doom3SkinCache::ParsedSkinFile Doom3SkinCache::parseSkinFile(const vfs::FileInfo& fileInfo)
+{
+    ParsedSkinFile result;
+    result.filename = fileInfo.name;
+
+    // Open the .skin file and get its contents as a std::string
+    auto file = GlobalFileSystem().openTextFile(SKINS_FOLDER + fileInfo.name);
+
+    if (!file)
+    {
+        rError() << "[skins] Unable to open " << fileInfo.name << std::endl;
+        return result;
+    }
 
-			modelSkin->setSkinFileName(filename);
+    try
+    {
+        std::istream is(&(file->getInputStream()));
 
-			auto found = _namedSkins.find(skinName);
+        // Construct a DefTokeniser to parse the file
+        parser::BasicDefTokeniser<std::istream> tok(is);
 
-			// Is this already defined?
-			if (found != _namedSkins.end()) 
+        // Call the parseSkin() function for each skin decl
+        while (tok.hasMoreTokens())
+        {
+            try
             {
-                rWarning() << "[skins] in " << filename << ": skin " + skinName +
-						     " previously defined in " +
-							 found->second->getSkinFileName() + "!" << std::endl;
-				// Don't insert the skin into the list
-			}
-			else
+                StringList models;
+                auto modelSkin = parseSkin(tok, models);
+
+                modelSkin->setSkinFileName(fileInfo.name);
+
+                result.skins.emplace_back(modelSkin, std::move(models));
+            }
+            catch (parser::ParseException& e)
             {
-				// Add the populated Doom3ModelSkin to the hashtable and the name to the
-				// list of all skins
-				_namedSkins.emplace(skinName, modelSkin);
-				_allSkins.emplace_back(skinName);
-			}
-		}
-		catch (parser::ParseException& e)
+                rWarning() << "[skins]: in " << fileInfo.name << ": " << e.what() << std::endl;
+            }
+        }
+    }
+    catch (parser::ParseException& e)
+    {
+        rError() << "[skins]: in " << fileInfo.name << ": " << e.what() << std::endl;
+    }
+
+    return result;
+}
+
+void Doom3SkinCache::mergeSkinFile(ParsedSkinFile& parsedFile, const std::set<std::string>* skinNames)
+{
+    for (auto& pair : parsedFile.skins)
+    {
+        const auto& modelSkin = pair.first;
+        const auto& skinName = modelSkin->getName();
+
+        if (skinNames && skinNames->count(skinName) == 0)
         {
-            rWarning() << "[skins]: in " << filename << ": " << e.what() << std::endl;
-		}
-	}
+            continue;
+        }
+
+        auto found = _namedSkins.find(skinName);
+
+        // Is this already defined?
+        if (found != _namedSkins.end())
+        {
+            rWarning() << "[skins] in " << parsedFile.filename << ": skin " + skinName +
+                " previously defined in " +
+                found->second->getSkinFileName() + "!" << std::endl;
+            // Don't insert the skin into the list
+            continue;
+        }
+
+        // Add the populated Doom3ModelSkin to the hashtable and the name to the
+        // list of all skins
+        _namedSkins.emplace(skinName, modelSkin);
+        _allSkins.emplace_back(skinName);
+
+        // Associate the skin to its models
+        for (const auto& model : pair.second)
+        {
+            _modelSkins[model].push_back(skinName);
+        }
+    }
 }
 
 // Parse an individual skin declaration
-Doom3ModelSkinPtr Doom3SkinCache::parseSkin(parser::DefTokeniser& tok) 
+Doom3ModelSkinPtr Doom3SkinCache::parseSkin(parser::DefTokeniser& tok, StringList& models)
 {
 	// [ "skin" ] <name> "{"
 	//			[ "model" <modelname> ]
@@ -185,11 +351,11 @@ Doom3ModelSkinPtr Doom3SkinCache::parseSkin(parser::DefTokeniser& tok)
 					  << skinName << std::endl;
 		}
 
-		// If this is a model key, add to the model->skin map, otherwise assume
+		// If this is a model key, remember the association, otherwise assume
 		// this is a remap declaration
 		if (key == "model")
         {
-			_modelSkins[value].push_back(skinName);
+			models.push_back(value);
 		}
 		else
         {
@@ -223,11 +389,8 @@ const StringSet& Doom3SkinCache::getDependencies() const
 
 void Doom3SkinCache::refresh()
 {
-	_modelSkins.clear();
-	_namedSkins.clear();
-	_allSkins.clear();
-
-    // Reset loader and launch a new thread
+    // Reset loader and launch a new thread, it will
+    // pick up the files that changed since the last run
     _defLoader.reset();
     _defLoader.start();
 }
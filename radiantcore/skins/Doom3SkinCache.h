@@ -3,13 +3,17 @@
 #include "Doom3ModelSkin.h"
 
 #include "imodule.h"
+#include "ifilesystem.h"
 #include "modelskin.h"
 #include "parser/DefTokeniser.h"
 
 #include <map>
+#include <set>
+#include <unordered_map>
 #include <string>
 #include <vector>
 #include "ThreadedDefLoader.h"
+#include "decl/DeclFileTracker.h"
 
 namespace skins
 {
@@ -28,13 +32,17 @@ class Doom3SkinCache :
 	StringList _allSkins;
 
 	// Map between model paths and a vector of names of the associated skins,
-	// which are contained in the main NamedSkinMap.
-	typedef std::map<std::string, std::vector<std::string> > ModelSkinMap;
+	// which are contained in the main NamedSkinMap. Filled in while merging
+	// the parsed skin files, lookups don't modify it.
+	typedef std::unordered_map<std::string, StringList> ModelSkinMap;
 	ModelSkinMap _modelSkins;
 
     // Helper which will invoke loadSkinFiles() in a separate thread
     util::ThreadedDefLoader<void> _defLoader;
 
+    // The skin files found during the last load, to reload the changed ones only
+    decl::DeclFileTracker _skinFiles;
+
 	// Empty Doom3ModelSkin to return if a named skin is not found
 	Doom3ModelSkin _nullSkin;
 
@@ -62,7 +70,8 @@ public:
     void removeSkin(const std::string& name) override;
 
 	/**
-	 * greebo: Clears and reloads all skins.
+	 * greebo: Reloads the skins of all files that have been changed, added
+	 * or removed since the last load.
 	 */
 	void refresh() override;
 
@@ -80,18 +89,34 @@ private:
     // realised.
     void ensureDefsLoaded();
 
-    // Iterates over each skin file in the VFS skins/ folder
+    // Parses the skin files in the VFS skins/ folder in parallel. After the
+    // first run, only the files that changed since the last run are processed.
     void loadSkinFiles();
 
-    // Parse an individual skin declaration and add return the skin object
-    Doom3ModelSkinPtr parseSkin(parser::DefTokeniser& tokeniser);
+    // The skin declarations of a single file, with the model associations
+    struct ParsedSkinFile;
+
+    // Re-parses the changed files and the unchanged ones declaring the same
+    // skins, then merges the affected skins in VFS order
+    void reloadChangedSkinFiles(const decl::DeclFileTracker::Changes& changes);
+
+    // Parses the given files in parallel, the results are in the order of the files
+    static std::vector<ParsedSkinFile> parseSkinFiles(const std::vector<vfs::FileInfo>& files);
+
+    // Removes the given skins from the internal data structures
+    void removeSkins(const std::set<std::string>& skinNames);
+
+    // Parse the given .skin file, to be called from worker threads
+    static ParsedSkinFile parseSkinFile(const vfs::FileInfo& fileInfo);
+
+    // Parse an individual skin declaration and return the skin object,
+    // the names of the models associated to the skin are added to the given list
+    static Doom3ModelSkinPtr parseSkin(parser::DefTokeniser& tokeniser, StringList& models);
 
-    /* Parse the provided istream as a .skin file, and add all skins found within
-    * to the internal data structures.
-    *
-    * @filename: This is for informational purposes only (error message display).
-    */
-    void parseFile(std::istream& contents, const std::string& filename);
+    // Adds the skins of the parsed file to the internal data structures,
+    // skins that have already been defined by a previous file are ignored.
+    // If skinNames is given, only the skins of these names are merged.
+    void mergeSkinFile(ParsedSkinFile& parsedFile, const std::set<std::string>* skinNames = nullptr);
 };
 
 } // namespace skins
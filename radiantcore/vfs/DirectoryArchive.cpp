@@ -114,4 +114,11 @@ bool DirectoryArchive::getIsPhysical(const std::string& relativePath)
 std::string DirectoryArchive::getArchivePath(const std::string& relativePath)
 {
     return _root;
-}
\ No newline at end of file
+}
+
+std::int64_t DirectoryArchive::getLastModified(const std::string& relativePath)
+{
+    // Files are read from disk on demand, so the stamp is always the live one
+    UnixPath path(_root);
+    return os::getLastModifiedStamp(std::string(path) + relativePath);
+}
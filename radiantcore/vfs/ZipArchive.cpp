@@ -7,6 +7,7 @@
 #include <zlib.h>
 
 #include "os/fs.h"
+#include "os/file.h"
 #include "os/path.h"
 
 #include "ZipStreamUtils.h"
@@ -32,6 +33,7 @@ public:
 ZipArchive::ZipArchive(const std::string& fullPath) :
 	_fullPath(fullPath),
 	_containingFolder(os::standardPathWithSlash(fs::path(_fullPath).remove_filename())),
+	_lastModified(os::getLastModifiedStamp(_fullPath)),
 	_istream(_fullPath)
 {
 	if (_istream.failed())
@@ -163,6 +165,12 @@ std::string ZipArchive::getArchivePath(const std::string& relativePath)
     return _fullPath;
 }
 
+std::int64_t ZipArchive::getLastModified(const std::string& relativePath)
+{
+    // The directory has been read once, the stamp of that state is returned
+    return _lastModified;
+}
+
 void ZipArchive::readZipRecord()
 {
 	ZipMagic magic;
@@ -51,6 +51,7 @@ private:
 	std::string _fullPath;			// the full path to the Zip file
 	std::string _containingFolder;  // the folder this Zip is located in
 	mutable std::string _modName;	// mod name, calculated based on the containing folder
+	std::int64_t _lastModified;		// modification stamp of the Zip file at the time it was loaded
 	stream::FileInputStream _istream;
     std::mutex _streamLock;
 
@@ -67,6 +68,7 @@ public:
     std::size_t getFileSize(const std::string& relativePath) override;
     bool getIsPhysical(const std::string& relativePath) override;
     std::string getArchivePath(const std::string& relativePath) override;
+    std::int64_t getLastModified(const std::string& relativePath) override;
 
 private:
 	void readZipRecord();
@@ -1,5 +1,6 @@
 #include "RadiantTest.h"
 
+#include <chrono>
 #include "ibrush.h"
 #include "imap.h"
 #include "iselection.h"
@@ -335,4 +336,46 @@ TEST_F(Quake3BrushTest, TextureOnAngledBrush)
 }
 #endif
 
+// Not a correctness test, this measures the time to walk a scene with many brushes
+TEST_F(BrushTest, SceneTraversalBenchmark)
+{
+    constexpr int NumBrushes = 10000;
+    constexpr int NumIterations = 20;
+
+    auto worldspawn = GlobalMapModule().findOrInsertWorldspawn();
+
+    for (int i = 0; i < NumBrushes; ++i)
+    {
+        algorithm::createCubicBrush(worldspawn, Vector3((i % 100) * 64, (i / 100) * 64, 0), "textures/numbers/1");
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < NumIterations; ++i)
+    {
+        std::size_t visitedBrushes = 0;
+        AABB bounds;
+
+        GlobalSceneGraph().foreachNode([&](const scene::INodePtr& node)
+        {
+            if (Node_isBrush(node) && node->visible())
+            {
+                bounds.includeAABB(node->worldAABB());
+                ++visitedBrushes;
+            }
+
+            return true;
+        });
+
+        EXPECT_EQ(visitedBrushes, NumBrushes);
+        EXPECT_TRUE(bounds.isValid());
+    }
+
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    rMessage() << "Traversing " << NumBrushes << " brushes took "
+        << (duration.count() / NumIterations) << " usec on average" << std::endl;
+}
+
 }
@@ -15,6 +15,12 @@
 #include "registry/registry.h"
 #include "eclass.h"
 #include "string/join.h"
+#include "string/predicate.h"
+#include "imap.h"
+#include "scenelib.h"
+#include "algorithm/Scene.h"
+#include "algorithm/FileSystem.h"
+#include "testutil/TemporaryFile.h"
 
 namespace test
 {
@@ -130,6 +136,56 @@ TEST_F(EntityTest, VisitInheritedClassAttributes)
     EXPECT_EQ(attributes.at("editor_displayFolder"), false);
 }
 
+namespace
+{
+
+class AttributeLookupChecker :
+    public EntityClassVisitor
+{
+public:
+    std::size_t numChecked = 0;
+
+    void visit(const IEntityClassPtr& eclass) override
+    {
+        eclass->forEachAttribute([&](const EntityClassAttribute& attribute, bool)
+        {
+            // Walk up the parents to find the class defining this attribute
+            const IEntityClass* definingClass = eclass.get();
+
+            while (definingClass->getAttribute(attribute.getName(), false).getName().empty())
+            {
+                definingClass = definingClass->getParent();
+                ASSERT_TRUE(definingClass != nullptr);
+            }
+
+            EXPECT_EQ(&eclass->getAttribute(attribute.getName()),
+                &definingClass->getAttribute(attribute.getName(), false))
+                << "Attribute " << attribute.getName() << " on class " << eclass->getName();
+            ++numChecked;
+        }, true);
+
+        EXPECT_EQ(eclass->getAttribute("attribute_that_does_not_exist").getValue(), "");
+    }
+};
+
+}
+
+TEST_F(EntityTest, AttributeLookupMatchesParentChain)
+{
+    AttributeLookupChecker checker;
+    GlobalEntityClassManager().forEachEntityClass(checker);
+
+    EXPECT_GT(checker.numChecked, 0);
+
+    // Attributes are gathered again after a reload
+    GlobalEntityClassManager().reloadDefs();
+
+    AttributeLookupChecker checkerAfterReload;
+    GlobalEntityClassManager().forEachEntityClass(checkerAfterReload);
+
+    EXPECT_EQ(checkerAfterReload.numChecked, checker.numChecked);
+}
+
 // #5621: When the classname key is selected in the entity inspector, the description of that
 // attribute should deliver the text that is stored in the editor_usage attributes
 TEST_F(EntityTest, MultiLineEditorUsage)
@@ -193,6 +249,151 @@ TEST_F(EntityTest, ReloadDefsOnUnchangedFiles)
     checkBucketEntityDef(eclass);
 }
 
+inline std::string getInheritedModelDefs(const std::string& parentModel, const std::string& childUsage)
+{
+    return "entityDef reload_test_model_parent\n{\n    \"model\" \"" + parentModel + "\"\n}\n"
+        "entityDef reload_test_model_child\n{\n    \"inherit\" \"reload_test_model_parent\"\n"
+        "    \"editor_usage\" \"" + childUsage + "\"\n}\n";
+}
+
+// The entities need to see the inherited attributes when their class notifies them after a reload
+TEST_F(EntityTest, ReloadDefsKeepsInheritedModel)
+{
+    const std::string modelPath = "models/darkmod/test/unit_cube.ase";
+
+    // Make sure the initial load is done before adding the file
+    EXPECT_FALSE(GlobalEntityClassManager().findClass("reload_test_model_child"));
+
+    TemporaryFile defFile(_context.getTestProjectPath() + "def/_reload_inheritance_test.def",
+        getInheritedModelDefs(modelPath, "first"));
+    GlobalEntityClassManager().reloadDefs();
+
+    auto eclass = GlobalEntityClassManager().findClass("reload_test_model_child");
+    ASSERT_TRUE(eclass);
+    EXPECT_EQ(eclass->getAttribute("model").getValue(), modelPath);
+
+    auto entity = GlobalEntityModule().createEntity(eclass);
+    scene::addNodeToContainer(entity, GlobalMapModule().getRoot());
+
+    auto childModel = algorithm::findChildModel(entity);
+    ASSERT_TRUE(childModel);
+    EXPECT_EQ(childModel->getIModel().getModelPath(), modelPath);
+
+    std::size_t changedSignalCount = 0;
+    eclass->changedSignal().connect([&]() { ++changedSignalCount; });
+
+    // Change the child class only, the model is still inherited from the parent
+    defFile.write(getInheritedModelDefs(modelPath, "second"));
+    GlobalEntityClassManager().reloadDefs();
+
+    EXPECT_EQ(eclass->getAttribute("editor_usage").getValue(), "second");
+    EXPECT_EQ(changedSignalCount, 1);
+
+    // The model key observer must not have seen an empty value in between
+    childModel = algorithm::findChildModel(entity);
+    ASSERT_TRUE(childModel);
+    EXPECT_EQ(childModel->getIModel().getModelPath(), modelPath);
+
+    scene::removeNodeFromParent(entity);
+}
+
+inline std::string getPrecedenceTestDef(const std::string& usage)
+{
+    return "entityDef reload_test_precedence\n{\n    \"editor_usage\" \"" + usage + "\"\n}\n";
+}
+
+// Reloading changed files must leave the entityDef with the file a full load would pick
+TEST_F(EntityTest, ReloadDefsRespectsFilePrecedence)
+{
+    EXPECT_FALSE(GlobalEntityClassManager().findClass("reload_test_precedence"));
+
+    auto defFolder = _context.getTestProjectPath() + "def/";
+    TemporaryFile fileA(defFolder + "_reload_precedence_a.def", "");
+    TemporaryFile fileB(defFolder + "_reload_precedence_b.def", "");
+
+    auto aIsListedFirst = algorithm::isListedBefore("def/", "def",
+        "_reload_precedence_a.def", "_reload_precedence_b.def");
+    auto& firstFile = aIsListedFirst ? fileA : fileB;
+    auto& lastFile = aIsListedFirst ? fileB : fileA;
+
+    // The definition of the file listed last wins
+    firstFile.write(getPrecedenceTestDef("first"));
+    lastFile.write(getPrecedenceTestDef("last"));
+    GlobalEntityClassManager().reloadDefs();
+
+    auto eclass = GlobalEntityClassManager().findClass("reload_test_precedence");
+    ASSERT_TRUE(eclass);
+    EXPECT_EQ(eclass->getAttribute("editor_usage").getValue(), "last");
+
+    // Changing the overridden definition doesn't change the class
+    firstFile.write(getPrecedenceTestDef("first changed"));
+    GlobalEntityClassManager().reloadDefs();
+    EXPECT_EQ(eclass->getAttribute("editor_usage").getValue(), "last");
+
+    // The overridden definition takes over when the other file stops declaring it
+    lastFile.write("");
+    GlobalEntityClassManager().reloadDefs();
+    EXPECT_EQ(eclass->getAttribute("editor_usage").getValue(), "first changed");
+
+    lastFile.write(getPrecedenceTestDef("last again"));
+    GlobalEntityClassManager().reloadDefs();
+    EXPECT_EQ(eclass->getAttribute("editor_usage").getValue(), "last again");
+
+    // Same for removing the file
+    lastFile.remove();
+    GlobalEntityClassManager().reloadDefs();
+    EXPECT_EQ(eclass->getAttribute("editor_usage").getValue(), "first changed");
+}
+
+inline std::string getParentModelDef(const std::string& mesh, const std::string& anim)
+{
+    return "model reload_test_parent_model\n{\n    mesh " + mesh + "\n    skin reload_test_skin\n"
+        "    anim idle " + anim + "\n}\n";
+}
+
+// An unchanged modelDef and entityDef must pick up the changes of a parent modelDef in another file
+TEST_F(EntityTest, ReloadDefsUpdatesInheritedModelDef)
+{
+    EXPECT_FALSE(GlobalEntityClassManager().findModel("reload_test_parent_model"));
+
+    auto defFolder = _context.getTestProjectPath() + "def/";
+    TemporaryFile parentFile(defFolder + "_reload_modeldef_parent.def",
+        getParentModelDef("models/reload_test/first.md5mesh", "models/reload_test/first_idle.md5anim"));
+    TemporaryFile childFile(defFolder + "_reload_modeldef_child.def",
+        "model reload_test_child_model\n{\n    inherit reload_test_parent_model\n}\n"
+        "entityDef reload_test_modeldef_entity\n{\n    \"model\" \"reload_test_child_model\"\n}\n");
+
+    GlobalEntityClassManager().reloadDefs();
+
+    auto childModel = GlobalEntityClassManager().findModel("reload_test_child_model");
+    auto eclass = GlobalEntityClassManager().findClass("reload_test_modeldef_entity");
+    ASSERT_TRUE(childModel);
+    ASSERT_TRUE(eclass);
+
+    EXPECT_EQ(childModel->mesh, "models/reload_test/first.md5mesh");
+    EXPECT_EQ(childModel->anims["idle"], "models/reload_test/first_idle.md5anim");
+    EXPECT_EQ(eclass->getModelPath(), "models/reload_test/first.md5mesh");
+    EXPECT_EQ(eclass->getSkin(), "reload_test_skin");
+
+    std::size_t changedSignalCount = 0;
+    eclass->changedSignal().connect([&]() { ++changedSignalCount; });
+
+    // Change the parent modelDef only
+    parentFile.write(getParentModelDef("models/reload_test/second.md5mesh", "models/reload_test/second_idle.md5anim"));
+    GlobalEntityClassManager().reloadDefs();
+
+    EXPECT_EQ(childModel->mesh, "models/reload_test/second.md5mesh");
+    EXPECT_EQ(childModel->anims["idle"], "models/reload_test/second_idle.md5anim");
+    EXPECT_EQ(eclass->getModelPath(), "models/reload_test/second.md5mesh");
+    EXPECT_EQ(eclass->getSkin(), "reload_test_skin");
+    EXPECT_EQ(changedSignalCount, 1);
+
+    // Unchanged files leave the classes alone
+    GlobalEntityClassManager().reloadDefs();
+    EXPECT_EQ(eclass->getModelPath(), "models/reload_test/second.md5mesh");
+    EXPECT_EQ(changedSignalCount, 1);
+}
+
 TEST_F(EntityTest, CannotCreateEntityWithoutClass)
 {
     // Creating with a null entity class should throw an exception
@@ -366,6 +567,159 @@ TEST_F(EntityTest, CopySpawnargs)
     EXPECT_EQ(overlap.size(), 0);
 }
 
+TEST_F(EntityTest, LookupManySpawnargsIgnoringCase)
+{
+    auto light = createByClassName("light");
+    auto& spawnArgs = light->getEntity();
+
+    // Add enough spawnargs to exceed the linear search
+    constexpr int NumKeys = 50;
+
+    for (int i = 0; i < NumKeys; ++i)
+    {
+        spawnArgs.setKeyValue("Custom_Key_" + string::to_string(i), string::to_string(i));
+    }
+
+    for (int i = 0; i < NumKeys; ++i)
+    {
+        EXPECT_EQ(spawnArgs.getKeyValue("custom_key_" + string::to_string(i)), string::to_string(i));
+        EXPECT_FALSE(spawnArgs.isInherited("CUSTOM_KEY_" + string::to_string(i)));
+    }
+
+    // Remove every second key, the remaining ones must still be found
+    for (int i = 0; i < NumKeys; i += 2)
+    {
+        spawnArgs.setKeyValue("custom_key_" + string::to_string(i), "");
+    }
+
+    for (int i = 0; i < NumKeys; ++i)
+    {
+        EXPECT_EQ(spawnArgs.getKeyValue("Custom_Key_" + string::to_string(i)),
+            i % 2 == 0 ? "" : string::to_string(i));
+    }
+
+    // Overwriting a key with different case keeps the original key
+    spawnArgs.setKeyValue("CUSTOM_KEY_1", "changed");
+
+    std::size_t count = 0;
+    spawnArgs.forEachKeyValue([&](const std::string& k, const std::string& v)
+    {
+        if (string::iequals(k, "custom_key_1"))
+        {
+            EXPECT_EQ(k, "Custom_Key_1");
+            EXPECT_EQ(v, "changed");
+            ++count;
+        }
+    });
+    EXPECT_EQ(count, 1);
+
+    // Keys that have never been used anywhere
+    EXPECT_EQ(spawnArgs.getKeyValue("a_key_nobody_has_ever_used"), "");
+}
+
+namespace
+{
+
+// Records the values reported to a single key
+class KeyValueRecorder :
+    public KeyObserver
+{
+public:
+    std::vector<std::string> values;
+
+    void onKeyValueChanged(const std::string& newValue) override
+    {
+        values.push_back(newValue);
+    }
+};
+
+// Records the keys reported by onKeyChange
+class KeyChangeRecorder :
+    public Entity::Observer
+{
+public:
+    std::vector<std::string> keys;
+
+    void onKeyChange(const std::string& key, const std::string& val) override
+    {
+        keys.push_back(key);
+    }
+};
+
+}
+
+TEST_F(EntityTest, KeyValueChangesReportedOnceAfterScope)
+{
+    auto light = createByClassName("light");
+    auto& spawnArgs = light->getEntity();
+
+    spawnArgs.setKeyValue("origin", "0 0 0");
+    spawnArgs.setKeyValue("custom", "0");
+
+    KeyValueRecorder originRecorder;
+    spawnArgs.forEachEntityKeyValue([&](const std::string& key, EntityKeyValue& value)
+    {
+        if (key == "origin") value.attach(originRecorder);
+    });
+
+    KeyChangeRecorder changeRecorder;
+    spawnArgs.attachObserver(&changeRecorder);
+
+    // Attaching reports the current value
+    EXPECT_EQ(originRecorder.values, std::vector<std::string>{ "0 0 0" });
+    originRecorder.values.clear();
+
+    {
+        KeyValueChangeScope scope(spawnArgs);
+
+        for (int i = 1; i <= 10; ++i)
+        {
+            spawnArgs.setKeyValue("origin", string::to_string(i) + " 0 0");
+            spawnArgs.setKeyValue("custom", string::to_string(i));
+        }
+
+        // The values are already changed, only the observers are waiting
+        EXPECT_EQ(spawnArgs.getKeyValue("origin"), "10 0 0");
+        EXPECT_TRUE(originRecorder.values.empty());
+        EXPECT_TRUE(changeRecorder.keys.empty());
+    }
+
+    // One notification with the final value
+    EXPECT_EQ(originRecorder.values, std::vector<std::string>{ "10 0 0" });
+    EXPECT_EQ(changeRecorder.keys.size(), 2);
+
+    originRecorder.values.clear();
+    changeRecorder.keys.clear();
+
+    // The global scope defers all entities, nested scopes end with the outermost one
+    {
+        KeyValueChangeScope globalScope;
+
+        {
+            KeyValueChangeScope entityScope(spawnArgs);
+            spawnArgs.setKeyValue("origin", "5 5 5");
+        }
+
+        spawnArgs.setKeyValue("origin", "6 6 6");
+        EXPECT_TRUE(originRecorder.values.empty());
+        EXPECT_TRUE(changeRecorder.keys.empty());
+    }
+
+    EXPECT_EQ(originRecorder.values, std::vector<std::string>{ "6 6 6" });
+    EXPECT_EQ(changeRecorder.keys, std::vector<std::string>{ "origin" });
+
+    // Without a scope every change is reported right away
+    spawnArgs.setKeyValue("origin", "7 7 7");
+    EXPECT_EQ(originRecorder.values.back(), "7 7 7");
+    EXPECT_EQ(changeRecorder.keys.size(), 2);
+
+    spawnArgs.detachObserver(&changeRecorder);
+    spawnArgs.forEachEntityKeyValue([&](const std::string& key, EntityKeyValue& value)
+    {
+        if (key == "origin") value.detach(originRecorder);
+    });
+}
+
 TEST_F(EntityTest, SelectEntity)
 {
     auto light = createByClassName("light");
@@ -645,6 +999,40 @@ TEST_F(EntityTest, OverrideEClassColour)
     EXPECT_EQ(torchCls->getColour(), YELLOW);
 }
 
+TEST_F(EntityTest, EClassShadersSharedUntilColourChanges)
+{
+    auto light = createByClassName("light");
+    auto secondLight = createByClassName("light");
+    auto lightCls = light->getEntity().getEntityClass();
+
+    RenderSystemPtr backend = GlobalRenderSystemFactory().createRenderSystem();
+    light->setRenderSystem(backend);
+    secondLight->setRenderSystem(backend);
+
+    // Both entities use the shader captured by their class
+    ASSERT_TRUE(light->getWireShader());
+    EXPECT_EQ(light->getWireShader(), secondLight->getWireShader());
+    EXPECT_EQ(light->getWireShader(), lightCls->captureWireShader(backend));
+    EXPECT_EQ(lightCls->captureFillShader(backend)->getName(), lightCls->getFillShader());
+
+    std::size_t changeCount = 0;
+    sigc::connection conn = lightCls->changedSignal().connect([&]() { ++changeCount; });
+
+    // Applying the colour the class already has is not a change
+    GlobalEclassColourManager().addOverrideColour("light", lightCls->getColour());
+    EXPECT_EQ(changeCount, 0);
+
+    // A different colour replaces the shaders of the class and its entities
+    GlobalEclassColourManager().addOverrideColour("light", Vector3(1, 0, 1));
+    EXPECT_EQ(changeCount, 1);
+
+    EXPECT_EQ(light->getWireShader()->getName(), "<1.000000 0.000000 1.000000>");
+    EXPECT_EQ(light->getWireShader(), secondLight->getWireShader());
+    EXPECT_EQ(light->getWireShader(), lightCls->captureWireShader(backend));
+
+    conn.disconnect();
+}
+
 TEST_F(EntityTest, FuncStaticLocalToWorld)
 {
     auto funcStatic = createByClassName("func_static");
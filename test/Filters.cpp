@@ -0,0 +1,85 @@
+#include "RadiantTest.h"
+
+#include "ifilter.h"
+#include "imap.h"
+#include "ientity.h"
+#include "ieclass.h"
+#include "algorithm/Primitives.h"
+
+namespace test
+{
+
+using FilterTest = RadiantTest;
+
+TEST_F(FilterTest, RulesMatchTheWholeName)
+{
+    FilterRules rules;
+    rules.push_back(FilterRule::Create(FilterRule::TYPE_TEXTURE, "textures/common/caulk", false));     // literal
+    rules.push_back(FilterRule::Create(FilterRule::TYPE_TEXTURE, "textures/darkmod/stone/.*", false)); // prefix
+    rules.push_back(FilterRule::Create(FilterRule::TYPE_TEXTURE, "textures/(.*)/nodraw", false));      // regex
+
+    EXPECT_TRUE(GlobalFilterSystem().addFilter("TestFilter", rules));
+    GlobalFilterSystem().setFilterState("TestFilter", true);
+
+    EXPECT_FALSE(GlobalFilterSystem().isVisible(FilterRule::TYPE_TEXTURE, "textures/common/caulk"));
+    EXPECT_TRUE(GlobalFilterSystem().isVisible(FilterRule::TYPE_TEXTURE, "textures/common/caulk_sky"));
+    EXPECT_FALSE(GlobalFilterSystem().isVisible(FilterRule::TYPE_TEXTURE, "textures/darkmod/stone/brick/rough"));
+    EXPECT_TRUE(GlobalFilterSystem().isVisible(FilterRule::TYPE_TEXTURE, "textures/darkmod/stone"));
+    EXPECT_FALSE(GlobalFilterSystem().isVisible(FilterRule::TYPE_TEXTURE, "textures/common/nodraw"));
+    EXPECT_TRUE(GlobalFilterSystem().isVisible(FilterRule::TYPE_TEXTURE, "textures/common/nodrawsolid"));
+
+    // Cached results must not leak into queries of another rule type
+    EXPECT_TRUE(GlobalFilterSystem().isVisible(FilterRule::TYPE_OBJECT, "textures/common/caulk"));
+
+    // Changing the rules must invalidate the cached results
+    rules.pop_back();
+    EXPECT_TRUE(GlobalFilterSystem().setFilterRules("TestFilter", rules));
+    EXPECT_TRUE(GlobalFilterSystem().isVisible(FilterRule::TYPE_TEXTURE, "textures/common/nodraw"));
+}
+
+TEST_F(FilterTest, ToggledFiltersUpdateTheAffectedNodes)
+{
+    GlobalFilterSystem().setAllFilterStates(false);
+
+    auto worldspawn = GlobalMapModule().findOrInsertWorldspawn();
+    auto caulkBrush = algorithm::createCubicBrush(worldspawn, Vector3(0, 0, 0), "textures/common/caulk");
+    auto otherBrush = algorithm::createCubicBrush(worldspawn, Vector3(128, 0, 0), "textures/darkmod/numbers/1");
+
+    auto light = GlobalEntityModule().createEntity(GlobalEntityClassManager().findClass("light"));
+    GlobalMapModule().getRoot()->addChildNode(light);
+
+    GlobalFilterSystem().setFilterState("Lights", true);
+
+    EXPECT_TRUE(light->isFiltered());
+    EXPECT_FALSE(worldspawn->isFiltered());
+    EXPECT_FALSE(caulkBrush->isFiltered());
+
+    GlobalFilterSystem().setFilterState("Caulk", true);
+
+    EXPECT_TRUE(light->isFiltered());
+    EXPECT_TRUE(caulkBrush->isFiltered());
+    EXPECT_FALSE(otherBrush->isFiltered());
+
+    GlobalFilterSystem().setFilterState("Lights", false);
+
+    EXPECT_FALSE(light->isFiltered());
+    EXPECT_TRUE(caulkBrush->isFiltered());
+
+    // Hiding and showing worldspawn must leave the caulk brush hidden
+    GlobalFilterSystem().setFilterState("World geometry", true);
+
+    EXPECT_TRUE(worldspawn->isFiltered());
+    EXPECT_TRUE(otherBrush->isFiltered());
+
+    GlobalFilterSystem().setFilterState("World geometry", false);
+
+    EXPECT_FALSE(worldspawn->isFiltered());
+    EXPECT_FALSE(otherBrush->isFiltered());
+    EXPECT_TRUE(caulkBrush->isFiltered());
+
+    GlobalFilterSystem().setFilterState("Caulk", false);
+
+    EXPECT_FALSE(caulkBrush->isFiltered());
+}
+
+}
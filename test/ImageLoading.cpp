@@ -1,7 +1,11 @@
 #include "RadiantTest.h"
 
+#include <fstream>
+#include <chrono>
 #include "iimage.h"
+#include "itextstream.h"
 #include "RGBAImage.h"
+#include "ThreadPool.h"
 
 // Helpers for examining pixel data
 using RGB8 = BasicVector3<uint8_t>;
@@ -49,6 +53,72 @@ protected:
         auto filePath = _context.getTestProjectPath() + path;
         return GlobalImageLoader().imageFromFile(filePath);
     }
+
+    // Writes a 32 bit RLE-compressed TGA file to the temp data path, consisting of
+    // run-length and raw packets of varying length, many of them spanning two rows.
+    // Returns the path to the file, the pixels are stored in file order.
+    std::string writeRLECompressedTga(const std::string& filename, uint16_t width, uint16_t height,
+        uint8_t attributes, std::vector<RGBAPixel>& pixels)
+    {
+        auto path = _context.getTemporaryDataPath() + filename;
+        std::ofstream stream(path, std::ios::binary);
+
+        uint8_t header[18] = { 0, 0, 10, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+            static_cast<uint8_t>(width & 0xff), static_cast<uint8_t>(width >> 8),
+            static_cast<uint8_t>(height & 0xff), static_cast<uint8_t>(height >> 8),
+            32, attributes };
+        stream.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+        std::size_t numPixels = width * height;
+
+        for (std::size_t packet = 0; pixels.size() < numPixels; ++packet)
+        {
+            auto count = std::min<std::size_t>(1 + (packet * 37) % 128, numPixels - pixels.size());
+            bool isRunLength = packet % 3 != 0;
+
+            stream.put(static_cast<char>((isRunLength ? 0x80 : 0) | (count - 1)));
+
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                auto index = pixels.size();
+                RGBAPixel pixel = isRunLength ?
+                    RGBAPixel{ static_cast<uint8_t>(packet), static_cast<uint8_t>(packet >> 8), 128, 255 } :
+                    RGBAPixel{ static_cast<uint8_t>(index), static_cast<uint8_t>(index >> 8), static_cast<uint8_t>(index >> 16), 7 };
+
+                if (!isRunLength || i == 0)
+                {
+                    // TGA stores pixels in BGRA order
+                    char bgra[4] = { static_cast<char>(pixel.blue), static_cast<char>(pixel.green),
+                        static_cast<char>(pixel.red), static_cast<char>(pixel.alpha) };
+                    stream.write(bgra, 4);
+                }
+
+                pixels.push_back(pixel);
+            }
+        }
+
+        return path;
+    }
+
+    // Compares the image to the pixels of a file with the given origin
+    void expectTgaPixels(const Image& image, const std::vector<RGBAPixel>& filePixels, bool topToBottom)
+    {
+        auto width = image.getWidth();
+        auto height = image.getHeight();
+        auto pixels = reinterpret_cast<const RGBAPixel*>(image.getPixels());
+
+        for (std::size_t i = 0; i < filePixels.size(); ++i)
+        {
+            auto row = topToBottom ? i / width : height - 1 - i / width;
+            const auto& pixel = pixels[row * width + i % width];
+
+            if (pixel.red != filePixels[i].red || pixel.green != filePixels[i].green ||
+                pixel.blue != filePixels[i].blue || pixel.alpha != filePixels[i].alpha)
+            {
+                FAIL() << "Pixel mismatch at file position " << i;
+            }
+        }
+    }
 };
 
 TEST_F(ImageLoadingTest, LoadPng8Bit)
@@ -239,4 +309,132 @@ TEST_F(ImageLoadingTest, LoadDDSCompressedBC5MipMaps)
     EXPECT_EQ(img->getGLFormat(), GL_COMPRESSED_RG_RGTC2);
 }
 
-}
\ No newline at end of file
+TEST_F(ImageLoadingTest, LoadTgaUncompressed)
+{
+    auto img = loadImage("textures/numbers/6.tga");
+    ASSERT_TRUE(img);
+
+    EXPECT_EQ(img->getWidth(), 32);
+    EXPECT_EQ(img->getHeight(), 32);
+    EXPECT_FALSE(img->isPrecompressed());
+    EXPECT_TRUE(std::dynamic_pointer_cast<RGBAImage>(img));
+}
+
+TEST_F(ImageLoadingTest, LoadTgaRLECompressed)
+{
+    auto img = loadImage("textures/a_1024x512.tga");
+    ASSERT_TRUE(img);
+
+    EXPECT_EQ(img->getWidth(), 1024);
+    EXPECT_EQ(img->getHeight(), 512);
+    EXPECT_FALSE(img->isPrecompressed());
+    EXPECT_TRUE(std::dynamic_pointer_cast<RGBAImage>(img));
+}
+
+TEST_F(ImageLoadingTest, LoadLargeTgaRLECompressed)
+{
+    // Large enough to be decoded in parallel, packets are crossing the row boundaries
+    std::vector<RGBAPixel> filePixels;
+    auto path = writeRLECompressedTga("rle_2048x1031.tga", 2048, 1031, 0, filePixels);
+
+    auto img = GlobalImageLoader().imageFromFile(path);
+    ASSERT_TRUE(img);
+    EXPECT_EQ(img->getWidth(), 2048);
+    EXPECT_EQ(img->getHeight(), 1031);
+
+    // Bottom-left origin
+    expectTgaPixels(*img, filePixels, false);
+}
+
+TEST_F(ImageLoadingTest, LoadLargeTgaRLECompressedTopLeftOrigin)
+{
+    std::vector<RGBAPixel> filePixels;
+    auto path = writeRLECompressedTga("rle_1031x2048.tga", 1031, 2048, 0x20, filePixels);
+
+    auto img = GlobalImageLoader().imageFromFile(path);
+    ASSERT_TRUE(img);
+    EXPECT_EQ(img->getWidth(), 1031);
+    EXPECT_EQ(img->getHeight(), 2048);
+
+    expectTgaPixels(*img, filePixels, true);
+}
+
+TEST_F(ImageLoadingTest, LoadLargeTgaRLECompressedOnWorkerThread)
+{
+    std::vector<RGBAPixel> filePixels;
+    auto path = writeRLECompressedTga("rle_2048x1031.tga", 2048, 1031, 0, filePixels);
+
+    // Pool workers are decoding serially, the result must be the same
+    util::ThreadPool pool(1);
+    auto img = pool.submit([&]()
+    {
+        EXPECT_TRUE(util::ThreadPool::IsWorkerThread());
+        return GlobalImageLoader().imageFromFile(path);
+    }).get();
+
+    EXPECT_FALSE(util::ThreadPool::IsWorkerThread());
+
+    ASSERT_TRUE(img);
+    EXPECT_EQ(img->getWidth(), 2048);
+    EXPECT_EQ(img->getHeight(), 1031);
+
+    expectTgaPixels(*img, filePixels, false);
+}
+
+TEST_F(ImageLoadingTest, LoadTruncatedTga)
+{
+    std::vector<RGBAPixel> filePixels;
+    auto path = writeRLECompressedTga("rle_truncated.tga", 1024, 1024, 0x20, filePixels);
+
+    // Cut the file in half
+    fs::resize_file(path, fs::file_size(path) / 2);
+
+    // The image is still loaded, the missing part is filled with black pixels
+    auto img = GlobalImageLoader().imageFromFile(path);
+    ASSERT_TRUE(img);
+    EXPECT_EQ(img->getWidth(), 1024);
+    EXPECT_EQ(img->getHeight(), 1024);
+
+    auto lastPixel = reinterpret_cast<const RGBAPixel*>(img->getPixels())[1024 * 1024 - 1];
+    EXPECT_EQ(lastPixel.red, 0);
+    EXPECT_EQ(lastPixel.green, 0);
+    EXPECT_EQ(lastPixel.blue, 0);
+    EXPECT_EQ(lastPixel.alpha, 255);
+}
+
+// Not a correctness test, reports the time spent loading a few image types to the log
+TEST_F(ImageLoadingTest, ImageLoadingBenchmark)
+{
+    std::vector<RGBAPixel> filePixels;
+    auto largeTga = writeRLECompressedTga("rle_benchmark.tga", 2048, 2048, 0, filePixels);
+
+    std::vector<std::string> paths = {
+        largeTga,
+        _context.getTestProjectPath() + "textures/a_1024x512.tga",
+        _context.getTestProjectPath() + "textures/numbers/6.tga",
+        _context.getTestProjectPath() + "textures/pngs/twentyone_8bit.png",
+        _context.getTestProjectPath() + "textures/pngs/twentyone_16bit.png",
+        _context.getTestProjectPath() + "textures/dds/test_128x128_dxt1.dds",
+    };
+
+    constexpr int NumIterations = 20;
+
+    for (const auto& path : paths)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < NumIterations; ++i)
+        {
+            auto img = GlobalImageLoader().imageFromFile(path);
+            ASSERT_TRUE(img) << "Failed to load " << path;
+        }
+
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+
+        rMessage() << "Loading " << fs::path(path).filename().string() << " took "
+            << (duration.count() / NumIterations) << " usec on average" << std::endl;
+    }
+}
+
+}
@@ -110,4 +110,72 @@ TEST_F(LayerTest, RemovingFromLayerMarksMapAsModified)
     performMoveOrAddToLayerTest(LayerAction::RemoveFromLayer);
 }
 
+TEST_F(LayerTest, LayerListStoresSortedIds)
+{
+    scene::LayerList list{ 200, 3, 0, 70 };
+
+    EXPECT_EQ(list.size(), 4);
+    EXPECT_EQ(std::vector<int>(list.begin(), list.end()), std::vector<int>({ 0, 3, 70, 200 }));
+    EXPECT_EQ(list.count(70), 1);
+    EXPECT_EQ(list.count(71), 0);
+    EXPECT_EQ(list.count(-1), 0);
+
+    EXPECT_EQ(list.erase(200), 1);
+    EXPECT_EQ(list.erase(200), 0);
+    EXPECT_EQ(list, scene::LayerList({ 0, 3, 70 }));
+    EXPECT_TRUE(list.intersects(scene::LayerList({ 1, 70 })));
+    EXPECT_FALSE(list.intersects(scene::LayerList({ 1, 71 })));
+
+    list.clear();
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ(list.begin(), list.end());
+}
+
+TEST_F(LayerTest, HidingLayerAffectsOnlyItsMembers)
+{
+    loadMap("general_purpose.mapx");
+
+    auto& layerManager = GlobalMapModule().getRoot()->getLayerManager();
+    auto worldspawn = GlobalMapModule().findOrInsertWorldspawn();
+
+    auto brush1 = algorithm::findFirstBrushWithMaterial(worldspawn, "textures/numbers/1");
+    auto brush2 = algorithm::findFirstBrushWithMaterial(worldspawn, "textures/numbers/2");
+    ASSERT_TRUE(brush1);
+    ASSERT_TRUE(brush2);
+
+    auto layerId = layerManager.createLayer("Test Layer");
+
+    Node_setSelected(brush1, true);
+    layerManager.moveSelectionToLayer(layerId);
+    Node_setSelected(brush1, false);
+
+    std::vector<scene::INodePtr> members;
+    layerManager.foreachLayerMember(layerId, [&](const scene::INodePtr& node) { members.push_back(node); });
+
+    EXPECT_EQ(members, std::vector<scene::INodePtr>({ brush1 }));
+
+    layerManager.setLayerVisibility(layerId, false);
+
+    EXPECT_FALSE(brush1->visible());
+    EXPECT_TRUE(brush2->visible());
+    EXPECT_TRUE(worldspawn->visible());
+
+    // Hidden members are not selected
+    layerManager.setSelected(layerId, true);
+    EXPECT_FALSE(Node_isSelected(brush1));
+
+    layerManager.setLayerVisibility(layerId, true);
+    EXPECT_TRUE(brush1->visible());
+
+    layerManager.setSelected(layerId, true);
+    EXPECT_TRUE(Node_isSelected(brush1));
+    EXPECT_FALSE(Node_isSelected(brush2));
+
+    // Deleting the layer moves the members back to the default layer
+    layerManager.deleteLayer("Test Layer");
+
+    EXPECT_EQ(brush1->getLayers(), scene::LayerList({ 0 }));
+    EXPECT_TRUE(brush1->visible());
+}
+
 }
@@ -1,10 +1,15 @@
 #include "RadiantTest.h"
 
+#include <fstream>
+
 #include "imap.h"
 #include "imapformat.h"
 #include "ibrush.h"
+#include "ientity.h"
+#include "ieclass.h"
 #include "iselection.h"
 #include "scenelib.h"
+#include "scene/Traverse.h"
 #include "os/path.h"
 #include "string/predicate.h"
 #include "xmlutil/Document.h"
@@ -30,6 +35,90 @@ void createAndSelectSingleBrush()
     Node_setSelected(brushNode, true);
 }
 
+// Forwards all calls to the wrapped writer, but doesn't support
+// entity writers, such that the map is written sequentially
+class SequentialMapWriter :
+    public map::IMapWriter
+{
+private:
+    map::IMapWriterPtr _writer;
+
+public:
+    SequentialMapWriter(const map::IMapWriterPtr& writer) :
+        _writer(writer)
+    {}
+
+    void beginWriteMap(const scene::IMapRootNodePtr& root, std::ostream& stream) override
+    {
+        _writer->beginWriteMap(root, stream);
+    }
+
+    void endWriteMap(const scene::IMapRootNodePtr& root, std::ostream& stream) override
+    {
+        _writer->endWriteMap(root, stream);
+    }
+
+    void beginWriteEntity(const IEntityNodePtr& entity, std::ostream& stream) override
+    {
+        _writer->beginWriteEntity(entity, stream);
+    }
+
+    void endWriteEntity(const IEntityNodePtr& entity, std::ostream& stream) override
+    {
+        _writer->endWriteEntity(entity, stream);
+    }
+
+    void beginWriteBrush(const IBrushNodePtr& brush, std::ostream& stream) override
+    {
+        _writer->beginWriteBrush(brush, stream);
+    }
+
+    void endWriteBrush(const IBrushNodePtr& brush, std::ostream& stream) override
+    {
+        _writer->endWriteBrush(brush, stream);
+    }
+
+    void beginWritePatch(const IPatchNodePtr& patch, std::ostream& stream) override
+    {
+        _writer->beginWritePatch(patch, stream);
+    }
+
+    void endWritePatch(const IPatchNodePtr& patch, std::ostream& stream) override
+    {
+        _writer->endWritePatch(patch, stream);
+    }
+};
+
+std::string exportMapUsingWriter(map::IMapWriter& writer)
+{
+    std::ostringstream output;
+
+    {
+        auto root = GlobalMapModule().getRoot();
+        auto exporter = GlobalMapModule().createMapExporter(writer, root, output);
+        exporter->exportMap(root, scene::traverse);
+    }
+
+    return output.str();
+}
+
+void expectParallelExportMatchesSequentialExport(const std::string& gameType)
+{
+    auto format = GlobalMapFormatManager().getMapFormatForGameType(gameType, "map");
+    ASSERT_TRUE(format);
+
+    auto writer = format->getMapWriter();
+    ASSERT_TRUE(writer->createEntityWriter(0)) << "Format " << gameType << " should support entity writers";
+
+    auto parallelText = exportMapUsingWriter(*writer);
+
+    SequentialMapWriter sequentialWriter(format->getMapWriter());
+    auto sequentialText = exportMapUsingWriter(sequentialWriter);
+
+    EXPECT_NE(parallelText.find("// entity 1\n"), std::string::npos) << "Exported text is missing entities";
+    EXPECT_EQ(parallelText, sequentialText) << "Parallel export of " << gameType << " differs from sequential export";
+}
+
 }
 
 using MapExportTest = RadiantTest;
@@ -195,4 +284,127 @@ brushDef3
     EXPECT_NE(brushTextIndex, std::string::npos) << "Could not locate the exported brush in the expected format";
 }
 
+TEST_F(MapExportTest, parallelExportMatchesSequentialExport)
+{
+    loadMap("altar.map");
+
+    // Add a few entities with brushes in their own groups, to have more than one job per worker
+    for (int i = 0; i < 64; ++i)
+    {
+        auto entity = GlobalEntityModule().createEntity(GlobalEntityClassManager().findClass("func_static"));
+        GlobalMapModule().getRoot()->addChildNode(entity);
+
+        algorithm::createCuboidBrush(entity, AABB(Vector3(i * 64, 0, 0), Vector3(16, 16.5, 1 + 0.125 * i)), "textures/darkmod/numbers/1");
+    }
+
+    expectParallelExportMatchesSequentialExport("doom3");
+    expectParallelExportMatchesSequentialExport("quake4");
+}
+
+// The fixture is in the form the sequential exporter wrote before the parallel
+// writer was introduced, its primitives are taken from maps saved by that exporter.
+// Loading and exporting it again must reproduce it byte by byte.
+TEST_F(MapExportTest, parallelExportMatchesGoldenFile)
+{
+    auto goldenPath = _context.getTestProjectPath() + "maps/parallel_export.map";
+
+    std::ifstream goldenStream(goldenPath);
+    ASSERT_TRUE(goldenStream) << "Cannot open " << goldenPath;
+    std::string goldenText(std::istreambuf_iterator<char>(goldenStream), {});
+
+    loadMap("parallel_export.map");
+
+    auto format = GlobalMapFormatManager().getMapFormatForGameType("doom3", "map");
+    auto writer = format->getMapWriter();
+    ASSERT_TRUE(writer->createEntityWriter(0)) << "Doom 3 format should support entity writers";
+
+    auto parallelText = exportMapUsingWriter(*writer);
+
+    EXPECT_NE(parallelText.find("// entity 48\n"), std::string::npos) << "Exported text is missing entities";
+    EXPECT_EQ(parallelText, goldenText) << "Parallel export differs from the golden file";
+
+    // The sequential path must produce the same
+    SequentialMapWriter sequentialWriter(format->getMapWriter());
+    EXPECT_EQ(exportMapUsingWriter(sequentialWriter), goldenText) << "Sequential export differs from the golden file";
+}
+
+TEST_F(MapExportTest, exportWritesChildPrimitivesRelativeToOrigin)
+{
+    auto entity = GlobalEntityModule().createEntity(GlobalEntityClassManager().findClass("func_static"));
+    GlobalMapModule().getRoot()->addChildNode(entity);
+    entity->getEntity().setKeyValue("origin", "128 0 0");
+
+    // Child primitives are stored in world coordinates
+    auto brush = algorithm::createCuboidBrush(entity, AABB(Vector3(128, 0, 0), Vector3(16, 16, 16)), "textures/darkmod/numbers/1");
+
+    std::vector<Plane3> planesBefore;
+    const auto& ibrush = *Node_getIBrush(brush);
+
+    for (std::size_t i = 0; i < ibrush.getNumFaces(); ++i)
+    {
+        planesBefore.push_back(ibrush.getFace(i).getPlane3());
+    }
+
+    auto format = GlobalMapFormatManager().getMapFormatForGameType("doom3", "map");
+    auto text = exportMapUsingWriter(*format->getMapWriter());
+
+    // The map file has them positioned relative to the entity origin
+    EXPECT_NE(text.find("( 1 0 0 -16 )"), std::string::npos) << "Brush has not been written relative to the origin";
+    EXPECT_NE(text.find("( -1 0 0 -16 )"), std::string::npos) << "Brush has not been written relative to the origin";
+    EXPECT_EQ(text.find("-144"), std::string::npos) << "Brush has been written in world coordinates";
+
+    // The scene must not have been touched
+    ASSERT_EQ(ibrush.getNumFaces(), planesBefore.size());
+
+    for (std::size_t i = 0; i < ibrush.getNumFaces(); ++i)
+    {
+        EXPECT_EQ(ibrush.getFace(i).getPlane3().normal(), planesBefore[i].normal());
+        EXPECT_EQ(ibrush.getFace(i).getPlane3().dist(), planesBefore[i].dist());
+    }
+}
+
+TEST_F(MapExportTest, exportPortableFormatWritesAllEntities)
+{
+    loadMap("altar.map");
+
+    for (int i = 0; i < 16; ++i)
+    {
+        auto entity = GlobalEntityModule().createEntity(GlobalEntityClassManager().findClass("func_static"));
+        GlobalMapModule().getRoot()->addChildNode(entity);
+
+        algorithm::createCuboidBrush(entity, AABB(Vector3(i * 64, 0, 0), Vector3(16, 16, 16)), "textures/darkmod/numbers/1");
+    }
+
+    std::size_t entityCount = 0;
+    GlobalMapModule().getRoot()->foreachNode([&](const scene::INodePtr& node)
+    {
+        if (Node_isEntity(node)) entityCount++;
+        return true;
+    });
+
+    auto format = GlobalMapFormatManager().getMapFormatByName(map::PORTABLE_MAP_FORMAT_NAME);
+    auto text = exportMapUsingWriter(*format->getMapWriter());
+
+    algorithm::assertStringIsMapxFile(text);
+
+    // The streamed document must be well-formed and have the same layout as before
+    std::istringstream stream(text);
+    xml::Document document(stream);
+
+    auto entityNodes = document.getTopLevelNode().getNamedChildren("entity");
+    EXPECT_EQ(entityNodes.size(), entityCount);
+
+    for (const auto& entityNode : entityNodes)
+    {
+        std::vector<std::string> childNames;
+
+        for (const auto& child : entityNode.getChildren())
+        {
+            if (child.getName() != "text") childNames.push_back(child.getName());
+        }
+
+        EXPECT_EQ(childNames, std::vector<std::string>({ "primitives", "keyValues", "layers", "selectionGroups", "selectionSets" }));
+    }
+}
+
 }
@@ -1,6 +1,7 @@
 #include "RadiantTest.h"
 
 #include <fstream>
+#include <sstream>
 #include "iundo.h"
 #include "imap.h"
 #include "imapformat.h"
@@ -10,6 +11,8 @@
 #include "iradiant.h"
 #include "iselectiongroup.h"
 #include "ilightnode.h"
+#include "ieclass.h"
+#include "ientity.h"
 #include "icommandsystem.h"
 #include "messages/FileSelectionRequest.h"
 #include "messages/FileOverwriteConfirmation.h"
@@ -18,6 +21,7 @@
 #include "algorithm/XmlUtils.h"
 #include "algorithm/Primitives.h"
 #include "os/file.h"
+#include "registry/registry.h"
 #include <sigc++/connection.h>
 #include "testutil/FileSelectionHelper.h"
 
@@ -64,6 +68,78 @@ public:
     }
 };
 
+// Enables writing the binary map cache, restores the previous setting on destruction
+class BinaryMapCacheEnabler
+{
+private:
+    constexpr static const char* const RKEY_WRITE_BINARY_MAP_CACHE = "user/ui/map/writeBinaryMapCache";
+
+    bool _previousValue;
+
+public:
+    BinaryMapCacheEnabler() :
+        _previousValue(registry::getValue<bool>(RKEY_WRITE_BINARY_MAP_CACHE))
+    {
+        registry::setValue(RKEY_WRITE_BINARY_MAP_CACHE, true);
+    }
+
+    ~BinaryMapCacheEnabler()
+    {
+        registry::setValue(RKEY_WRITE_BINARY_MAP_CACHE, _previousValue);
+    }
+};
+
+// Replaces the given string in the (binary) file by another one of the same length
+bool replaceStringInFile(const fs::path& path, const std::string& original, const std::string& replacement)
+{
+    std::string contents;
+    {
+        std::ifstream input(path, std::ios::binary);
+        std::stringstream buffer;
+        buffer << input.rdbuf();
+        contents = buffer.str();
+    }
+
+    auto pos = contents.find(original);
+
+    if (pos == std::string::npos || original.length() != replacement.length())
+    {
+        return false;
+    }
+
+    contents.replace(pos, original.length(), replacement);
+
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    output << contents;
+
+    return !output.fail();
+}
+
+// Converts the line endings of the given file to CRLF, like a map saved on Windows
+void convertToCrlfLineEndings(const fs::path& path)
+{
+    std::string contents;
+    {
+        std::ifstream input(path, std::ios::binary);
+        std::stringstream buffer;
+        buffer << input.rdbuf();
+        contents = buffer.str();
+    }
+
+    std::string converted;
+    converted.reserve(contents.size() * 2);
+
+    for (auto c : contents)
+    {
+        if (c == '\r') continue;
+        if (c == '\n') converted += '\r';
+        converted += c;
+    }
+
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    output << converted;
+}
+
 }
 
 class MapFileTestBase :
@@ -1240,4 +1316,359 @@ TEST_F(MapSavingTest, AutoSaverDoesntChangeSaveCopyAsFilename)
     GlobalRadiantCore().getMessageBus().removeListener(msgSubscription);
 }
 
+TEST_F(MapSavingTest, AutoSaverWritesSceneAtTimeOfAutosave)
+{
+    std::string mapFileName = "altar_autosaveSnapshot.map";
+    auto mapPath = createMapCopyInModMapsPath("altar.map", mapFileName);
+
+    GlobalCommandSystem().executeCommand("OpenMap", "maps/" + mapFileName);
+    checkAltarScene();
+
+    fs::path autosavePath = mapPath;
+    autosavePath.replace_filename("altar_autosaveSnapshot_autosave.map");
+    fs::path autosaveInfoPath = fs::path(autosavePath).replace_extension("darkradiant");
+
+    EXPECT_FALSE(os::fileOrDirExists(autosavePath));
+
+    GlobalAutoSaver().performAutosave();
+
+    // Changes made after the autosave has been started don't end up in the file
+    auto entity = GlobalEntityModule().createEntity(GlobalEntityClassManager().findClass("func_static"));
+    GlobalMapModule().getRoot()->addChildNode(entity);
+    Node_getEntity(entity)->setKeyValue("name", "added_after_autosave");
+
+    GlobalAutoSaver().waitForPendingSave();
+
+    EXPECT_TRUE(os::fileOrDirExists(autosavePath));
+    EXPECT_TRUE(os::fileOrDirExists(autosaveInfoPath));
+
+    std::ifstream autosaveFile(autosavePath);
+    std::stringstream contents;
+    contents << autosaveFile.rdbuf();
+
+    EXPECT_NE(contents.str().find("\"classname\" \"worldspawn\""), std::string::npos);
+    EXPECT_EQ(contents.str().find("added_after_autosave"), std::string::npos);
+
+    // The layers of the scene are written to the info file
+    std::ifstream autosaveInfoFile(autosaveInfoPath);
+    std::stringstream infoContents;
+    infoContents << autosaveInfoFile.rdbuf();
+
+    EXPECT_NE(infoContents.str().find("Windows"), std::string::npos);
+
+    autosaveFile.close();
+    autosaveInfoFile.close();
+
+    fs::remove(autosavePath);
+    fs::remove(autosaveInfoPath);
+}
+
+TEST_F(MapSavingTest, AutoSaverSnapshotLeavesLiveSceneAlone)
+{
+    std::string mapFileName = "altar_autosaveLiveScene.map";
+    auto mapPath = createMapCopyInModMapsPath("altar.map", mapFileName);
+
+    GlobalCommandSystem().executeCommand("OpenMap", "maps/" + mapFileName);
+    checkAltarScene();
+
+    fs::path autosavePath = mapPath;
+    autosavePath.replace_filename("altar_autosaveLiveScene_autosave.map");
+    fs::path autosaveInfoPath = fs::path(autosavePath).replace_extension("darkradiant");
+
+    std::size_t exportSignalCount = 0;
+    auto exportingConn = GlobalMapResourceManager().signal_onResourceExporting().connect(
+        [&](const scene::IMapRootNodePtr&) { ++exportSignalCount; });
+    auto exportedConn = GlobalMapResourceManager().signal_onResourceExported().connect(
+        [&](const scene::IMapRootNodePtr&) { ++exportSignalCount; });
+
+    GlobalAutoSaver().performAutosave();
+
+    exportingConn.disconnect();
+    exportedConn.disconnect();
+
+    // Capturing the snapshot doesn't emit any export signals
+    EXPECT_EQ(exportSignalCount, 0) << "Export signals have been emitted on the live scene";
+
+    // A regular save doesn't need to wait for the autosave
+    GlobalCommandSystem().executeCommand("SaveMap");
+    GlobalAutoSaver().waitForPendingSave();
+
+    std::ifstream mapFile(mapPath);
+    std::stringstream mapContents;
+    mapContents << mapFile.rdbuf();
+
+    std::ifstream autosaveFile(autosavePath);
+    std::stringstream autosaveContents;
+    autosaveContents << autosaveFile.rdbuf();
+
+    auto countBrushes = [](const std::string& text)
+    {
+        std::size_t count = 0;
+
+        for (auto pos = text.find("brushDef3"); pos != std::string::npos; pos = text.find("brushDef3", pos + 1))
+        {
+            ++count;
+        }
+
+        return count;
+    };
+
+    // The snapshot brushes are carrying the windings of the scene, all of them are written
+    EXPECT_GT(countBrushes(mapContents.str()), 0);
+    EXPECT_EQ(countBrushes(autosaveContents.str()), countBrushes(mapContents.str()));
+
+    mapFile.close();
+    autosaveFile.close();
+
+    fs::remove(autosavePath);
+    fs::remove(autosaveInfoPath);
+}
+
+namespace
+{
+
+// Collects the entities and their child primitives in traversal order
+std::vector<scene::INodePtr> getEntitiesAndPrimitives(const scene::IMapRootNodePtr& root)
+{
+    std::vector<scene::INodePtr> nodes;
+
+    root->foreachNode([&](const scene::INodePtr& entity)
+    {
+        nodes.push_back(entity);
+
+        entity->foreachNode([&](const scene::INodePtr& primitive)
+        {
+            nodes.push_back(primitive);
+            return true;
+        });
+
+        return true;
+    });
+
+    return nodes;
+}
+
+std::vector<std::pair<std::string, std::string>> getKeyValues(const scene::INodePtr& entity)
+{
+    std::vector<std::pair<std::string, std::string>> keyValues;
+
+    Node_getEntity(entity)->forEachKeyValue([&](const std::string& key, const std::string& value)
+    {
+        keyValues.emplace_back(key, value);
+    });
+
+    return keyValues;
+}
+
+// Expects the two scenes to contain the same entities, brushes and patches, down to the last bit
+void expectIdenticalScenes(const scene::IMapRootNodePtr& a, const scene::IMapRootNodePtr& b)
+{
+    auto nodesA = getEntitiesAndPrimitives(a);
+    auto nodesB = getEntitiesAndPrimitives(b);
+
+    ASSERT_EQ(nodesA.size(), nodesB.size());
+
+    for (std::size_t i = 0; i < nodesA.size(); ++i)
+    {
+        const auto& nodeA = nodesA[i];
+        const auto& nodeB = nodesB[i];
+
+        ASSERT_EQ(nodeA->getNodeType(), nodeB->getNodeType()) << "Node " << i << " differs";
+
+        if (Node_isEntity(nodeA))
+        {
+            EXPECT_EQ(getKeyValues(nodeA), getKeyValues(nodeB)) << "Entity " << i << " differs";
+        }
+        else if (Node_isBrush(nodeA))
+        {
+            const auto& brushA = *Node_getIBrush(nodeA);
+            const auto& brushB = *Node_getIBrush(nodeB);
+
+            ASSERT_EQ(brushA.getNumFaces(), brushB.getNumFaces());
+            EXPECT_EQ(brushA.getDetailFlag(), brushB.getDetailFlag());
+
+            for (std::size_t f = 0; f < brushA.getNumFaces(); ++f)
+            {
+                const auto& faceA = brushA.getFace(f);
+                const auto& faceB = brushB.getFace(f);
+
+                EXPECT_EQ(faceA.getShader(), faceB.getShader());
+                EXPECT_EQ(faceA.getPlane3().normal(), faceB.getPlane3().normal());
+                EXPECT_EQ(faceA.getPlane3().dist(), faceB.getPlane3().dist());
+
+                auto texdefA = faceA.getTexDefMatrix();
+                auto texdefB = faceB.getTexDefMatrix();
+
+                EXPECT_EQ(texdefA.xx(), texdefB.xx());
+                EXPECT_EQ(texdefA.yx(), texdefB.yx());
+                EXPECT_EQ(texdefA.tx(), texdefB.tx());
+                EXPECT_EQ(texdefA.xy(), texdefB.xy());
+                EXPECT_EQ(texdefA.yy(), texdefB.yy());
+                EXPECT_EQ(texdefA.ty(), texdefB.ty());
+            }
+        }
+        else if (Node_isPatch(nodeA))
+        {
+            const auto& patchA = *Node_getIPatch(nodeA);
+            const auto& patchB = *Node_getIPatch(nodeB);
+
+            EXPECT_EQ(patchA.getShader(), patchB.getShader());
+            EXPECT_EQ(patchA.subdivisionsFixed(), patchB.subdivisionsFixed());
+            EXPECT_EQ(patchA.getSubdivisions(), patchB.getSubdivisions());
+            ASSERT_EQ(patchA.getWidth(), patchB.getWidth());
+            ASSERT_EQ(patchA.getHeight(), patchB.getHeight());
+
+            for (std::size_t c = 0; c < patchA.getWidth(); ++c)
+            {
+                for (std::size_t r = 0; r < patchA.getHeight(); ++r)
+                {
+                    EXPECT_EQ(patchA.ctrlAt(r, c).vertex, patchB.ctrlAt(r, c).vertex);
+                    EXPECT_EQ(patchA.ctrlAt(r, c).texcoord, patchB.ctrlAt(r, c).texcoord);
+                }
+            }
+        }
+    }
+}
+
+}
+
+TEST_F(MapSavingTest, saveMapWritesBinaryCache)
+{
+    BinaryMapCacheEnabler enableCache;
+
+    auto mapPath = createMapCopyInTempDataPath("altar.map", "altar_binaryCache.map");
+    auto cachePath = fs::path(mapPath).replace_extension("mapcache");
+
+    GlobalCommandSystem().executeCommand("OpenMap", mapPath.string());
+    checkAltarScene();
+
+    std::size_t startedMessages = 0;
+    std::size_t finishedMessages = 0;
+
+    auto msgSubscription = GlobalRadiantCore().getMessageBus().addListener(
+        radiant::IMessage::Type::MapFileOperation,
+        radiant::TypeListener<map::FileOperation>([&](map::FileOperation& msg)
+    {
+        if (msg.getOperationType() != map::FileOperation::Type::Export) return;
+
+        if (msg.getMessageType() == map::FileOperation::Started) ++startedMessages;
+        if (msg.getMessageType() == map::FileOperation::Finished) ++finishedMessages;
+    }));
+
+    std::size_t exportingSignals = 0;
+    std::size_t exportedSignals = 0;
+    auto exportingConn = GlobalMapResourceManager().signal_onResourceExporting().connect(
+        [&](const scene::IMapRootNodePtr&) { ++exportingSignals; });
+    auto exportedConn = GlobalMapResourceManager().signal_onResourceExported().connect(
+        [&](const scene::IMapRootNodePtr&) { ++exportedSignals; });
+
+    EXPECT_FALSE(os::fileOrDirExists(cachePath));
+    GlobalCommandSystem().executeCommand("SaveMap");
+    EXPECT_TRUE(os::fileOrDirExists(cachePath)) << "Map cache has not been written";
+
+    exportingConn.disconnect();
+    exportedConn.disconnect();
+    GlobalRadiantCore().getMessageBus().removeListener(msgSubscription);
+
+    // Writing the cache is part of the regular export, no extra messages or signals
+    EXPECT_EQ(startedMessages, 1);
+    EXPECT_EQ(finishedMessages, 1);
+    EXPECT_EQ(exportingSignals, 1);
+    EXPECT_EQ(exportedSignals, 1);
+
+    // Load the saved map through the cache
+    auto cachedResource = GlobalMapResourceManager().createFromPath(mapPath.string());
+    EXPECT_TRUE(cachedResource->load());
+    checkAltarScene(cachedResource->getRootNode());
+
+    // Move the cache away, the map file needs to be parsed now
+    auto movedCachePath = fs::path(cachePath).replace_extension("mapcache.bak");
+    fs::rename(cachePath, movedCachePath);
+
+    auto parsedResource = GlobalMapResourceManager().createFromPath(mapPath.string());
+    EXPECT_TRUE(parsedResource->load());
+    checkAltarScene(parsedResource->getRootNode());
+
+    expectIdenticalScenes(cachedResource->getRootNode(), parsedResource->getRootNode());
+
+    // Change a spawnarg in the cache only, which tells whether the cache is used
+    fs::rename(movedCachePath, cachePath);
+    EXPECT_TRUE(replaceStringInFile(cachePath, "0.286 0.408 0.259", "0.999 0.999 0.999"));
+
+    auto markedResource = GlobalMapResourceManager().createFromPath(mapPath.string());
+    EXPECT_TRUE(markedResource->load());
+    EXPECT_EQ(Node_getEntity(algorithm::findWorldspawn(markedResource->getRootNode()))->getKeyValue("_color"),
+        "0.999 0.999 0.999") << "The map has not been loaded through the cache";
+
+    fs::remove(cachePath);
+    fs::remove(fs::path(mapPath).replace_extension("bak"));
+    fs::remove(fs::path(mapPath).replace_extension("darkradiant").string() + ".bak");
+}
+
+// The cache is written for the saved file as it is on disk, it must be picked up
+// on loading when the map file has CRLF line endings (like on Windows)
+TEST_F(MapSavingTest, binaryCacheOfMapWithCrlfLineEndings)
+{
+    BinaryMapCacheEnabler enableCache;
+
+    auto mapPath = createMapCopyInTempDataPath("altar.map", "altar_crlfBinaryCache.map");
+    auto cachePath = fs::path(mapPath).replace_extension("mapcache");
+
+    convertToCrlfLineEndings(mapPath);
+
+    GlobalCommandSystem().executeCommand("OpenMap", mapPath.string());
+    checkAltarScene();
+
+    GlobalCommandSystem().executeCommand("SaveMap");
+    EXPECT_TRUE(os::fileOrDirExists(cachePath)) << "Map cache has not been written";
+
+    // Whatever line endings the map writer used on this platform, the file has CRLF now
+    convertToCrlfLineEndings(mapPath);
+
+    // Change a spawnarg in the cache only, which tells whether the cache is used
+    EXPECT_TRUE(replaceStringInFile(cachePath, "0.286 0.408 0.259", "0.999 0.999 0.999"));
+
+    auto resource = GlobalMapResourceManager().createFromPath(mapPath.string());
+    EXPECT_TRUE(resource->load());
+    EXPECT_EQ(Node_getEntity(algorithm::findWorldspawn(resource->getRootNode()))->getKeyValue("_color"),
+        "0.999 0.999 0.999") << "The map has not been loaded through the cache";
+
+    fs::remove(cachePath);
+    fs::remove(fs::path(mapPath).replace_extension("bak"));
+    fs::remove(fs::path(mapPath).replace_extension("darkradiant").string() + ".bak");
+}
+
+TEST_F(MapSavingTest, outdatedBinaryCacheIsIgnored)
+{
+    BinaryMapCacheEnabler enableCache;
+
+    auto mapPath = createMapCopyInTempDataPath("altar.map", "altar_outdatedBinaryCache.map");
+    auto cachePath = fs::path(mapPath).replace_extension("mapcache");
+
+    GlobalCommandSystem().executeCommand("OpenMap", mapPath.string());
+    GlobalCommandSystem().executeCommand("SaveMap");
+    EXPECT_TRUE(os::fileOrDirExists(cachePath));
+
+    // Change a spawnarg in the cache only, it must not show up in the loaded map
+    EXPECT_TRUE(replaceStringInFile(cachePath, "0.286 0.408 0.259", "0.999 0.999 0.999"));
+
+    // Change the map file behind the cache's back
+    {
+        std::ofstream mapFile(mapPath, std::ios::app);
+        mapFile << "{\n\"classname\" \"func_static\"\n\"name\" \"added_to_map_file\"\n}\n";
+    }
+
+    auto resource = GlobalMapResourceManager().createFromPath(mapPath.string());
+    EXPECT_TRUE(resource->load());
+
+    checkAltarScene(resource->getRootNode());
+    EXPECT_TRUE(algorithm::getEntityByName(resource->getRootNode(), "added_to_map_file"));
+    EXPECT_EQ(Node_getEntity(algorithm::findWorldspawn(resource->getRootNode()))->getKeyValue("_color"),
+        "0.286 0.408 0.259") << "The outdated cache has been used to load the map";
+
+    fs::remove(cachePath);
+    fs::remove(fs::path(mapPath).replace_extension("bak"));
+    fs::remove(fs::path(mapPath).replace_extension("darkradiant").string() + ".bak");
+}
+
 }
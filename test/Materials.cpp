@@ -8,6 +8,8 @@
 #include "string/join.h"
 #include "math/MatrixUtils.h"
 #include "materials/FrobStageSetup.h"
+#include "algorithm/FileSystem.h"
+#include "testutil/TemporaryFile.h"
 
 namespace test
 {
@@ -46,6 +48,28 @@ TEST_F(MaterialsTest, MaterialFileInfo)
     EXPECT_EQ(hiddenTex2->getShaderFileInfo().visibility, vfs::Visibility::HIDDEN);
 }
 
+TEST_F(MaterialsTest, MaterialGeneratedForImageFile)
+{
+    auto& materialManager = GlobalMaterialManager();
+
+    // There's no decl for this name, but an image file exists in the VFS
+    EXPECT_FALSE(materialManager.materialExists("lights/squarelight1a"));
+
+    auto material = materialManager.getMaterial("lights/squarelight1a");
+    EXPECT_EQ(material->getShaderFileInfo().name, "_autogenerated_by_darkradiant_.mtr");
+    EXPECT_EQ(material->getShaderFileInfo().visibility, vfs::Visibility::HIDDEN);
+
+    // The generated material has a single diffuse stage referencing the image
+    ASSERT_EQ(material->getAllLayers().size(), 1);
+    EXPECT_EQ(material->getAllLayers().front()->getType(), IShaderLayer::DIFFUSE);
+
+    // A name matching neither a decl nor an image ends up as visible placeholder material
+    auto missing = materialManager.getMaterial("textures/doesnt/exist/anywhere");
+    EXPECT_EQ(missing->getShaderFileInfo().name, "_autogenerated_by_darkradiant_.mtr");
+    EXPECT_EQ(missing->getShaderFileInfo().visibility, vfs::Visibility::NORMAL);
+    EXPECT_EQ(missing->getAllLayers().size(), 0);
+}
+
 TEST_F(MaterialsTest, MaterialCanBeModified)
 {
     auto& materialManager = GlobalMaterialManager();
@@ -1501,4 +1525,89 @@ TEST_F(MaterialsTest, MaterialFrobStageRemoval)
     checkFrobStageRemoval("textures/parsertest/frobstage_missing5");
 }
 
+inline std::string getReloadTestMaterial(const std::string& name, const std::string& description)
+{
+    return name + "\n{\n    description \"" + description + "\"\n}\n";
+}
+
+TEST_F(MaterialsTest, ReloadChangedMaterialFiles)
+{
+    // Make sure the initial load is done before adding the file
+    EXPECT_FALSE(GlobalMaterialManager().materialExists("textures/reloadtest/changing"));
+
+    TemporaryFile materialFile(_context.getTestProjectPath() + "materials/_reload_test.mtr",
+        getReloadTestMaterial("textures/reloadtest/changing", "first"));
+
+    // Added files are picked up
+    GlobalMaterialManager().reloadChangedMaterials();
+    EXPECT_TRUE(GlobalMaterialManager().materialExists("textures/reloadtest/changing"));
+
+    auto material = GlobalMaterialManager().getMaterial("textures/reloadtest/changing");
+    EXPECT_EQ(material->getDescription(), "first");
+
+    std::size_t changedSignalCount = 0;
+    material->sig_materialChanged().connect([&]() { ++changedSignalCount; });
+
+    // Unchanged files are not touched
+    GlobalMaterialManager().reloadChangedMaterials();
+    EXPECT_EQ(changedSignalCount, 0);
+
+    // The existing material instance takes the new declaration
+    materialFile.write(getReloadTestMaterial("textures/reloadtest/changing", "second declaration"));
+    GlobalMaterialManager().reloadChangedMaterials();
+
+    EXPECT_EQ(material->getDescription(), "second declaration");
+    EXPECT_EQ(changedSignalCount, 1);
+    EXPECT_EQ(GlobalMaterialManager().getMaterial("textures/reloadtest/changing"), material);
+
+    // Removing the file removes the material
+    materialFile.remove();
+    GlobalMaterialManager().reloadChangedMaterials();
+
+    EXPECT_FALSE(GlobalMaterialManager().materialExists("textures/reloadtest/changing"));
+}
+
+// Reloading changed files must leave the material with the file a full load would pick
+TEST_F(MaterialsTest, ReloadMaterialsRespectsFilePrecedence)
+{
+    EXPECT_FALSE(GlobalMaterialManager().materialExists("textures/reloadtest/precedence"));
+
+    auto materialFolder = _context.getTestProjectPath() + "materials/";
+    TemporaryFile fileA(materialFolder + "_reload_precedence_a.mtr", "");
+    TemporaryFile fileB(materialFolder + "_reload_precedence_b.mtr", "");
+
+    auto aIsListedFirst = algorithm::isListedBefore("materials/", "mtr",
+        "_reload_precedence_a.mtr", "_reload_precedence_b.mtr");
+    auto& firstFile = aIsListedFirst ? fileA : fileB;
+    auto& lastFile = aIsListedFirst ? fileB : fileA;
+
+    // The definition of the file listed first wins
+    firstFile.write(getReloadTestMaterial("textures/reloadtest/precedence", "first"));
+    lastFile.write(getReloadTestMaterial("textures/reloadtest/precedence", "last"));
+    GlobalMaterialManager().reloadChangedMaterials();
+
+    auto material = GlobalMaterialManager().getMaterial("textures/reloadtest/precedence");
+    EXPECT_EQ(material->getDescription(), "first");
+
+    // Changing the shadowed definition doesn't change the material
+    lastFile.write(getReloadTestMaterial("textures/reloadtest/precedence", "last changed"));
+    GlobalMaterialManager().reloadChangedMaterials();
+    EXPECT_EQ(material->getDescription(), "first");
+
+    // The shadowed definition takes over when the other file stops declaring it
+    firstFile.write(getReloadTestMaterial("textures/reloadtest/precedence_other", "first"));
+    GlobalMaterialManager().reloadChangedMaterials();
+    EXPECT_EQ(material->getDescription(), "last changed");
+
+    firstFile.write(getReloadTestMaterial("textures/reloadtest/precedence", "first again"));
+    GlobalMaterialManager().reloadChangedMaterials();
+    EXPECT_EQ(material->getDescription(), "first again");
+
+    // Same for removing the file
+    firstFile.remove();
+    GlobalMaterialManager().reloadChangedMaterials();
+    EXPECT_EQ(material->getDescription(), "last changed");
+    EXPECT_EQ(GlobalMaterialManager().getMaterial("textures/reloadtest/precedence"), material);
+}
+
 }
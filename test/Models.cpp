@@ -3,8 +3,23 @@
 #include <unordered_set>
 #include "imodelsurface.h"
 #include "imodelcache.h"
+#include "imd5anim.h"
+#include "ifilesystem.h"
+#include "modelskin.h"
+#include "ientity.h"
+#include "ieclass.h"
+#include "scenelib.h"
+#include "algorithm/Scene.h"
+#include "algorithm/FileSystem.h"
+#include "testutil/TemporaryFile.h"
 
 #include "render/VertexHashing.h"
+#include "render/ArbitraryMeshVertex.h"
+#include "render/MeshSkinning.h"
+#include "render/PackedMeshVertex.h"
+
+#include <random>
+#include <chrono>
 
 namespace test
 {
@@ -30,6 +45,90 @@ TEST_F(ModelTest, AsePolyCount)
     EXPECT_EQ(model->getPolyCount(), 12);
 }
 
+TEST_F(ModelTest, ModelNodesShareGeometry)
+{
+    const std::string modelPath = "models/twosided_ivy.lwo";
+
+    auto statsBefore = GlobalModelCache().getStatistics();
+
+    auto firstNode = GlobalModelCache().getModelNode(modelPath);
+    auto secondNode = GlobalModelCache().getModelNode(modelPath);
+
+    auto statsAfter = GlobalModelCache().getStatistics();
+
+    // The second request should be a cache hit, adding no further geometry
+    EXPECT_EQ(statsAfter.numMisses, statsBefore.numMisses + 1);
+    EXPECT_GE(statsAfter.numHits, statsBefore.numHits + 1);
+    EXPECT_EQ(statsAfter.numModels, statsBefore.numModels + 1);
+    EXPECT_GT(statsAfter.vertexDataSize, statsBefore.vertexDataSize);
+    EXPECT_GT(statsAfter.indexDataSize, statsBefore.indexDataSize);
+
+    auto& firstSurface = dynamic_cast<const model::IIndexedModelSurface&>(
+        Node_getModel(firstNode)->getIModel().getSurface(0));
+    auto& secondSurface = dynamic_cast<const model::IIndexedModelSurface&>(
+        Node_getModel(secondNode)->getIModel().getSurface(0));
+
+    // Both nodes are referencing the same geometry
+    EXPECT_EQ(&firstSurface.getIndexArray(), &secondSurface.getIndexArray());
+
+    // Skins are applied per node, without affecting the other one
+    auto skinnedModel = std::dynamic_pointer_cast<SkinnedModel>(secondNode);
+    ASSERT_TRUE(skinnedModel);
+    skinnedModel->skinChanged("ivy_onesided");
+
+    EXPECT_EQ(&firstSurface.getIndexArray(), &secondSurface.getIndexArray());
+    EXPECT_EQ(firstSurface.getActiveMaterial(), "textures/darkmod/decals/vegetation/ivy_mixed_pieces");
+    EXPECT_EQ(secondSurface.getActiveMaterial(), "textures/darkmod/decals/vegetation/ivy_mixed_pieces_onesided");
+}
+
+TEST_F(ModelTest, AsyncLoadingSwapsPlaceholder)
+{
+    const std::string modelPath = "models/darkmod/test/unit_cube.lwo";
+
+    auto entity = GlobalEntityModule().createEntity(GlobalEntityClassManager().findClass("func_static"));
+    entity->getEntity().setKeyValue("model", modelPath);
+
+    // The entity is not in the scene yet, it should receive a placeholder
+    auto childModel = algorithm::findChildModel(entity);
+    ASSERT_TRUE(childModel);
+    EXPECT_TRUE(std::dynamic_pointer_cast<model::IModelPlaceholder>(childModel));
+
+    // A second request for the same model is sharing the pending load
+    auto secondNode = GlobalModelCache().getModelNodeAsync(modelPath);
+    auto secondPlaceholder = std::dynamic_pointer_cast<model::IModelPlaceholder>(secondNode);
+    ASSERT_TRUE(secondPlaceholder);
+
+    scene::INodePtr loadedNode;
+    secondPlaceholder->signal_modelLoaded().connect([&](const scene::INodePtr& node) { loadedNode = node; });
+
+    GlobalModelCache().waitForPendingModels();
+
+    ASSERT_TRUE(loadedNode);
+    EXPECT_EQ(Node_getModel(loadedNode)->getIModel().getPolyCount(), 12);
+
+    // The entity got the actual model swapped in
+    childModel = algorithm::findChildModel(entity);
+    ASSERT_TRUE(childModel);
+    EXPECT_FALSE(std::dynamic_pointer_cast<model::IModelPlaceholder>(childModel));
+    EXPECT_EQ(childModel->getIModel().getPolyCount(), 12);
+
+    // Cache hits are served right away
+    auto cachedNode = GlobalModelCache().getModelNodeAsync(modelPath);
+    EXPECT_FALSE(std::dynamic_pointer_cast<model::IModelPlaceholder>(cachedNode));
+
+    // Entities don't take their placeholders into the scene
+    auto otherEntity = GlobalEntityModule().createEntity(GlobalEntityClassManager().findClass("func_static"));
+    otherEntity->getEntity().setKeyValue("model", "models/darkmod/test/unit_cube.ase");
+    EXPECT_TRUE(std::dynamic_pointer_cast<model::IModelPlaceholder>(algorithm::findChildModel(otherEntity)));
+
+    scene::addNodeToContainer(otherEntity, GlobalMapModule().getRoot());
+
+    childModel = algorithm::findChildModel(otherEntity);
+    ASSERT_TRUE(childModel);
+    EXPECT_FALSE(std::dynamic_pointer_cast<model::IModelPlaceholder>(childModel));
+    EXPECT_EQ(childModel->getIModel().getPolyCount(), 12);
+}
+
 // #4644: If the *BITMAP material cannot be resolved, the code should not fall back to *MATERIAL_NAME (in TDM/idTech4)
 TEST_F(AseImportTest, BitmapFieldPreferredOverMaterialName)
 {
@@ -453,4 +552,584 @@ TEST_F(ModelTest, LoadFbxModel)
     EXPECT_EQ(model->getPolyCount(), 12);
 }
 
+namespace
+{
+
+// Returns a pseudo-random value in the range [min, max), independent of the standard library implementation
+double getRandomValue(std::mt19937& random, double min, double max)
+{
+    return min + (max - min) * (random() / (static_cast<double>(std::mt19937::max()) + 1));
+}
+
+struct TestJoint
+{
+    Quaternion orientation;
+    Vector3 origin;
+};
+
+struct TestWeight
+{
+    std::size_t joint;
+    float t;
+    Vector3 v;
+};
+
+// The skinning algorithm as it was implemented in double precision, using the ArbitraryMeshVertex helpers
+std::vector<ArbitraryMeshVertex> skinMeshReference(const std::vector<TestJoint>& joints, const std::vector<TestWeight>& weights,
+    const std::vector<render::SkinningInfluence>& influences, const std::vector<Vector2>& texcoords, const std::vector<unsigned int>& indices)
+{
+    std::vector<ArbitraryMeshVertex> vertices(influences.size());
+
+    for (std::size_t i = 0; i < influences.size(); ++i)
+    {
+        Vector3 skinned(0, 0, 0);
+
+        for (auto w = influences[i].firstWeight; w < influences[i].firstWeight + influences[i].numWeights; ++w)
+        {
+            const auto& weight = weights[w];
+            const auto& joint = joints[weight.joint];
+
+            skinned += (joint.orientation.transformPoint(weight.v) + joint.origin) * weight.t;
+        }
+
+        vertices[i].vertex = skinned;
+        vertices[i].texcoord = TexCoord2f(texcoords[i].x(), texcoords[i].y());
+        vertices[i].normal = Normal3f(0, 0, 0);
+    }
+
+    for (std::size_t i = 0; i < indices.size(); i += 3)
+    {
+        auto& a = vertices[indices[i]];
+        auto& b = vertices[indices[i + 1]];
+        auto& c = vertices[indices[i + 2]];
+
+        Vector3 weightedNormal((c.vertex - a.vertex).cross(b.vertex - a.vertex));
+
+        a.normal += weightedNormal;
+        b.normal += weightedNormal;
+        c.normal += weightedNormal;
+
+        ArbitraryMeshTriangle_sumTangents(a, b, c);
+    }
+
+    for (auto& vertex : vertices)
+    {
+        vertex.normal = Normal3f(vertex.normal.getNormalised());
+        vertex.tangent.normalise();
+        vertex.bitangent.normalise();
+    }
+
+    return vertices;
+}
+
+void expectVectorNear(const float* actual, const Vector3& expected, double epsilon, const std::string& what, std::size_t index)
+{
+    EXPECT_NEAR(actual[0], expected.x(), epsilon) << what << " mismatch at vertex " << index;
+    EXPECT_NEAR(actual[1], expected.y(), epsilon) << what << " mismatch at vertex " << index;
+    EXPECT_NEAR(actual[2], expected.z(), epsilon) << what << " mismatch at vertex " << index;
+}
+
+}
+
+TEST_F(ModelTest, MeshSkinningMatchesReference)
+{
+    std::mt19937 random(4711);
+
+    // A few joints with arbitrary orientations and origins
+    std::vector<TestJoint> joints;
+
+    for (std::size_t i = 0; i < 8; ++i)
+    {
+        auto axis = Vector3(getRandomValue(random, -1, 1), getRandomValue(random, -1, 1), getRandomValue(random, 0.1, 1)).getNormalised();
+        auto angle = getRandomValue(random, -3, 3);
+
+        joints.push_back(TestJoint{
+            Quaternion::createForAxisAngle(axis, angle),
+            Vector3(getRandomValue(random, -64, 64), getRandomValue(random, -64, 64), getRandomValue(random, -64, 64))
+        });
+    }
+
+    // A wavy grid of vertices, each of them attached to 1-4 joints. The weight positions are
+    // chosen such that the skinned vertex ends up (close to) its grid position
+    constexpr std::size_t GridSize = 24;
+
+    std::vector<TestWeight> weights;
+    std::vector<render::SkinningInfluence> influences;
+    std::vector<Vector2> texcoords;
+
+    for (std::size_t y = 0; y < GridSize; ++y)
+    {
+        for (std::size_t x = 0; x < GridSize; ++x)
+        {
+            Vector3 gridPosition(x * 8.0, y * 8.0, sin(x * 0.5) * 4 + cos(y * 0.3) * 4);
+
+            auto numWeights = 1 + random() % 4;
+            influences.push_back(render::SkinningInfluence{ static_cast<std::uint32_t>(weights.size()), static_cast<std::uint32_t>(numWeights) });
+            texcoords.push_back(Vector2(x / 8.0, y / 8.0));
+
+            for (std::size_t w = 0; w < numWeights; ++w)
+            {
+                auto jointIndex = random() % joints.size();
+                const auto& joint = joints[jointIndex];
+
+                // Transform the grid position (plus some noise) into joint space
+                Quaternion inverse(-joint.orientation.x(), -joint.orientation.y(), -joint.orientation.z(), joint.orientation.w());
+                auto noise = Vector3(getRandomValue(random, -0.5, 0.5), getRandomValue(random, -0.5, 0.5), getRandomValue(random, -0.5, 0.5));
+
+                weights.push_back(TestWeight{ jointIndex, 1.0f / numWeights, inverse.transformPoint(gridPosition + noise - joint.origin) });
+            }
+        }
+    }
+
+    std::vector<unsigned int> indices;
+
+    for (unsigned int y = 0; y + 1 < GridSize; ++y)
+    {
+        for (unsigned int x = 0; x + 1 < GridSize; ++x)
+        {
+            auto topLeft = y * GridSize + x;
+
+            indices.insert(indices.end(), { topLeft, topLeft + 1, topLeft + GridSize });
+            indices.insert(indices.end(), { topLeft + 1, topLeft + GridSize + 1, topLeft + GridSize });
+        }
+    }
+
+    // Run the kernel
+    std::vector<render::SkinningJoint> skinningJoints;
+    for (const auto& joint : joints)
+    {
+        skinningJoints.push_back(render::createSkinningJoint(joint.orientation, joint.origin));
+    }
+
+    std::vector<render::SkinningWeight> skinningWeights;
+    for (const auto& weight : weights)
+    {
+        skinningWeights.push_back(render::createSkinningWeight(weight.v, weight.t, weight.joint));
+    }
+
+    std::vector<render::SkinnedVertex> skinned(influences.size());
+    for (std::size_t i = 0; i < skinned.size(); ++i)
+    {
+        skinned[i].texcoord[0] = static_cast<float>(texcoords[i].x());
+        skinned[i].texcoord[1] = static_cast<float>(texcoords[i].y());
+    }
+
+    render::skinMesh(skinningJoints, skinningWeights, influences, indices, skinned);
+
+    auto expected = skinMeshReference(joints, weights, influences, texcoords, indices);
+
+    ASSERT_EQ(skinned.size(), expected.size());
+
+    for (std::size_t i = 0; i < skinned.size(); ++i)
+    {
+        expectVectorNear(skinned[i].vertex, expected[i].vertex, 0.001, "Position", i);
+        expectVectorNear(skinned[i].normal, expected[i].normal, 0.001, "Normal", i);
+        expectVectorNear(skinned[i].tangent, expected[i].tangent, 0.001, "Tangent", i);
+        expectVectorNear(skinned[i].bitangent, expected[i].bitangent, 0.001, "Bitangent", i);
+    }
+
+    // Skinning the same vertices again yields the same result, nothing is accumulated
+    auto firstResult = skinned;
+    render::skinMesh(skinningJoints, skinningWeights, influences, indices, skinned);
+
+    EXPECT_EQ(memcmp(firstResult.data(), skinned.data(), skinned.size() * sizeof(render::SkinnedVertex)), 0);
+}
+
+TEST_F(ModelTest, PackedMeshVertexRoundTrip)
+{
+    EXPECT_LT(sizeof(render::PackedMeshVertex), sizeof(ArbitraryMeshVertex) / 3);
+
+    ArbitraryMeshVertex vertex(Vertex3f(-0.0218, -744.8999, 2238.5), Normal3f(-0.8698, 0, -0.493405).getNormalised(),
+        TexCoord2f(-3.9808, 12.8198), Vector3(0.9882, 0.5, 0));
+    vertex.tangent = Normal3f(0, 1, 0);
+    vertex.bitangent = Normal3f(0.493405, 0, -0.8698).getNormalised();
+
+    auto unpacked = render::unpackMeshVertex(render::packMeshVertex(vertex));
+
+    // Quantisation errors are well below the tolerances used for the vertex comparisons
+    EXPECT_TRUE(math::isNear(unpacked.vertex, vertex.vertex, 1e-3));
+    EXPECT_TRUE(math::isNear(unpacked.texcoord, vertex.texcoord, 1e-5));
+    EXPECT_TRUE(math::isNear(unpacked.normal, vertex.normal, 1e-4));
+    EXPECT_TRUE(math::isNear(unpacked.tangent, vertex.tangent, 1e-4));
+    EXPECT_TRUE(math::isNear(unpacked.bitangent, vertex.bitangent, 1e-4));
+    EXPECT_TRUE(math::isNear(unpacked.colour, vertex.colour, 1.0 / 255));
+
+    std::equal_to<ArbitraryMeshVertex> equalityComparer;
+    EXPECT_TRUE(equalityComparer(unpacked, vertex));
+
+    // Loaded static models store their vertices in the compact format, expect the same results as before
+    auto model = GlobalModelCache().getModel("models/ase/tiles_with_shared_vertex_and_colour.ase");
+    ASSERT_EQ(model->getSurfaceCount(), 1);
+
+    const auto& surface = static_cast<const model::IIndexedModelSurface&>(model->getSurface(0));
+    EXPECT_EQ(surface.getVertexArray().size(), surface.getNumVertices());
+    expectVertexWithColour(surface, Vertex3f(-19, 18, 2), Vector3(0.9216, 0.9216, 0.9216));
+    expectVertexWithNormal(surface, Vertex3f(56, -19, 2), Normal3f(0, 0, 1));
+}
+
+// Loads every static test model and reports the vertex memory they occupy in the cache
+TEST_F(ModelTest, StaticModelVertexDataSize)
+{
+    GlobalModelCache().clear();
+    auto statsBefore = GlobalModelCache().getStatistics();
+
+    std::size_t numVertices = 0;
+
+    for (const auto& extension : { "ase", "lwo" })
+    {
+        GlobalFileSystem().forEachFile("models/", extension, [&](const vfs::FileInfo& fileInfo)
+        {
+            auto model = GlobalModelCache().getModel(fileInfo.fullPath());
+            EXPECT_TRUE(model) << "Failed to load " << fileInfo.fullPath();
+
+            if (model)
+            {
+                numVertices += model->getVertexCount();
+            }
+        }, 99);
+    }
+
+    ASSERT_GT(numVertices, 0);
+
+    auto packedSize = GlobalModelCache().getStatistics().vertexDataSize - statsBefore.vertexDataSize;
+    auto unpackedSize = numVertices * sizeof(ArbitraryMeshVertex);
+
+    rMessage() << numVertices << " static model vertices occupy " << packedSize
+        << " bytes, " << unpackedSize << " bytes unpacked" << std::endl;
+
+    EXPECT_EQ(packedSize, numVertices * sizeof(render::PackedMeshVertex));
+    EXPECT_LT(packedSize * 3, unpackedSize);
+}
+
+TEST_F(ModelTest, StaticModelVertexArrayCanBeReleased)
+{
+    auto model = GlobalModelCache().getModel("models/ase/tiles_with_shared_vertex_and_colour.ase");
+    ASSERT_EQ(model->getSurfaceCount(), 1);
+
+    const auto& surface = static_cast<const model::IIndexedModelSurface&>(model->getSurface(0));
+    auto firstVertex = surface.getVertex(0);
+    auto numVertices = surface.getVertexArray().size();
+
+    surface.releaseVertexArray();
+
+    // The vertices are built again on the next access
+    EXPECT_EQ(surface.getVertexArray().size(), numVertices);
+    EXPECT_EQ(surface.getVertex(0).vertex, firstVertex.vertex);
+    EXPECT_EQ(surface.getVertex(0).texcoord, firstVertex.texcoord);
+}
+
+// Not a correctness test, reports the time spent parsing the ASE and LWO test models to the log
+TEST_F(ModelTest, ModelLoadingBenchmark)
+{
+    constexpr int NumIterations = 20;
+
+    for (const auto& extension : { "ase", "lwo" })
+    {
+        auto importer = GlobalModelFormatManager().getImporter(extension);
+
+        std::vector<std::string> paths;
+        GlobalFileSystem().forEachFile("models/", extension, [&](const vfs::FileInfo& fileInfo)
+        {
+            paths.push_back(fileInfo.fullPath());
+        }, 99);
+
+        ASSERT_FALSE(paths.empty()) << "No " << extension << " models found";
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < NumIterations; ++i)
+        {
+            for (const auto& path : paths)
+            {
+                // Load the model bypassing the cache
+                EXPECT_TRUE(importer->loadModelFromPath(path)) << "Failed to load " << path;
+            }
+        }
+
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+
+        rMessage() << "Loading " << paths.size() << " " << extension << " models took "
+            << (duration.count() / NumIterations) << " usec on average" << std::endl;
+    }
+}
+
+TEST_F(ModelTest, LookupSkinsForModel)
+{
+    auto& skinCache = GlobalModelSkinCache();
+
+    // The skin declared in skins/selection_test.skin
+    auto& skin = skinCache.capture("ivy_onesided");
+    EXPECT_EQ(skin.getName(), "ivy_onesided");
+    EXPECT_EQ(skin.getSkinFileName(), "selection_test.skin");
+    EXPECT_EQ(skin.getRemap("textures/darkmod/decals/vegetation/ivy_mixed_pieces"),
+        "textures/darkmod/decals/vegetation/ivy_mixed_pieces_onesided");
+
+    const auto& skins = skinCache.getSkinsForModel("models/twosided_ivy.lwo");
+    EXPECT_NE(std::find(skins.begin(), skins.end(), "ivy_onesided"), skins.end());
+
+    const auto& allSkins = skinCache.getAllSkins();
+    EXPECT_NE(std::find(allSkins.begin(), allSkins.end(), "ivy_onesided"), allSkins.end());
+
+    // Models without skins get an empty list
+    EXPECT_TRUE(skinCache.getSkinsForModel("models/without/any/skin.lwo").empty());
+}
+
+inline std::string getPrecedenceTestSkin(const std::string& replacement)
+{
+    return "skin reload_test_precedence\n{\n    model models/reload_test.lwo\n"
+        "    textures/reload_test/original " + replacement + "\n}\n";
+}
+
+// Reloading changed files must leave the skin with the file a full load would pick
+TEST_F(ModelTest, ReloadSkinsRespectsFilePrecedence)
+{
+    auto& skinCache = GlobalModelSkinCache();
+    EXPECT_EQ(skinCache.capture("reload_test_precedence").getName(), "");
+
+    auto skinFolder = _context.getTestProjectPath() + "skins/";
+    TemporaryFile fileA(skinFolder + "_reload_precedence_a.skin", "");
+    TemporaryFile fileB(skinFolder + "_reload_precedence_b.skin", "");
+
+    auto aIsListedFirst = algorithm::isListedBefore("skins/", "skin",
+        "_reload_precedence_a.skin", "_reload_precedence_b.skin");
+    auto& firstFile = aIsListedFirst ? fileA : fileB;
+    auto& lastFile = aIsListedFirst ? fileB : fileA;
+
+    auto getRemap = [&]()
+    {
+        return skinCache.capture("reload_test_precedence").getRemap("textures/reload_test/original");
+    };
+
+    // The skin of the file listed first wins
+    firstFile.write(getPrecedenceTestSkin("textures/reload_test/first"));
+    lastFile.write(getPrecedenceTestSkin("textures/reload_test/last"));
+    skinCache.refresh();
+    EXPECT_EQ(getRemap(), "textures/reload_test/first");
+
+    // Changing the overridden skin doesn't change anything
+    lastFile.write(getPrecedenceTestSkin("textures/reload_test/last_changed"));
+    skinCache.refresh();
+    EXPECT_EQ(getRemap(), "textures/reload_test/first");
+
+    // The overridden skin takes over when the other file stops declaring it
+    firstFile.write("");
+    skinCache.refresh();
+    EXPECT_EQ(getRemap(), "textures/reload_test/last_changed");
+
+    const auto& skins = skinCache.getSkinsForModel("models/reload_test.lwo");
+    EXPECT_EQ(skins, StringList{ "reload_test_precedence" });
+
+    firstFile.write(getPrecedenceTestSkin("textures/reload_test/first_again"));
+    skinCache.refresh();
+    EXPECT_EQ(getRemap(), "textures/reload_test/first_again");
+
+    // Same for removing the file
+    firstFile.remove();
+    skinCache.refresh();
+    EXPECT_EQ(getRemap(), "textures/reload_test/last_changed");
+    EXPECT_EQ(skinCache.getSkinsForModel("models/reload_test.lwo"), StringList{ "reload_test_precedence" });
+}
+
+namespace
+{
+
+// The slerp the skeleton used before the poses were calculated by the anim
+inline Quaternion referenceSlerp(const Quaternion& qa, const Quaternion& qb, float fraction)
+{
+    double cosHalfTheta = qa.w() * qb.w() + qa.x() * qb.x() + qa.y() * qb.y() + qa.z() * qb.z();
+
+    if (std::abs(cosHalfTheta) > 1.0)
+    {
+        return qb;
+    }
+
+    Quaternion temp = qb;
+
+    if (cosHalfTheta < 0.0)
+    {
+        temp = qb * (-1);
+        cosHalfTheta = -cosHalfTheta;
+    }
+
+    double halfTheta = acos(cosHalfTheta);
+    double sinHalfTheta = sqrt(1.0 - cosHalfTheta * cosHalfTheta);
+
+    if (fabs(sinHalfTheta) < 0.006)
+    {
+        return Quaternion(qa.x() * (1 - fraction) + temp.x() * fraction, qa.y() * (1 - fraction) + temp.y() * fraction,
+            qa.z() * (1 - fraction) + temp.z() * fraction, qa.w() * (1 - fraction) + temp.w() * fraction);
+    }
+
+    double ratioA = sin((1 - fraction) * halfTheta) / sinHalfTheta;
+    double ratioB = sin(fraction * halfTheta) / sinHalfTheta;
+
+    return Quaternion(qa.x() * ratioA + temp.x() * ratioB, qa.y() * ratioA + temp.y() * ratioB,
+        qa.z() * ratioA + temp.z() * ratioB, qa.w() * ratioA + temp.w() * ratioB);
+}
+
+inline double getQuaternionW(const Quaternion& q)
+{
+    auto w = -sqrt(1.0 - q.getVector3().getLengthSquared());
+    return isNaN(w) ? 0 : w;
+}
+
+void transformReferenceJoint(const md5::IMD5Anim& anim, md5::IMD5Anim::Pose& pose, std::size_t jointId)
+{
+    const auto& joint = anim.getJoint(jointId);
+
+    if (joint.parentId >= 0)
+    {
+        pose[joint.id].orientation.preMultiplyBy(pose[joint.parentId].orientation);
+        pose[joint.id].origin = pose[joint.parentId].orientation.transformPoint(pose[joint.id].origin);
+        pose[joint.id].origin += pose[joint.parentId].origin;
+    }
+
+    for (int child : joint.children)
+    {
+        transformReferenceJoint(anim, pose, child);
+    }
+}
+
+// Interpolates the raw frame keys like the skeleton did on every update
+md5::IMD5Anim::Pose calculateReferencePose(const md5::IMD5Anim& anim, std::size_t time)
+{
+    md5::IMD5Anim::Pose pose(anim.getNumJoints());
+
+    float timePerFrameMsec = 1000 / static_cast<float>(anim.getFrameRate());
+    float frameTime = time / timePerFrameMsec;
+
+    float nextFrameFrac = float_mod(frameTime, 1.0f);
+    float curFrameFrac = 1.0f - nextFrameFrac;
+
+    std::size_t curFrame = static_cast<std::size_t>(std::floor(frameTime)) % anim.getNumFrames();
+    std::size_t nextFrame = curFrame == anim.getNumFrames() - 1 ? curFrame : (curFrame + 1) % anim.getNumFrames();
+
+    const auto& cur = anim.getFrameKeys(curFrame);
+    const auto& next = anim.getFrameKeys(nextFrame);
+
+    for (std::size_t i = 0; i < pose.size(); ++i)
+    {
+        const auto& joint = anim.getJoint(i);
+        const auto& baseKey = anim.getBaseFrameKey(joint.id);
+
+        pose[i] = baseKey;
+
+        std::size_t key = joint.firstKey;
+        auto& orientation = pose[i].orientation;
+        auto nextOrientation = baseKey.orientation;
+
+        if (joint.animComponents & md5::Joint::X) { pose[i].origin.x() = cur[key] * curFrameFrac + next[key] * nextFrameFrac; key++; }
+        if (joint.animComponents & md5::Joint::Y) { pose[i].origin.y() = cur[key] * curFrameFrac + next[key] * nextFrameFrac; key++; }
+        if (joint.animComponents & md5::Joint::Z) { pose[i].origin.z() = cur[key] * curFrameFrac + next[key] * nextFrameFrac; key++; }
+        if (joint.animComponents & md5::Joint::YAW) { orientation.x() = cur[key]; nextOrientation.x() = next[key]; key++; }
+        if (joint.animComponents & md5::Joint::PITCH) { orientation.y() = cur[key]; nextOrientation.y() = next[key]; key++; }
+        if (joint.animComponents & md5::Joint::ROLL) { orientation.z() = cur[key]; nextOrientation.z() = next[key]; key++; }
+
+        if (joint.animComponents & (md5::Joint::YAW | md5::Joint::PITCH | md5::Joint::ROLL))
+        {
+            orientation.w() = getQuaternionW(orientation);
+            nextOrientation.w() = getQuaternionW(nextOrientation);
+
+            orientation = referenceSlerp(orientation, nextOrientation, nextFrameFrac).getNormalised();
+        }
+    }
+
+    for (std::size_t i = 0; i < pose.size(); ++i)
+    {
+        if (anim.getJoint(i).parentId == -1)
+        {
+            transformReferenceJoint(anim, pose, i);
+        }
+    }
+
+    return pose;
+}
+
+const char* const POSE_TEST_ANIM = "models/md5/pose_test.md5anim";
+
+}
+
+TEST_F(ModelTest, MD5AnimPoseMatchesInterpolation)
+{
+    auto anim = GlobalAnimationCache().getAnim(POSE_TEST_ANIM);
+    ASSERT_TRUE(anim);
+    EXPECT_EQ(anim->getNumJoints(), 3);
+    EXPECT_EQ(anim->getNumFrames(), 4);
+
+    // At 24 fps a frame lasts 41.67 msec, check exact frames, fractions and the wrap-around
+    for (std::size_t time : { 0, 10, 21, 41, 42, 62, 83, 100, 125, 140, 166, 180, 250 })
+    {
+        auto pose = anim->getPose(time);
+        ASSERT_TRUE(pose);
+        ASSERT_EQ(pose->size(), anim->getNumJoints());
+
+        auto expected = calculateReferencePose(*anim, time);
+
+        for (std::size_t i = 0; i < expected.size(); ++i)
+        {
+            const auto& key = (*pose)[i];
+
+            EXPECT_NEAR(key.origin.x(), expected[i].origin.x(), 1e-4) << "Joint " << i << " at time " << time;
+            EXPECT_NEAR(key.origin.y(), expected[i].origin.y(), 1e-4) << "Joint " << i << " at time " << time;
+            EXPECT_NEAR(key.origin.z(), expected[i].origin.z(), 1e-4) << "Joint " << i << " at time " << time;
+            EXPECT_NEAR(key.orientation.x(), expected[i].orientation.x(), 1e-5) << "Joint " << i << " at time " << time;
+            EXPECT_NEAR(key.orientation.y(), expected[i].orientation.y(), 1e-5) << "Joint " << i << " at time " << time;
+            EXPECT_NEAR(key.orientation.z(), expected[i].orientation.z(), 1e-5) << "Joint " << i << " at time " << time;
+            EXPECT_NEAR(key.orientation.w(), expected[i].orientation.w(), 1e-5) << "Joint " << i << " at time " << time;
+        }
+    }
+}
+
+TEST_F(ModelTest, MD5AnimPosesAreShared)
+{
+    auto anim = GlobalAnimationCache().getAnim(POSE_TEST_ANIM);
+    ASSERT_TRUE(anim);
+
+    // The animation cache hands out the same anim to every model playing it
+    EXPECT_EQ(GlobalAnimationCache().getAnim(POSE_TEST_ANIM), anim);
+
+    // Two skeletons updated to the same time are referencing the same pose
+    auto firstPose = anim->getPose(70);
+    auto secondPose = anim->getPose(70);
+    EXPECT_EQ(firstPose, secondPose);
+
+    EXPECT_NE(anim->getPose(71), firstPose);
+}
+
+TEST_F(ModelTest, MD5AnimPoseCacheEvictsLeastRecentlyUsed)
+{
+    auto anim = GlobalAnimationCache().getAnim(POSE_TEST_ANIM);
+    ASSERT_TRUE(anim);
+
+    // Fill the cache with 32 poses
+    std::vector<md5::IMD5Anim::PosePtr> poses;
+
+    for (std::size_t time = 1000; time < 1032; ++time)
+    {
+        poses.push_back(anim->getPose(time));
+    }
+
+    // Use the oldest pose again, the second one is the least recently used now
+    EXPECT_EQ(anim->getPose(1000), poses[0]);
+
+    // One more pose pushes the least recently used one out
+    anim->getPose(2000);
+
+    EXPECT_EQ(anim->getPose(1000), poses[0]) << "Recently used pose got evicted";
+    EXPECT_EQ(anim->getPose(1031), poses[31]) << "Recently used pose got evicted";
+
+    auto recalculated = anim->getPose(1001);
+    EXPECT_NE(recalculated, poses[1]) << "Least recently used pose has not been evicted";
+
+    // The recalculated pose has the same contents
+    ASSERT_EQ(recalculated->size(), poses[1]->size());
+
+    for (std::size_t i = 0; i < recalculated->size(); ++i)
+    {
+        EXPECT_EQ((*recalculated)[i].origin, (*poses[1])[i].origin);
+        EXPECT_EQ((*recalculated)[i].orientation, (*poses[1])[i].orientation);
+    }
+}
+
 }
@@ -0,0 +1,102 @@
+#include "RadiantTest.h"
+
+#include "iparticles.h"
+#include "algorithm/FileSystem.h"
+#include "testutil/TemporaryFile.h"
+
+namespace test
+{
+
+using ParticlesTest = RadiantTest;
+
+namespace
+{
+
+inline std::string getReloadTestParticle(const std::string& name, float depthHack)
+{
+    return "particle " + name + "\n{\n    depthHack " + std::to_string(depthHack) + "\n}\n";
+}
+
+}
+
+TEST_F(ParticlesTest, ReloadChangedParticleFiles)
+{
+    EXPECT_FALSE(GlobalParticlesManager().getDefByName("reload_test_changing"));
+
+    auto particleFolder = _context.getTestProjectPath() + particles::PARTICLES_DIR;
+    TemporaryFile particleFile(particleFolder + "_reload_test.prt",
+        getReloadTestParticle("reload_test_changing", 0.5f));
+
+    // Added files are picked up
+    GlobalParticlesManager().reloadParticleDefs();
+
+    auto particle = GlobalParticlesManager().getDefByName("reload_test_changing");
+    ASSERT_TRUE(particle);
+    EXPECT_FLOAT_EQ(particle->getDepthHack(), 0.5f);
+    EXPECT_EQ(particle->getFilename(), "_reload_test.prt");
+
+    // The existing def takes the new declaration
+    particleFile.write(getReloadTestParticle("reload_test_changing", 0.25f));
+    GlobalParticlesManager().reloadParticleDefs();
+
+    EXPECT_EQ(GlobalParticlesManager().getDefByName("reload_test_changing"), particle);
+    EXPECT_FLOAT_EQ(particle->getDepthHack(), 0.25f);
+
+    // Defs no longer declared anywhere are emptied
+    particleFile.write(getReloadTestParticle("reload_test_other", 0.25f));
+    GlobalParticlesManager().reloadParticleDefs();
+
+    EXPECT_FLOAT_EQ(particle->getDepthHack(), 0.0f);
+    EXPECT_TRUE(GlobalParticlesManager().getDefByName("reload_test_other"));
+}
+
+// Reloading changed files must leave the def with the file a full load would pick
+TEST_F(ParticlesTest, ReloadParticlesRespectsFilePrecedence)
+{
+    EXPECT_FALSE(GlobalParticlesManager().getDefByName("reload_test_precedence"));
+
+    auto particleFolder = _context.getTestProjectPath() + particles::PARTICLES_DIR;
+    TemporaryFile fileA(particleFolder + "_reload_precedence_a.prt", "");
+    TemporaryFile fileB(particleFolder + "_reload_precedence_b.prt", "");
+
+    auto aIsListedFirst = algorithm::isListedBefore(particles::PARTICLES_DIR, particles::PARTICLES_EXT,
+        "_reload_precedence_a.prt", "_reload_precedence_b.prt");
+    auto& firstFile = aIsListedFirst ? fileA : fileB;
+    auto& lastFile = aIsListedFirst ? fileB : fileA;
+    auto lastFilename = lastFile.getPath().filename().string();
+    auto firstFilename = firstFile.getPath().filename().string();
+
+    // The definition of the file listed last wins
+    firstFile.write(getReloadTestParticle("reload_test_precedence", 0.1f));
+    lastFile.write(getReloadTestParticle("reload_test_precedence", 0.2f));
+    GlobalParticlesManager().reloadParticleDefs();
+
+    auto particle = GlobalParticlesManager().getDefByName("reload_test_precedence");
+    ASSERT_TRUE(particle);
+    EXPECT_FLOAT_EQ(particle->getDepthHack(), 0.2f);
+    EXPECT_EQ(particle->getFilename(), lastFilename);
+
+    // Changing the overridden definition doesn't change the def
+    firstFile.write(getReloadTestParticle("reload_test_precedence", 0.3f));
+    GlobalParticlesManager().reloadParticleDefs();
+    EXPECT_FLOAT_EQ(particle->getDepthHack(), 0.2f);
+    EXPECT_EQ(particle->getFilename(), lastFilename);
+
+    // The overridden definition takes over when the other file stops declaring it
+    lastFile.write(getReloadTestParticle("reload_test_precedence_other", 0.2f));
+    GlobalParticlesManager().reloadParticleDefs();
+    EXPECT_FLOAT_EQ(particle->getDepthHack(), 0.3f);
+    EXPECT_EQ(particle->getFilename(), firstFilename);
+
+    lastFile.write(getReloadTestParticle("reload_test_precedence", 0.4f));
+    GlobalParticlesManager().reloadParticleDefs();
+    EXPECT_FLOAT_EQ(particle->getDepthHack(), 0.4f);
+
+    // Same for removing the file
+    lastFile.remove();
+    GlobalParticlesManager().reloadParticleDefs();
+    EXPECT_FLOAT_EQ(particle->getDepthHack(), 0.3f);
+    EXPECT_EQ(particle->getFilename(), firstFilename);
+}
+
+}
@@ -1,10 +1,15 @@
 #include "RadiantTest.h"
 
+#include <chrono>
 #include "icommandsystem.h"
+#include "ieclass.h"
+#include "ientity.h"
+#include "inamespace.h"
 #include "ispeakernode.h"
 #include "ilightnode.h"
 #include "ibrush.h"
 #include "scene/PrefabBoundsAccumulator.h"
+#include "scene/BasicRootNode.h"
 #include "os/path.h"
 #include "algorithm/Scene.h"
 
@@ -117,4 +122,52 @@ TEST_F(PrefabTest, PrefabInsertPositionWithoutOriginCorrection)
     EXPECT_EQ(brush->worldAABB().getOrigin(), Vector3(128, 0, 0));
 }
 
+// Inserting a large number of entities with names conflicting with existing ones,
+// this reports the time it takes to assign the new names
+TEST_F(PrefabTest, InsertLargePrefabWithConflictingNames)
+{
+    constexpr int NumEntities = 2000;
+
+    auto eclass = GlobalEntityClassManager().findOrInsert("func_static", true);
+    auto mapRoot = GlobalMapModule().getRoot();
+
+    for (int i = 0; i < NumEntities; ++i)
+    {
+        mapRoot->addChildNode(GlobalEntityModule().createEntity(eclass));
+    }
+
+    // The prefab entities get the same func_static_N names as the ones in the map
+    auto prefabRoot = std::make_shared<scene::BasicRootNode>();
+    std::vector<IEntityNodePtr> prefabEntities;
+
+    for (int i = 0; i < NumEntities; ++i)
+    {
+        auto entity = GlobalEntityModule().createEntity(eclass);
+        prefabRoot->addChildNode(entity);
+        prefabEntities.push_back(entity);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    mapRoot->getNamespace()->ensureNoConflicts(prefabRoot);
+
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    rMessage() << "Resolving the name conflicts of " << NumEntities << " entities took "
+        << duration.count() << " usec" << std::endl;
+
+    std::set<std::string> prefabNames;
+
+    for (const auto& entity : prefabEntities)
+    {
+        auto name = entity->getEntity().getKeyValue("name");
+
+        EXPECT_FALSE(mapRoot->getNamespace()->nameExists(name)) << name << " is already in use";
+        prefabNames.insert(name);
+    }
+
+    EXPECT_EQ(prefabNames.size(), NumEntities) << "Prefab entity names are not unique";
+}
+
 }
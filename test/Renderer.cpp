@@ -3,7 +3,12 @@
 #include "ieclass.h"
 #include "ientity.h"
 #include "ilightnode.h"
+#include "iglprogram.h"
 #include "math/Matrix4.h"
+#include "render/RenderQueue.h"
+
+#include <random>
+#include <algorithm>
 
 namespace test
 {
@@ -194,4 +199,163 @@ TEST_F(RendererTest, SimpleProjectedLight)
     EXPECT_EQ(projT.z(), 1);
 }
 
-}
\ No newline at end of file
+// Program doing nothing, the render queue is only interested in its address
+class DummyProgram :
+    public GLProgram
+{
+public:
+    void create() override {}
+    void destroy() override {}
+    void enable() override {}
+    void disable() override {}
+};
+
+// Stand-in for the shader pass, the render queue doesn't call any of its methods
+struct TestPass
+{
+    int id;
+};
+
+OpenGLState createState(OpenGLState::SortPosition sortPosition, unsigned flags, GLProgram* program, GLint texture0)
+{
+    OpenGLState state;
+
+    state.setSortPosition(sortPosition);
+    state.setRenderFlags(flags);
+    state.glProgram = program;
+    state.texture0 = texture0;
+
+    return state;
+}
+
+std::vector<int> getQueuedPassIds(const render::RenderQueue<TestPass>& queue)
+{
+    std::vector<int> ids;
+
+    for (const auto& entry : queue)
+    {
+        ids.push_back(entry.pass->id);
+    }
+
+    return ids;
+}
+
+TEST_F(RendererTest, RenderQueueRespectsSortPosition)
+{
+    render::RenderQueue<TestPass> queue;
+
+    TestPass passes[] = { { 0 }, { 1 }, { 2 }, { 3 } };
+
+    // Layering must be respected, even if the states are the same otherwise
+    queue.add(createState(OpenGLState::SORT_GUI0, RENDER_FILL, nullptr, 5), RENDER_FILL, &passes[0]);
+    queue.add(createState(OpenGLState::SORT_FULLBRIGHT, RENDER_FILL, nullptr, 7), RENDER_FILL, &passes[1]);
+    queue.add(createState(OpenGLState::SORT_FIRST, RENDER_FILL, nullptr, 5), RENDER_FILL, &passes[2]);
+    queue.add(createState(OpenGLState::SORT_FULLBRIGHT, RENDER_FILL, nullptr, 5), RENDER_FILL, &passes[3]);
+
+    queue.sort();
+
+    EXPECT_EQ(getQueuedPassIds(queue), std::vector<int>({ 2, 3, 1, 0 }));
+}
+
+TEST_F(RendererTest, RenderQueueGroupsByProgramAndState)
+{
+    render::RenderQueue<TestPass> queue;
+    DummyProgram programA, programB;
+
+    constexpr unsigned int flagsMask = RENDER_FILL | RENDER_DEPTHTEST | RENDER_BLEND | RENDER_PROGRAM;
+    constexpr auto sortPosition = OpenGLState::SORT_INTERACTION;
+
+    TestPass passes[] = { { 0 }, { 1 }, { 2 }, { 3 }, { 4 }, { 5 } };
+
+    // Interleaved programs and textures, as they come from the pointer-sorted state map
+    queue.add(createState(sortPosition, RENDER_PROGRAM | RENDER_FILL, &programA, 3), flagsMask, &passes[0]);
+    queue.add(createState(sortPosition, RENDER_PROGRAM | RENDER_FILL, &programB, 1), flagsMask, &passes[1]);
+    queue.add(createState(sortPosition, RENDER_PROGRAM | RENDER_FILL, &programA, 1), flagsMask, &passes[2]);
+    queue.add(createState(sortPosition, RENDER_PROGRAM | RENDER_FILL | RENDER_BLEND, &programA, 1), flagsMask, &passes[3]);
+    queue.add(createState(sortPosition, RENDER_PROGRAM | RENDER_FILL, &programB, 1), flagsMask, &passes[4]);
+
+    // Without the RENDER_PROGRAM flag, the program pointer is irrelevant
+    queue.add(createState(sortPosition, RENDER_FILL, &programB, 1), flagsMask, &passes[5]);
+
+    queue.sort();
+
+    // No program first, then program A (sorted by flags and texture), then program B.
+    // Passes with identical keys keep their order
+    EXPECT_EQ(getQueuedPassIds(queue), std::vector<int>({ 5, 2, 0, 3, 1, 4 }));
+
+    // Clearing the queue keeps the program indices
+    queue.clear();
+    EXPECT_TRUE(queue.empty());
+
+    queue.add(createState(sortPosition, RENDER_PROGRAM, &programB, 0), flagsMask, &passes[0]);
+    queue.add(createState(sortPosition, RENDER_PROGRAM, &programA, 0), flagsMask, &passes[1]);
+    queue.sort();
+
+    EXPECT_EQ(getQueuedPassIds(queue), std::vector<int>({ 1, 0 }));
+}
+
+TEST_F(RendererTest, RenderQueueAppliesGlobalFlagsMask)
+{
+    render::RenderQueue<TestPass> queue;
+
+    auto blended = createState(OpenGLState::SORT_FULLBRIGHT, RENDER_BLEND, nullptr, 0);
+    auto opaque = createState(OpenGLState::SORT_FULLBRIGHT, 0, nullptr, 0);
+
+    // Flags masked out by the global state don't affect the order
+    EXPECT_EQ(queue.getSortKey(blended, RENDER_FILL), queue.getSortKey(opaque, RENDER_FILL));
+    EXPECT_NE(queue.getSortKey(blended, RENDER_BLEND), queue.getSortKey(opaque, RENDER_BLEND));
+}
+
+TEST_F(RendererTest, RadixSortMatchesStableSort)
+{
+    struct Entry
+    {
+        std::uint64_t key;
+        std::size_t index;
+    };
+
+    std::mt19937_64 random(12345);
+
+    // Try a few key distributions: full 64 bit, only a few low bits (many duplicates), only high bits
+    for (auto mask : { ~0ull, 0x7ull, 0xff00000000000000ull })
+    {
+        std::vector<Entry> entries;
+
+        for (std::size_t i = 0; i < 5000; ++i)
+        {
+            entries.push_back(Entry{ random() & mask, i });
+        }
+
+        auto expected = entries;
+        std::stable_sort(expected.begin(), expected.end(), [](const Entry& a, const Entry& b)
+        {
+            return a.key < b.key;
+        });
+
+        std::vector<Entry> buffer;
+        render::radixSortByKey(entries, buffer);
+
+        ASSERT_EQ(entries.size(), expected.size());
+
+        for (std::size_t i = 0; i < entries.size(); ++i)
+        {
+            EXPECT_EQ(entries[i].key, expected[i].key) << "Key mismatch at index " << i;
+            EXPECT_EQ(entries[i].index, expected[i].index) << "Sort is not stable at index " << i;
+        }
+    }
+}
+
+TEST_F(RendererTest, RenderableSortKey)
+{
+    // Renderables without entity are rendered first, entities in submission order
+    EXPECT_LT(render::getRenderableSortKey(0, false, false), render::getRenderableSortKey(1, true, false));
+    EXPECT_LT(render::getRenderableSortKey(1, false, false), render::getRenderableSortKey(2, true, false));
+
+    // Identity transforms come first within an entity, to save matrix changes
+    EXPECT_LT(render::getRenderableSortKey(1, true, false), render::getRenderableSortKey(1, false, false));
+
+    // Unless the submission order needs to be preserved
+    EXPECT_EQ(render::getRenderableSortKey(1, true, true), render::getRenderableSortKey(1, false, true));
+}
+
+}
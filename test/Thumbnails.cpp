@@ -0,0 +1,214 @@
+#include "RadiantTest.h"
+
+#include "iimage.h"
+#include "ithumbnailcache.h"
+#include "image/ThumbnailGenerator.h"
+#include "os/dir.h"
+#include "testutil/TemporaryFile.h"
+#include <fstream>
+
+namespace test
+{
+
+using ThumbnailTest = RadiantTest;
+
+namespace
+{
+
+// Creates an image with the left half black and the right half white
+RGBAImagePtr createHalfWhiteImage(std::size_t width, std::size_t height)
+{
+    auto image = std::make_shared<RGBAImage>(width, height);
+
+    for (std::size_t y = 0; y < height; ++y)
+    {
+        for (std::size_t x = 0; x < width; ++x)
+        {
+            uint8_t value = x < width / 2 ? 0 : 255;
+            image->pixels[y * width + x] = RGBAPixel{ value, value, value, 255 };
+        }
+    }
+
+    return image;
+}
+
+void expectThumbnailSize(std::size_t width, std::size_t height, std::size_t expectedWidth, std::size_t expectedHeight)
+{
+    auto size = image::getThumbnailSize(width, height, 128);
+
+    EXPECT_EQ(size.first, expectedWidth) << "Wrong thumbnail width for " << width << "x" << height;
+    EXPECT_EQ(size.second, expectedHeight) << "Wrong thumbnail height for " << width << "x" << height;
+}
+
+std::string readBinaryFile(const fs::path& path)
+{
+    std::ifstream stream(path.string(), std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(stream), {});
+}
+
+image::Thumbnail::Ptr getThumbnailAndWait(const std::string& materialName)
+{
+    auto thumbnail = GlobalThumbnailCache().getThumbnail(materialName);
+
+    if (!thumbnail)
+    {
+        GlobalThumbnailCache().waitForPendingThumbnails();
+        thumbnail = GlobalThumbnailCache().getThumbnail(materialName);
+    }
+
+    return thumbnail;
+}
+
+}
+
+TEST_F(ThumbnailTest, ThumbnailSize)
+{
+    // Aspect ratio is preserved, longer side is clamped
+    expectThumbnailSize(1024, 512, 128, 64);
+    expectThumbnailSize(64, 2048, 4, 128);
+
+    // Small images are not enlarged
+    expectThumbnailSize(32, 16, 32, 16);
+
+    // Very thin images result in at least one pixel
+    expectThumbnailSize(4096, 1, 128, 1);
+}
+
+TEST_F(ThumbnailTest, CreateThumbnail)
+{
+    auto source = createHalfWhiteImage(512, 256);
+    auto thumbnail = image::createThumbnail(*source, 128);
+
+    ASSERT_TRUE(thumbnail);
+    EXPECT_EQ(thumbnail->getWidth(), 128);
+    EXPECT_EQ(thumbnail->getHeight(), 64);
+
+    // Each thumbnail pixel covers 4x4 source pixels, none of them straddles the edge
+    EXPECT_EQ(thumbnail->pixels[0].red, 0);
+    EXPECT_EQ(thumbnail->pixels[63].red, 0);
+    EXPECT_EQ(thumbnail->pixels[64].red, 255);
+    EXPECT_EQ(thumbnail->pixels[127].red, 255);
+    EXPECT_EQ(thumbnail->pixels[127].alpha, 255);
+}
+
+TEST_F(ThumbnailTest, CreateThumbnailAveragesPixels)
+{
+    // 3 source pixels per thumbnail pixel, the middle one straddles the edge
+    auto source = createHalfWhiteImage(6, 3);
+    auto thumbnail = image::createThumbnail(*source, 2);
+
+    ASSERT_TRUE(thumbnail);
+    EXPECT_EQ(thumbnail->getWidth(), 2);
+    EXPECT_EQ(thumbnail->getHeight(), 1);
+
+    EXPECT_EQ(thumbnail->pixels[0].green, 0);
+    EXPECT_EQ(thumbnail->pixels[1].green, 255);
+}
+
+TEST_F(ThumbnailTest, CreateThumbnailOfPrecompressedImage)
+{
+    auto image = GlobalImageLoader().imageFromFile(_context.getTestProjectPath() + "textures/dds/test_128x128_dxt1.dds");
+    ASSERT_TRUE(image);
+    ASSERT_TRUE(image->isPrecompressed());
+
+    // Precompressed images are not supported
+    EXPECT_FALSE(image::createThumbnail(*image, 64));
+}
+
+TEST_F(ThumbnailTest, ThumbnailOfMaterial)
+{
+    GlobalThumbnailCache().clear();
+
+    auto thumbnail = getThumbnailAndWait("textures/a_1024x512");
+
+    ASSERT_TRUE(thumbnail);
+    ASSERT_TRUE(thumbnail->image);
+    EXPECT_FALSE(GlobalThumbnailCache().hasPendingThumbnails());
+
+    // Source dimensions are reported, the image itself is downscaled
+    EXPECT_EQ(thumbnail->sourceWidth, 1024);
+    EXPECT_EQ(thumbnail->sourceHeight, 512);
+    EXPECT_EQ(thumbnail->image->getWidth(), 128);
+    EXPECT_EQ(thumbnail->image->getHeight(), 64);
+
+    // Subsequent requests are served from memory
+    EXPECT_EQ(GlobalThumbnailCache().getThumbnail("textures/a_1024x512"), thumbnail);
+}
+
+TEST_F(ThumbnailTest, ThumbnailIsStoredOnDisk)
+{
+    GlobalThumbnailCache().clear();
+
+    auto thumbnail = getThumbnailAndWait("textures/a_1024x512");
+    ASSERT_TRUE(thumbnail && thumbnail->image);
+
+    std::size_t numThumbnailFiles = 0;
+    os::foreachItemInDirectory(_context.getCacheDataPath() + "thumbnails/", [&](const fs::path& path)
+    {
+        if (path.extension() == ".thumb") ++numThumbnailFiles;
+    });
+
+    EXPECT_GT(numThumbnailFiles, 0) << "No thumbnail files found in the cache folder";
+
+    // Clearing the memory cache, the next request will be loaded from disk
+    GlobalThumbnailCache().clear();
+
+    auto reloaded = getThumbnailAndWait("textures/a_1024x512");
+    ASSERT_TRUE(reloaded && reloaded->image);
+    EXPECT_NE(reloaded, thumbnail);
+
+    EXPECT_EQ(reloaded->sourceWidth, thumbnail->sourceWidth);
+    EXPECT_EQ(reloaded->sourceHeight, thumbnail->sourceHeight);
+    ASSERT_EQ(reloaded->image->getWidth(), thumbnail->image->getWidth());
+    ASSERT_EQ(reloaded->image->getHeight(), thumbnail->image->getHeight());
+
+    auto numBytes = thumbnail->image->getWidth() * thumbnail->image->getHeight() * sizeof(RGBAPixel);
+    EXPECT_EQ(memcmp(reloaded->image->getPixels(), thumbnail->image->getPixels(), numBytes), 0);
+}
+
+TEST_F(ThumbnailTest, EditedImageInvalidatesStoredThumbnail)
+{
+    GlobalThumbnailCache().clear();
+
+    // Work on a copy of the image in a scratch folder, the image file is implicitly used as material
+    auto texturePath = _context.getTestProjectPath();
+    TemporaryFile texture(texturePath + "textures/_thumbnail_test/edited.tga",
+        readBinaryFile(texturePath + "textures/a_1024x512.tga"));
+
+    auto thumbnail = getThumbnailAndWait("textures/_thumbnail_test/edited");
+    ASSERT_TRUE(thumbnail && thumbnail->image);
+    EXPECT_EQ(thumbnail->sourceWidth, 1024);
+
+    // Replace the image file in place
+    texture.write(readBinaryFile(texturePath + "textures/numbers/1.tga"));
+
+    GlobalThumbnailCache().clear();
+    auto regenerated = getThumbnailAndWait("textures/_thumbnail_test/edited");
+
+    // The stored thumbnail must not be used, it has been generated from the old file
+    ASSERT_TRUE(regenerated && regenerated->image);
+    EXPECT_EQ(regenerated->sourceWidth, 32);
+    EXPECT_EQ(regenerated->sourceHeight, 32);
+
+    // After restoring the original file, the thumbnail is generated again
+    texture.write(readBinaryFile(texturePath + "textures/a_1024x512.tga"));
+
+    GlobalThumbnailCache().clear();
+    auto restored = getThumbnailAndWait("textures/_thumbnail_test/edited");
+
+    ASSERT_TRUE(restored && restored->image);
+    EXPECT_EQ(restored->sourceWidth, 1024);
+    EXPECT_EQ(restored->sourceHeight, 512);
+}
+
+TEST_F(ThumbnailTest, ThumbnailOfMaterialWithoutImage)
+{
+    // A material without any stages has nothing to generate a thumbnail from,
+    // the result is available immediately and has an empty image
+    auto thumbnail = GlobalThumbnailCache().getThumbnail("textures/doesnt/exist/anywhere");
+
+    ASSERT_TRUE(thumbnail);
+    EXPECT_FALSE(thumbnail->image);
+}
+
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include "ifilesystem.h"
+
+namespace test::algorithm
+{
+
+// Returns true if the VFS lists the first file before the second one when
+// traversing the given folder. Both names are relative to that folder.
+inline bool isListedBefore(const std::string& folder, const std::string& extension,
+    const std::string& first, const std::string& second)
+{
+    bool firstFound = false;
+    bool result = false;
+
+    GlobalFileSystem().forEachFile(folder, extension, [&](const vfs::FileInfo& fileInfo)
+    {
+        if (fileInfo.name == first)
+        {
+            firstFound = true;
+        }
+        else if (fileInfo.name == second && firstFound)
+        {
+            result = true;
+        }
+    }, 0);
+
+    return result;
+}
+
+}
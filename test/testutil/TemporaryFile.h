@@ -0,0 +1,72 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+#include "os/fs.h"
+
+namespace test
+{
+
+/**
+ * A file written by a test, which is removed again when this object
+ * goes out of scope, also when the test fails half-way. A missing parent
+ * folder is created and removed again along with the file.
+ */
+class TemporaryFile
+{
+private:
+    fs::path _path;
+    bool _createdFolder;
+
+public:
+    TemporaryFile(const fs::path& path) :
+        _path(path),
+        _createdFolder(false)
+    {
+        if (!fs::exists(_path.parent_path()))
+        {
+            fs::create_directories(_path.parent_path());
+            _createdFolder = true;
+        }
+    }
+
+    TemporaryFile(const fs::path& path, const std::string& contents) :
+        TemporaryFile(path)
+    {
+        write(contents);
+    }
+
+    TemporaryFile(const TemporaryFile& other) = delete;
+    TemporaryFile& operator=(const TemporaryFile& other) = delete;
+
+    ~TemporaryFile()
+    {
+        remove();
+
+        if (_createdFolder)
+        {
+            std::error_code ec;
+            fs::remove(_path.parent_path(), ec);
+        }
+    }
+
+    const fs::path& getPath() const
+    {
+        return _path;
+    }
+
+    // (Over)writes the file with the given contents, which are written as they are
+    void write(const std::string& contents)
+    {
+        std::ofstream stream(_path.string(), std::ios::out | std::ios::binary | std::ios::trunc);
+        stream << contents;
+    }
+
+    void remove()
+    {
+        std::error_code ec;
+        fs::remove(_path, ec);
+    }
+};
+
+}